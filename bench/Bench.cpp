@@ -0,0 +1,458 @@
+/**
+ * @file Bench.cpp
+ * @brief Headless benchmarks that drive scripted keystrokes through TerminalEditor.
+ *
+ * Each corpus gets its own home directory with generated notes, tasks and events.
+ * The editor runs on a virtual ncurses screen, so every keystroke is handled,
+ * drawn and diffed exactly as in the application, only the output goes nowhere.
+ * Every benchmark prints one JSON object per line with its throughput, latency
+ * percentiles and allocations, so runs on two commits can be diffed. Allocations are
+ * counted by AllocationTracker, which also splits the bytes by subsystem.
+ *
+ * The frames are shown by the chosen render backend: curses lets ncurses write the
+ * updates, direct writes them with EscapeBackend, memory only keeps them. The bytes
+ * the first two would send to a terminal go to an unlinked temporary file and are counted.
+ *
+ * Usage: neonote-bench [--sizes MB,MB,...] [--tasks N] [--events N] [--screen COLSxROWS]
+ *                      [--backend curses|direct|memory] [--label TEXT] [--keep]
+ */
+
+#include "../src/AllocationTracker.h"
+#include "../src/EscapeBackend.h"
+#include "../src/MemoryBackend.h"
+#include "../src/NcursesSetup.h"
+#include "../src/PaneTree.h"
+#include "../src/Settings.h"
+#include "../src/TerminalEditor.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+int output_fd = -1;     ///< Where ncurses and EscapeBackend write, its offset counts the bytes
+
+struct Options {
+    std::vector<int> note_sizes_mb = {1, 16};
+    int tasks = 100000;
+    int events = 100000;
+    int lines = 40;
+    int cols = 120;
+    std::string backend = "curses";
+    std::string label;
+    bool keep = false;
+};
+
+struct Counters {
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+    std::uint64_t output_bytes = 0;     ///< Written to the terminal, 0 for the memory backend
+    std::uint64_t tag_bytes[AllocationTracker::TAG_COUNT] = {};
+
+    Counters operator-(const Counters& before) const {
+        Counters difference{allocations - before.allocations, allocated_bytes - before.allocated_bytes,
+                            output_bytes - before.output_bytes};
+        for (int tag = 0; tag < AllocationTracker::TAG_COUNT; ++tag) {
+            difference.tag_bytes[tag] = tag_bytes[tag] - before.tag_bytes[tag];
+        }
+        return difference;
+    }
+};
+
+struct Result {
+    std::string name;
+    std::string corpus;
+    std::vector<std::uint64_t> nanos;   ///< One per keystroke, or one for a single operation
+    Counters counters;
+};
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Gets the time since an earlier point in nanoseconds.
+ */
+std::uint64_t since(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Reads the allocation and output counters.
+ */
+Counters counters() {
+    AllocationTracker::Usage total = AllocationTracker::usage(AllocationTracker::TAG_COUNT);
+    off_t output_bytes = lseek(output_fd, 0, SEEK_CUR);
+    Counters now{total.allocations, total.allocated, output_bytes > 0 ? std::uint64_t(output_bytes) : 0};
+    for (int tag = 0; tag < AllocationTracker::TAG_COUNT; ++tag) {
+        now.tag_bytes[tag] = AllocationTracker::usage(static_cast<AllocationTracker::Tag>(tag)).allocated;
+    }
+    return now;
+}
+
+/**
+ * @brief Gets a percentile of sorted durations.
+ */
+double percentileMicros(const std::vector<std::uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[index] / 1e3;
+}
+
+/**
+ * @brief Escapes a string for a JSON value.
+ */
+std::string quoted(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+/**
+ * @brief Prints a result as one line of JSON.
+ */
+void report(Result result) {
+    std::sort(result.nanos.begin(), result.nanos.end());
+    std::uint64_t total = 0;
+    for (std::uint64_t nanos : result.nanos) total += nanos;
+    double seconds = total / 1e9;
+    size_t count = result.nanos.size();
+
+    std::ostringstream line;
+    line << "{\"benchmark\":" << quoted(result.name)
+         << ",\"corpus\":" << quoted(result.corpus)
+         << ",\"ops\":" << count
+         << ",\"seconds\":" << seconds
+         << ",\"ops_per_second\":" << (seconds > 0 ? count / seconds : 0)
+         << ",\"p50_us\":" << percentileMicros(result.nanos, 0.50)
+         << ",\"p90_us\":" << percentileMicros(result.nanos, 0.90)
+         << ",\"p99_us\":" << percentileMicros(result.nanos, 0.99)
+         << ",\"max_us\":" << (count ? result.nanos.back() / 1e3 : 0)
+         << ",\"allocations\":" << result.counters.allocations
+         << ",\"allocated_bytes\":" << result.counters.allocated_bytes
+         << ",\"allocations_per_op\":" << (count ? double(result.counters.allocations) / count : 0)
+         << ",\"output_bytes\":" << result.counters.output_bytes
+         << ",\"output_bytes_per_op\":" << (count ? double(result.counters.output_bytes) / count : 0)
+         << ",\"allocated_bytes_by_tag\":{";
+    for (int tag = 0; tag < AllocationTracker::TAG_COUNT; ++tag) {
+        line << (tag ? "," : "") << quoted(AllocationTracker::tagName(static_cast<AllocationTracker::Tag>(tag)))
+             << ":" << result.counters.tag_bytes[tag];
+    }
+    line << "}}";
+    std::cout << line.str() << std::endl;
+}
+
+/**
+ * @brief Times a single operation.
+ */
+template <typename Operation>
+Result timeOnce(const std::string& name, const std::string& corpus, Operation operation) {
+    Result result{name, corpus, {}, {}};
+    Counters before = counters();
+    Clock::time_point start = Clock::now();
+    operation();
+    result.nanos.push_back(since(start));
+    result.counters = counters() - before;
+    return result;
+}
+
+/**
+ * @brief Feeds keystrokes to the editor, timing each one.
+ */
+Result replay(TerminalEditor& editor, const std::string& name, const std::string& corpus,
+              const std::vector<int>& keys) {
+    Result result{name, corpus, {}, {}};
+    result.nanos.reserve(keys.size());
+    Counters before = counters();
+    for (int key : keys) {
+        Clock::time_point start = Clock::now();
+        editor.handleInput(key);
+        result.nanos.push_back(since(start));
+    }
+    result.counters = counters() - before;
+    return result;
+}
+
+/**
+ * @brief Repeats a key.
+ */
+std::vector<int> repeat(int key, int count) {
+    return std::vector<int>(count, key);
+}
+
+/**
+ * @brief Types text as keystrokes, with Enter for newlines.
+ */
+std::vector<int> typing(const std::string& text) {
+    std::vector<int> keys;
+    for (char c : text) keys.push_back(c == '\n' ? NEW_LINE : static_cast<unsigned char>(c));
+    return keys;
+}
+
+/**
+ * @brief Writes a markdown note of about the given size.
+ *
+ * The lines mix headings, lists, checkboxes, emphasis, links, code blocks and
+ * long paragraphs that wrap, chosen by a fixed seed so every run is the same.
+ */
+void writeNote(const std::string& path, std::uint64_t bytes) {
+    static const char* words[] = {"note", "terminal", "editor", "markdown", "task", "calendar",
+                                  "render", "window", "cursor", "scroll", "buffer", "latency"};
+    std::mt19937 random(42);
+    std::ofstream file(path, std::ios::binary);
+    std::uint64_t written = 0;
+    std::string line;
+    int section = 0;
+    while (written < bytes) {
+        int kind = random() % 20;
+        line.clear();
+        if (kind == 0) {
+            line = "## Section " + std::to_string(++section);
+        } else if (kind < 5) {
+            line = (kind == 1 ? "- [ ] " : "- ") + std::string(words[random() % 12]) + " **"
+                 + words[random() % 12] + "** and [[note " + std::to_string(random() % 100) + "]]";
+        } else if (kind == 5) {
+            line = "```\nint main() { return " + std::to_string(random() % 10) + "; }\n```";
+        } else {
+            int count = 5 + random() % (kind == 6 ? 80 : 20);
+            for (int i = 0; i < count; ++i) {
+                if (i) line += ' ';
+                line += words[random() % 12];
+                if (random() % 15 == 0) line = line + " *" + words[random() % 12] + "*";
+            }
+        }
+        line += '\n';
+        file << line;
+        written += line.size();
+    }
+}
+
+/**
+ * @brief Writes the tasks of the default board, spread over its three columns.
+ */
+void writeTasks(const std::string& kanban_dir, int count) {
+    std::filesystem::create_directories(kanban_dir);
+    for (int id = 0; id < count; ++id) {
+        std::ofstream file(kanban_dir + std::to_string(id));
+        file << "Task " << id << '\n' << id % 3 << '\n' << "Generated task\n"
+             << id % 4 << '\n' << "2025-0" << 1 + id % 9 << "-1" << id % 10 << '\n'
+             << (id % 5 == 0 ? "bench" : "") << "\n\n";
+    }
+}
+
+/**
+ * @brief Writes calendar events spread over a year.
+ */
+void writeEvents(const std::string& events_dir, int count) {
+    std::filesystem::create_directories(events_dir);
+    for (int id = 0; id < count; ++id) {
+        std::ofstream file(events_dir + "/" + std::to_string(id));
+        file << "Event " << id << '\n' << "2025-" << 1 + id % 12 << '-' << 1 + id % 28 << '\n'
+             << "Generated event\n";
+    }
+}
+
+/**
+ * @brief Owns the windows an editor draws into, laid out like the application does.
+ */
+class Screen {
+public:
+    Screen() {
+        int sidebar_width = static_cast<int>(COLS * SIDEBAR_WIDTH_RATIO);
+        main = newwin(LINES, COLS, 0, 0);
+        sidebar = derwin(main, LINES, sidebar_width, 0, 0);
+        panes.layout(main, 0, sidebar_width, LINES, COLS - sidebar_width);
+    }
+    ~Screen() {
+        panes.releaseWindows();
+        delwin(sidebar);
+        delwin(main);
+    }
+
+    WINDOW* main;
+    WINDOW* sidebar;
+    PaneTree panes;
+};
+
+/**
+ * @brief Runs the note benchmarks on a note of the given size.
+ */
+void benchNote(const std::string& root, int megabytes) {
+    std::string corpus = "note-" + std::to_string(megabytes) + "MB";
+    std::string home = root + "/" + corpus;
+    std::filesystem::create_directories(home + "/.local/share/neonote");
+    writeNote(home + "/.local/share/neonote/bench.md", std::uint64_t(megabytes) << 20);
+    setenv("HOME", home.c_str(), 1);
+    std::cerr << "bench: " << corpus << std::endl;
+
+    Screen screen;
+    TerminalEditor* editor = nullptr;
+    report(timeOnce("note.open", corpus, [&] {
+        editor = new TerminalEditor(screen.main, screen.sidebar, &screen.panes, {});
+    }));
+
+    report(replay(*editor, "note.scroll", corpus, repeat(CURSOR_DOWN, 5000)));
+    report(replay(*editor, "note.jump", corpus, {GOTO_FILE_END, GOTO_FILE_START, GOTO_FILE_END, GOTO_FILE_START}));
+
+    std::string text;
+    for (int i = 0; i < 100; ++i) text += "typing a line of **bold** text with a [[link]] in it\n";
+    report(replay(*editor, "note.type", corpus, typing(text)));
+    report(replay(*editor, "note.delete", corpus, repeat(DELETE_LEFT, 2000)));
+    report(replay(*editor, "note.save", corpus, {SAVE_FILE}));
+
+    editor->handleInput(GOTO_FILE_START);
+    report(replay(*editor, "note.wrap_toggle", corpus, {TOGGLE_WRAP}));
+    report(replay(*editor, "note.wrap_scroll", corpus, repeat(CURSOR_DOWN, 5000)));
+    report(replay(*editor, "note.wrap_type", corpus, typing(text)));
+    report(replay(*editor, "note.split", corpus, {SPLIT_SIDE_BY_SIDE}));
+    report(replay(*editor, "note.split_type", corpus, typing(text)));
+
+    report(timeOnce("note.close", corpus, [&] {
+        editor->cleanup();
+        delete editor;
+    }));
+}
+
+/**
+ * @brief Runs the kanban and calendar benchmarks on generated tasks and events.
+ */
+void benchBoards(const std::string& root, const Options& options) {
+    std::string corpus = std::to_string(options.tasks) + "-tasks-" + std::to_string(options.events) + "-events";
+    std::string home = root + "/boards";
+    std::filesystem::create_directories(home + "/.local/share/neonote");
+    writeNote(home + "/.local/share/neonote/bench.md", 4096);
+    writeTasks(home + "/.local/share/neonote/kanban/", options.tasks);
+    writeEvents(home + "/.local/share/neonote/events", options.events);
+    setenv("HOME", home.c_str(), 1);
+    std::cerr << "bench: " << corpus << std::endl;
+
+    Screen screen;
+    TerminalEditor* editor = nullptr;
+    report(timeOnce("boards.open", corpus, [&] {
+        editor = new TerminalEditor(screen.main, screen.sidebar, &screen.panes, {});
+    }));
+
+    // The sidebar lists the note, then My Tasks, then Calendar
+    editor->handleInput(SWITCH_PANEL);
+    editor->handleInput(CURSOR_DOWN);
+    report(replay(*editor, "kanban.open", corpus, {SWITCH_PANEL}));
+    report(replay(*editor, "kanban.select", corpus, repeat(CURSOR_DOWN, 2000)));
+    std::vector<int> across;
+    for (int i = 0; i < 500; ++i) {
+        across.push_back(MOVE_TASK_RIGHT);
+        across.push_back(MOVE_TASK_LEFT);
+    }
+    report(replay(*editor, "kanban.columns", corpus, across));
+    report(replay(*editor, "kanban.sort", corpus, repeat(SORT_TASKS, 3)));
+
+    editor->handleInput(SWITCH_PANEL);
+    editor->handleInput(CURSOR_DOWN);
+    report(replay(*editor, "calendar.open", corpus, {SWITCH_PANEL}));
+    report(replay(*editor, "calendar.select", corpus, repeat(CURSOR_DOWN, 2000)));
+
+    editor->cleanup();
+    delete editor;
+}
+
+/**
+ * @brief Reads the command line, exits with a message on a bad option.
+ */
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        std::string value = i + 1 < argc ? argv[i + 1] : "";
+        if (option == "--sizes") {
+            options.note_sizes_mb.clear();
+            std::stringstream sizes(value);
+            for (std::string size; std::getline(sizes, size, ',');) {
+                if (!size.empty()) options.note_sizes_mb.push_back(std::atoi(size.c_str()));
+            }
+            ++i;
+        } else if (option == "--tasks") {
+            options.tasks = std::atoi(value.c_str());
+            ++i;
+        } else if (option == "--events") {
+            options.events = std::atoi(value.c_str());
+            ++i;
+        } else if (option == "--screen" && std::sscanf(value.c_str(), "%dx%d", &options.cols, &options.lines) == 2) {
+            ++i;
+        } else if (option == "--backend" && (value == "curses" || value == "direct" || value == "memory")) {
+            options.backend = value;
+            ++i;
+        } else if (option == "--label") {
+            options.label = value;
+            ++i;
+        } else if (option == "--keep") {
+            options.keep = true;
+        } else {
+            std::cerr << "usage: neonote-bench [--sizes MB,MB,...] [--tasks N] [--events N] [--screen COLSxROWS]"
+                         " [--backend curses|direct|memory] [--label TEXT] [--keep]" << std::endl;
+            std::exit(2);
+        }
+    }
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options = parseOptions(argc, argv);
+    AllocationTracker::enable();
+
+    char root_template[] = "/tmp/neonote-bench-XXXXXX";
+    if (!mkdtemp(root_template)) {
+        std::perror("neonote-bench");
+        return 1;
+    }
+    std::string root = root_template;
+
+    FILE* output = tmpfile();
+    NcursesSetup ncurses;
+    if (!output || !ncurses.initializeHeadless(options.lines, options.cols, output)) {
+        std::cerr << "neonote-bench: could not create a virtual screen" << std::endl;
+        return 1;
+    }
+    output_fd = fileno(output);
+
+    EscapeBackend escape(output_fd);
+    MemoryBackend memory;
+    if (options.backend == "direct") {
+        RenderBackend::use(&escape);
+    } else if (options.backend == "memory") {
+        RenderBackend::use(&memory);
+    }
+
+    std::cout << "{\"run\":\"neonote-bench\",\"label\":" << quoted(options.label)
+              << ",\"backend\":" << quoted(options.backend)
+              << ",\"screen\":\"" << COLS << "x" << LINES << "\"}" << std::endl;
+    for (int megabytes : options.note_sizes_mb) {
+        benchNote(root, megabytes);
+    }
+    if (options.tasks > 0 || options.events > 0) {
+        benchBoards(root, options);
+    }
+
+    RenderBackend::use(nullptr);
+    ncurses.cleanup();
+    fclose(output);
+    if (options.keep) {
+        std::cerr << "bench: corpora kept in " << root << std::endl;
+    } else {
+        std::filesystem::remove_all(root);
+    }
+    return 0;
+}
@@ -0,0 +1,290 @@
+#include "AllocationTracker.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+AllocationTracker::Counters AllocationTracker::counters[AllocationTracker::TAG_COUNT + 1];
+
+namespace {
+
+// Put in front of every block; 16 bytes keep the block aligned like malloc's
+struct BlockHeader {
+    std::uint64_t size;
+    std::uint32_t tag;
+    std::uint32_t tracked;      ///< Counted when allocated, so it is taken off when freed
+};
+static_assert(sizeof(BlockHeader) == __STDCPP_DEFAULT_NEW_ALIGNMENT__, "the header must keep blocks aligned");
+
+}  // namespace
+
+/**
+ * @brief Turns counting and the overlay on or off.
+ *
+ * Blocks allocated while counting was off are never counted, not even when freed.
+ */
+void AllocationTracker::toggle() {
+    enabled.store(!enabled.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Turns counting on, used at startup and by the benchmarks.
+ */
+void AllocationTracker::enable() {
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Checks whether allocations are counted.
+ *
+ * @return `true` while allocations are counted and the overlay is shown.
+ */
+bool AllocationTracker::isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Reads the counters of a tag.
+ *
+ * @param tag The tag, or TAG_COUNT for all tags together.
+ * @return The usage; live bytes never go below zero.
+ */
+AllocationTracker::Usage AllocationTracker::usage(Tag tag) {
+    const Counters& source = counters[tag];
+    Usage result;
+    std::int64_t live = source.live.load(std::memory_order_relaxed);
+    result.live = live > 0 ? live : 0;
+    result.peak = source.peak.load(std::memory_order_relaxed);
+    result.allocations = source.allocations.load(std::memory_order_relaxed);
+    result.allocated = source.allocated.load(std::memory_order_relaxed);
+    return result;
+}
+
+/**
+ * @brief Gets the name of a tag as shown in the overlay and the dump.
+ *
+ * @param tag The tag, or TAG_COUNT for the total.
+ * @return A short lowercase name.
+ */
+const char* AllocationTracker::tagName(Tag tag) {
+    switch (tag) {
+        case Other: return "other";
+        case Buffer: return "buffer";
+        case Render: return "render";
+        case Tasks: return "tasks";
+        case Events: return "events";
+        case FileIO: return "file_io";
+        case TAG_COUNT: return "total";
+        default: return "?";
+    }
+}
+
+/**
+ * @brief Draws live bytes, peak and allocation rate in the bottom right corner of a window.
+ *
+ * The rate is averaged over at least a second, so it stays readable while typing.
+ * Nothing is drawn if the window is too small. The cursor of the window is left
+ * where it was, and the window is not refreshed.
+ *
+ * @param win The window to draw over.
+ */
+void AllocationTracker::drawOverlay(WINDOW* win) {
+    const int width = 47;
+    const int height = TAG_COUNT + 3;
+    int rows, cols;
+    getmaxyx(win, rows, cols);
+    if (cols < width + 2 || rows < height + 2) return;
+
+    static std::chrono::steady_clock::time_point sampled;
+    static std::uint64_t sampled_allocations = 0;
+    static double rate = 0;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::uint64_t allocations = usage(TAG_COUNT).allocations;
+    double elapsed = std::chrono::duration<double>(now - sampled).count();
+    if (elapsed >= 1.0) {
+        if (sampled_allocations > 0) rate = (allocations - sampled_allocations) / elapsed;
+        sampled = now;
+        sampled_allocations = allocations;
+    }
+
+    int cursor_y, cursor_x;
+    getyx(win, cursor_y, cursor_x);
+    int top = rows - height - 1;
+    int left = cols - width - 1;
+    for (int y = 0; y < height; ++y) {
+        mvwprintw(win, top + y, left, "%*s", width, "");
+    }
+
+    char title[48];
+    snprintf(title, sizeof(title), "Allocations  %.0f/s", rate);
+    wattron(win, A_REVERSE);
+    mvwprintw(win, top, left, " %-*s", width - 1, title);
+    wattroff(win, A_REVERSE);
+    wattron(win, A_BOLD);
+    mvwprintw(win, top + 1, left, " %-8s %8s %8s %9s %8s", "tag", "live", "peak", "allocs", "bytes");
+    wattroff(win, A_BOLD);
+    for (int tag = 0; tag <= TAG_COUNT; ++tag) {
+        Usage shown = usage(static_cast<Tag>(tag));
+        if (tag == TAG_COUNT) wattron(win, A_BOLD);
+        mvwprintw(win, top + 2 + tag, left, " %-8s %8s %8s %9llu %8s", tagName(static_cast<Tag>(tag)),
+                  formatBytes(shown.live).c_str(), formatBytes(shown.peak).c_str(),
+                  (unsigned long long)shown.allocations, formatBytes(shown.allocated).c_str());
+        if (tag == TAG_COUNT) wattroff(win, A_BOLD);
+    }
+    wmove(win, cursor_y, cursor_x);
+}
+
+/**
+ * @brief Writes the usage of every tag to a file if anything was counted.
+ *
+ * @param path The file to write, replaced if it exists.
+ */
+void AllocationTracker::dump(const std::string& path) {
+    if (usage(TAG_COUNT).allocations == 0) return;
+
+    std::ofstream file(path);
+    file << "tag live_bytes peak_bytes allocations allocated_bytes\n";
+    for (int tag = 0; tag <= TAG_COUNT; ++tag) {
+        Usage shown = usage(static_cast<Tag>(tag));
+        file << tagName(static_cast<Tag>(tag)) << ' ' << shown.live << ' ' << shown.peak << ' '
+             << shown.allocations << ' ' << shown.allocated << '\n';
+    }
+}
+
+/**
+ * @brief Allocates a block with a header and counts it under the current tag.
+ *
+ * Safe to call from any thread; only relaxed atomic operations are used.
+ *
+ * @param size The size the caller asked for.
+ * @return The block after the header, or nullptr if malloc failed.
+ */
+void* AllocationTracker::allocate(std::size_t size) noexcept {
+    BlockHeader* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+    if (!header) return nullptr;
+    header->size = size;
+    header->tag = current;
+    header->tracked = enabled.load(std::memory_order_relaxed);
+
+    if (header->tracked) {
+        for (Counters* target : {&counters[current], &counters[TAG_COUNT]}) {
+            target->allocations.fetch_add(1, std::memory_order_relaxed);
+            target->allocated.fetch_add(size, std::memory_order_relaxed);
+            raisePeak(*target, target->live.fetch_add(size, std::memory_order_relaxed) + size);
+        }
+    }
+    return header + 1;
+}
+
+/**
+ * @brief Frees a block from allocate(), taking its bytes off the tag it was counted under.
+ *
+ * @param block The block, or nullptr.
+ */
+void AllocationTracker::release(void* block) noexcept {
+    if (!block) return;
+    BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+    if (header->tracked) {
+        counters[header->tag].live.fetch_sub(header->size, std::memory_order_relaxed);
+        counters[TAG_COUNT].live.fetch_sub(header->size, std::memory_order_relaxed);
+    }
+    std::free(header);
+}
+
+/**
+ * @brief Raises the peak of a counter to a live byte count if it is higher.
+ */
+void AllocationTracker::raisePeak(Counters& target, std::int64_t live) {
+    if (live < 0) return;
+    std::uint64_t seen = target.peak.load(std::memory_order_relaxed);
+    while (std::uint64_t(live) > seen && !target.peak.compare_exchange_weak(seen, live, std::memory_order_relaxed)) {}
+}
+
+/**
+ * @brief Formats a byte count with a unit that keeps it short.
+ *
+ * @param bytes The byte count.
+ * @return The count in bytes, KiB, MiB or GiB, or "-" for zero.
+ */
+std::string AllocationTracker::formatBytes(std::uint64_t bytes) {
+    char text[16];
+    if (bytes == 0) return "-";
+    if (bytes < 1024) snprintf(text, sizeof(text), "%lluB", (unsigned long long)bytes);
+    else if (bytes < 1024 * 1024) snprintf(text, sizeof(text), "%.1fK", bytes / 1024.0);
+    else if (bytes < 1024ULL * 1024 * 1024) snprintf(text, sizeof(text), "%.1fM", bytes / (1024.0 * 1024));
+    else snprintf(text, sizeof(text), "%.2fG", bytes / (1024.0 * 1024 * 1024));
+    return text;
+}
+
+/**
+ * @brief Allocates through the tracker.
+ */
+void* operator new(std::size_t size) {
+    if (void* block = AllocationTracker::allocate(size)) return block;
+    throw std::bad_alloc();
+}
+
+/**
+ * @brief Allocates an array through the tracker.
+ */
+void* operator new[](std::size_t size) {
+    if (void* block = AllocationTracker::allocate(size)) return block;
+    throw std::bad_alloc();
+}
+
+/**
+ * @brief Allocates through the tracker, nullptr on failure.
+ */
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return AllocationTracker::allocate(size);
+}
+
+/**
+ * @brief Allocates an array through the tracker, nullptr on failure.
+ */
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return AllocationTracker::allocate(size);
+}
+
+/**
+ * @brief Frees a block from the tracker.
+ */
+void operator delete(void* block) noexcept {
+    AllocationTracker::release(block);
+}
+
+/**
+ * @brief Frees an array from the tracker.
+ */
+void operator delete[](void* block) noexcept {
+    AllocationTracker::release(block);
+}
+
+/**
+ * @brief Frees a block from the tracker; the header knows the size.
+ */
+void operator delete(void* block, std::size_t) noexcept {
+    AllocationTracker::release(block);
+}
+
+/**
+ * @brief Frees an array from the tracker; the header knows the size.
+ */
+void operator delete[](void* block, std::size_t) noexcept {
+    AllocationTracker::release(block);
+}
+
+/**
+ * @brief Frees a block from the nothrow operator new.
+ */
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+    AllocationTracker::release(block);
+}
+
+/**
+ * @brief Frees an array from the nothrow operator new[].
+ */
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+    AllocationTracker::release(block);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file AllocationTracker.h
+ * @brief Header file for the AllocationTracker class, which accounts heap memory to the subsystem that asked for it.
+ *
+ * The global operator new and delete are replaced. Each block gets a small header
+ * holding its size and the tag that was current when it was allocated, so freeing it
+ * takes the bytes off the same tag, whichever code frees it. A Scope sets the tag of
+ * the current thread: the innermost scope wins, and code outside any scope counts as
+ * "other". While tracking is off, new and delete only add the header and one load.
+ */
+
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <ncurses.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class AllocationTracker {
+public:
+    enum Tag {
+        Other,          ///< Anything outside a tagged scope
+        Buffer,         ///< Editing the lines of a note
+        Render,         ///< Drawing panes, the board and the calendar
+        Tasks,          ///< Kanban boards and their tasks
+        Events,         ///< Calendar events
+        FileIO,         ///< Reading and writing notes
+        TAG_COUNT
+    };
+
+    struct Usage {
+        std::uint64_t live = 0;             ///< Bytes allocated and not freed yet
+        std::uint64_t peak = 0;             ///< Most live bytes at once
+        std::uint64_t allocations = 0;
+        std::uint64_t allocated = 0;        ///< Bytes ever allocated
+    };
+
+    // Tags the allocations of the current thread until destroyed
+    class Scope {
+    public:
+        explicit Scope(Tag tag) : previous(current) { current = tag; }
+        ~Scope() { current = previous; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Tag previous;
+    };
+
+    // Turns counting and the overlay on or off
+    static void toggle();
+    static void enable();
+    static bool isEnabled();
+
+    // The usage of a tag, or of all tags with TAG_COUNT
+    static Usage usage(Tag tag);
+    static const char* tagName(Tag tag);
+
+    // Draws live bytes, peak and allocation rate in the bottom right corner of a window
+    static void drawOverlay(WINDOW* win);
+
+    // Writes the usage of every tag to a file if anything was counted
+    static void dump(const std::string& path);
+
+    // Used by the global operator new and delete
+    static void* allocate(std::size_t size) noexcept;
+    static void release(void* block) noexcept;
+
+private:
+    struct Counters {
+        std::atomic<std::int64_t> live;
+        std::atomic<std::uint64_t> peak;
+        std::atomic<std::uint64_t> allocations;
+        std::atomic<std::uint64_t> allocated;
+    };
+
+    static inline std::atomic<bool> enabled{false};
+    static inline thread_local Tag current = Other;
+    static Counters counters[TAG_COUNT + 1];    ///< One per tag and the total, zeroed as static storage
+
+    static void raisePeak(Counters& target, std::int64_t live);
+    static std::string formatBytes(std::uint64_t bytes);
+};
+
+#endif // ALLOCATION_TRACKER_H
@@ -1,5 +1,14 @@
 #include "Application.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include "RenderBackend.h"
+#include <cstdlib>
+#include <string>
 #include <ncurses.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+volatile sig_atomic_t Application::resize_pending_ = 0;
 
 /**
  * @brief Default constructor for Application
@@ -8,8 +17,7 @@
  * Actual windows created in initalize().
  */
 Application::Application() 
-    : main_menu_(nullptr),
-      terminal_editor_(nullptr, nullptr, nullptr, {}) {
+    : main_menu_(nullptr) {
 }
 
 /**
@@ -19,6 +27,9 @@ Application::Application()
  */
 Application::~Application() {
     cleanup();
+    RenderBackend::use(nullptr);
+    InputDecoder::use(nullptr);
+    panes_.releaseWindows();  // Subwindows must go before the main window
 }
 
 /**
@@ -27,16 +38,59 @@ Application::~Application() {
  *
  * Sets up ncurses enviroment and creates windows.
  * Needs to be called before running main app loop.
+ * The resize handler is installed first, so ncurses leaves SIGWINCH to it.
  */
 bool Application::initialize() {
-    if (!ncurses_setup_.initialize()) {
+    // No SA_RESTART, so a resize wakes up the wait for a key with ERR
+    struct sigaction action {};
+    action.sa_handler = on_resize_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGWINCH, &action, nullptr);
+
+    // NEONOTE_TRACK_ALLOCATIONS=1 counts from startup, so the notes and boards loaded first are included
+    const char* track = getenv("NEONOTE_TRACK_ALLOCATIONS");
+    if (track && std::string(track) == "1") {
+        AllocationTracker::enable();
+    }
+
+    // NEONOTE_SYNC=0 lets ncurses write to the terminal as it goes instead of once per frame, synchronized
+    const char* sync = getenv("NEONOTE_SYNC");
+    const bool synchronized = !(sync && std::string(sync) == "0");
+
+    // NEONOTE_RENDERER=direct writes frames with EscapeBackend instead of ncurses
+    const char* renderer = getenv("NEONOTE_RENDERER");
+    if (renderer && std::string(renderer) == "direct") {
+        if (!ncurses_setup_.initializeDirect()) {
+            return false;
+        }
+        escape_backend_ = std::make_unique<EscapeBackend>(STDOUT_FILENO, synchronized);
+        RenderBackend::use(escape_backend_.get());
+    } else if (synchronized) {
+        curses_backend_ = std::make_unique<CursesBackend>(STDOUT_FILENO);
+        if (!curses_backend_->capture() || !ncurses_setup_.initializeDirect(curses_backend_->capture())) {
+            return false;
+        }
+        RenderBackend::use(curses_backend_.get());
+    } else if (!ncurses_setup_.initialize()) {
         return false;
     }
+    input_decoder_ = std::make_unique<InputDecoder>(STDIN_FILENO, STDOUT_FILENO);
+    InputDecoder::use(input_decoder_.get());
 
     create_windows();
     return true;
 }
 
+/**
+ * @brief Records that the terminal was resized
+ * @param signal The signal number, always SIGWINCH
+ *
+ * Only sets a flag; the main loop lays out the windows once the resizing stops.
+ */
+void Application::on_resize_signal(int) {
+    resize_pending_ = 1;
+}
+
 /**
  * @brief Deletes Window object
  * @param win Window pointer to deleted window
@@ -54,7 +108,7 @@ void Application::WindowDeleter::operator()(WINDOW* win) const {
  * @brief Creates and initializes parent container for all UI elements
  *
  * Creates the main window container and divides it into sidebar and content area.
- * Initializes the main menue
+ * The content area starts as a single pane. Initializes the main menue
  */
 void Application::create_windows() {
     main_window_ = std::unique_ptr<WINDOW, WindowDeleter>(
@@ -62,16 +116,15 @@ void Application::create_windows() {
 
     auto [sidebar_width, content_width] = calculate_layout(COLS);
 
-    // Create sidebar and content windows in container
+    // Create the sidebar window in container, the panes get theirs in setup_window_layout
     sidebar_ = std::unique_ptr<WINDOW, WindowDeleter>(
         derwin(main_window_.get(), LINES, sidebar_width, 0, 0), WindowDeleter());
-    content_ = std::unique_ptr<WINDOW, WindowDeleter>(
-        derwin(main_window_.get(), LINES, content_width, 0, sidebar_width), WindowDeleter());
     
     // Initialize main menu in the window
     setup_window_layout(LINES, COLS);
+    previous_dimensions_ = {LINES, COLS};
     main_menu_ = MainMenu(main_window_.get());
-    refresh();
+    wnoutrefresh(stdscr);
 }
 
 /**
@@ -93,7 +146,8 @@ std::pair<int, int> Application::calculate_layout(int total_cols) const {
  * @param cols Current number of columns
  *
  * Handles resizing and repositioning of all windows when terminal dimentiosn change.
- * Redraws borders and refreshes all windows to maintain consistant appearance.
+ * The panes split the content area again in the same proportions. Nothing is sent
+ * to the terminal here, the caller draws the new layout in one frame.
  */
 void Application::setup_window_layout(int lines, int cols) {
     // Calculate new dimentions
@@ -102,22 +156,14 @@ void Application::setup_window_layout(int lines, int cols) {
     // Resize main window first
     wresize(main_window_.get(), lines, cols); 
     werase(main_window_.get());
-    wrefresh(main_window_.get());
     
     // Resize and reposition subwindows
     wresize(sidebar_.get(), lines, sidebar_width);
-    wresize(content_.get(), lines, content_width);
     mvwin(sidebar_.get(), 0, 0);
-    mvwin(content_.get(), 0, sidebar_width);
+    panes_.layout(main_window_.get(), 0, sidebar_width, lines, content_width);
     
     // Redraw borders
     box(sidebar_.get(), 0, 0);
-    box(content_.get(), 0, 0);
-    
-    // Refresh all windows
-    wrefresh(sidebar_.get());
-    wrefresh(content_.get());
-    wrefresh(main_window_.get());
 }
 
 /**
@@ -126,12 +172,17 @@ void Application::setup_window_layout(int lines, int cols) {
  *
  * Initializes the application and enters the main app loop
  * Returns when the user exits NeoNote
+ * If the last session was saved, the editor opens straight where it was left.
  */
 int Application::run() {
     if (!initialize()) {
         return 1;
     }
 
+    Session session;
+    if (session.load()) {
+        open_editor(&session);
+    }
     main_loop();
     return 0;
 }
@@ -148,7 +199,7 @@ void Application::main_loop() {
         
         if (current_window_ == WindowState::MainMenu) {
             wclear(main_window_.get());
-            refresh();
+            wnoutrefresh(stdscr);
 	    handle_main_menu();
         } else {
             handle_editor();
@@ -159,32 +210,51 @@ void Application::main_loop() {
 /**
  * @brief Handles terminal resize events
  *
- * Checks for terminal dimension changes and updates the window accordingly.
- * Maintains UI consistency across resizes.
+ * Does nothing unless a SIGWINCH arrived. Dragging the edge of a terminal sends
+ * many signals, so it first waits until none arrived for RESIZE_SETTLE_MS; a key
+ * pressed meanwhile ends the wait and is read afterwards. The new size is then
+ * applied once, the windows are laid out if it changed, and the screen is redrawn.
  */
 
 void Application::handle_resize() {
+    if (!resize_pending_) {
+        return;
+    }
+
+    // Coalesce the burst of signals, each one interrupts the wait
+    int key = ERR;
+    while (resize_pending_ && key == ERR) {
+        resize_pending_ = 0;
+        key = InputDecoder::get(stdscr, RESIZE_SETTLE_MS);
+    }
+    if (key != ERR) {
+        InputDecoder::unget(key);
+    }
+
     // Retrieve terminal size
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+        resize_term(size.ws_row, size.ws_col);
+    }
+    RenderBackend::active().invalidate();  // The terminal may have reflowed what was on screen
+    // Copy the resized stdscr now, or the next readKey would paint it over the windows
+    werase(stdscr);
+    wnoutrefresh(stdscr);
     int current_lines, current_cols;
     getmaxyx(stdscr, current_lines, current_cols);
 
-    // Redraw if size changed
+    // Lay out again only if the size changed
     if (current_cols != previous_dimensions_.cols || current_lines != previous_dimensions_.lines) {
-        
-        // Blanks entire terminal and refreshes
-        werase(main_window_.get());
-        refresh();
-
         setup_window_layout(current_lines, current_cols);
         previous_dimensions_ = {current_lines, current_cols};
+    }
 
-        if (current_window_ == WindowState::MainMenu) {
-            main_menu_.display();
-        }
-	else if (current_window_ == WindowState::Editor) {
-            const int sidebar_width = static_cast<int>(current_cols * SIDEBAR_WIDTH_RATIO);        
-	    terminal_editor_.redraw(sidebar_width);
-        }
+    if (current_window_ == WindowState::MainMenu) {
+        main_menu_.display();
+    }
+    else if (current_window_ == WindowState::Editor) {
+        const int sidebar_width = static_cast<int>(current_cols * SIDEBAR_WIDTH_RATIO);        
+        terminal_editor_->redraw(sidebar_width);
     }
 }
 /**
@@ -195,21 +265,37 @@ void Application::handle_resize() {
  */
 void Application::handle_main_menu() {
     main_menu_.display();
-    const int input = getch();
+    const int input = RenderBackend::readKey();
+    if (input == ERR) {
+        return;  // Interrupted by a resize
+    }
     main_menu_.handleInput(input);
 
     if (main_menu_.shouldExit()) {
         running_ = false;
     } else if (main_menu_.getCurrentWindow() != 0) { ///< "new note"
 	// Creates new editor instance
-        current_window_ = WindowState::Editor;
-        terminal_editor_ = TerminalEditor(main_window_.get(), 
-                                        sidebar_.get(), 
-                                        content_.get(), 
-                                        {});
+        Session session;
+        open_editor(session.load() ? &session : nullptr);
     }
 }
 
+/**
+ * @brief Creates the editor and switches to it
+ * @param session The last session to open where it was left, nullptr to open the first note
+ *
+ * The previous editor is destroyed first, its notes were saved when it was left.
+ */
+void Application::open_editor(const Session* session) {
+    terminal_editor_.reset();
+    terminal_editor_ = std::make_unique<TerminalEditor>(main_window_.get(),
+                                                        sidebar_.get(),
+                                                        &panes_,
+                                                        std::vector<std::string>{},
+                                                        session);
+    current_window_ = WindowState::Editor;
+}
+
 /**
  * @brief Handles editor interaction
  *
@@ -220,15 +306,21 @@ void Application::handle_editor() {
     while (current_window_ == WindowState::Editor) {
         handle_resize();
      
-        const int input = getch();
+        // Wake up now and then while a restored session is checked against the disk
+        const int timeout = terminal_editor_->checkCatalog() ? CATALOG_POLL_MS : -1;
+        const int input = RenderBackend::readKey(stdscr, timeout);
+        if (input == ERR) {
+            continue;  // Interrupted by a resize, handled at the top of the loop, or no key yet
+        }
         if (input == MENU_SHORTCUT) {
-            terminal_editor_.cleanup();
+            terminal_editor_->cleanup();
             main_menu_.returnToMenu();
 	    current_window_ = WindowState::MainMenu;
             break;
         }
         
-        terminal_editor_.handleInput(input);
+        Profiler::Scope timer(Profiler::Keystroke);
+        terminal_editor_->handleInput(input);
     }
 }
 
@@ -242,9 +334,6 @@ void Application::cleanup() {
     if (sidebar_) {
         wclear(sidebar_.get());
     }
-    if (content_) {
-        wclear(content_.get());
-    }
     if (main_window_) {
         wclear(main_window_.get());
     }
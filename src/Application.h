@@ -9,11 +9,17 @@
 #define APPLICATION_H
 
 #include <ncurses.h>
+#include <csignal>
 #include <memory>
 #include <vector>
 #include "TerminalEditor.h"
+#include "PaneTree.h"
 #include "MainMenu.h"
 #include "NcursesSetup.h"
+#include "EscapeBackend.h"
+#include "CursesBackend.h"
+#include "InputDecoder.h"
+#include "Session.h"
 #include "Settings.h"
 
 /**
@@ -22,7 +28,10 @@
  * @Author Runcong Zhu
  *
  * Handles initialization, window management, and the main event loop for NeoNote.
- * Manages transitions between main menu and editor and handles resizes.
+ * Manages transitions between main menu and editor and handles resizes. A saved
+ * session skips the main menu and opens the editor where it was left. The area
+ * right of the sidebar is a tree of panes that can be split side by side or stacked.
+ * Resizes arrive as SIGWINCH signals; a burst of them is laid out and drawn once.
  */
 class Application {
 public:
@@ -46,10 +55,12 @@ private:
     };
 
     bool initialize();
+    static void on_resize_signal(int signal);
     void create_windows();
     void main_loop();
     void handle_resize();
     void handle_main_menu();
+    void open_editor(const Session* session);
     void handle_editor();
     void cleanup();
 
@@ -58,10 +69,15 @@ private:
     int calculate_sidebar_width(int current_cols = COLS) const;
 
     static constexpr double SIDEBAR_WIDTH_RATIO = 0.25; 
+    static volatile sig_atomic_t resize_pending_;
 
+    std::unique_ptr<CursesBackend> curses_backend_;   // Set when ncurses frames are sent synchronized, outlives endwin
     NcursesSetup ncurses_setup_;
+    std::unique_ptr<EscapeBackend> escape_backend_;   // Set when frames are written without ncurses
+    std::unique_ptr<InputDecoder> input_decoder_;     // Goes first, while the terminal is still on the alternate screen
     MainMenu main_menu_;
-    TerminalEditor terminal_editor_;
+    PaneTree panes_;
+    std::unique_ptr<TerminalEditor> terminal_editor_;   // Created when the editor is opened
     WindowState current_window_{WindowState::MainMenu};
     bool running_{true};
     Dimensions previous_dimensions_;
@@ -69,7 +85,6 @@ private:
     // Smart pointers managing windows
     std::unique_ptr<WINDOW, WindowDeleter> main_window_{nullptr};
     std::unique_ptr<WINDOW, WindowDeleter> sidebar_{nullptr};
-    std::unique_ptr<WINDOW, WindowDeleter> content_{nullptr};
 };
 
 #endif // APPLICATION_H
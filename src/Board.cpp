@@ -0,0 +1,590 @@
+#include "Board.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+/**
+ * @brief Constructs a Board without reading its tasks.
+ *
+ * @param name The name shown for the board.
+ * @param dir The directory holding the board's files, with a trailing slash.
+ */
+Board::Board(const std::string& name, const std::string& dir) : name(name), dir(dir) {}
+
+/**
+ * @brief Gets the name of the board.
+ * @return The board name.
+ */
+const std::string& Board::getName() const { return name; }
+
+/**
+ * @brief Checks whether the board's tasks have been read from disk.
+ * @return `true` once load() has run.
+ */
+bool Board::isLoaded() const { return loaded; }
+
+/**
+ * @brief Column names used when a board has no `columns` file.
+ * @return "To Do", "In Progress" and "Done".
+ */
+std::vector<std::string> Board::defaultColumns() {
+    return {"To Do", "In Progress", "Done"};
+}
+
+/**
+ * @brief Reads the board's columns, tags and tasks from its directory.
+ *
+ * Tasks are linked into their columns in ID order. Tasks whose status is past
+ * the last column are shown in the last column. Task files written before
+ * descriptions, priorities, due dates and tags existed only hold a title and a
+ * status, the other fields are left empty. Does nothing if the board is already loaded.
+ */
+void Board::load() {
+    if (loaded) return;
+    loaded = true;
+
+    std::filesystem::create_directories(dir);
+
+    std::vector<std::string> names;
+    std::ifstream columnsFile(dir + "columns");
+    std::string line;
+    while (std::getline(columnsFile, line)) {
+        if (!line.empty()) names.push_back(line);
+    }
+    if (names.empty()) names = defaultColumns();
+    for (const std::string& columnName : names) {
+        columns.push_back(Column{columnName});
+    }
+
+    std::ifstream tagsFile(dir + "tags");
+    while (std::getline(tagsFile, line) && (int)tagNames.size() < Task::MAX_TAGS) {
+        if (!line.empty()) tagNames.push_back(line);
+    }
+
+    std::vector<Task> loadedTasks;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (!entry.is_regular_file()) continue;
+
+        int taskId = 0;
+        try {
+            taskId = std::stoi(entry.path().filename().string());
+        } catch (const std::exception&) {
+            continue;  // Not a task file
+        }
+
+        std::ifstream inFile(entry.path());
+        std::string title, status, description, priority, dueDate, tags, note;
+        if (!std::getline(inFile, title) || !std::getline(inFile, status)) continue;
+        std::getline(inFile, description);
+        std::getline(inFile, priority);
+        std::getline(inFile, dueDate);
+        std::getline(inFile, tags);
+        std::getline(inFile, note);
+
+        int type = std::atoi(status.c_str());
+        if (type < 0) continue;
+
+        Task task(taskId, title, std::min(type, columnCount() - 1), description);
+        task.setPriority(std::atoi(priority.c_str()));
+        task.setDueDate(Task::parseDate(dueDate));
+
+        std::uint64_t tagBits = 0;
+        std::stringstream tagStream(tags);
+        std::string tag;
+        while (std::getline(tagStream, tag, ',')) {
+            int bit = findTag(tag, true);
+            if (bit >= 0) tagBits |= std::uint64_t(1) << bit;
+        }
+        task.setTags(tagBits);
+        task.setNote(note);
+
+        loadedTasks.push_back(task);
+    }
+
+    // Directory order is arbitrary, keep columns in creation order
+    std::sort(loadedTasks.begin(), loadedTasks.end(),
+              [](const Task& a, const Task& b) { return a.getId() < b.getId(); });
+    pool.reserve(loadedTasks.size());
+    for (const Task& task : loadedTasks) {
+        insertTask(task);
+    }
+}
+
+/**
+ * @brief Initializes a new, empty board on disk with the given columns.
+ *
+ * @param columnNames The column names, or an empty list for the default columns.
+ */
+void Board::create(const std::vector<std::string>& columnNames) {
+    loaded = true;
+    columns.clear();
+    for (const std::string& columnName : columnNames.empty() ? defaultColumns() : columnNames) {
+        columns.push_back(Column{columnName});
+    }
+    writeColumns();
+}
+
+/**
+ * @brief Gets the number of columns on the board.
+ * @return The column count.
+ */
+int Board::columnCount() const { return (int)columns.size(); }
+
+/**
+ * @brief Gets a column by index.
+ * @param type The column index.
+ * @return The column.
+ */
+const Board::Column& Board::getColumn(int type) const { return columns[type]; }
+
+/**
+ * @brief Appends a new empty column and saves the column list.
+ * @param columnName The name of the new column.
+ */
+void Board::addColumn(const std::string& columnName) {
+    columns.push_back(Column{columnName});
+    for (Index& index : indexes) {
+        index.columns.emplace_back();
+    }
+    writeColumns();
+}
+
+/**
+ * @brief Gets the pool entry for a slot.
+ * @param slot The pool slot.
+ * @return The task and its list links.
+ */
+const Board::Node& Board::getNode(int slot) const { return pool[slot]; }
+
+/**
+ * @brief Looks up the pool slot of a task.
+ * @param taskId The ID of the task.
+ * @return The slot, or -1 if no task has this ID.
+ */
+int Board::findSlot(int taskId) const {
+    auto found = slotById.find(taskId);
+    return found == slotById.end() ? -1 : found->second;
+}
+
+/**
+ * @brief Finds the next available task ID.
+ *
+ * The largest ID in use is tracked as tasks are added, so this is constant time.
+ *
+ * @return The next free task ID.
+ */
+int Board::nextFree() const { return maxId + 1; }
+
+/**
+ * @brief Stores a task in the pool and appends it to the column given by its status.
+ *
+ * Reuses a free slot when one is available. Runs in constant time.
+ *
+ * @param task The task to store.
+ * @return The pool slot holding the task.
+ */
+int Board::insertTask(const Task& task) {
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        pool[slot] = Node{task, -1, -1, 0};
+    } else {
+        slot = (int)pool.size();
+        pool.push_back(Node{task, -1, -1, 0});
+    }
+
+    slotById[task.getId()] = slot;
+    maxId = std::max(maxId, task.getId());
+    linkTail(task.getStatus(), slot);
+    return slot;
+}
+
+/**
+ * @brief Creates a task with the next free ID, adds it to a column and saves it.
+ *
+ * @param title The title of the task.
+ * @param type The column to add the task to.
+ * @param note The note holding the task's checkbox, empty if none.
+ * @return The pool slot holding the task.
+ */
+int Board::addTask(const std::string& title, int type, const std::string& note) {
+    Task task(nextFree(), title, type);
+    task.setNote(note);
+    int slot = insertTask(task);
+    writeTask(pool[slot].task);
+    return slot;
+}
+
+/**
+ * @brief Removes a task from its column and deletes its file.
+ * @param slot The pool slot of the task.
+ */
+void Board::removeTask(int slot) {
+    int taskId = pool[slot].task.getId();
+    unlink(slot);
+    slotById.erase(taskId);
+    pool[slot].task = Task(-1, "", 0);
+    freeSlots.push_back(slot);
+
+    std::string filePath = dir + std::to_string(taskId);
+    if (std::filesystem::exists(filePath)) {
+        std::filesystem::remove(filePath);
+    }
+}
+
+/**
+ * @brief Moves a task to the end of another column and saves its new status.
+ * @param slot The pool slot of the task.
+ * @param type The column to move to.
+ */
+void Board::moveTask(int slot, int type) {
+    unlink(slot);
+    linkTail(type, slot);
+    writeTask(pool[slot].task);
+}
+
+/**
+ * @brief Changes the title of a task and saves it.
+ * @param slot The pool slot of the task.
+ * @param title The new title.
+ */
+void Board::renameTask(int slot, const std::string& title) {
+    pool[slot].task.setTitle(title);
+    writeTask(pool[slot].task);
+}
+
+/**
+ * @brief Links a task to the note holding its checkbox and saves it.
+ * @param slot The pool slot of the task.
+ * @param note The note name, or an empty string to unlink the task.
+ */
+void Board::linkNote(int slot, const std::string& note) {
+    pool[slot].task.setNote(note);
+    writeTask(pool[slot].task);
+}
+
+/**
+ * @brief Updates the description, priority, due date and tags of a task and saves it.
+ *
+ * The task is taken out of every secondary index and put back, so views sorted
+ * by due date or priority stay ordered.
+ *
+ * @param slot The pool slot of the task.
+ * @param description The new description.
+ * @param priority The new priority.
+ * @param dueDate The new packed due date, 0 for none.
+ * @param tags The new tag bits.
+ */
+void Board::updateTask(int slot, const std::string& description, int priority,
+                       std::uint32_t dueDate, std::uint64_t tags) {
+    removeFromIndexes(slot);
+
+    Task& task = pool[slot].task;
+    task.setDescription(description);
+    task.setPriority(priority);
+    task.setDueDate(dueDate);
+    task.setTags(tags);
+
+    addToIndexes(slot);
+    writeTask(task);
+}
+
+/**
+ * @brief Appends a pool slot to the end of a column and sets its status.
+ *
+ * The slot gets the next manual order position and is added to the secondary indexes.
+ *
+ * @param type The column to append to.
+ * @param slot The pool slot to link.
+ */
+void Board::linkTail(int type, int slot) {
+    Column& column = columns[type];
+    Node& node = pool[slot];
+
+    node.task.setStatus(type);
+    node.seq = nextSeq++;
+    node.prev = column.tail;
+    node.next = -1;
+    if (column.tail != -1) {
+        pool[column.tail].next = slot;
+    } else {
+        column.head = slot;
+    }
+    column.tail = slot;
+    column.size++;
+
+    addToIndexes(slot);
+}
+
+/**
+ * @brief Removes a pool slot from its column and from the secondary indexes.
+ *
+ * @param slot The pool slot to unlink.
+ */
+void Board::unlink(int slot) {
+    removeFromIndexes(slot);
+
+    Node& node = pool[slot];
+    Column& column = columns[node.task.getStatus()];
+
+    if (node.prev != -1) pool[node.prev].next = node.next;
+    else column.head = node.next;
+    if (node.next != -1) pool[node.next].prev = node.prev;
+    else column.tail = node.prev;
+    column.size--;
+
+    node.prev = node.next = -1;
+}
+
+/**
+ * @brief Gets the first task of a column in the order of a view.
+ *
+ * @param type The column.
+ * @param view The order and filter to use.
+ * @return The slot of the first task, or -1 if no task of the column is in the view.
+ */
+int Board::first(int type, const View& view) {
+    if (view.order == SortOrder::Manual && view.tag < 0) return columns[type].head;
+
+    const auto& entries = indexFor(view).columns[type];
+    return entries.empty() ? -1 : entries.begin()->second;
+}
+
+/**
+ * @brief Gets the last task of a column in the order of a view.
+ *
+ * @param type The column.
+ * @param view The order and filter to use.
+ * @return The slot of the last task, or -1 if no task of the column is in the view.
+ */
+int Board::last(int type, const View& view) {
+    if (view.order == SortOrder::Manual && view.tag < 0) return columns[type].tail;
+
+    const auto& entries = indexFor(view).columns[type];
+    return entries.empty() ? -1 : entries.rbegin()->second;
+}
+
+/**
+ * @brief Gets the task after another one in the order of a view.
+ *
+ * Constant time in manual order, logarithmic in the column size otherwise.
+ *
+ * @param slot A task in the view.
+ * @param view The order and filter to use.
+ * @return The slot of the next task, or -1 if it was the last one.
+ */
+int Board::next(int slot, const View& view) {
+    if (view.order == SortOrder::Manual && view.tag < 0) return pool[slot].next;
+
+    const auto& entries = indexFor(view).columns[pool[slot].task.getStatus()];
+    auto found = entries.find({sortKey(view, slot), slot});
+    if (found == entries.end() || ++found == entries.end()) return -1;
+    return found->second;
+}
+
+/**
+ * @brief Gets the task before another one in the order of a view.
+ *
+ * Constant time in manual order, logarithmic in the column size otherwise.
+ *
+ * @param slot A task in the view.
+ * @param view The order and filter to use.
+ * @return The slot of the previous task, or -1 if it was the first one.
+ */
+int Board::prev(int slot, const View& view) {
+    if (view.order == SortOrder::Manual && view.tag < 0) return pool[slot].prev;
+
+    const auto& entries = indexFor(view).columns[pool[slot].task.getStatus()];
+    auto found = entries.find({sortKey(view, slot), slot});
+    if (found == entries.end() || found == entries.begin()) return -1;
+    return (--found)->second;
+}
+
+/**
+ * @brief Checks whether a task passes the filter of a view.
+ *
+ * @param slot The pool slot of the task.
+ * @param view The view.
+ * @return `true` if the task is shown in the view.
+ */
+bool Board::inView(int slot, const View& view) const {
+    return view.tag < 0 || pool[slot].task.hasTag(view.tag);
+}
+
+/**
+ * @brief Gets the secondary index for a view, building it the first time it is used.
+ *
+ * Building sorts the board once; afterwards the index is kept up to date as tasks
+ * are added, moved, edited and removed, so switching back to the view is free.
+ *
+ * @param view The view to index.
+ * @return The index.
+ */
+Board::Index& Board::indexFor(const View& view) {
+    for (Index& index : indexes) {
+        if (index.view.order == view.order && index.view.tag == view.tag) {
+            return index;
+        }
+    }
+
+    indexes.push_back(Index{view, std::vector<std::set<std::pair<std::uint64_t, int>>>(columns.size())});
+    Index& index = indexes.back();
+    for (int type = 0; type < columnCount(); ++type) {
+        for (int slot = columns[type].head; slot != -1; slot = pool[slot].next) {
+            if (inView(slot, view)) {
+                index.columns[type].emplace_hint(index.columns[type].end(), sortKey(view, slot), slot);
+            }
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief Computes the key a task is ordered by in a view.
+ *
+ * The high half holds the sort field (tasks without a due date last, higher
+ * priorities first) and the low half the manual order, which breaks ties.
+ *
+ * @param view The view.
+ * @param slot The pool slot of the task.
+ * @return The sort key.
+ */
+std::uint64_t Board::sortKey(const View& view, int slot) const {
+    const Node& node = pool[slot];
+    std::uint64_t primary = 0;
+    switch (view.order) {
+        case SortOrder::Manual:
+            break;
+        case SortOrder::Due:
+            primary = node.task.getDueDate() ? node.task.getDueDate() : UINT32_MAX;
+            break;
+        case SortOrder::Priority:
+            primary = Task::MAX_PRIORITY - node.task.getPriority();
+            break;
+    }
+    return (primary << 32) | node.seq;
+}
+
+/**
+ * @brief Adds a linked task to every built index whose view shows it.
+ *
+ * @param slot The pool slot of the task.
+ */
+void Board::addToIndexes(int slot) {
+    int type = pool[slot].task.getStatus();
+    for (Index& index : indexes) {
+        if (inView(slot, index.view)) {
+            index.columns[type].emplace(sortKey(index.view, slot), slot);
+        }
+    }
+}
+
+/**
+ * @brief Removes a linked task from every built index.
+ *
+ * @param slot The pool slot of the task.
+ */
+void Board::removeFromIndexes(int slot) {
+    int type = pool[slot].task.getStatus();
+    for (Index& index : indexes) {
+        index.columns[type].erase({sortKey(index.view, slot), slot});
+    }
+}
+
+/**
+ * @brief Gets the names of the board's tags, indexed by tag bit.
+ *
+ * @return The tag names.
+ */
+const std::vector<std::string>& Board::getTagNames() const {
+    return tagNames;
+}
+
+/**
+ * @brief Looks up the bit of a tag, optionally adding it to the board.
+ *
+ * @param tag The tag name, surrounding spaces are ignored.
+ * @param create Whether to add the tag if the board does not have it yet.
+ * @return The tag's bit, or -1 if it does not exist or the board has MAX_TAGS tags.
+ */
+int Board::findTag(const std::string& tag, bool create) {
+    size_t start = tag.find_first_not_of(' ');
+    if (start == std::string::npos) return -1;
+    std::string trimmed = tag.substr(start, tag.find_last_not_of(' ') - start + 1);
+
+    for (int bit = 0; bit < (int)tagNames.size(); ++bit) {
+        if (tagNames[bit] == trimmed) return bit;
+    }
+    if (!create || (int)tagNames.size() >= Task::MAX_TAGS) return -1;
+
+    tagNames.push_back(trimmed);
+    writeTags();
+    return (int)tagNames.size() - 1;
+}
+
+/**
+ * @brief Formats tag bits as a comma separated list of tag names.
+ *
+ * @param tags The tag bits.
+ * @return The tag names.
+ */
+std::string Board::formatTags(std::uint64_t tags) const {
+    std::string result;
+    for (int bit = 0; bit < (int)tagNames.size(); ++bit) {
+        if ((tags >> bit) & 1) {
+            if (!result.empty()) result += ",";
+            result += tagNames[bit];
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Writes a task to its file in the board directory.
+ *
+ * @param task The task to save.
+ */
+void Board::writeTask(const Task& task) const {
+    // Create the directory if it doesn't exist
+    std::filesystem::create_directories(dir);
+
+    // Write the task to a file with ID as filename
+    std::ofstream outFile(dir + std::to_string(task.getId()));
+    if (outFile.is_open()) {
+        outFile << task.getTitle() << "\n";
+        outFile << task.getStatus() << "\n";
+        outFile << task.getDescription() << "\n";
+        outFile << task.getPriority() << "\n";
+        outFile << Task::formatDate(task.getDueDate()) << "\n";
+        outFile << formatTags(task.getTags()) << "\n";
+        outFile << task.getNote() << "\n";
+        outFile.close();
+    }
+}
+
+/**
+ * @brief Writes the column names to the board's `columns` file.
+ */
+void Board::writeColumns() const {
+    std::filesystem::create_directories(dir);
+
+    std::ofstream outFile(dir + "columns");
+    for (const Column& column : columns) {
+        outFile << column.name << "\n";
+    }
+}
+
+/**
+ * @brief Writes the tag names to the board's `tags` file, one per line in bit order.
+ */
+void Board::writeTags() const {
+    std::filesystem::create_directories(dir);
+
+    std::ofstream outFile(dir + "tags");
+    for (const std::string& tag : tagNames) {
+        outFile << tag << "\n";
+    }
+}
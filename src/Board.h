@@ -0,0 +1,118 @@
+/**
+ * @file Board.h
+ * @brief Header file for the Board class, a named kanban board with user-defined columns.
+ *
+ * Each board is stored in its own directory, one file per task plus a `columns`
+ * file listing the column names and a `tags` file listing the board's tags. Tasks
+ * are only read from disk the first time the board is opened.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "Task.h"
+#include <vector>
+#include <string>
+#include <set>
+#include <cstdint>
+#include <unordered_map>
+
+class Board {
+public:
+    // A task in the pool, linked into the list of its column
+    struct Node {
+        Task task;
+        int prev;
+        int next;
+        std::uint32_t seq;    ///< Position in the column's manual order
+    };
+
+    // Intrusive list of pool slots, in manual order
+    struct Column {
+        std::string name;
+        int head = -1;
+        int tail = -1;
+        int size = 0;
+    };
+
+    enum class SortOrder {
+        Manual,
+        Due,
+        Priority
+    };
+
+    // Order and filter used to walk a column
+    struct View {
+        SortOrder order = SortOrder::Manual;
+        int tag = -1;         ///< Only tasks with this tag, -1 for all tasks
+    };
+
+    Board(const std::string& name, const std::string& dir);
+
+    const std::string& getName() const;
+    bool isLoaded() const;
+    void load();
+    void create(const std::vector<std::string>& columnNames);
+
+    int columnCount() const;
+    const Column& getColumn(int type) const;
+    void addColumn(const std::string& name);
+
+    const Node& getNode(int slot) const;
+    int findSlot(int taskId) const;
+    int nextFree() const;
+
+    int addTask(const std::string& title, int type, const std::string& note = "");
+    void removeTask(int slot);
+    void moveTask(int slot, int type);
+    void renameTask(int slot, const std::string& title);
+    void linkNote(int slot, const std::string& note);
+    void updateTask(int slot, const std::string& description, int priority,
+                    std::uint32_t dueDate, std::uint64_t tags);
+
+    // Walking a column in the order of a view
+    int first(int type, const View& view);
+    int last(int type, const View& view);
+    int next(int slot, const View& view);
+    int prev(int slot, const View& view);
+    bool inView(int slot, const View& view) const;
+
+    const std::vector<std::string>& getTagNames() const;
+    int findTag(const std::string& tag, bool create);
+    std::string formatTags(std::uint64_t tags) const;
+
+    static std::vector<std::string> defaultColumns();
+
+private:
+    // Secondary index over one view, one ordered set of (sort key, slot) per column
+    struct Index {
+        View view;
+        std::vector<std::set<std::pair<std::uint64_t, int>>> columns;
+    };
+
+    std::string name;
+    std::string dir;
+    bool loaded = false;
+
+    std::vector<Node> pool;                    ///< Stable task storage, indexed by slot
+    std::vector<int> freeSlots;                ///< Slots released by removed tasks
+    std::unordered_map<int, int> slotById;     ///< Task ID -> pool slot
+    std::vector<Column> columns;
+    std::vector<std::string> tagNames;         ///< Tag name for each tag bit
+    std::vector<Index> indexes;                ///< Built the first time each view is used
+    int maxId = 0;
+    std::uint32_t nextSeq = 0;
+
+    int insertTask(const Task& task);
+    void linkTail(int type, int slot);
+    void unlink(int slot);
+    Index& indexFor(const View& view);
+    std::uint64_t sortKey(const View& view, int slot) const;
+    void addToIndexes(int slot);
+    void removeFromIndexes(int slot);
+    void writeTask(const Task& task) const;
+    void writeColumns() const;
+    void writeTags() const;
+};
+
+#endif // BOARD_H
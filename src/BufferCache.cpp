@@ -0,0 +1,115 @@
+#include "BufferCache.h"
+
+/**
+ * @brief Constructs an empty cache.
+ *
+ * @param budgetBytes The memory the parked buffers may take before clean ones are dropped.
+ */
+BufferCache::BufferCache(size_t budgetBytes) : budget(budgetBytes) {}
+
+/**
+ * @brief Parks a buffer as the most recently used one.
+ *
+ * The buffer's lines are moved, not copied, so parking takes constant time apart
+ * from the buffers that have to be dropped.
+ *
+ * @param name The name of the note.
+ * @param buffer The buffer, moved into the cache.
+ */
+void BufferCache::store(const std::string& name, Buffer&& buffer) {
+    remove(name);
+    used += buffer.bytes;
+    order.emplace_front(name, std::move(buffer));
+    index[name] = order.begin();
+    evict();
+}
+
+/**
+ * @brief Takes a parked buffer out of the cache.
+ *
+ * @param name The name of the note.
+ * @param buffer Set to the parked buffer if there is one.
+ * @return `true` if the note was parked.
+ */
+bool BufferCache::take(const std::string& name, Buffer& buffer) {
+    auto found = index.find(name);
+    if (found == index.end()) return false;
+
+    used -= found->second->second.bytes;
+    buffer = std::move(found->second->second);
+    order.erase(found->second);
+    index.erase(found);
+    return true;
+}
+
+/**
+ * @brief Looks at a parked buffer without taking it out of the cache.
+ *
+ * Used to draw notes that are shown in a pane without being edited. The buffer
+ * becomes the most recently used one, so notes on screen are the last to be dropped.
+ * The pointer is valid until the next call that stores or drops a buffer.
+ *
+ * @param name The name of the note.
+ * @return The parked buffer, or nullptr if the note is not parked.
+ */
+const BufferCache::Buffer* BufferCache::peek(const std::string& name) {
+    auto found = index.find(name);
+    if (found == index.end()) return nullptr;
+
+    order.splice(order.begin(), order, found->second);
+    return &order.front().second;
+}
+
+/**
+ * @brief Drops a parked buffer, for example because its note was deleted or rewritten on disk.
+ *
+ * @param name The name of the note.
+ */
+void BufferCache::remove(const std::string& name) {
+    auto found = index.find(name);
+    if (found == index.end()) return;
+
+    used -= found->second->second.bytes;
+    order.erase(found->second);
+    index.erase(found);
+}
+
+/**
+ * @brief Drops every parked buffer.
+ */
+void BufferCache::clear() {
+    order.clear();
+    index.clear();
+    used = 0;
+}
+
+/**
+ * @brief Estimates the memory a buffer's lines take.
+ *
+ * Counts the text and the string objects. Computed when a note is loaded or saved,
+ * which already walk every line, so parking a buffer does not have to.
+ *
+ * @param lines The lines of the buffer.
+ * @return The estimate in bytes.
+ */
+size_t BufferCache::footprint(const std::vector<std::string>& lines) {
+    size_t bytes = lines.capacity() * sizeof(std::string);
+    for (const std::string& line : lines) {
+        bytes += line.capacity();
+    }
+    return bytes;
+}
+
+/**
+ * @brief Drops the least recently used buffers until the cache fits its budget.
+ *
+ * The buffer parked last is never dropped, so the note just switched away from is
+ * always kept.
+ */
+void BufferCache::evict() {
+    while (used > budget && order.size() > 1) {
+        used -= order.back().second.bytes;
+        index.erase(order.back().first);
+        order.pop_back();
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * @file BufferCache.h
+ * @brief Header file for the BufferCache class, which keeps recently open notes in memory.
+ *
+ * Switching notes parks the open buffer here with its cursor, scroll position and
+ * wrap map, and switching back takes it out again without touching the disk. Buffers
+ * are kept in least recently used order. A note is saved before it is parked, so
+ * every buffer here matches its file. When their estimated memory goes over the
+ * budget, the least recently used buffers are dropped and will be read from disk
+ * the next time they are opened.
+ */
+
+#ifndef BUFFER_CACHE_H
+#define BUFFER_CACHE_H
+
+#include <vector>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <cstddef>
+#include "WrapMap.h"
+#include "Outline.h"
+#include "SyntaxCache.h"
+#include "TableMap.h"
+#include "TextStats.h"
+
+class BufferCache {
+public:
+    struct Buffer {
+        std::vector<std::string> lines;
+        int row = 0;
+        int col = 0;
+        int scroll_row = 0;
+        int scroll_col = 0;
+        WrapMap wrap;               ///< Wrapped rows of the lines, kept so they are not wrapped again
+        Outline outline;            ///< Headings and folds of the lines
+        SyntaxCache syntax;         ///< Token runs of the code blocks in the lines
+        TableMap tables;            ///< Tables in the lines and their column widths
+        TextStats stats;            ///< Word counts of the lines
+        size_t bytes = 0;           ///< Estimated memory, see footprint
+    };
+
+    BufferCache(size_t budgetBytes);
+
+    // Parks a buffer as the most recently used one, then evicts buffers over the budget
+    void store(const std::string& name, Buffer&& buffer);
+
+    // Takes a parked buffer out of the cache, returns false if it is not there
+    bool take(const std::string& name, Buffer& buffer);
+
+    // Marks a parked buffer as the most recently used one and returns it, or nullptr
+    const Buffer* peek(const std::string& name);
+
+    void remove(const std::string& name);
+    void clear();
+
+    // Estimates the memory a buffer's lines take
+    static size_t footprint(const std::vector<std::string>& lines);
+
+private:
+    using Entry = std::pair<std::string, Buffer>;
+
+    size_t budget;
+    size_t used = 0;
+    std::list<Entry> order;     ///< Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+    void evict();
+};
+
+#endif // BUFFER_CACHE_H
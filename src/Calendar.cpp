@@ -1,4 +1,5 @@
 #include "Calendar.h"
+#include "AllocationTracker.h"
 #include <iostream>
 #include <chrono>
 #include <ctime>
@@ -19,9 +20,20 @@ using namespace std;
  * @brief Constructor for the Calendar class.
  * @param content Pointer to the ncurses window where the calendar will be rendered.
  * @Author Gordon Xu
+ *
+ * The events are read the first time they are needed, so starting the editor
+ * does not wait for the events directory.
  */
-Calendar::Calendar(WINDOW *content): selectedEvent(-1), eventsScrollOffset(0) {
+Calendar::Calendar(WINDOW *content): selectedEvent(-1), eventsScrollOffset(0), loaded(false) {
     this->content = content;
+}
+
+/**
+ * @brief Reads every event from the events directory, creating it if needed.
+ */
+void Calendar::loadEvents() {
+    AllocationTracker::Scope tag(AllocationTracker::Events);
+    loaded = true;
     std::string path = getenv("HOME");
     path += "/.local/share/neonote/events";
 
@@ -69,9 +81,11 @@ Calendar::Calendar(WINDOW *content): selectedEvent(-1), eventsScrollOffset(0) {
  * 
  * This function creates a grid of sub-windows inside the `content` window to represent 
  * each day of the month. It displays the current month and year, highlights the current day, 
- * and organizes the days in a weekly format.
+ * and organizes the days in a weekly format. The terminal is updated by the next doupdate.
  */
 void Calendar::renderCalendar() {
+    if (!loaded) loadEvents();
+    AllocationTracker::Scope tag(AllocationTracker::Render);
     werase(content);
     box(content, 0, 0);
 
@@ -125,7 +139,7 @@ void Calendar::renderCalendar() {
             wattroff(dayWin, A_REVERSE);
         }
 
-        wrefresh(dayWin);
+        wnoutrefresh(dayWin);
 
         // Move to the next day position
         startX += dayWidth;
@@ -145,9 +159,8 @@ void Calendar::renderCalendar() {
 
     WINDOW* eventswin = derwin(content, eventsWinHeight, eventsWinWidth, eventsWinY, eventsWinX);
     
-    refresh();
     mvwprintw(eventswin, 0, 0, "%s", "Events");
-    wrefresh(eventswin);
+    wnoutrefresh(eventswin);
 
     int y = 1;
     int lineWidth = eventsWinWidth - 1;
@@ -182,8 +195,8 @@ void Calendar::renderCalendar() {
         }
     }
 
-    // Refresh the main content window
-    wrefresh(content);
+    // Copy the main content window to the virtual screen, the terminal is updated once per frame
+    wnoutrefresh(content);
 
     // Cleanup: Free memory by deleting all sub-windows.
     for (auto win : dayWindows) {
@@ -196,6 +209,7 @@ void Calendar::renderCalendar() {
  * @param event The event to add.
  */
 void Calendar::addEvent(const Event& event) {
+    if (!loaded) loadEvents();
     // Get the directory path
     std::string path = getenv("HOME");
     path += "/.local/share/neonote/events";
@@ -226,6 +240,7 @@ void Calendar::addEvent(const Event& event) {
  * @param index The index of the event to remove.
  */
 void Calendar::removeEvent(int index) {
+    if (!loaded) loadEvents();
     if (index < 0 || index >= static_cast<int>(events.size())) {
         std::cerr << "Invalid event index.\n";
         return;
@@ -251,6 +266,7 @@ void Calendar::removeEvent(int index) {
  * @param updatedEvent The new event data.
  */
 void Calendar::updateEvent(int eventId, Event& updatedEvent) {
+    if (!loaded) loadEvents();
     for (auto& event : events) {
         if (event.getId() == eventId) {
             event = updatedEvent;
@@ -374,5 +390,15 @@ void Calendar::setSelectedEvent(int index){
  * @return A vector containing all events.
  */
 std::vector<Event> Calendar::getEvents(){
+    if (!loaded) loadEvents();
     return events;
 }
+
+/**
+ * @brief Sets the window the calendar is drawn into.
+ * 
+ * @param content The window of the pane showing the calendar.
+ */
+void Calendar::setWindow(WINDOW *content){
+    this->content = content;
+}
@@ -39,6 +39,7 @@ public:
     int getFirstDayOfMonth(int month, int year) const;
 
     void renderCalendar();
+    void setWindow(WINDOW *content);
     int nextFree();
 
     void setSelectedEvent(int index);
@@ -50,6 +51,9 @@ private:
 
     int selectedEvent;
     int eventsScrollOffset;
+    bool loaded;                ///< Whether the events were read from disk yet
+
+    void loadEvents();
 };
 
 #endif // CALENDAR_H
@@ -0,0 +1,135 @@
+#include "CellGrid.h"
+#include "Utf8.h"
+
+/**
+ * @brief Compares the text, attributes and color of two cells.
+ *
+ * @param other The cell to compare with.
+ * @return `true` if both cells look the same.
+ */
+bool CellGrid::Cell::operator==(const Cell& other) const {
+    if (attrs != other.attrs || pair != other.pair) return false;
+    for (int i = 0; i < MAX_CODEPOINTS; ++i) {
+        if (text[i] != other.text[i]) return false;
+        if (text[i] == 0) break;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks whether a cell is an unstyled space.
+ *
+ * @return `true` if erasing the cell to the default background draws the same thing.
+ */
+bool CellGrid::Cell::isBlank() const {
+    return text[0] == U' ' && text[1] == 0 && attrs == A_NORMAL && pair == 0;
+}
+
+/**
+ * @brief Constructs a grid of blank cells.
+ *
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ */
+CellGrid::CellGrid(int rows, int cols) : height(rows), width(cols), cells(rows * cols) {}
+
+/**
+ * @brief Resizes the grid to a window and copies every cell of the window.
+ *
+ * Line drawing characters of the alternate character set are stored as their
+ * Unicode box drawing characters, so the grid can be printed as plain UTF-8.
+ * The cursor of the window is left where it was.
+ *
+ * @param win The window to copy, usually `newscr`.
+ */
+void CellGrid::capture(WINDOW* win) {
+    int rows, cols;
+    getmaxyx(win, rows, cols);
+    if (rows != height || cols != width) {
+        height = rows;
+        width = cols;
+        cells.assign(rows * cols, Cell());
+    }
+
+    int cursor_y, cursor_x;
+    getyx(win, cursor_y, cursor_x);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            cchar_t source;
+            wchar_t text[CCHARW_MAX + 1] = {};
+            attr_t attrs = A_NORMAL;
+            short pair = 0;
+            mvwin_wch(win, y, x, &source);
+            getcchar(&source, text, &attrs, &pair, nullptr);
+
+            Cell& cell = at(y, x);
+            cell.attrs = attrs & ~(A_COLOR | A_ALTCHARSET);
+            cell.pair = pair;
+            for (int i = 0; i < MAX_CODEPOINTS; ++i) {
+                cell.text[i] = static_cast<char32_t>(text[i]);
+            }
+            if (cell.text[0] == 0) cell.text[0] = U' ';
+            if (attrs & A_ALTCHARSET) {
+                cell.text[0] = fromAlternateCharset(cell.text[0]);
+            }
+
+            // The right half of a wide character is drawn by its left half
+            if (Utf8::codepointWidth(cell.text[0]) == 2 && x + 1 < width) {
+                Cell& right = at(y, ++x);
+                right = cell;
+                for (char32_t& codepoint : right.text) codepoint = 0;
+            }
+        }
+    }
+    wmove(win, cursor_y, cursor_x);
+}
+
+/**
+ * @brief Gets the text of a row.
+ *
+ * @param row The row.
+ * @return The row as UTF-8, wide characters once and without attributes.
+ */
+std::string CellGrid::rowText(int row) const {
+    std::string text;
+    for (int x = 0; x < width; ++x) {
+        const Cell& cell = at(row, x);
+        for (int i = 0; i < MAX_CODEPOINTS && cell.text[i]; ++i) {
+            Utf8::encode(cell.text[i], text);
+        }
+    }
+    return text;
+}
+
+/**
+ * @brief Maps a character of the VT100 alternate character set to Unicode.
+ *
+ * @param ch The character as stored with A_ALTCHARSET.
+ * @return The matching box drawing or symbol character, or `ch` if it has none.
+ */
+char32_t CellGrid::fromAlternateCharset(char32_t ch) {
+    switch (ch) {
+        case U'j': return U'┘';
+        case U'k': return U'┐';
+        case U'l': return U'┌';
+        case U'm': return U'└';
+        case U'n': return U'┼';
+        case U'q': return U'─';
+        case U't': return U'├';
+        case U'u': return U'┤';
+        case U'v': return U'┴';
+        case U'w': return U'┬';
+        case U'x': return U'│';
+        case U'a': return U'▒';
+        case U'`': return U'◆';
+        case U'~': return U'·';
+        case U'f': return U'°';
+        case U'g': return U'±';
+        case U'0': return U'█';
+        case U'+': return U'→';
+        case U',': return U'←';
+        case U'-': return U'↑';
+        case U'.': return U'↓';
+        default: return ch;
+    }
+}
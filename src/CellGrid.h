@@ -0,0 +1,55 @@
+/**
+ * @file CellGrid.h
+ * @brief Header file for the CellGrid class, a screen as rows of character cells.
+ *
+ * Each cell holds the code points drawn in it, its attributes and its color pair.
+ * The second cell of a wide character is empty. A grid is filled from an ncurses
+ * window, usually the virtual screen after the windows were copied to it, so a
+ * render backend can compare two frames cell by cell without asking ncurses.
+ */
+
+#ifndef CELL_GRID_H
+#define CELL_GRID_H
+
+#include <ncurses.h>
+#include <string>
+#include <vector>
+
+class CellGrid {
+public:
+    static constexpr int MAX_CODEPOINTS = 4;   ///< A base character and up to three combining marks
+
+    struct Cell {
+        char32_t text[MAX_CODEPOINTS] = {U' '};     ///< Zero terminated unless full, all zero for the right half of a wide character
+        attr_t attrs = A_NORMAL;                    ///< Without the color pair
+        short pair = 0;
+
+        bool operator==(const Cell& other) const;
+        bool operator!=(const Cell& other) const { return !(*this == other); }
+        bool isBlank() const;
+    };
+
+    CellGrid() = default;
+    CellGrid(int rows, int cols);
+
+    int rows() const { return height; }
+    int cols() const { return width; }
+
+    // Resizes the grid to a window and copies its cells, line drawing characters become Unicode
+    void capture(WINDOW* win);
+
+    Cell& at(int row, int col) { return cells[row * width + col]; }
+    const Cell& at(int row, int col) const { return cells[row * width + col]; }
+
+    // The text of a row as UTF-8, for tests and debugging
+    std::string rowText(int row) const;
+
+private:
+    int height = 0;
+    int width = 0;
+    std::vector<Cell> cells;
+
+    static char32_t fromAlternateCharset(char32_t ch);
+};
+
+#endif // CELL_GRID_H
@@ -0,0 +1,245 @@
+#include "CodeLexer.h"
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+
+struct Language {
+    const char* tags;               // Fence tags selecting the language, space separated
+    const char* keywords;
+    const char* literals;
+    const char* line_comment;       // nullptr if the language has none
+    const char* block_open;
+    const char* block_close;
+    const char* quotes;             // Characters that start a string
+    const char* raw_quotes;         // Quotes whose strings have no backslash escapes
+    char meta;                      // Starts a Meta token: '#' directive, '@' decorator, '$' variable
+    bool comment_after_space;       // The line comment starts only a word, like # in shell
+    bool triple_quotes;             // """ and ''' strings, which may span lines
+    bool multiline_strings;         // Any string may span lines
+    bool ignore_case;               // Keywords match in any case
+};
+
+// Row 0 is for blocks with no tag or one not listed, drawn without tokens
+const Language LANGUAGES[] = {
+    {"", "", "", nullptr, nullptr, nullptr, "", "", 0, false, false, false, false},
+    {"c cpp c++ cc cxx h hpp hxx",
+     "alignas alignof asm auto bool break case catch char char8_t char16_t char32_t class concept const "
+     "consteval constexpr constinit const_cast continue co_await co_return co_yield decltype default delete "
+     "do double dynamic_cast else enum explicit export extern final float for friend goto if inline int long "
+     "mutable namespace new noexcept operator override private protected public register reinterpret_cast "
+     "requires return short signed size_t sizeof static static_assert static_cast struct switch template this "
+     "thread_local throw try typedef typeid typename union unsigned using virtual void volatile wchar_t while",
+     "true false nullptr NULL", "//", "/*", "*/", "\"'", "", '#', false, false, false, false},
+    {"python py python3",
+     "and as assert async await break case class continue def del elif else except finally for from global "
+     "if import in is lambda match nonlocal not or pass raise return self try while with yield",
+     "True False None", "#", nullptr, nullptr, "\"'", "", '@', false, true, false, false},
+    {"sh bash shell zsh console",
+     "alias break case cd continue declare do done echo elif else esac exit export fi for function if in "
+     "local read readonly return select set shift source then time unset until while",
+     "true false", "#", nullptr, nullptr, "\"'", "'", '$', true, false, true, false},
+    {"json jsonc", "", "true false null", "//", "/*", "*/", "\"", "", 0, false, false, false, false},
+    {"sql mysql postgresql psql sqlite",
+     "add all alter and as asc begin between boolean by case char check column commit constraint create cross "
+     "date default delete desc distinct drop else end exists float foreign from full group having if in index "
+     "inner insert int integer into is join key left like limit not offset on or order outer primary real "
+     "references replace returning right rollback select serial set table text then timestamp transaction "
+     "union unique update values varchar view when where with",
+     "null true false", "--", "/*", "*/", "'\"", "", 0, false, false, false, true},
+};
+const size_t LANGUAGE_COUNT = sizeof(LANGUAGES) / sizeof(LANGUAGES[0]);
+
+// What a line leaves open, in the low byte of a state; the language is in the bits above
+enum Open {
+    NOTHING = 0,
+    BLOCK_COMMENT = 1,
+    STRING = 2,             // + index of the quote in Language::quotes
+    TRIPLE_STRING = 8,      // + index of the quote
+};
+
+struct Words {
+    std::unordered_set<std::string> keywords;
+    std::unordered_set<std::string> literals;
+};
+
+void addWords(const char* list, std::unordered_set<std::string>& words) {
+    std::istringstream stream(list);
+    std::string word;
+    while (stream >> word) words.insert(word);
+}
+
+// The keyword sets of every language, built once
+const Words& wordsOf(size_t language) {
+    static const std::vector<Words> compiled = [] {
+        std::vector<Words> all(LANGUAGE_COUNT);
+        for (size_t i = 0; i < LANGUAGE_COUNT; ++i) {
+            addWords(LANGUAGES[i].keywords, all[i].keywords);
+            addWords(LANGUAGES[i].literals, all[i].literals);
+        }
+        return all;
+    }();
+    return compiled[language];
+}
+
+bool isWord(char c) {
+    return std::isalnum((unsigned char)c) || c == '_' || (unsigned char)c >= 0x80;
+}
+
+// Finds the end of a string whose opening quote ends before from, npos if it runs past the line
+size_t stringEnd(const std::string& line, size_t from, char quote, bool triple, bool escapes) {
+    for (size_t i = from; i < line.size(); ++i) {
+        if (escapes && line[i] == '\\') {
+            ++i;
+        } else if (line[i] == quote) {
+            if (!triple) return i + 1;
+            if (line.compare(i, 3, std::string(3, quote)) == 0) return i + 3;
+        }
+    }
+    return std::string::npos;
+}
+
+}
+
+/**
+ * @brief Gets the state a code block starts in from its opening fence.
+ *
+ * The tag is the first word after the backticks, in any case, so ```cpp,
+ * ``` Python and ```sql {.numbered} all select their language.
+ *
+ * @param fence The fence line.
+ * @return The state of the block's first line, for the plain language if the tag is unknown.
+ */
+int CodeLexer::blockState(const std::string& fence) {
+    size_t start = fence.find_first_not_of("` \t");
+    std::string tag;
+    for (size_t i = start; i < fence.size() && !std::isspace((unsigned char)fence[i]) && fence[i] != '{'; ++i) {
+        tag += std::tolower((unsigned char)fence[i]);
+    }
+    for (size_t language = 1; language < LANGUAGE_COUNT && !tag.empty(); ++language) {
+        std::istringstream tags(LANGUAGES[language].tags);
+        std::string name;
+        while (tags >> name) {
+            if (name == tag) return (int)(language + 1) << 8;
+        }
+    }
+    return 1 << 8;
+}
+
+/**
+ * @brief Splits a line of a code block into token runs.
+ *
+ * @param line The line.
+ * @param state The state the line starts in, the end state of the line above.
+ * @param runs Set to the runs of the line, in order.
+ * @return The state the next line starts in.
+ */
+int CodeLexer::lex(const std::string& line, int state, std::vector<Run>& runs) {
+    runs.clear();
+    size_t language = (size_t)(state >> 8) - 1;
+    if (language >= LANGUAGE_COUNT) language = 0;
+    const Language& lang = LANGUAGES[language];
+    const Words& words = wordsOf(language);
+    int base = (int)(language + 1) << 8;
+    int open = state & 0xFF;
+    if (language == 0) return base;
+
+    auto mark = [&](size_t at, Kind kind) {
+        if (runs.empty() || runs.back().kind != kind) runs.push_back({(int)at, kind});
+    };
+
+    // Finish what the line above left open
+    size_t pos = 0;
+    if (open == BLOCK_COMMENT) {
+        mark(0, Comment);
+        size_t end = line.find(lang.block_close);
+        if (end == std::string::npos) return state;
+        pos = end + std::strlen(lang.block_close);
+    } else if (open >= STRING) {
+        bool triple = open >= TRIPLE_STRING;
+        char quote = lang.quotes[open - (triple ? TRIPLE_STRING : STRING)];
+        mark(0, String);
+        pos = stringEnd(line, 0, quote, triple, !std::strchr(lang.raw_quotes, quote));
+        if (pos == std::string::npos) return state;
+    }
+
+    size_t indent = line.find_first_not_of(" \t");
+    while (pos < line.size()) {
+        char c = line[pos];
+        bool word_start = pos == 0 || !isWord(line[pos - 1]);
+
+        if (lang.line_comment && line.compare(pos, std::strlen(lang.line_comment), lang.line_comment) == 0
+            && (!lang.comment_after_space || pos == 0 || std::isspace((unsigned char)line[pos - 1]))) {
+            mark(pos, Comment);
+            return base;
+        }
+
+        if (lang.block_open && line.compare(pos, std::strlen(lang.block_open), lang.block_open) == 0) {
+            mark(pos, Comment);
+            size_t end = line.find(lang.block_close, pos + std::strlen(lang.block_open));
+            if (end == std::string::npos) return base | BLOCK_COMMENT;
+            pos = end + std::strlen(lang.block_close);
+            continue;
+        }
+
+        const char* quote = c ? std::strchr(lang.quotes, c) : nullptr;
+        if (quote) {
+            int index = quote - lang.quotes;
+            bool triple = lang.triple_quotes && line.compare(pos, 3, std::string(3, c)) == 0;
+            mark(pos, String);
+            size_t end = stringEnd(line, pos + (triple ? 3 : 1), c, triple, !std::strchr(lang.raw_quotes, c));
+            if (end == std::string::npos) {
+                if (triple) return base | (TRIPLE_STRING + index);
+                return lang.multiline_strings ? base | (STRING + index) : base;
+            }
+            pos = end;
+            continue;
+        }
+
+        if (lang.meta && c == lang.meta && (c != '#' || pos == indent)) {
+            mark(pos, Meta);
+            ++pos;
+            if (c == '#') {
+                while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) ++pos;
+            } else if (c == '$' && pos < line.size() && line[pos] == '{') {
+                size_t end = line.find('}', pos);
+                pos = end == std::string::npos ? line.size() : end + 1;
+                continue;
+            } else if (c == '$' && pos < line.size() && std::strchr("?#@*!$-", line[pos])) {
+                ++pos;
+                continue;
+            }
+            while (pos < line.size() && (isWord(line[pos]) || (c == '@' && line[pos] == '.'))) ++pos;
+            continue;
+        }
+
+        if (word_start && (std::isdigit((unsigned char)c)
+                           || (c == '.' && pos + 1 < line.size() && std::isdigit((unsigned char)line[pos + 1])))) {
+            mark(pos, Number);
+            for (++pos; pos < line.size(); ++pos) {
+                char d = line[pos];
+                bool exponent_sign = (d == '+' || d == '-') && (line[pos - 1] == 'e' || line[pos - 1] == 'E');
+                if (!isWord(d) && d != '.' && !exponent_sign) break;
+            }
+            continue;
+        }
+
+        if (isWord(c)) {
+            size_t end = pos;
+            while (end < line.size() && isWord(line[end])) ++end;
+            std::string word = line.substr(pos, end - pos);
+            if (lang.ignore_case) {
+                for (char& letter : word) letter = std::tolower((unsigned char)letter);
+            }
+            mark(pos, words.keywords.count(word) ? Keyword : words.literals.count(word) ? Literal : Plain);
+            pos = end;
+            continue;
+        }
+
+        mark(pos, Plain);
+        ++pos;
+    }
+    return base;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file CodeLexer.h
+ * @brief Header file for the CodeLexer class, which splits lines of fenced code into tokens.
+ *
+ * Each language is a row of a table: the tags that select it after ```, its
+ * keywords and literals, its comment and string delimiters and a few flags. One
+ * lexer walks a line using the row of the block's language. What a line leaves
+ * open, a block comment or a string running onto the next line, is its end state,
+ * a small integer that also names the language, so a line is lexed from the end
+ * state of the line above it alone.
+ */
+
+#ifndef CODE_LEXER_H
+#define CODE_LEXER_H
+
+#include <string>
+#include <vector>
+
+class CodeLexer {
+public:
+    enum Kind : unsigned char {
+        Plain,
+        Keyword,
+        Literal,        ///< true, null, None and the like
+        String,
+        Number,
+        Comment,
+        Meta,           ///< Preprocessor lines, decorators, shell variables
+        KIND_COUNT
+    };
+
+    struct Run {
+        int start;      ///< Byte the run starts at, it ends where the next one starts
+        Kind kind;
+    };
+
+    // The state at the start of a block opened by a fence with this tag, never 0
+    static int blockState(const std::string& fence);
+
+    // Splits a line of a block into runs, returns the state the next line starts in
+    static int lex(const std::string& line, int state, std::vector<Run>& runs);
+};
+
+#endif // CODE_LEXER_H
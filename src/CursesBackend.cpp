@@ -0,0 +1,83 @@
+#include "CursesBackend.h"
+#include <cerrno>
+#include <unistd.h>
+
+/**
+ * @brief Constructs a backend that sends the frames ncurses writes to a capture file.
+ *
+ * The capture file is a temporary file, see capture(). Without one, the backend
+ * works like the default constructed one.
+ *
+ * @param fd_in The file descriptor of the terminal.
+ */
+CursesBackend::CursesBackend(int fd_in) : capture_file(tmpfile()), fd(fd_in) {}
+
+/**
+ * @brief Sends what is left in the capture file and closes it.
+ *
+ * ncurses must not write to the capture file any more.
+ */
+CursesBackend::~CursesBackend() {
+    finish();
+    if (capture_file) fclose(capture_file);
+}
+
+/**
+ * @brief Sends the changes of the virtual screen to the terminal.
+ *
+ * With a capture file, the output of doupdate is sent on as one synchronized update.
+ */
+void CursesBackend::show() {
+    doupdate();
+    if (capture_file) forward(true);
+}
+
+/**
+ * @brief Makes the next update clear the terminal and draw everything.
+ */
+void CursesBackend::invalidate() {
+    clearok(curscr, TRUE);
+}
+
+/**
+ * @brief Sends what ncurses wrote since the last frame as it is.
+ *
+ * Called after endwin, so the terminal gets the sequences that restore it.
+ */
+void CursesBackend::finish() {
+    if (capture_file) forward(false);
+}
+
+/**
+ * @brief Moves the output in the capture file to the terminal with one write.
+ *
+ * ncurses writes to the file descriptor of the capture file, not through its
+ * buffer, so the output is everything before the file offset. The offset is set
+ * back to the start for the next frame.
+ *
+ * @param synchronized Whether to wrap the output in a synchronized update.
+ */
+void CursesBackend::forward(bool synchronized) {
+    int source = fileno(capture_file);
+    off_t size = lseek(source, 0, SEEK_CUR);
+    if (size <= 0) return;
+
+    out.clear();
+    if (synchronized) out += BEGIN_SYNC;
+    size_t start = out.size();
+    out.resize(start + size);
+    ssize_t read = pread(source, &out[start], size, 0);
+    out.resize(start + (read > 0 ? read : 0));
+    lseek(source, 0, SEEK_SET);
+    if (synchronized) out += END_SYNC;
+
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t written = ::write(fd, out.data() + done, out.size() - done);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        done += written;
+    }
+}
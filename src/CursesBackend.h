@@ -0,0 +1,49 @@
+/**
+ * @file CursesBackend.h
+ * @brief Header file for the CursesBackend class, which lets ncurses update the terminal.
+ *
+ * The default backend. ncurses compares the virtual screen with what it last sent
+ * and writes the difference with the terminal's own capabilities. ncurses flushes
+ * its output whenever its buffer fills, so a large frame can reach the terminal
+ * in several writes. Given a capture file, the backend has ncurses write there
+ * instead and sends each frame on with one write, as a synchronized update, so
+ * the terminal never shows half of it.
+ */
+
+#ifndef CURSES_BACKEND_H
+#define CURSES_BACKEND_H
+
+#include "RenderBackend.h"
+#include <cstdio>
+#include <string>
+
+class CursesBackend : public RenderBackend {
+public:
+    // ncurses writes to the terminal itself
+    CursesBackend() = default;
+
+    // ncurses writes to a capture file, each frame is sent from there to fd
+    explicit CursesBackend(int fd);
+    ~CursesBackend() override;
+
+    CursesBackend(const CursesBackend&) = delete;
+    CursesBackend& operator=(const CursesBackend&) = delete;
+
+    void show() override;
+    void invalidate() override;
+
+    // The file ncurses should write to, nullptr when it writes to the terminal
+    FILE* capture() const { return capture_file; }
+
+    // Sends what ncurses wrote since the last frame, like the restore sequences of endwin
+    void finish();
+
+private:
+    FILE* capture_file = nullptr;
+    int fd = -1;
+    std::string out;    ///< The frame being sent
+
+    void forward(bool synchronized);
+};
+
+#endif // CURSES_BACKEND_H
@@ -1,8 +1,33 @@
 #include "EditorUI.h"
 #include <ncurses.h>
+#include <algorithm>
+#include <cstdlib>
 #include <string>
 #include <vector>
 #include "TextPrompt.h"
+#include "LineDiff.h"
+#include "LinkGraph.h"
+#include "Utf8.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include "RenderBackend.h"
+
+namespace {
+
+// The attributes a token of fenced code is drawn with, on the grey of the block
+attr_t codeAttr(CodeLexer::Kind kind) {
+    switch (kind) {
+        case CodeLexer::Keyword: return COLOR_PAIR(10) | A_BOLD;
+        case CodeLexer::Literal: return COLOR_PAIR(11);
+        case CodeLexer::String: return COLOR_PAIR(12);
+        case CodeLexer::Number: return COLOR_PAIR(13);
+        case CodeLexer::Comment: return COLOR_PAIR(14) | A_DIM;
+        case CodeLexer::Meta: return COLOR_PAIR(15);
+        default: return COLOR_PAIR(9);
+    }
+}
+
+}
 
 /**
  * @brief Constructor for the EditorUI class.
@@ -12,43 +37,44 @@
  * @param content_in The content window to be used for rendering.
  */
 EditorUI::EditorUI(WINDOW *win_in, WINDOW *sidebar_in, WINDOW *content_in) 
-    : win(win_in), sidebar(sidebar_in), content(content_in), sidebarScrollOffset(0) {}
+    : win(win_in), sidebar(sidebar_in), content(content_in), sidebarScrollOffset(0),
+      boards{"My Tasks"}, boardScrollOffset(0) {}
 
 /**
  * @brief Renders the entire user interface.
  * 
  * Clears the main window, renders the sidebar, and the content window. 
- * Refreshes all windows after rendering.
+ * The windows are copied to the virtual screen without a blank frame in
+ * between; the terminal is updated by the next doupdate.
  * 
  * @param sidebar_width The width of the sidebar.
  * @param files A vector of strings representing the files to display in the sidebar.
  */
 void EditorUI::renderUI(int sidebar_width, const std::vector<std::string> &files) {
     werase(win);
-    wrefresh(win);
-    refresh();
 
     renderSidebar(sidebar_width, files, 0);
     box(content, 0, 0);
 
-    wrefresh(win);
-    wrefresh(sidebar);
-    wrefresh(content);
+    wnoutrefresh(win);
+    wnoutrefresh(sidebar);
+    wnoutrefresh(content);
 }
 
 /**
  * @brief Formats a string with an ellipsis if it exceeds the specified width.
  * 
- * This function truncates the input string to `maxWidth - 3` characters and appends `...` 
- * if the string length exceeds `maxWidth`. Otherwise, it returns the original string.
+ * This function truncates the input string to `maxWidth - 3` columns and appends `...` 
+ * if the string is wider than `maxWidth`. Otherwise, it returns the original string.
+ * Widths are display columns, so multibyte characters are never cut in half.
  * 
  * @param text The input string to format.
  * @param maxWidth The maximum allowed width of the string (including the ellipsis, if applied).
  * @return The formatted string with an ellipsis if it exceeds the max width.
  */
 std::string EditorUI::formatWithEllipsis(const std::string& text, int maxWidth)  {
-    if ((int)text.length() > maxWidth) {
-        return text.substr(0, maxWidth - 3) + "...";
+    if (Utf8::width(text, 0, text.length()) > maxWidth) {
+        return text.substr(0, Utf8::offsetAtWidth(text, 0, maxWidth - 3)) + "...";
     }
     return text;
 };
@@ -56,8 +82,10 @@ std::string EditorUI::formatWithEllipsis(const std::string& text, int maxWidth)
 /**
  * @brief Renders the sidebar with the list of files and additional content.
  * 
- * The sidebar includes labels like "My Tasks" and "Calendar", 
- * along with a horizontal line and a list of file names.
+ * The sidebar lists the kanban boards, starting with "My Tasks", then "Calendar",
+ * a horizontal line and the file names. The selection indexes the files first,
+ * then the boards, then the calendar. The boards take at most half of the rows
+ * and scroll to keep a selected board in view.
  * 
  * @param sidebar_width The width of the sidebar.
  * @param files A vector of strings representing the file names to be displayed.
@@ -65,19 +93,32 @@ std::string EditorUI::formatWithEllipsis(const std::string& text, int maxWidth)
 void EditorUI::renderSidebar(int sidebar_width, const std::vector<std::string> &files, int sidebar_index) {
     werase(sidebar); 
     box(sidebar, 0, 0);
-    mvwhline(sidebar, 5, 1, ACS_HLINE, sidebar_width - 2);
 
-    
+    int boardsVector = (int)boards.size();
+    int maxVisibleBoards = std::clamp((LINES - 10) / 2, 1, boardsVector);
+    int board = sidebar_index - (int)files.size();
+    if (board >= 0 && board < boardsVector) {
+        if (board < boardScrollOffset) {
+            boardScrollOffset = board;
+        } else if (board >= boardScrollOffset + maxVisibleBoards) {
+            boardScrollOffset = board - maxVisibleBoards + 1;
+        }
+    }
+    boardScrollOffset = std::clamp(boardScrollOffset, 0, boardsVector - maxVisibleBoards);
 
-    if (sidebar_index == files.size()) wattron(sidebar, COLOR_PAIR(1));
-    mvwprintw(sidebar, 2, 2, "%s", formatWithEllipsis("My Tasks", sidebar_width - 4).c_str());
-    wattroff(sidebar, COLOR_PAIR(1));
+    for (int i = 0; i < maxVisibleBoards; i++) {
+        if (boardScrollOffset + i == board) wattron(sidebar, COLOR_PAIR(1));
+        mvwprintw(sidebar, 2 + i, 2, "%s", formatWithEllipsis(boards[boardScrollOffset + i], sidebar_width - 4).c_str());
+        wattroff(sidebar, COLOR_PAIR(1));
+    }
 
-    if (sidebar_index == files.size() + 1) wattron(sidebar, COLOR_PAIR(1));
-    mvwprintw(sidebar, 3, 2, "%s", formatWithEllipsis("Calendar", sidebar_width - 4).c_str());
+    if (board == boardsVector) wattron(sidebar, COLOR_PAIR(1));
+    mvwprintw(sidebar, 2 + maxVisibleBoards, 2, "%s", formatWithEllipsis("Calendar", sidebar_width - 4).c_str());
     wattroff(sidebar, COLOR_PAIR(1));
 
-    int maxVisibleFiles = LINES - 9;
+    mvwhline(sidebar, 4 + maxVisibleBoards, 1, ACS_HLINE, sidebar_width - 2);
+
+    int maxVisibleFiles = LINES - 8 - maxVisibleBoards;
     int filesVector = (int)files.size();
 
     if (sidebar_index < sidebarScrollOffset) {
@@ -92,12 +133,12 @@ void EditorUI::renderSidebar(int sidebar_width, const std::vector<std::string> &
 
         // Apply ellipsis overflow to the file names
         std::string fileName = formatWithEllipsis(files[i], sidebar_width - 4);
-        mvwprintw(sidebar, 7 + j++, 2, "%s", fileName.c_str());
+        mvwprintw(sidebar, 6 + maxVisibleBoards + j++, 2, "%s", fileName.c_str());
 
         wattroff(sidebar, COLOR_PAIR(1));
     }
 
-    wrefresh(sidebar);
+    wnoutrefresh(sidebar);
 }
 
 /**
@@ -105,45 +146,164 @@ void EditorUI::renderSidebar(int sidebar_width, const std::vector<std::string> &
  * 
  * Clears the content window, draws a box around it, and then renders the 
  * actual content lines in the window. The content is rendered based on 
- * the current row, column, and scrolling parameters.
+ * the current row, column, and scrolling parameters. The terminal is updated
+ * by the next doupdate.
  * 
  * @param lines A vector of strings representing the lines to be displayed.
  * @param row The current row position of the cursor.
  * @param col The current column position of the cursor.
  * @param scroll_row The row index for the scrolling.
  * @param scroll_col The column index for the scrolling.
+ *
+ * When only the scroll position changed since the last call, the rows still in view
+ * are shifted with a scroll region and only the rows that came into view are drawn.
+ * The shift is passed to the render backend, which can scroll the terminal instead
+ * of sending the rows again.
  */
 void EditorUI::displayContent(const std::vector<std::string> &lines, 
                             int row, int col, int scroll_row,
                             int scroll_col, std::string title) {
-    werase(content);
-    box(content, 0, 0);
-    wattron(content, A_BOLD);
-    std::string formattedTitle = formatWithEllipsis(title, std::max(0, static_cast<int>((COLS * 0.75) - 4)));
-    mvwprintw(content, 1, ((COLS * 0.75) - formattedTitle.length()) / 2, "%s", formattedTitle.c_str());
-    wattroff(content, A_BOLD);
-    renderContent(lines, row, col, scroll_row, scroll_col);
-    wrefresh(content);
+    int height, width;
+    getmaxyx(content, height, width);
+    bool scrolled = shown.win == content && shown.height == height && shown.width == width &&
+                    shown.scroll_col == scroll_col && shown.wrapped == wrapMap.isActive() &&
+                    shown.title == title && shown.scroll_row != scroll_row;
+    if (scrolled) {
+        renderContent(content, wrapMap, lines, row, col, scroll_row, scroll_col,
+                      &shown.row_keys, scroll_row - shown.scroll_row, &outline, &syntax, &tables);
+        touchwin(content);  /**< Popups may have been drawn over the rows that were kept. */
+    } else {
+        displayView(content, wrapMap, lines, row, col, scroll_row, scroll_col, title, true, &shown.row_keys, &outline, &syntax, &tables);
+    }
+    renderStatus(lines, row, col);
+    shown = Shown{content, height, width, scroll_row, scroll_col, wrapMap.isActive(), title, std::move(shown.row_keys)};
+    wnoutrefresh(content);
+}
+
+/**
+ * @brief Draws the word counts into the bottom border of the content window.
+ *
+ * Shows the words up to the cursor out of the words of the note, its characters,
+ * its reading time and the words of all notes. The parts that do not fit are
+ * left out from the end. The cursor is left where it was.
+ *
+ * @param lines The lines of the note.
+ * @param row The cursor row.
+ * @param col The cursor column.
+ */
+void EditorUI::renderStatus(const std::vector<std::string> &lines, int row, int col) {
+    int cursor_y, cursor_x, height, width;
+    getyx(content, cursor_y, cursor_x);
+    getmaxyx(content, height, width);
+    mvwhline(content, height - 1, 1, ACS_HLINE, width - 2);
+
+    TextStats::Counts total = stats.total();
+    TextStats::Counts done = stats.before(row);
+    if (row >= 0 && row < (int)lines.size()) done += TextStats::count(lines[row], 0, col);
+    TextStats::Counts all = corpus;
+    all += total;
+
+    std::vector<std::string> parts = {
+        std::to_string(done.words) + "/" + std::to_string(total.words) + " words",
+        std::to_string(total.chars) + " chars",
+        std::to_string(TextStats::readingMinutes(total.words)) + " min",
+        std::to_string(all.words) + " in all notes",
+    };
+    std::string status;
+    for (const std::string &part : parts) {
+        std::string longer = status.empty() ? part : status + " | " + part;
+        if ((int)longer.size() + 4 > width) break;
+        status = longer;
+    }
+    if (!status.empty()) {
+        wattron(content, A_DIM);
+        mvwprintw(content, height - 1, width - (int)status.size() - 3, " %s ", status.c_str());
+        wattroff(content, A_DIM);
+    }
+    wmove(content, cursor_y, cursor_x);
+}
+
+/**
+ * @brief Draws a note into a pane window.
+ * 
+ * Works like displayContent for any pane, but leaves copying the window to the
+ * screen to the caller, so a pane can copy only its damaged rows. The title of
+ * the focused pane is bold.
+ * 
+ * @param target The window of the pane.
+ * @param wrap The wrap map of the pane, used when soft wrap is on.
+ * @param lines The lines of the note.
+ * @param row The cursor row of the pane.
+ * @param col The cursor column of the pane.
+ * @param scroll_row The row index for the scrolling.
+ * @param scroll_col The column index for the scrolling.
+ * @param title The title shown at the top of the pane.
+ * @param focused Whether the pane receives input.
+ * @param row_keys If not nullptr, set to the keys of the drawn rows.
+ * @param outline The folds of the note, nullptr to show every line.
+ * @param syntax The token runs of the note's code, nullptr to lex the lines drawn.
+ * @param tables The tables of the note, nullptr to draw them as they are written.
+ */
+void EditorUI::displayView(WINDOW *target, WrapMap &wrap, const std::vector<std::string> &lines,
+                           int row, int col, int scroll_row, int scroll_col,
+                           const std::string &title, bool focused,
+                           std::vector<std::uint64_t> *row_keys, const Outline *outline,
+                           const SyntaxCache *syntax, const TableMap *tables) {
+    int width = getmaxx(target);
+    werase(target);
+    box(target, 0, 0);
+    if (focused) wattron(target, A_BOLD);
+    std::string formattedTitle = formatWithEllipsis(title, std::max(0, width - 4));
+    mvwprintw(target, 1, (width - Utf8::width(formattedTitle, 0, formattedTitle.length())) / 2, "%s", formattedTitle.c_str());
+    wattroff(target, A_BOLD);
+    renderContent(target, wrap, lines, row, col, scroll_row, scroll_col, row_keys, 0, outline, syntax, tables);
 }
 
 /**
  * @brief Renders the actual content inside the content window.
  * 
  * This method handles the rendering of lines with special formatting such as 
- * bold and italics based on the presence of asterisks (*). It also manages 
- renderco* cursor position and scrolling logic.
+ * bold and italics based on the presence of asterisks (*), and shows `[[links]]`
+ * as their underlined label without the brackets. It also manages 
+ * cursor position and scrolling logic.
+ * 
+ * With soft wrap on, `scroll_row` counts screen rows instead of lines, and each
+ * line continues on the next screen row at the breaks of the wrap map.
+ * 
+ * Folded sections are left out: rows count only the lines shown, a folded
+ * heading ends with the number of lines it hides, and the loop jumps from the
+ * heading to the line after its section.
+ * 
+ * With `row_keys`, the key of every text row is computed and stored. If `scroll_by`
+ * is not zero as well, the window still shows the rows of `row_keys` scrolled by
+ * that many rows less. If every row that stays in view matches its new key, the
+ * rows are shifted in the window and only the ones that came into view are drawn;
+ * otherwise the text area is cleared and drawn in full.
  * 
+ * @param target The window to draw into.
+ * @param wrap The wrap map of the window.
  * @param lines A vector of strings representing the lines to be displayed.
  * @param row The current row position of the cursor.
  * @param col The current column position of the cursor.
  * @param scroll_row The row index for the scrolling.
  * @param scroll_col The column index for the scrolling.
+ * @param row_keys The keys of the rows on screen, replaced by the keys of the drawn rows.
+ * @param scroll_by How far the view scrolled down since `row_keys` was drawn, negative for up.
+ * @param outline The folds of the note, nullptr to show every line.
+ * @param syntax The token runs of the note's code, nullptr to lex the lines drawn.
+ * @param tables The tables of the note, nullptr to draw them as they are written.
  */
-void EditorUI::renderContent(const std::vector<std::string> &lines,
+void EditorUI::renderContent(WINDOW *target, WrapMap &wrap,
+                           const std::vector<std::string> &lines,
                            int row, int col,
-                           int scroll_row, int scroll_col) {
-    int max_lines = LINES - 4;
-    int max_cols = COLS * 0.75 - 4;
+                           int scroll_row, int scroll_col,
+                           std::vector<std::uint64_t> *row_keys, int scroll_by,
+                           const Outline *outline, const SyntaxCache *syntax,
+                           const TableMap *tables) {
+    Profiler::Scope timer(Profiler::Render);
+    AllocationTracker::Scope tag(AllocationTracker::Render);
+    int max_lines = getmaxy(target) - 4;
+    int max_cols = getmaxx(target) - 4;
     static bool bold_on = false;
     static bool italics_on = false;
     static bool in_inline_code = false;
@@ -152,25 +312,90 @@ void EditorUI::renderContent(const std::vector<std::string> &lines,
     int total_header_offset = 0;
     int code_block_indent_offset = 0;
     int total_backtick_offset = 0;
+    int total_link_offset = 0;
+    LinkGraph::Link link;
+
+    static const Outline unfolded;
+    const Outline &folds = outline ? *outline : unfolded;
+    SyntaxCache lexed;
+    const SyntaxCache &code = syntax ? *syntax : lexed;
+    static const TableMap no_tables;
+    const TableMap &layout = tables ? *tables : no_tables;
+    bool wrapped = wrap.isActive();
+    bool aligned = aligned_tables && !wrapped;
+    int cursor_screen_row = folds.rowOf(wrap, row) - scroll_row;
+    int cursor_segment_start = 0;
+    if (wrapped) {
+        wrap.setWidth(wrapWidth(target), lines);
+        if (folds.hasFolds()) {
+            int segment = 0;
+            for (int line = folds.lineAt(wrap, scroll_row, segment), filled = -segment;
+                 line < (int)lines.size() && filled < max_lines; line = folds.nextVisible(line + 1)) {
+                wrap.wrapLines(lines, line, line + 1);
+                filled += wrap.rowCount(line);
+            }
+        } else {
+            wrap.wrapRows(lines, scroll_row, max_lines);
+        }
+        int segment = wrap.segmentOf(row, col);
+        cursor_segment_start = wrap.segmentStart(row, segment);
+        cursor_screen_row = folds.rowOf(wrap, row) + segment - scroll_row;
+        scroll_col = 0;
+    }
+
+    // Every text row is drawn, unless the rows of a scroll can be kept
+    std::vector<char> draw_row(std::max(max_lines, 0), 1);
+    if (row_keys) {
+        std::vector<std::uint64_t> keys(draw_row.size(), rowKey("", -1, 0));
+        int key_segment = 0;
+        int key_line = folds.lineAt(wrap, scroll_row, key_segment);
+        for (int y = 0; y < max_lines && key_line < (int)lines.size(); ++y) {
+            keys[y] = rowKey(lines[key_line], key_segment, code.stateAt(lines, key_line), folds.isFolded(key_line),
+                             aligned ? layout.layoutKey(key_line) : 0);
+            if (!wrapped || ++key_segment >= wrap.rowCount(key_line)) {
+                key_segment = 0;
+                key_line = folds.nextVisible(key_line + 1);
+            }
+        }
 
-    // Determine code block state for the entire document
-    std::vector<bool> code_block_states(lines.size() + 1, false);
-    bool current_code_block_state = false;
-    for (size_t i = 0; i < lines.size(); ++i) {
-        code_block_states[i] = current_code_block_state;
-        if (lines[i].rfind("```", 0) == 0) {
-            current_code_block_state = !current_code_block_state;
+        bool shifted = scroll_by != 0 && std::abs(scroll_by) < max_lines && row_keys->size() == keys.size();
+        for (int y = 0; y < max_lines && shifted; ++y) {
+            int from = y + scroll_by;
+            if (from >= 0 && from < max_lines && (*row_keys)[from] != keys[y]) shifted = false;
         }
+
+        if (shifted) {
+            scrollok(target, TRUE);
+            wsetscrreg(target, 2, max_lines + 1);
+            wscrl(target, scroll_by);
+            wsetscrreg(target, 0, getmaxy(target) - 1);
+            scrollok(target, FALSE);
+            for (int y = 0; y < max_lines; ++y) {
+                int from = y + scroll_by;
+                draw_row[y] = from < 0 || from >= max_lines;
+                if (draw_row[y]) {
+                    mvwaddch(target, y + 2, 0, ACS_VLINE);  /**< The scroll blanked the border too. */
+                    mvwaddch(target, y + 2, max_cols + 3, ACS_VLINE);
+                }
+            }
+            int top = getbegy(target);
+            RenderBackend::active().scrolled(top + 2, top + 2 + max_lines, scroll_by);
+        } else if (scroll_by != 0) {
+            for (int y = 0; y < max_lines; ++y) {
+                mvwhline(target, y + 2, 1, ' ', max_cols + 2);
+            }
+        }
+        *row_keys = std::move(keys);
     }
 
     // Calculate the total formatting offset up to the cursor position
-    if (row >= scroll_row && row < scroll_row + max_lines) {
+    if (cursor_screen_row >= 0 && cursor_screen_row < max_lines) {
         std::string cursor_line = lines[row];
         bool is_header = (cursor_line.length() > 0 && cursor_line[0] == '#');
         int header_level = 0;
         size_t header_start = 0;
         
-        bool current_line_in_code = code_block_states[row];
+        bool current_line_in_code = code.inCode(lines, row);
         
         if (current_line_in_code) {
             code_block_indent_offset = 2;
@@ -183,15 +408,11 @@ void EditorUI::renderContent(const std::vector<std::string> &lines,
             }
             if (header_level <= 6 && (cursor_line.length() == header_level || cursor_line[header_level] == ' ')) {
                 header_start = (cursor_line[header_level] == ' ') ? header_level + 1 : header_level;
-                if (col <= header_start) {
-                    total_header_offset = col;
-                } else {
-                    total_header_offset = header_start;
-                }
+                total_header_offset = std::max(0, std::min(col, (int)header_start) - cursor_segment_start);
             }
         }
 
-        for (size_t pos = 0; pos < col && pos < cursor_line.length(); ++pos) {
+        for (size_t pos = cursor_segment_start; pos < col && pos < cursor_line.length(); ++pos) {
             if (is_header && pos < header_start) {
                 continue;
             }
@@ -200,6 +421,15 @@ void EditorUI::renderContent(const std::vector<std::string> &lines,
                 continue;
             }
 
+            // Brackets and the target of a labelled link are hidden
+            if (cursor_line.compare(pos, 2, "[[") == 0 && LinkGraph::findLink(cursor_line, pos, link) && link.start == pos) {
+                size_t before = std::min<size_t>(col, link.end);
+                total_link_offset += Utf8::width(cursor_line, link.start, std::min(before, link.labelStart));
+                if (before > link.labelEnd) total_link_offset += Utf8::width(cursor_line, link.labelEnd, before);
+                pos = before - 1;
+                continue;
+            }
+
             if (cursor_line[pos] == '`') {
                 if (pos > 0 && cursor_line[pos-1] == '\\') {
                     total_backtick_offset -= 1;
@@ -224,45 +454,108 @@ void EditorUI::renderContent(const std::vector<std::string> &lines,
         }
     }
 
-    // Render all lines
-    for (int i = 0; i < max_lines; ++i) {
-        int line_index = scroll_row + i;
+    // Draws a cell if it is inside the visible text area
+    auto put = [&](int screen_row, int x, chtype ch) {
+        if (screen_row >= 0 && screen_row < max_lines && draw_row[screen_row] && x < max_cols + 2) {
+            mvwaddch(target, screen_row + 2, x, ch);
+        }
+    };
+
+    // Draws the character at [from, to), which may take several bytes and two cells, and returns its width
+    auto putChar = [&](int screen_row, int x, const std::string& text, size_t from, size_t to) {
+        int columns = Utf8::width(text, from, to);
+        if (to - from == 1) {
+            unsigned char byte = text[from];
+            put(screen_row, x, byte < 0x80 ? byte : '?');  // A stray byte that is not valid UTF-8
+        } else if (screen_row >= 0 && screen_row < max_lines && draw_row[screen_row] && x + columns <= max_cols + 2) {
+            mvwaddnstr(target, screen_row + 2, x, text.c_str() + from, to - from);
+        }
+        return columns;
+    };
+
+    // Render all lines, a wrapped line takes one screen row per segment
+    int first_segment = 0;
+    int first_line = folds.lineAt(wrap, scroll_row, first_segment);
+    int rows = 1;
+    for (int line_index = first_line, y = -first_segment; y < max_lines;
+         line_index = folds.nextVisible(line_index + 1), y += rows) {
         if (line_index < lines.size()) {
+            rows = wrapped ? wrap.rowCount(line_index) : 1;
+            bool drawn = false;
+            for (int s = std::max(y, 0); s < std::min(y + rows, max_lines); ++s) {
+                if (draw_row[s]) drawn = true;
+            }
+            if (!drawn) continue;
+
             std::string line = lines[line_index];
+            int segment = 0;
+            size_t next_break = wrapped ? wrap.segmentEnd(line_index, 0, line.length()) : std::string::npos;
             int x = 2;
             line_asterisk_offset = 0;
 
-            if (bold_on) wattroff(content, A_BOLD);
-            if (italics_on) wattroff(content, A_ITALIC);
-            if (in_inline_code) wattroff(content, COLOR_PAIR(9));
+            if (bold_on) wattroff(target, A_BOLD);
+            if (italics_on) wattroff(target, A_ITALIC);
+            if (in_inline_code) wattroff(target, COLOR_PAIR(9));
             bold_on = italics_on = in_inline_code = false;
 
-            bool current_line_in_code = code_block_states[line_index];
+            bool current_line_in_code = code.inCode(lines, line_index);
             bool is_backtick_line = line.rfind("```", 0) == 0;
 
             if (is_backtick_line) {
                 // Color the backtick line but hide the backticks
-                wattron(content, COLOR_PAIR(9));
-                for (; x < max_cols + 2; ++x) {
-                    mvwaddch(content, i + 2, x, ' ');
+                wattron(target, COLOR_PAIR(9));
+                for (int s = 0; s < rows; ++s) {
+                    for (x = 2; x < max_cols + 2; ++x) {
+                        put(y + s, x, ' ');
+                    }
+                }
+                wattroff(target, COLOR_PAIR(9));
+                continue;
+            }
+
+            // In table mode a row is drawn with its cells padded to the widths of its columns
+            if (aligned && !current_line_in_code && layout.isRow(line_index)) {
+                const std::vector<TableMap::Cell> &cells = layout.cells(line_index);
+                const std::vector<int> &widths = layout.widths(line_index);
+                bool delimiter = layout.isDelimiter(line_index);
+                attr_t text_attr = layout.isHeader(line_index) ? A_BOLD : A_NORMAL;
+                int cell_x = 2 - scroll_col;
+                for (size_t c = 0; c <= widths.size(); ++c) {
+                    chtype border = ACS_VLINE;
+                    if (delimiter) border = c == 0 ? ACS_LTEE : c == widths.size() ? ACS_RTEE : ACS_PLUS;
+                    if (cell_x >= 2) put(y, cell_x, border | A_DIM);
+                    if (c == widths.size()) break;
+
+                    if (delimiter) {
+                        for (int i = std::max(1, 2 - cell_x); i <= widths[c] + 2; ++i) put(y, cell_x + i, ACS_HLINE | A_DIM);
+                    } else if (c < cells.size()) {
+                        x = 2 - scroll_col + layout.displayColumn(line, line_index, cells[c].start);
+                        wattron(target, text_attr);
+                        for (size_t pos = cells[c].start; pos < cells[c].end;) {
+                            size_t next = Utf8::nextChar(line, pos);
+                            x += x >= 2 ? putChar(y, x, line, pos, next) : Utf8::width(line, pos, next);
+                            pos = next;
+                        }
+                        wattroff(target, text_attr);
+                    }
+                    cell_x += widths[c] + 3;
                 }
-                wattroff(content, COLOR_PAIR(9));
                 continue;
             }
 
             if (current_line_in_code) {
-                wattron(content, COLOR_PAIR(9));
-                // Add 2-space indentation for code blocks
-                mvwaddch(content, i + 2, x, ' ');
-                mvwaddch(content, i + 2, x + 1, ' ');
-                x += 2;
-                
-                // Highlight the whole line for code blocks
-                for (; x < max_cols + 2; ++x) {
-                    mvwaddch(content, i + 2, x, ' ');
+                wattron(target, COLOR_PAIR(9));
+                // Highlight every row of the line, including the 2-space indentation
+                for (int s = 0; s < rows; ++s) {
+                    for (x = 2; x < max_cols + 2; ++x) {
+                        put(y + s, x, ' ');
+                    }
                 }
                 x = 4; // Start text at position 4 (2 + 2 spaces)
             }
+            const std::vector<CodeLexer::Run> &code_runs = code.runs(lines, line_index);
+            size_t code_run = 0;
+            attr_t code_attr = COLOR_PAIR(9);
 
             // Handle markdown headers (only outside code blocks)
             int header_level = 0;
@@ -277,11 +570,21 @@ void EditorUI::renderContent(const std::vector<std::string> &lines,
                 if (header_level <= 6 && (line.length() == header_level || line[header_level] == ' ')) {
                     in_header = true;
                     header_start = (line[header_level] == ' ') ? header_level + 1 : header_level;
-                    wattron(content, COLOR_PAIR(header_level + 1));
+                    wattron(target, COLOR_PAIR(header_level + 1));
                 }
             }
 
-            for (size_t pos = scroll_col; pos < line.length() && x < max_cols + 2; ++pos) {
+            // Horizontal scrolling is in bytes of the cursor line, start at a character boundary of this one
+            size_t first = scroll_col;
+            while (first < line.length() && Utf8::isContinuation(line[first])) ++first;
+
+            for (size_t pos = first; pos < line.length() && (wrapped || x < max_cols + 2); ++pos) {
+                while (pos >= next_break) {
+                    ++segment;
+                    next_break = wrap.segmentEnd(line_index, segment, line.length());
+                    x = current_line_in_code ? 4 : 2;
+                }
+
                 if (in_header && pos < header_start) {
                     line_asterisk_offset += 1;
                     continue;
@@ -289,35 +592,50 @@ void EditorUI::renderContent(const std::vector<std::string> &lines,
 
                 if (!current_line_in_code && line[pos] == '`') {
                     if (pos > 0 && line[pos-1] == '\\') {
-                        mvwaddch(content, i + 2, x, line[pos]);
+                        put(y + segment, x, line[pos]);
                         x++;
                         continue;
                     }
                     
                     in_inline_code = !in_inline_code;
                     if (in_inline_code) {
-                        wattron(content, COLOR_PAIR(9));
+                        wattron(target, COLOR_PAIR(9));
                     } else {
-                        wattroff(content, COLOR_PAIR(9));
+                        wattroff(target, COLOR_PAIR(9));
                     }
                     line_asterisk_offset += 1;
                     continue;
                 }
 
+                if (!current_line_in_code && !in_inline_code && line.compare(pos, 2, "[[") == 0 &&
+                    LinkGraph::findLink(line, pos, link) && link.start == pos) {
+                    wattron(target, COLOR_PAIR(1) | A_UNDERLINE);
+                    for (size_t label = link.labelStart; label < link.labelEnd && x < max_cols + 2;) {
+                        size_t next = std::min(Utf8::nextChar(line, label), link.labelEnd);
+                        x += putChar(y + segment, x, line, label, next);
+                        label = next;
+                    }
+                    wattroff(target, COLOR_PAIR(1) | A_UNDERLINE);
+                    if (in_header) wattron(target, COLOR_PAIR(header_level + 1));
+                    line_asterisk_offset += (link.end - link.start) - (link.labelEnd - link.labelStart);
+                    pos = link.end - 1;
+                    continue;
+                }
+
                 if (!current_line_in_code && !in_inline_code) {
                     if (pos + 1 < line.length() && line[pos] == '*' && line[pos + 1] == '*') {
                         bold_on = !bold_on;
                         line_asterisk_offset += 2;
                         pos++;
-                        if (bold_on) wattron(content, A_BOLD);
-                        else wattroff(content, A_BOLD);
+                        if (bold_on) wattron(target, A_BOLD);
+                        else wattroff(target, A_BOLD);
                         continue;
                     }
                     else if (line[pos] == '*') {
                         italics_on = !italics_on;
                         line_asterisk_offset += 1;
-                        if (italics_on) wattron(content, A_ITALIC);
-                        else wattroff(content, A_ITALIC);
+                        if (italics_on) wattron(target, A_ITALIC);
+                        else wattroff(target, A_ITALIC);
                         continue;
                     }
                     else if (line[pos] == '\\' && pos + 1 < line.length() && 
@@ -327,30 +645,102 @@ void EditorUI::renderContent(const std::vector<std::string> &lines,
                     }
                 }
 
-                mvwaddch(content, i + 2, x, line[pos]);
-                ++x;
+                // Tokens of code are drawn in the color of their kind
+                if (!code_runs.empty()) {
+                    while (code_run + 1 < code_runs.size() && code_runs[code_run + 1].start <= (int)pos) ++code_run;
+                    attr_t attr = codeAttr(code_runs[code_run].start <= (int)pos ? code_runs[code_run].kind : CodeLexer::Plain);
+                    if (attr != code_attr) {
+                        wattroff(target, code_attr);
+                        wattron(target, attr);
+                        code_attr = attr;
+                    }
+                }
+
+                size_t next = Utf8::nextChar(line, pos);
+                x += putChar(y + segment, x, line, pos, next);
+                pos = next - 1;
             }
+            if (code_attr != COLOR_PAIR(9)) wattroff(target, code_attr);
 
             if (in_header) {
-                wattroff(content, COLOR_PAIR(header_level + 1));
+                wattroff(target, COLOR_PAIR(header_level + 1));
+            }
+
+            // A folded heading ends with the number of lines it hides
+            if (int hidden = folds.foldedLines(line_index)) {
+                std::string marker = " [+" + std::to_string(hidden) + "]";
+                wattron(target, A_DIM);
+                for (char c : marker) put(y + segment, x++, c);
+                wattroff(target, A_DIM);
             }
             
             if (current_line_in_code || in_inline_code) {
-                wattroff(content, COLOR_PAIR(9));
+                wattroff(target, COLOR_PAIR(9));
             }
         }
     }
 
-    if (bold_on) wattroff(content, A_BOLD);
-    if (italics_on) wattroff(content, A_ITALIC);
-    if (in_inline_code) wattroff(content, COLOR_PAIR(9));
+    if (bold_on) wattroff(target, A_BOLD);
+    if (italics_on) wattroff(target, A_ITALIC);
+    if (in_inline_code) wattroff(target, COLOR_PAIR(9));
     
     // Apply the total formatting offsets to cursor position
-    int cursor_col = col - scroll_col + 2 - total_asterisk_offset - total_header_offset - total_backtick_offset;
-    if (code_block_states[row]) {
+    int cursor_col = Utf8::width(lines[row], scroll_col + cursor_segment_start, col) + 2 - total_asterisk_offset - total_header_offset - total_backtick_offset - total_link_offset;
+    if (code.inCode(lines, row)) {
         cursor_col += code_block_indent_offset;
+    } else if (aligned && layout.isRow(row)) {
+        cursor_col = 2 - scroll_col + layout.displayColumn(lines[row], row, col);
     }
-    wmove(content, row - scroll_row + 2, cursor_col);
+    wmove(target, cursor_screen_row + 2, cursor_col);
+}
+
+/**
+ * @brief Computes a key that changes whenever a text row would be drawn differently.
+ *
+ * @param line The line shown on the row.
+ * @param segment The wrapped segment of the line shown on the row, -1 for a row past the last line.
+ * @param code_state The state the line starts in, 0 outside fenced code blocks.
+ * @param folded Whether the line is a folded heading.
+ * @param layout The layout key of an aligned table row, see TableMap::layoutKey, else 0.
+ * @return The key.
+ */
+std::uint64_t EditorUI::rowKey(const std::string &line, int segment, int code_state, bool folded, std::uint64_t layout) {
+    std::uint64_t key = LineDiff::hashLine(line) ^ (std::uint64_t)(segment + 1) * 0x9E3779B97F4A7C15ULL ^ layout;
+    if (folded) key ^= 0xC2B2AE3D27D4EB4FULL;
+    return code_state ? ~key ^ (std::uint64_t)code_state * 0xD6E8FEB86659FD93ULL : key;
+}
+
+/**
+ * @brief Turns soft wrap on or off for a buffer.
+ *
+ * @param on Whether long lines should wrap.
+ * @param lines The lines being edited.
+ */
+void EditorUI::setSoftWrap(bool on, const std::vector<std::string> &lines) {
+    wrapMap.setWidth(wrapWidth(), lines);
+    wrapMap.setActive(on, lines);
+}
+
+/**
+ * @brief Gets the number of characters a wrapped row can hold.
+ *
+ * Uses the width of the content window inside its border and margins. Code blocks
+ * are indented by two columns, so every row leaves room for them.
+ *
+ * @return The wrap width for the current window size.
+ */
+int EditorUI::wrapWidth() const {
+    return wrapWidth(content);
+}
+
+/**
+ * @brief Gets the number of characters a wrapped row of a pane can hold.
+ *
+ * @param target The window of the pane.
+ * @return The wrap width for the window's size.
+ */
+int EditorUI::wrapWidth(WINDOW *target) {
+    return std::max(1, getmaxx(target) - 4 - 2);
 }
 /**
  * @brief Displays the prompt and captures user input.
@@ -368,14 +758,80 @@ std::string EditorUI::displayPrompt(std::string title){
 }
 
 /**
- * @brief Cleans up and terminates the ncurses session.
+ * @brief Shows a list of options in a centered popup and lets the user pick one.
+ *
+ * Long lists scroll inside the popup. Enter picks the highlighted option and Escape cancels.
+ *
+ * @param title The title shown above the options.
+ * @param options The options to pick from.
+ * @param initial The option highlighted first.
+ * @return The index of the picked option, or -1 if cancelled or if there are no options.
+ */
+int EditorUI::displayChoice(const std::string& title, const std::vector<std::string>& options, int initial) {
+    if (options.empty()) return -1;
+
+    int longest = (int)title.length();
+    for (const std::string& option : options) {
+        longest = std::max(longest, (int)option.length());
+    }
+    int height = std::min((int)options.size() + 4, std::max(5, LINES - 2));
+    int width = std::min(std::max(20, longest + 6), std::max(20, COLS - 2));
+    int visible = height - 4;
+
+    WINDOW* popup = newwin(height, width, (LINES - height) / 2, (COLS - width) / 2);
+    keypad(popup, TRUE);
+    curs_set(0);
+
+    int highlight = std::max(0, std::min(initial, (int)options.size() - 1));
+    int offset = 0;
+    int choice = -1;
+    while (choice == -1) {
+        if (highlight < offset) offset = highlight;
+        if (highlight >= offset + visible) offset = highlight - visible + 1;
+
+        werase(popup);
+        box(popup, 0, 0);
+        mvwprintw(popup, 1, 3, "%.*s", width - 6, title.c_str());
+        for (int i = 0; i < visible && offset + i < (int)options.size(); i++) {
+            if (offset + i == highlight) wattron(popup, A_REVERSE);
+            mvwprintw(popup, i + 2, 3, "%.*s", width - 6, options[offset + i].c_str());
+            wattroff(popup, A_REVERSE);
+        }
+        wnoutrefresh(popup);
+
+        int count = (int)options.size();
+        switch (RenderBackend::readKey(popup)) {
+            case KEY_UP:
+                highlight = (highlight == 0) ? count - 1 : highlight - 1;
+                break;
+            case KEY_DOWN:
+                highlight = (highlight == count - 1) ? 0 : highlight + 1;
+                break;
+            case '\n':
+                choice = highlight;
+                break;
+            case 27: // Escape
+                choice = -2;
+                break;
+        }
+    }
+
+    delwin(popup);
+    curs_set(1);
+    touchwin(win);
+    wnoutrefresh(win);
+    return choice < 0 ? -1 : choice;
+}
+
+/**
+ * @brief Clears the screen when leaving the editor.
  * 
- * This function is called to clean up the ncurses environment after 
- * the program has finished running.
+ * The main menu is drawn over it in the same frame. ncurses keeps running,
+ * NcursesSetup ends it when the program exits; leaving and entering curses
+ * mode here would flash the shell's screen between the two.
  */
 void EditorUI::cleanup() {
     clear();
-    refresh();
-    wrefresh(win);
-    endwin();
+    wnoutrefresh(stdscr);
+    wnoutrefresh(win);
 }
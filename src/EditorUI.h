@@ -10,8 +10,14 @@
 #define EDITOR_UI_H
 
 #include <ncurses.h>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include "WrapMap.h"
+#include "Outline.h"
+#include "SyntaxCache.h"
+#include "TableMap.h"
+#include "TextStats.h"
 
 /**
  * @class EditorUI
@@ -31,13 +37,48 @@ public:
     void displayContent(const std::vector<std::string> &lines, 
                        int row, int col, int scroll_row,
                        int scroll_col, std::string title);
+    void displayView(WINDOW *target, WrapMap &wrap, const std::vector<std::string> &lines,
+                     int row, int col, int scroll_row, int scroll_col,
+                     const std::string &title, bool focused,
+                     std::vector<std::uint64_t> *row_keys = nullptr, const Outline *outline = nullptr,
+                     const SyntaxCache *syntax = nullptr, const TableMap *tables = nullptr);
     void renderSidebar(int sidebar_width, const std::vector<std::string> &files, int sidebar_index);
+
+    // The kanban boards listed in the sidebar between the notes and the calendar
+    void setBoards(const std::vector<std::string> &names) { boards = names; }
     void cleanup();
     std::string displayPrompt(std::string title);
+    int displayChoice(const std::string& title, const std::vector<std::string>& options, int initial = 0);
+
+    // Soft wrap maps each line to one screen row per wrapped segment
+    void setSoftWrap(bool on, const std::vector<std::string> &lines);
+    WrapMap& getWrapMap() { return wrapMap; }
+    Outline& getOutline() { return outline; }
+    SyntaxCache& getSyntax() { return syntax; }
+    TableMap& getTables() { return tables; }
+    TextStats& getStats() { return stats; }
+
+    // Counts of the notes other than the one in the content window, for the total in the status line
+    void setCorpusCounts(const TextStats::Counts &others) { corpus = others; }
+
+    // In table mode the rows of markdown tables are drawn with their columns aligned, unless lines wrap
+    void setTableMode(bool on) { aligned_tables = on; }
+    bool tableMode() const { return aligned_tables; }
+    int wrapWidth() const;
+    static int wrapWidth(WINDOW *target);
     
     WINDOW* getMainWindow() const { return win; }
     WINDOW* getSidebar() const { return sidebar; }
     WINDOW* getContent() const { return content; }
+
+    // The content window is the focused pane's, it changes when panes are split or focused
+    void setContent(WINDOW *content_in) {
+        if (content_in != content) invalidate();
+        content = content_in;
+    }
+
+    // Forgets what the content window shows, needed when something else drew into it
+    void invalidate() { shown.win = nullptr; }
         
 private:
     WINDOW *win;
@@ -45,11 +86,39 @@ private:
     WINDOW *content;
 
     int sidebarScrollOffset;
+    std::vector<std::string> boards;    ///< Names of the boards in the sidebar, "My Tasks" first
+    int boardScrollOffset;
+    WrapMap wrapMap;
+    Outline outline;            ///< Headings and folds of the note in the content window
+    SyntaxCache syntax;         ///< Token runs of the code blocks of the note in the content window
+    TableMap tables;            ///< Tables of the note in the content window
+    TextStats stats;            ///< Word counts of the note in the content window
+    TextStats::Counts corpus;   ///< Word counts of the other notes
+    bool aligned_tables = false;
+
+    // What displayContent last drew, so a pure scroll can shift it instead of drawing it again
+    struct Shown {
+        WINDOW *win = nullptr;      ///< nullptr when the content window may hold something else
+        int height = 0;
+        int width = 0;
+        int scroll_row = 0;
+        int scroll_col = 0;
+        bool wrapped = false;
+        std::string title;
+        std::vector<std::uint64_t> row_keys;    ///< One per text row, see rowKey()
+    } shown;
     
-    void renderContent(const std::vector<std::string> &lines, 
+    void renderContent(WINDOW *target, WrapMap &wrap,
+                      const std::vector<std::string> &lines, 
                       int row, int col, 
-                      int scroll_row, int scroll_col);
+                      int scroll_row, int scroll_col,
+                      std::vector<std::uint64_t> *row_keys = nullptr, int scroll_by = 0,
+                      const Outline *outline = nullptr, const SyntaxCache *syntax = nullptr,
+                      const TableMap *tables = nullptr);
+    static std::uint64_t rowKey(const std::string &line, int segment, int code_state, bool folded = false,
+                                std::uint64_t layout = 0);
 
+    void renderStatus(const std::vector<std::string> &lines, int row, int col);
     std::string formatWithEllipsis(const std::string& text, int maxWidth);
 };
 
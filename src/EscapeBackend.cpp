@@ -0,0 +1,336 @@
+#include "EscapeBackend.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <unistd.h>
+
+/**
+ * @brief Constructs a backend writing to a file descriptor.
+ *
+ * Nothing is written until the first frame.
+ *
+ * @param fd_in The file descriptor of the terminal.
+ * @param synchronized_in Whether to wrap each frame in a synchronized update.
+ */
+EscapeBackend::EscapeBackend(int fd_in, bool synchronized_in) : fd(fd_in), synchronized(synchronized_in) {}
+
+/**
+ * @brief Restores the terminal.
+ */
+EscapeBackend::~EscapeBackend() {
+    finish();
+}
+
+/**
+ * @brief Writes the changes between the last frame and the virtual screen.
+ *
+ * Rows are scanned left to right. A changed cell after the last non-blank cell of
+ * its row clears the rest of the row with one erase. Otherwise the cursor moves to
+ * the cell, by reprinting a short unchanged gap, a relative move or an absolute
+ * one, whichever is shorter, and the run of changed cells is printed. A frame
+ * that changed anything is sent as one synchronized update if enabled.
+ */
+void EscapeBackend::show() {
+    if (!started) start();
+    frame.capture(newscr);
+    out.clear();
+
+    if (!valid || shown.rows() != frame.rows() || shown.cols() != frame.cols()) {
+        shown = CellGrid(frame.rows(), frame.cols());
+        out += "\033[0m\033[H\033[2J";
+        style_attrs = A_NORMAL;
+        style_pair = 0;
+        cursor_y = cursor_x = 0;
+        valid = true;
+        scrolls.clear();
+    }
+    for (const Scroll& region : scrolls) scrollRows(region);
+    scrolls.clear();
+
+    for (int y = 0; y < frame.rows(); ++y) {
+        int blank_from = frame.cols();
+        while (blank_from > 0 && frame.at(y, blank_from - 1).isBlank()) --blank_from;
+
+        for (int x = 0; x < frame.cols(); ++x) {
+            if (frame.at(y, x) == shown.at(y, x)) continue;
+
+            if (x >= blank_from) {
+                moveTo(y, x);
+                setStyle(A_NORMAL, 0);
+                out += "\033[K";
+                for (int rest = x; rest < frame.cols(); ++rest) shown.at(y, rest) = frame.at(y, rest);
+                break;
+            }
+
+            // The right half of a wide character changed, print the whole character
+            if (frame.at(y, x).text[0] == 0 && x > 0) --x;
+            putCell(y, x);
+            if (frame.at(y, x).text[0] != 0 && Utf8::codepointWidth(frame.at(y, x).text[0]) == 2) ++x;
+        }
+    }
+
+    int target_y, target_x;
+    getyx(newscr, target_y, target_x);
+    moveTo(target_y, target_x);
+
+    int visibility = curs_set(1);
+    if (visibility != ERR) curs_set(visibility);
+    if (visibility != ERR && visibility != cursor_visibility) {
+        putCapability(visibility == 0 ? "civis" : "cnorm");
+        cursor_visibility = visibility;
+    }
+    if (synchronized && !out.empty()) {
+        out.insert(0, BEGIN_SYNC);
+        out += END_SYNC;
+    }
+    flush();
+}
+
+/**
+ * @brief Makes the next frame clear the terminal and draw everything.
+ */
+void EscapeBackend::invalidate() {
+    valid = false;
+}
+
+/**
+ * @brief Remembers a scroll of the next frame, so show() can let the terminal do it.
+ *
+ * @param top First screen row of the scrolled area.
+ * @param bottom One past the last screen row.
+ * @param distance How far the rows moved up, negative for down.
+ */
+void EscapeBackend::scrolled(int top, int bottom, int distance) {
+    scrolls.push_back({top, bottom, distance});
+}
+
+/**
+ * @brief Leaves the alternate screen and puts the terminal back as it was.
+ *
+ * Does nothing if no frame was written or the terminal was already restored.
+ */
+void EscapeBackend::finish() {
+    if (!started) return;
+    out.clear();
+    out += "\033[0m";
+    putCapability("cnorm");
+    out += "\033]104\007";      // Reset the palette changed in start()
+    putCapability("rmkx");
+    putCapability("rmcup");
+    flush();
+    started = false;
+}
+
+/**
+ * @brief Switches to the alternate screen and sets up the terminal like ncurses would.
+ *
+ * The keypad is put in application mode so keys send what terminfo says, and the
+ * colors NcursesSetup redefines are sent as palette changes.
+ */
+void EscapeBackend::start() {
+    started = true;
+    valid = false;
+    out.clear();
+    putCapability("smcup");
+    putCapability("smkx");
+    if (can_change_color()) {
+        static const char hex[] = "0123456789abcdef";
+        for (short color = COLOR_BLACK; color <= COLOR_CYAN; ++color) {
+            short red, green, blue;
+            if (color_content(color, &red, &green, &blue) == ERR) continue;
+            out += "\033]4;" + std::to_string(color) + ";rgb:";
+            short levels[] = {red, green, blue};
+            for (int i = 0; i < 3; ++i) {
+                int byte = levels[i] * 255 / 1000;
+                out += hex[byte >> 4];
+                out += hex[byte & 15];
+                if (i < 2) out += '/';
+            }
+            out += "\007";
+        }
+    }
+    flush();
+}
+
+/**
+ * @brief Scrolls rows of the terminal if that leaves fewer cells to send.
+ *
+ * A scroll region always spans the whole width, so the cells beside the scrolled
+ * area, like the sidebar, move too and are sent again by the diff. The cells that
+ * would differ with and without the scroll are counted, and the terminal is only
+ * scrolled when that saves more than the scroll costs.
+ *
+ * @param region The rows and the distance they moved.
+ */
+void EscapeBackend::scrollRows(const Scroll& region) {
+    int top = std::max(region.top, 0);
+    int bottom = std::min(region.bottom, shown.rows());
+    int distance = region.distance;
+    if (distance == 0 || std::abs(distance) >= bottom - top) return;
+
+    static const CellGrid::Cell blank;
+    int kept = 0, moved = 0;
+    for (int y = top; y < bottom; ++y) {
+        int from = y + distance;
+        for (int x = 0; x < shown.cols(); ++x) {
+            const CellGrid::Cell& cell = frame.at(y, x);
+            if (cell != shown.at(y, x)) ++kept;
+            if (cell != (from >= top && from < bottom ? shown.at(from, x) : blank)) ++moved;
+        }
+    }
+    if (moved + SCROLL_COST >= kept) return;
+
+    setStyle(A_NORMAL, 0);  // New rows are blanked with the current background
+    out += "\033[" + std::to_string(top + 1) + ";" + std::to_string(bottom) + "r";
+    out += "\033[" + std::to_string(std::abs(distance)) + (distance > 0 ? "S" : "T");
+    out += "\033[r";
+    cursor_y = cursor_x = 0;    // Setting the scroll region moved the cursor home
+
+    for (int i = 0; i < bottom - top; ++i) {
+        int y = distance > 0 ? top + i : bottom - 1 - i;
+        int from = y + distance;
+        for (int x = 0; x < shown.cols(); ++x) {
+            shown.at(y, x) = from >= top && from < bottom ? shown.at(from, x) : blank;
+        }
+    }
+}
+
+/**
+ * @brief Moves the terminal cursor with the shortest sequence that gets there.
+ *
+ * @param y Target row.
+ * @param x Target column.
+ */
+void EscapeBackend::moveTo(int y, int x) {
+    if (y == cursor_y && x == cursor_x) return;
+
+    if (y == cursor_y && cursor_x >= 0 && x > cursor_x) {
+        int gap = x - cursor_x;
+        bool reprint = gap <= MAX_REPRINT;
+        for (int i = cursor_x; reprint && i < x; ++i) {
+            const CellGrid::Cell& cell = shown.at(y, i);
+            reprint = cell.text[0] != 0 && cell.text[1] == 0 && Utf8::codepointWidth(cell.text[0]) == 1
+                      && sameStyle(cell, style_attrs, style_pair);
+        }
+        if (reprint) {
+            for (int i = cursor_x; i < x; ++i) Utf8::encode(shown.at(y, i).text[0], out);
+        } else {
+            out += "\033[" + std::to_string(gap) + "C";
+        }
+    } else if (x == 0 && y == cursor_y) {
+        out += "\r";
+    } else if (x == 0 && cursor_x >= 0 && y == cursor_y + 1) {
+        out += "\r\n";
+    } else {
+        out += "\033[" + std::to_string(y + 1) + ";" + std::to_string(x + 1) + "H";
+    }
+    cursor_y = y;
+    cursor_x = x;
+}
+
+/**
+ * @brief Changes the terminal attributes and colors, sending only what differs.
+ *
+ * Attributes can only be added one by one; if any has to be removed, everything
+ * is reset and the new style is sent in full.
+ *
+ * @param attrs The attributes to draw with.
+ * @param pair The color pair to draw with.
+ */
+void EscapeBackend::setStyle(attr_t attrs, short pair) {
+    if (attrs == style_attrs && pair == style_pair) return;
+
+    static const struct { attr_t attr; const char* code; } codes[] = {
+        {A_BOLD, "1"}, {A_DIM, "2"}, {A_ITALIC, "3"}, {A_UNDERLINE, "4"},
+        {A_BLINK, "5"}, {A_REVERSE, "7"}, {A_STANDOUT, "7"}, {A_INVIS, "8"},
+    };
+
+    std::string sequence;
+    attr_t added = attrs;
+    bool reset = (style_attrs & ~attrs) != 0;
+    if (reset) {
+        sequence = "0";
+    } else {
+        added = attrs & ~style_attrs;
+    }
+    for (const auto& code : codes) {
+        if (added & code.attr) sequence += (sequence.empty() ? "" : ";") + std::string(code.code);
+    }
+
+    if (reset || pair != style_pair) {
+        short foreground = -1, background = -1;
+        if (pair != 0) pair_content(pair, &foreground, &background);
+        auto color = [&](short value, int base, int bright_base, const char* extended, int default_code) {
+            std::string code;
+            if (value < 0) code = std::to_string(default_code);
+            else if (value < 8) code = std::to_string(base + value);
+            else if (value < 16) code = std::to_string(bright_base + value - 8);
+            else code = std::string(extended) + std::to_string(value);
+            sequence += (sequence.empty() ? "" : ";") + code;
+        };
+        // After a reset the default colors are already set
+        if (!reset || foreground >= 0) color(foreground, 30, 90, "38;5;", 39);
+        if (!reset || background >= 0) color(background, 40, 100, "48;5;", 49);
+    }
+
+    if (!sequence.empty()) out += "\033[" + sequence + "m";
+    style_attrs = attrs;
+    style_pair = pair;
+}
+
+/**
+ * @brief Prints a cell of the frame where the cursor is.
+ *
+ * @param y Row of the cell.
+ * @param x Column of the cell.
+ */
+void EscapeBackend::putCell(int y, int x) {
+    const CellGrid::Cell& cell = frame.at(y, x);
+    moveTo(y, x);
+    setStyle(cell.attrs, cell.pair);
+    for (int i = 0; i < CellGrid::MAX_CODEPOINTS && cell.text[i]; ++i) {
+        Utf8::encode(cell.text[i], out);
+    }
+
+    int width = Utf8::codepointWidth(cell.text[0]) == 2 ? 2 : 1;
+    for (int i = 0; i < width && x + i < frame.cols(); ++i) {
+        shown.at(y, x + i) = frame.at(y, x + i);
+    }
+    cursor_x = x + width;
+    if (cursor_x >= frame.cols()) cursor_x = -1;   // Terminals differ on where the cursor is now
+}
+
+/**
+ * @brief Appends a terminfo string capability, if the terminal has it.
+ *
+ * @param name The capability name, like "smcup".
+ */
+void EscapeBackend::putCapability(const char* name) {
+    char* value = tigetstr(const_cast<char*>(name));
+    if (value && value != reinterpret_cast<char*>(-1)) out += value;
+}
+
+/**
+ * @brief Writes the collected escape sequences with as few writes as possible.
+ */
+void EscapeBackend::flush() {
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t written = ::write(fd, out.data() + done, out.size() - done);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        done += written;
+    }
+    bytes += done;
+    out.clear();
+}
+
+/**
+ * @brief Checks whether a cell is drawn with the given attributes and colors.
+ */
+bool EscapeBackend::sameStyle(const CellGrid::Cell& cell, attr_t attrs, short pair) {
+    return cell.attrs == attrs && cell.pair == pair;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file EscapeBackend.h
+ * @brief Header file for the EscapeBackend class, which writes frames to the terminal itself.
+ *
+ * ncurses draws into its virtual screen but sends its output nowhere; this backend
+ * copies each frame into a CellGrid, compares it with the last frame it wrote and
+ * writes only the changed cells. It knows the shape of our screens: changes come
+ * in short runs inside boxed panes and rows often end in blanks, so it skips small
+ * gaps by reprinting them, clears row tails with one erase, changes only the
+ * attributes that differ, and sends the whole frame with a single write. When the
+ * editor reports a scroll, the terminal shifts the rows itself inside a scroll
+ * region, so only the rows that came into view are sent. A synchronized backend
+ * wraps every frame in a synchronized update, so the terminal shows it at once.
+ */
+
+#ifndef ESCAPE_BACKEND_H
+#define ESCAPE_BACKEND_H
+
+#include "RenderBackend.h"
+#include "CellGrid.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class EscapeBackend : public RenderBackend {
+public:
+    // Writes to a file descriptor, normally the terminal on standard output
+    explicit EscapeBackend(int fd, bool synchronized = false);
+    ~EscapeBackend() override;
+
+    EscapeBackend(const EscapeBackend&) = delete;
+    EscapeBackend& operator=(const EscapeBackend&) = delete;
+
+    void show() override;
+    void invalidate() override;
+    void scrolled(int top, int bottom, int distance) override;
+
+    // Leaves the alternate screen and restores the terminal, called by the destructor
+    void finish();
+
+    std::uint64_t bytesWritten() const { return bytes; }
+
+private:
+    static constexpr int MAX_REPRINT = 4;   ///< Longest gap reprinted instead of moving over it
+    static constexpr int SCROLL_COST = 16;  ///< About the bytes of setting a scroll region and scrolling it
+
+    struct Scroll {
+        int top;
+        int bottom;
+        int distance;   ///< Rows moved up, negative for down
+    };
+
+    int fd;
+    bool synchronized;              ///< Frames are wrapped in a synchronized update
+    bool started = false;
+    bool valid = false;             ///< The terminal shows `shown`
+    CellGrid frame;
+    CellGrid shown;
+    std::string out;                ///< The escape sequences of the frame being written
+    std::vector<Scroll> scrolls;    ///< Reported for the next frame
+    int cursor_y = -1;              ///< Where the terminal cursor is, -1 when unknown
+    int cursor_x = -1;
+    attr_t style_attrs = A_NORMAL;  ///< The attributes the terminal draws with
+    short style_pair = 0;
+    int cursor_visibility = -1;
+    std::uint64_t bytes = 0;
+
+    void start();
+    void scrollRows(const Scroll& region);
+    void moveTo(int y, int x);
+    void setStyle(attr_t attrs, short pair);
+    void putCell(int y, int x);
+    void putCapability(const char* name);
+    void flush();
+    static bool sameStyle(const CellGrid::Cell& cell, attr_t attrs, short pair);
+};
+
+#endif // ESCAPE_BACKEND_H
@@ -1,10 +1,13 @@
 #include "FileManager.h"
+#include "AllocationTracker.h"
 #include <fstream>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <cstdlib>
 #include <filesystem>
+#include <algorithm>
 #include <iostream>
+#include <unordered_set>
 
 using namespace std;
 
@@ -15,16 +18,26 @@ using namespace std;
  * 
  * It handles tasks like initializing the app directory, scanning for existing files, and ensuring 
  * that a default file is created if no files are present.
+ *
+ * @param known The notes of a session snapshot, used instead of scanning the directory; nullptr to scan.
  */
-FileManager::FileManager() {
+FileManager::FileManager(const vector<string> *known) : links(""), saves(std::make_unique<SaveQueue>()) {
     const char *home = getenv("HOME");
     if (home == nullptr) {
         throw runtime_error("No home directory found");
     }
     appDataPath = string(home) + "/.local/share/neonote";  /**< Application data path. */
+    links = LinkGraph(appDataPath + "/links/");
     initializeAppDirectory();  /**< Initialize the app's directory if it doesn't exist. */
-    scanExistingFiles();       /**< Scan for existing files in the app directory. */
-    createDefaultFileIfNeeded(); /**< Create a default file if none exist. */
+    finishRename();            /**< Complete a rename that was interrupted. */
+    if (known && !known->empty()) {
+        files = *known;        /**< Checked against the directory later, see setFiles. */
+    } else {
+        scanExistingFiles();       /**< Scan for existing files in the app directory. */
+        createDefaultFileIfNeeded(); /**< Create a default file if none exist. */
+    }
+    links.load();              /**< Read the links between notes. */
+    loadCounts();              /**< Read the word counts of the notes. */
 }
 
 /**
@@ -48,13 +61,70 @@ void FileManager::initializeAppDirectory() {
  * @brief Scans the application directory for existing files.
  * 
  * Iterates through the directory and adds the filenames (without extensions) to the `files` vector.
+ * Only `.md` files are notes, so a save interrupted halfway does not show up as one.
  */
  void FileManager::scanExistingFiles() {
-    for (const auto &entry : std::filesystem::directory_iterator(appDataPath)) {
-        if (std::filesystem::is_regular_file(entry)) {
-            files.push_back(entry.path().stem().string());  /**< Extract and store filenames (without extension). */
+    files = scanNotes(appDataPath);
+}
+
+/**
+ * @brief Lists the notes in a directory.
+ *
+ * Only reads the directory, so it can run on another thread.
+ *
+ * @param dir The directory of the notes.
+ * @return The names of the `.md` files, without the extension.
+ */
+vector<string> FileManager::scanNotes(const string &dir) {
+    vector<string> names;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(dir, error)) {
+        if (std::filesystem::is_regular_file(entry) && entry.path().extension() == ".md") {
+            names.push_back(entry.path().stem().string());  /**< Extract and store filenames (without extension). */
         }
     }
+    return names;
+}
+
+/**
+ * @brief Replaces the notes taken from a session snapshot with the ones on disk.
+ *
+ * The scan may have started before notes were created or deleted in the editor,
+ * so a note the scan and the list disagree on is kept only if its file exists
+ * now. Notes keep their place in the list, new ones are added at the end.
+ *
+ * @param scanned The notes found by scanNotes.
+ * @return `true` if the list changed.
+ */
+bool FileManager::setFiles(const vector<string> &scanned) {
+    unordered_set<string> on_disk(scanned.begin(), scanned.end());
+    unordered_set<string> listed(files.begin(), files.end());
+    auto exists = [this](const string &name) {
+        return std::filesystem::exists(appDataPath + "/" + name + ".md");
+    };
+
+    vector<string> merged;
+    for (const string &file : files) {
+        if (on_disk.count(file) || exists(file)) merged.push_back(file);
+    }
+    for (const string &file : scanned) {
+        if (!listed.count(file) && exists(file)) merged.push_back(file);
+    }
+    if (merged == files) return false;
+
+    files = std::move(merged);
+    createDefaultFileIfNeeded();
+    reconcileCounts();
+    return true;
+}
+
+/**
+ * @brief Writes a session snapshot, on the save queue's thread.
+ *
+ * @param session The snapshot.
+ */
+void FileManager::saveSession(const Session &session) {
+    saves->write(Session::path(), session.text());
 }
 
 /**
@@ -91,6 +161,8 @@ vector<string> FileManager::getFiles() const {
  * @param current_file A reference to a string that will hold the name of the current file being loaded.
  */
 void FileManager::loadFile(const string &filename, vector<string> &lines, std::string &current_file) {
+    AllocationTracker::Scope tag(AllocationTracker::FileIO);
+    saves->flush();  /**< The note may still be waiting to be written. */
     string path = appDataPath + "/" + filename + ".md";  /**< Construct the full file path. */
     ifstream file(path);  /**< Open the file for reading. */
     string line;
@@ -100,24 +172,48 @@ void FileManager::loadFile(const string &filename, vector<string> &lines, std::s
         lines.push_back(line);  /**< Add each line to the lines vector. */
     }
     file.close();  /**< Close the file after reading. */
+    snapshots[filename] = LineDiff::hashLines(lines);  /**< Remember what is on disk for the next save. */
 }
 
 /**
  * @brief Saves the contents of a vector of strings to a specified file.
  * 
  * Writes each string in the `lines` vector to a file with the given name. Each line is written 
- * followed by a newline character.
+ * followed by a newline character. The text is handed to the save queue, so the file is
+ * written on a background thread and the editor does not wait for the disk. The lines are compared with the version last read or
+ * written, so the link graph and whatever else indexes the notes only has to look at
+ * the lines that changed.
  * 
  * @param filename The name of the file to save (without the ".md" extension).
  * @param lines A reference to the vector containing the lines to write to the file.
+ * @param counts The counts of the lines if the caller keeps them, nullptr to count them.
+ * @return The window of lines that changed since the last load or save of this file.
  */
-void FileManager::saveFile(const string &filename, const vector<string> &lines) {
+LineDiff FileManager::saveFile(const string &filename, const vector<string> &lines, const TextStats::Counts *counts) {
+    AllocationTracker::Scope tag(AllocationTracker::FileIO);
     string path = appDataPath + "/" + filename + ".md";  /**< Construct the full file path. */
-    ofstream file(path);  /**< Open the file for writing. */
+    string text;
     for (const auto &line : lines) {
-        file << line << '\n';  /**< Write each line to the file. */
+        text += line;
+        text += '\n';  /**< Write each line to the file. */
     }
-    file.close();  /**< Close the file after writing. */
+    saves->write(path, std::move(text));
+
+    vector<uint64_t> hashes = LineDiff::hashLines(lines);
+    auto previous = snapshots.find(filename);
+    LineDiff diff = (previous == snapshots.end()) ? LineDiff::everything((int)lines.size())
+                                                  : LineDiff::between(previous->second, hashes);
+    snapshots[filename] = std::move(hashes);
+    links.update(filename, lines, diff);
+
+    TextStats::Counts note;
+    if (counts) {
+        note = *counts;
+    } else {
+        for (const auto &line : lines) note += TextStats::count(line);
+    }
+    setCounts(filename, note);
+    return diff;
 }
 
 /**
@@ -127,6 +223,7 @@ void FileManager::saveFile(const string &filename, const vector<string> &lines)
  * The new file is saved as an empty markdown file and added to the list of files.
  */
 void FileManager::newFile(){
+    saves->flush();
     int dupeId = 0;
     while(1){
         dupeId++;
@@ -147,9 +244,15 @@ void FileManager::newFile(){
  * @param filename The name of the file to delete (without the ".md" extension).
  */
 void FileManager::deleteFile(const string &filename){
+    saves->flush();
     string path = appDataPath + "/" + filename + ".md";  /**< Construct the full file path. */
     if(filesystem::exists(path)){
         filesystem::remove(path);
+        snapshots.erase(filename);
+        links.remove(filename);
+        corpus -= getCounts(filename);
+        counts.erase(filename);
+        writeCounts();
         for(int i = 0; i < files.size(); i++){
             if (files[i] == filename) files.erase(files.begin() + i);
         }
@@ -159,7 +262,12 @@ void FileManager::deleteFile(const string &filename){
 /**
  * @brief Renames a specified file in the application directory.
  * 
- * Renames the file both on the file system and in the `files` vector.
+ * Renames the file both on the file system and in the `files` vector, and rewrites the
+ * `[[links]]` of every note pointing to it. The notes to rewrite come from the link graph,
+ * so no other note is read. The rewritten notes are first staged next to the link graph,
+ * then a journal listing every move is written, and only then are the files moved into
+ * place. If the editor stops halfway, the constructor finishes the moves from the
+ * journal, so either no note or every note ends up pointing to the new name.
  * 
  * @param filename The current name of the file to rename (without the ".md" extension).
  * @param newName The new name for the file (without the ".md" extension).
@@ -168,9 +276,64 @@ void FileManager::deleteFile(const string &filename){
 void FileManager::renameFile(const string &filename, string newName, string &current_file){
     string oldPath = appDataPath + "/" + filename + ".md";
     string newPath = appDataPath + "/" + newName + ".md";
-    current_file = newName;
+    saves->flush();  /**< Every note must be on disk before it is moved or rewritten. */
     if (filesystem::exists(oldPath) && !filesystem::exists(newPath)) {
-        filesystem::rename(oldPath, newPath);
+        current_file = newName;
+
+        // Stage the rewritten notes, the renamed note itself goes to its new path
+        string staging = appDataPath + "/links/.rename/";
+        filesystem::create_directories(staging);
+        vector<pair<string, string>> moves = {{oldPath, newPath}};
+        vector<pair<string, vector<string>>> rewritten;
+        for (const string &source : links.backlinks(filename)) {
+            string target = (source == filename) ? newName : source;
+            ifstream in(appDataPath + "/" + source + ".md");
+            if (!in) continue;
+            vector<string> lines;
+            string line;
+            while (getline(in, line)) {
+                lines.push_back(LinkGraph::retarget(line, filename, newName));
+            }
+
+            string staged = staging + to_string(moves.size());
+            ofstream out(staged);
+            for (const auto &each : lines) {
+                out << each << '\n';
+            }
+            moves.emplace_back(staged, appDataPath + "/" + target + ".md");
+            rewritten.emplace_back(target, std::move(lines));
+        }
+
+        // The journal appears in one step, once it exists the rename will complete
+        {
+            ofstream journal(staging + "journal.tmp");
+            for (const auto &[from, to] : moves) {
+                journal << from << '\t' << to << '\n';
+            }
+        }
+        filesystem::rename(staging + "journal.tmp", staging + "journal");
+        finishRename();
+
+        auto snapshot = snapshots.find(filename);
+        if (snapshot != snapshots.end()) {
+            vector<uint64_t> hashes = std::move(snapshot->second);
+            snapshots.erase(snapshot);
+            snapshots[newName] = std::move(hashes);
+        }
+        for (const auto &[note, lines] : rewritten) {
+            snapshots[note] = LineDiff::hashLines(lines);
+        }
+        links.rename(filename, newName);
+
+        TextStats::Counts renamed = getCounts(filename);
+        counts.erase(filename);
+        counts[newName] = renamed;
+        for (const auto &[note, lines] : rewritten) {
+            TextStats::Counts note_counts;
+            for (const auto &line : lines) note_counts += TextStats::count(line);
+            setCounts(note, note_counts);
+        }
+        writeCounts();
 
         for (auto &file : files) {
             if (file == filename) {
@@ -179,4 +342,168 @@ void FileManager::renameFile(const string &filename, string newName, string &cur
             }
         }
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Applies the moves of a rename journal, if there is one.
+ *
+ * Moves whose source is already gone were done before, so running this again
+ * after an interruption is safe. The journal is removed once every move is done.
+ */
+void FileManager::finishRename() {
+    string staging = appDataPath + "/links/.rename/";
+    ifstream journal(staging + "journal");
+    if (!journal) return;
+
+    string line;
+    while (getline(journal, line)) {
+        size_t tab = line.find('\t');
+        if (tab == string::npos) continue;
+        string from = line.substr(0, tab);
+        if (filesystem::exists(from)) {
+            filesystem::rename(from, line.substr(tab + 1));
+        }
+    }
+    journal.close();
+    filesystem::remove_all(staging);
+}
+
+/**
+ * @brief Creates an empty note with the given name if it does not exist yet.
+ *
+ * @param filename The name of the note (without the ".md" extension).
+ */
+void FileManager::createFile(const string &filename) {
+    saves->flush();
+    if (filesystem::exists(appDataPath + "/" + filename + ".md")) return;
+    files.push_back(filename);
+    saveFile(filename, vector<string>{""});
+}
+
+/**
+ * @brief Gets the notes that link to a note.
+ *
+ * @param filename The name of the linked note (without the ".md" extension).
+ * @return The names of the notes containing a `[[filename]]` link.
+ */
+vector<string> FileManager::getBacklinks(const string &filename) const {
+    return links.backlinks(filename);
+}
+
+/**
+ * @brief Waits until every note saved so far is written to disk.
+ *
+ * Needed before anything outside the file manager reads or patches note files.
+ */
+void FileManager::flushSaves() {
+    saves->flush();
+}
+
+/**
+ * @brief Gets the files the save queue could not write.
+ *
+ * @return The names of the notes, without the ".md" extension, and of the other files.
+ */
+vector<string> FileManager::takeSaveFailures() {
+    vector<string> names;
+    for (const string &path : saves->takeFailures()) {
+        filesystem::path failed(path);
+        names.push_back(failed.extension() == ".md" ? failed.stem().string() : failed.filename().string());
+    }
+    return names;
+}
+
+/**
+ * @brief Gets the directory the notes are kept in.
+ *
+ * @return The path of the application data directory.
+ */
+const std::string& FileManager::getDataPath() const {
+    return appDataPath;
+}
+
+/**
+ * @brief Gets the counts of a note as it was last saved.
+ *
+ * @param filename The name of the note (without the ".md" extension).
+ * @return Its counts, zero for a note that is not counted.
+ */
+TextStats::Counts FileManager::getCounts(const string &filename) const {
+    auto found = counts.find(filename);
+    return found == counts.end() ? TextStats::Counts() : found->second;
+}
+
+/**
+ * @brief Reads the stored counts of every note.
+ *
+ * The counts are kept in one small file next to the notes, rewritten on every
+ * save, so the totals of all notes are known without reading them. Only notes
+ * missing from the file, like ones added while the editor was closed, are read
+ * and counted.
+ */
+void FileManager::loadCounts() {
+    ifstream in(appDataPath + "/stats");
+    long words, chars;
+    string name;
+    while (in >> words >> chars && getline(in >> ws, name)) {
+        counts[name] = TextStats::Counts{words, chars};
+    }
+    reconcileCounts();
+}
+
+/**
+ * @brief Makes the counts cover exactly the notes in the list.
+ *
+ * Counts of notes that are gone are dropped, notes without counts are read and
+ * counted. The counts are stored again if that changed them.
+ */
+void FileManager::reconcileCounts() {
+    unordered_set<string> listed(files.begin(), files.end());
+    bool changed = false;
+    for (auto entry = counts.begin(); entry != counts.end();) {
+        if (!listed.count(entry->first)) {
+            entry = counts.erase(entry);  /**< Deleted while the editor was closed. */
+            changed = true;
+        } else {
+            ++entry;
+        }
+    }
+    for (const string &file : files) {
+        if (counts.count(file)) continue;
+        ifstream note(appDataPath + "/" + file + ".md");
+        TextStats::Counts note_counts;
+        string line;
+        while (getline(note, line)) note_counts += TextStats::count(line);
+        counts[file] = note_counts;
+        changed = true;
+    }
+    corpus = TextStats::Counts();
+    for (const auto &[file, note] : counts) corpus += note;
+    if (changed) writeCounts();
+}
+
+/**
+ * @brief Replaces the counts of a note and stores them if they changed.
+ *
+ * @param filename The name of the note (without the ".md" extension).
+ * @param note Its new counts.
+ */
+void FileManager::setCounts(const string &filename, const TextStats::Counts &note) {
+    TextStats::Counts &stored = counts[filename];
+    if (stored.words == note.words && stored.chars == note.chars) return;
+    corpus -= stored;
+    corpus += note;
+    stored = note;
+    writeCounts();
+}
+
+/**
+ * @brief Writes the counts of every note, on the save queue's thread.
+ */
+void FileManager::writeCounts() {
+    string text;
+    for (const auto &[file, note] : counts) {
+        text += to_string(note.words) + ' ' + to_string(note.chars) + ' ' + file + '\n';
+    }
+    saves->write(appDataPath + "/stats", std::move(text));
+}
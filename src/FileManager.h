@@ -14,24 +14,59 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <unordered_map>
+#include <memory>
+#include "LineDiff.h"
+#include "LinkGraph.h"
+#include "SaveQueue.h"
+#include "TextStats.h"
+#include "Session.h"
 
 class FileManager {
 public:
-    FileManager();
+    FileManager(const std::vector<std::string> *known = nullptr);
     std::vector<std::string> getFiles() const;
     void loadFile(const std::string &filename, std::vector<std::string> &lines, std::string &current_file);
-    void saveFile(const std::string &filename, const std::vector<std::string> &lines);
+    LineDiff saveFile(const std::string &filename, const std::vector<std::string> &lines,
+                      const TextStats::Counts *counts = nullptr);
     void newFile();
     void deleteFile(const std::string &filename);
     void renameFile(const std::string &filename, std::string newName, std::string &current_file);
+    void createFile(const std::string &filename);
+    std::vector<std::string> getBacklinks(const std::string &filename) const;
+    void flushSaves();
+
+    // The notes and data files whose background save failed since the last call
+    std::vector<std::string> takeSaveFailures();
+    const std::string& getDataPath() const;
+
+    // Word and character counts of a note as saved, and of every note together
+    TextStats::Counts getCounts(const std::string &filename) const;
+    TextStats::Counts getCorpusCounts() const { return corpus; }
+
+    // Lists the notes in a directory; setFiles takes the result when the list came from a session snapshot
+    static std::vector<std::string> scanNotes(const std::string &dir);
+    bool setFiles(const std::vector<std::string> &scanned);
+    void saveSession(const Session &session);
     
 private:
     std::string appDataPath;
     std::vector<std::string> files;
+    std::unordered_map<std::string, std::vector<std::uint64_t>> snapshots;  ///< Line hashes of each note as last read or written
+    LinkGraph links;
+    std::unique_ptr<SaveQueue> saves;    ///< Writes saved notes in the background
+    std::unordered_map<std::string, TextStats::Counts> counts;   ///< Counts of each note as last saved
+    TextStats::Counts corpus;            ///< Sum of counts
     
     void initializeAppDirectory();
     void scanExistingFiles();
     void createDefaultFileIfNeeded();
+    void finishRename();
+    void loadCounts();
+    void reconcileCounts();
+    void setCounts(const std::string &filename, const TextStats::Counts &note);
+    void writeCounts();
 };
 
 #endif
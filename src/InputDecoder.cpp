@@ -0,0 +1,453 @@
+#include "InputDecoder.h"
+#include "Settings.h"
+#include "Utf8.h"
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+InputDecoder* InputDecoder::current = nullptr;
+
+namespace {
+
+// Writes a whole escape sequence to a file descriptor
+void writeSequence(int fd, const char* sequence, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t written = ::write(fd, sequence + done, length - done);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        done += written;
+    }
+}
+
+}  // namespace
+
+/**
+ * @brief Constructs a decoder and builds its trie.
+ *
+ * ncurses must be set up, as the terminal's own sequences come from terminfo. They
+ * are added after the built in ones, so they win where the two disagree.
+ *
+ * @param fd_in The file descriptor keys are read from, normally standard input.
+ * @param out_fd_in The terminal's output, used to turn the kitty keyboard protocol on and off.
+ */
+InputDecoder::InputDecoder(int fd_in, int out_fd_in) : fd(fd_in), out_fd(out_fd_in) {
+    trie.emplace_back();
+
+    static const struct { const char* sequence; int key; } sequences[] = {
+        // xterm and vt220 CSI
+        {"\033[A", KEY_UP}, {"\033[B", KEY_DOWN}, {"\033[C", KEY_RIGHT}, {"\033[D", KEY_LEFT},
+        {"\033[H", KEY_HOME}, {"\033[F", KEY_END}, {"\033[Z", KEY_BTAB},
+        {"\033[1~", KEY_HOME}, {"\033[2~", KEY_IC}, {"\033[3~", KEY_DC}, {"\033[4~", KEY_END},
+        {"\033[5~", KEY_PPAGE}, {"\033[6~", KEY_NPAGE}, {"\033[7~", KEY_HOME}, {"\033[8~", KEY_END},
+        {"\033[11~", KEY_F(1)}, {"\033[12~", KEY_F(2)}, {"\033[13~", KEY_F(3)}, {"\033[14~", KEY_F(4)},
+        {"\033[15~", KEY_F(5)}, {"\033[17~", KEY_F(6)}, {"\033[18~", KEY_F(7)}, {"\033[19~", KEY_F(8)},
+        {"\033[20~", KEY_F(9)}, {"\033[21~", KEY_F(10)}, {"\033[23~", KEY_F(11)}, {"\033[24~", KEY_F(12)},
+        // SS3, sent in application keypad mode
+        {"\033OA", KEY_UP}, {"\033OB", KEY_DOWN}, {"\033OC", KEY_RIGHT}, {"\033OD", KEY_LEFT},
+        {"\033OH", KEY_HOME}, {"\033OF", KEY_END}, {"\033OM", '\n'},
+        {"\033OP", KEY_F(1)}, {"\033OQ", KEY_F(2)}, {"\033OR", KEY_F(3)}, {"\033OS", KEY_F(4)},
+        {"\033Oj", '*'}, {"\033Ok", '+'}, {"\033Ol", ','}, {"\033Om", '-'}, {"\033On", '.'},
+        {"\033Oo", '/'}, {"\033OX", '='}, {"\033Op", '0'}, {"\033Oq", '1'}, {"\033Or", '2'},
+        {"\033Os", '3'}, {"\033Ot", '4'}, {"\033Ou", '5'}, {"\033Ov", '6'}, {"\033Ow", '7'},
+        {"\033Ox", '8'}, {"\033Oy", '9'},
+        // linux console
+        {"\033[[A", KEY_F(1)}, {"\033[[B", KEY_F(2)}, {"\033[[C", KEY_F(3)}, {"\033[[D", KEY_F(4)},
+        {"\033[[E", KEY_F(5)},
+    };
+    for (const auto& entry : sequences) addSequence(entry.sequence, entry.key);
+
+    static const struct { const char* name; int key; } capabilities[] = {
+        {"kcuu1", KEY_UP}, {"kcud1", KEY_DOWN}, {"kcub1", KEY_LEFT}, {"kcuf1", KEY_RIGHT},
+        {"khome", KEY_HOME}, {"kend", KEY_END}, {"kpp", KEY_PPAGE}, {"knp", KEY_NPAGE},
+        {"kich1", KEY_IC}, {"kdch1", KEY_DC}, {"kcbt", KEY_BTAB}, {"kent", '\n'},
+        {"kri", withModifiers(KEY_UP, Shift)}, {"kind", withModifiers(KEY_DOWN, Shift)},
+        {"kLFT", withModifiers(KEY_LEFT, Shift)}, {"kRIT", withModifiers(KEY_RIGHT, Shift)},
+        {"kHOM", withModifiers(KEY_HOME, Shift)}, {"kEND", withModifiers(KEY_END, Shift)},
+        {"kDC", withModifiers(KEY_DC, Shift)},
+        {"kf1", KEY_F(1)}, {"kf2", KEY_F(2)}, {"kf3", KEY_F(3)}, {"kf4", KEY_F(4)},
+        {"kf5", KEY_F(5)}, {"kf6", KEY_F(6)}, {"kf7", KEY_F(7)}, {"kf8", KEY_F(8)},
+        {"kf9", KEY_F(9)}, {"kf10", KEY_F(10)}, {"kf11", KEY_F(11)}, {"kf12", KEY_F(12)},
+    };
+    for (const auto& entry : capabilities) addCapability(entry.name, entry.key);
+
+    char* sequence = tigetstr(const_cast<char*>("kbs"));
+    if (sequence && sequence != reinterpret_cast<char*>(-1) && sequence[0] && !sequence[1]) {
+        backspace = static_cast<unsigned char>(sequence[0]);
+    }
+}
+
+/**
+ * @brief Turns the kitty keyboard protocol off if it was turned on.
+ */
+InputDecoder::~InputDecoder() {
+    finish();
+}
+
+/**
+ * @brief Reads the next key.
+ *
+ * Everything the terminal sent is read at once, and the keys in it are returned one
+ * by one before standard input is read again. A sequence cut off at the end of what
+ * was read waits up to ESCAPE_TIMEOUT_MS for the rest; if nothing comes, its first
+ * byte is a key of its own, so a bare Escape is Escape.
+ *
+ * @param timeout_ms How long to wait for a key, forever if negative.
+ * @return The key, or ERR if none came in time or a signal interrupted the wait.
+ */
+int InputDecoder::read(int timeout_ms) {
+    if (!pending.empty()) {
+        int key = pending.front();
+        pending.pop_front();
+        return key;
+    }
+    if (KITTY_KEYBOARD && !protocol_on) {
+        writeSequence(out_fd, "\033[>1u", 5);  // Disambiguate escape codes
+        protocol_on = true;
+    }
+
+    while (true) {
+        int key = ERR;
+        Result result = start < input.size() ? decode(false, key) : Incomplete;
+        if (result == Decoded) return key;
+        if (result == Skipped) continue;
+
+        bool waiting = start < input.size();
+        int filled = fill(waiting ? ESCAPE_TIMEOUT_MS : timeout_ms);
+        if (filled < 0) return ERR;
+        if (filled == 0) {
+            if (!waiting) return ERR;
+            if (decode(true, key) == Decoded) return key;
+        }
+    }
+}
+
+/**
+ * @brief Makes a key the next one read.
+ *
+ * @param key The key, as returned by read().
+ */
+void InputDecoder::unread(int key) {
+    pending.push_front(key);
+}
+
+/**
+ * @brief Turns the kitty keyboard protocol off, if read() turned it on.
+ *
+ * Must run before the terminal leaves the alternate screen, which keeps its own setting.
+ */
+void InputDecoder::finish() {
+    if (!protocol_on) return;
+    writeSequence(out_fd, "\033[<u", 4);
+    protocol_on = false;
+}
+
+/**
+ * @brief Makes a decoder read the keys from now on.
+ *
+ * The decoder is not owned and must outlive its use.
+ *
+ * @param decoder The decoder, or nullptr to read keys with ncurses.
+ */
+void InputDecoder::use(InputDecoder* decoder) {
+    current = decoder;
+}
+
+/**
+ * @brief Reads a key with the active decoder, or with ncurses if there is none.
+ *
+ * @param win The window ncurses reads from; wgetch refreshes it first if it changed.
+ * @param timeout_ms How long to wait for a key, forever if negative.
+ * @return The key, or ERR if none came in time or a signal interrupted the wait.
+ */
+int InputDecoder::get(WINDOW* win, int timeout_ms) {
+    if (current) return current->read(timeout_ms);
+    wtimeout(win, timeout_ms);
+    int key = wgetch(win);
+    wtimeout(win, -1);
+    return key;
+}
+
+/**
+ * @brief Makes a key the next one get() returns.
+ *
+ * @param key The key.
+ */
+void InputDecoder::unget(int key) {
+    if (current) current->unread(key);
+    else ungetch(key);
+}
+
+/**
+ * @brief Adds an escape sequence to the trie.
+ *
+ * @param sequence The bytes the terminal sends.
+ * @param key The key they stand for; replaces the key of an equal sequence.
+ */
+void InputDecoder::addSequence(const char* sequence, int key) {
+    int node = 0;
+    for (const char* byte = sequence; *byte; ++byte) {
+        unsigned char value = static_cast<unsigned char>(*byte);
+        int child = -1;
+        for (const auto& edge : trie[node].next) {
+            if (edge.first == value) child = edge.second;
+        }
+        if (child < 0) {
+            child = (int)trie.size();
+            trie[node].next.push_back({value, child});
+            trie.emplace_back();
+        }
+        node = child;
+    }
+    trie[node].key = key;
+}
+
+/**
+ * @brief Adds the sequence of a terminfo key capability to the trie.
+ *
+ * Only escape sequences are added; single bytes are handled by decodeByte().
+ *
+ * @param name The capability name, like "kcuu1".
+ * @param key The key it stands for.
+ */
+void InputDecoder::addCapability(const char* name, int key) {
+    char* sequence = tigetstr(const_cast<char*>(name));
+    if (!sequence || sequence == reinterpret_cast<char*>(-1)) return;
+    if (sequence[0] == '\033' && sequence[1]) addSequence(sequence, key);
+}
+
+/**
+ * @brief Waits for input and appends all of it that is there.
+ *
+ * @param timeout_ms How long to wait, forever if negative.
+ * @return 1 if bytes were read, 0 on timeout, -1 if interrupted or input failed.
+ */
+int InputDecoder::fill(int timeout_ms) {
+    struct pollfd ready = {fd, POLLIN, 0};
+    int count = poll(&ready, 1, timeout_ms);
+    if (count < 0) return -1;
+    if (count == 0) return 0;
+
+    if (start > 0) {
+        input.erase(0, start);
+        start = 0;
+    }
+    size_t used = input.size();
+    input.resize(used + READ_SIZE);
+    ssize_t got = ::read(fd, &input[used], READ_SIZE);
+    input.resize(used + (got > 0 ? got : 0));
+    return got > 0 ? 1 : -1;
+}
+
+/**
+ * @brief Decodes the key at the start of the unread input.
+ *
+ * An escape sequence is looked up in the trie first, then parsed as CSI. An Escape
+ * before any other byte is that key held with Alt.
+ *
+ * @param expired Whether the escape timeout passed, so nothing more will complete a sequence.
+ * @param key Set to the key if one was decoded.
+ * @return Decoded, Skipped, or Incomplete if more bytes are needed; never Incomplete once expired.
+ */
+InputDecoder::Result InputDecoder::decode(bool expired, int& key) {
+    unsigned char byte = input[start];
+    if (byte != '\033') {
+        ++start;
+        key = decodeByte(byte);
+        return Decoded;
+    }
+
+    size_t length = 0;
+    Result result = matchTrie(expired, key, length);
+    if (result == Incomplete) return Incomplete;
+    if (result == Decoded) {
+        start += length;
+        return Decoded;
+    }
+
+    if (start + 1 >= input.size()) {
+        if (!expired) return Incomplete;
+        ++start;
+        key = 27;
+        return Decoded;
+    }
+    unsigned char next = input[start + 1];
+    if (next == '[') return decodeCsi(expired, key);
+    if (next == 'O' && start + 2 < input.size()) {
+        start += 3;  // An SS3 key the trie does not know
+        return Skipped;
+    }
+    if (next == 'O' && !expired) return Incomplete;
+    if (next == '\033' || next >= 128) {
+        ++start;
+        key = 27;
+        return Decoded;
+    }
+    start += 2;
+    key = withModifiers(decodeByte(next), Alt);
+    return Decoded;
+}
+
+/**
+ * @brief Finds the longest sequence in the trie that the unread input starts with.
+ *
+ * @param expired Whether the escape timeout passed.
+ * @param key Set to the key of the sequence.
+ * @param length Set to the length of the sequence.
+ * @return Decoded if a sequence matched, Incomplete if the input ran out inside the
+ *         trie before the timeout, Skipped if no sequence matched.
+ */
+InputDecoder::Result InputDecoder::matchTrie(bool expired, int& key, size_t& length) const {
+    int node = 0;
+    size_t i = start;
+    for (; i < input.size(); ++i) {
+        int child = -1;
+        for (const auto& edge : trie[node].next) {
+            if (edge.first == static_cast<unsigned char>(input[i])) child = edge.second;
+        }
+        if (child < 0) break;
+        node = child;
+        if (trie[node].key) {
+            key = trie[node].key;
+            length = i - start + 1;
+        }
+    }
+    if (i == input.size() && !trie[node].next.empty() && !expired) return Incomplete;
+    return length > 0 ? Decoded : Skipped;
+}
+
+/**
+ * @brief Parses a CSI sequence: ESC [, parameters, and a final byte.
+ *
+ * Parameters are numbers split by ';', with ':' before sub-parameters. Cursor and
+ * function keys carry their modifiers as the second number (ESC [ 1 ; 5 A); xterm's
+ * modifyOtherKeys sends ESC [ 27 ; modifiers ; code ~ and the kitty protocol sends
+ * ESC [ code ; modifiers u. Replies to queries, mouse reports and key releases are
+ * skipped. If no final byte came before the timeout, ESC [ was Alt+[.
+ *
+ * @param expired Whether the escape timeout passed.
+ * @param key Set to the key if one was decoded.
+ * @return Decoded, Skipped, or Incomplete if the final byte did not arrive yet.
+ */
+InputDecoder::Result InputDecoder::decodeCsi(bool expired, int& key) {
+    size_t end = start + 2;
+    while (end < input.size() && input[end] >= 0x20 && input[end] <= 0x3f) ++end;
+    unsigned char final_byte = end < input.size() ? input[end] : 0;
+    if (end == input.size() && !expired) return Incomplete;
+    if (final_byte < 0x40 || final_byte > 0x7e) {
+        start += 2;
+        key = withModifiers('[', Alt);
+        return Decoded;
+    }
+
+    std::string parameters = input.substr(start + 2, end - start - 2);
+    start = end + 1;
+    int values[4][3] = {};
+    int field = 0, sub = 0;
+    for (char c : parameters) {
+        if (c == ';') {
+            ++field;
+            sub = 0;
+        } else if (c == ':') {
+            ++sub;
+        } else if (c < '0' || c > '9') {
+            return Skipped;  // A private marker or an intermediate byte
+        } else if (field < 4 && sub < 3 && values[field][sub] < 1000000) {
+            values[field][sub] = values[field][sub] * 10 + (c - '0');
+        }
+    }
+    if (values[1][1] == 3) return Skipped;  // Released
+
+    // The parameter is 1 plus the bits; kitty's meta counts as Alt, the lock keys are ignored
+    int bits = values[1][0] > 0 ? values[1][0] - 1 : 0;
+    int modifiers = bits & (Shift | Alt | Ctrl);
+    if (bits & 32) modifiers |= Alt;
+
+    int named = 0;
+    switch (final_byte) {
+        case 'A': named = KEY_UP; break;
+        case 'B': named = KEY_DOWN; break;
+        case 'C': named = KEY_RIGHT; break;
+        case 'D': named = KEY_LEFT; break;
+        case 'H': named = KEY_HOME; break;
+        case 'F': named = KEY_END; break;
+        case 'P': named = KEY_F(1); break;
+        case 'Q': named = KEY_F(2); break;
+        case 'R': named = KEY_F(3); break;
+        case 'S': named = KEY_F(4); break;
+        case 'Z': named = KEY_BTAB; modifiers &= ~Shift; break;
+        case 'u':
+            key = decodeCode(values[0][0], modifiers);
+            return key == ERR ? Skipped : Decoded;
+        case '~': {
+            int number = values[0][0];
+            if (number == 27) {
+                key = decodeCode(values[2][0], modifiers);
+                return key == ERR ? Skipped : Decoded;
+            }
+            static const int tilde_keys[] = {
+                0, KEY_HOME, KEY_IC, KEY_DC, KEY_END, KEY_PPAGE, KEY_NPAGE, KEY_HOME, KEY_END, 0,
+                0, KEY_F(1), KEY_F(2), KEY_F(3), KEY_F(4), KEY_F(5), 0, KEY_F(6), KEY_F(7), KEY_F(8),
+                KEY_F(9), KEY_F(10), 0, KEY_F(11), KEY_F(12),
+            };
+            if (number < (int)(sizeof(tilde_keys) / sizeof(tilde_keys[0]))) named = tilde_keys[number];
+            break;
+        }
+    }
+    if (named == 0) return Skipped;
+    key = withModifiers(named, modifiers);
+    return Decoded;
+}
+
+/**
+ * @brief Decodes a byte that is not part of an escape sequence.
+ *
+ * Enter sends a carriage return, read as '\n' like ncurses does. Backspace sends DEL
+ * or ^H, as terminfo says; terminals send the other one for Ctrl+Backspace.
+ *
+ * @param byte The byte.
+ * @return The key.
+ */
+int InputDecoder::decodeByte(unsigned char byte) const {
+    if (byte == '\r') return '\n';
+    if (byte == backspace) return KEY_BACKSPACE;
+    if (byte == 127 || byte == 8) return withModifiers(KEY_BACKSPACE, Ctrl);
+    return byte;
+}
+
+/**
+ * @brief Decodes a key sent as a code point with modifiers.
+ *
+ * Ctrl with a letter or one of @[\]^_ gives the control byte that terminals send
+ * without the kitty protocol, so the key bindings stay the same. A character beyond
+ * ASCII gives its UTF-8 bytes, the first one now and the rest on the next reads, as
+ * if it had been typed as text. Held with Alt or Ctrl it is no key: its code point
+ * would run into the modifier bits of withModifiers(), and no binding uses one.
+ *
+ * @param code The Unicode code point, or the key code of Escape, Enter, Tab or Backspace.
+ * @param modifiers The modifiers held.
+ * @return The key, or ERR for keys without one, like a modifier pressed alone.
+ */
+int InputDecoder::decodeCode(int code, int modifiers) {
+    if (code >= 57344 && code <= 63743) return ERR;  // Kitty's own codes: keypad, media and modifier keys
+    if (code >= 128) {
+        if (modifiers & ~Shift) return ERR;     // Shift is already in the character
+        std::string bytes;
+        Utf8::encode(code, bytes);
+        for (size_t i = 1; i < bytes.size(); ++i) pending.push_back(static_cast<unsigned char>(bytes[i]));
+        return static_cast<unsigned char>(bytes[0]);
+    }
+    if (code == '\t' && modifiers == Shift) return KEY_BTAB;
+
+    int key = code;
+    if (code == 13) key = '\n';
+    if (code == 127 || code == 8) key = KEY_BACKSPACE;
+    if ((modifiers & Ctrl) && ((code >= '@' && code <= '_') || (code >= 'a' && code <= 'z') || code == ' ')) {
+        key = code & 0x1f;
+        modifiers &= ~(Ctrl | Shift);
+    }
+    if (key >= 32 && key < 127) modifiers &= ~Shift;    // Already in the character
+    return withModifiers(key, modifiers);
+}
@@ -0,0 +1,99 @@
+/**
+ * @file InputDecoder.h
+ * @brief Header file for the InputDecoder class, which turns the bytes typed into the terminal into keys.
+ *
+ * ncurses decodes keys itself but waits ESCDELAY, a second by default, after a bare
+ * Escape or an Alt combination, and only knows the sequences in terminfo. The decoder
+ * reads standard input in batches and matches escape sequences against a trie built
+ * from terminfo and the usual xterm, vt220 and linux console sequences. Sequences not
+ * in the trie are parsed as CSI: modifier parameters (ESC [ 1 ; 5 A), xterm's
+ * modifyOtherKeys and the kitty keyboard protocol (ESC [ 127 ; 5 u). An Escape
+ * with nothing after it is a key once ESCAPE_TIMEOUT_MS passed; terminals speaking
+ * the kitty protocol send Escape as a sequence of its own, so there is no wait.
+ *
+ * Keys are the ints the rest of the editor already compares against: bytes for text
+ * and control keys, ncurses KEY_ codes for named keys, and withModifiers() for keys
+ * held with Shift, Alt or Ctrl that have no code of their own. Without an active
+ * decoder, as in the benchmarks, keys come from ncurses.
+ */
+
+#ifndef INPUT_DECODER_H
+#define INPUT_DECODER_H
+
+#include <ncurses.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+class InputDecoder {
+public:
+    enum Modifier {
+        Shift = 1,
+        Alt = 2,
+        Ctrl = 4,
+    };
+
+    // A key held with modifiers; the modifiers go above KEY_MAX, so it never equals a plain key
+    static constexpr int withModifiers(int key, int modifiers) {
+        return modifiers ? (modifiers << 9) | key : key;
+    }
+
+    // Reads from fd; out_fd is told to use the kitty keyboard protocol before the first read
+    InputDecoder(int fd, int out_fd);
+    ~InputDecoder();
+
+    InputDecoder(const InputDecoder&) = delete;
+    InputDecoder& operator=(const InputDecoder&) = delete;
+
+    // Waits up to timeout_ms for a key, forever if negative; ERR on timeout or a signal
+    int read(int timeout_ms = -1);
+
+    // Makes a key the next one read
+    void unread(int key);
+
+    // Turns the kitty keyboard protocol off again, called by the destructor
+    void finish();
+
+    // Makes a decoder read the keys from now on, nullptr goes back to ncurses
+    static void use(InputDecoder* decoder);
+
+    // A key from the active decoder, or from the window with ncurses
+    static int get(WINDOW* win = stdscr, int timeout_ms = -1);
+    static void unget(int key);
+
+private:
+    enum Result {
+        Decoded,        ///< A key was read
+        Skipped,        ///< A sequence was read that is no key, like a key release
+        Incomplete,     ///< The bytes so far may start a longer sequence
+    };
+
+    struct Node {
+        int key = 0;                                        ///< Set if a sequence ends here
+        std::vector<std::pair<unsigned char, int>> next;    ///< Byte and index of the child
+    };
+
+    static constexpr size_t READ_SIZE = 4096;
+
+    int fd;
+    int out_fd;
+    bool protocol_on = false;
+    std::vector<Node> trie;     ///< Escape sequences; the root is trie[0]
+    std::string input;          ///< Bytes read and not decoded yet, from `start`
+    size_t start = 0;
+    std::deque<int> pending;    ///< Keys to return before decoding more
+    int backspace = 127;        ///< The byte Backspace sends; the other of DEL and ^H is Ctrl+Backspace
+
+    static InputDecoder* current;
+
+    void addSequence(const char* sequence, int key);
+    void addCapability(const char* name, int key);
+    int fill(int timeout_ms);
+    Result decode(bool expired, int& key);
+    Result matchTrie(bool expired, int& key, size_t& length) const;
+    Result decodeCsi(bool expired, int& key);
+    int decodeByte(unsigned char byte) const;
+    int decodeCode(int code, int modifiers);
+};
+
+#endif // INPUT_DECODER_H
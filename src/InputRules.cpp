@@ -0,0 +1,224 @@
+#include "InputRules.h"
+#include "Settings.h"
+#include <algorithm>
+#include <cctype>
+#include <map>
+
+/**
+ * @brief Compiles rules and pairs into an automaton.
+ *
+ * @param rule_list The rules, earlier ones win when several match.
+ * @param rule_count Number of rules.
+ * @param pair_list The pairs.
+ * @param pair_count Number of pairs.
+ */
+InputRules::InputRules(const Rule* rule_list, size_t rule_count, const Pair* pair_list, size_t pair_count)
+    : pairs(pair_list, pair_list + pair_count) {
+    std::vector<std::vector<Atom>> patterns;
+    for (size_t i = 0; i < rule_count; ++i) {
+        std::vector<Atom> before = parse(rule_list[i].before);
+        std::vector<Atom> trigger = parse(rule_list[i].trigger);
+        before.insert(before.end(), trigger.begin(), trigger.end());
+        patterns.push_back(before);
+        rules.push_back({trigger, rule_list[i].replacement});
+    }
+    build(patterns);
+}
+
+/**
+ * @brief Returns the rules and pairs declared in Settings.h.
+ */
+const InputRules& InputRules::standard() {
+    static const InputRules compiled(INPUT_RULES, sizeof(INPUT_RULES) / sizeof(INPUT_RULES[0]),
+                                     INPUT_PAIRS, sizeof(INPUT_PAIRS) / sizeof(INPUT_PAIRS[0]));
+    return compiled;
+}
+
+/**
+ * @brief Runs the automaton over the start of a line.
+ *
+ * @param line The line.
+ * @param col Number of bytes to run over.
+ * @return The state for a cursor at col.
+ */
+int InputRules::stateAt(const std::string& line, size_t col) const {
+    int state = line_start;
+    for (size_t i = 0; i < col && i < line.size(); ++i) {
+        state = advance(state, line[i]);
+    }
+    return state;
+}
+
+/**
+ * @brief Works out the edit of the rule a state matched.
+ *
+ * The automaton only knows that a rule matched, not where its trigger starts, so
+ * the trigger is matched backwards from the cursor, repeats taking as much as
+ * they can.
+ *
+ * @param state The state after the byte just typed.
+ * @param line The line, with the typed byte in it.
+ * @param col The cursor, just after the typed byte.
+ * @param edit Set to the replacement if a rule matched.
+ * @return Whether a rule matched.
+ */
+bool InputRules::expand(int state, const std::string& line, size_t col, Edit& edit) const {
+    if (matched[state] < 0) return false;
+    const Compiled& rule = rules[matched[state]];
+
+    size_t start = col;
+    for (auto atom = rule.trigger.rbegin(); atom != rule.trigger.rend(); ++atom) {
+        if (atom->symbol == LINE_START) {
+            if (start != 0) return false;
+        } else if (atom->repeat) {
+            while (start > 0 && matches(*atom, (unsigned char)line[start - 1])) --start;
+        } else if (start > 0 && matches(*atom, (unsigned char)line[start - 1])) {
+            --start;
+        } else {
+            return false;
+        }
+    }
+
+    edit.start = start;
+    edit.end = col;
+    edit.text.clear();
+    size_t cursor = std::string::npos;
+    const std::string& replacement = rule.replacement;
+    for (size_t i = 0; i < replacement.size(); ++i) {
+        if (replacement[i] == '$' && i + 1 < replacement.size()) {
+            char next = replacement[++i];
+            if (next == '&') edit.text += line.substr(start, col - start);
+            else if (next == '|') cursor = edit.text.size();
+            else edit.text += next;
+        } else {
+            edit.text += replacement[i];
+        }
+    }
+    edit.cursor = start + (cursor == std::string::npos ? edit.text.size() : cursor);
+    return true;
+}
+
+/**
+ * @brief Finds the pair a key inserts.
+ */
+const InputRules::Pair* InputRules::pairFor(int key) const {
+    for (const Pair& pair : pairs) {
+        if (pair.key == key) return &pair;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Splits a pattern into atoms.
+ *
+ * @param pattern The pattern, see Rule.
+ * @return One atom per byte, digit class or line start.
+ */
+std::vector<InputRules::Atom> InputRules::parse(const char* pattern) {
+    std::vector<Atom> atoms;
+    for (const char* c = pattern; *c; ++c) {
+        if ((*c == '+' || *c == '*') && !atoms.empty() && !atoms.back().repeat && atoms.back().symbol != LINE_START) {
+            // x+ is any number of x followed by x, so matching backwards leaves the last x for x
+            if (*c == '+') atoms.insert(atoms.end() - 1, atoms.back());
+            atoms[atoms.size() - (*c == '+' ? 2 : 1)].repeat = true;
+        } else if (*c == '^') {
+            atoms.push_back({LINE_START, false});
+        } else if (*c == '\\' && c[1]) {
+            ++c;
+            atoms.push_back({*c == 'd' ? DIGIT : (unsigned char)*c, false});
+        } else {
+            atoms.push_back({(unsigned char)*c, false});
+        }
+    }
+    return atoms;
+}
+
+/**
+ * @brief Checks whether an atom accepts a symbol.
+ */
+bool InputRules::matches(const Atom& atom, int symbol) {
+    if (atom.symbol == DIGIT) return symbol < 256 && std::isdigit(symbol);
+    return atom.symbol == symbol;
+}
+
+/**
+ * @brief Builds the transition table recognizing any pattern as a suffix.
+ *
+ * Each pattern is a chain of positions, a position before a repeated atom loops
+ * on it and may also skip it. A start position that loops on every symbol lets a
+ * match begin anywhere. The subsets of positions reachable after some input are
+ * the states, found breadth first, so the table has one row per distinct subset
+ * instead of one state per position in the line.
+ *
+ * @param patterns The full pattern of each rule, context and trigger.
+ */
+void InputRules::build(const std::vector<std::vector<Atom>>& patterns) {
+    // Position 0 is the start; pattern p's positions follow from base[p], its last one accepts
+    std::vector<int> base;
+    int positions = 1;
+    for (const auto& pattern : patterns) {
+        base.push_back(positions);
+        positions += pattern.size() + 1;
+    }
+    auto atomAt = [&](int position, size_t& pattern) -> const Atom* {
+        for (pattern = 0; pattern + 1 < base.size() && base[pattern + 1] <= position; ++pattern) {}
+        size_t index = position - base[pattern];
+        return index < patterns[pattern].size() ? &patterns[pattern][index] : nullptr;
+    };
+    auto close = [&](std::vector<int> set) {
+        std::vector<bool> seen(positions, false);
+        std::vector<int> closed;
+        while (!set.empty()) {
+            int position = set.back();
+            set.pop_back();
+            if (seen[position]) continue;
+            seen[position] = true;
+            closed.push_back(position);
+            size_t pattern;
+            if (position == 0) {
+                for (int start : base) set.push_back(start);
+            } else if (const Atom* atom = atomAt(position, pattern)) {
+                if (atom->repeat) set.push_back(position + 1);
+            }
+        }
+        std::sort(closed.begin(), closed.end());
+        return closed;
+    };
+
+    std::map<std::vector<int>, int> ids;
+    std::vector<std::vector<int>> states;
+    auto stateFor = [&](const std::vector<int>& set) {
+        auto found = ids.find(set);
+        if (found != ids.end()) return found->second;
+        int id = states.size();
+        ids.emplace(set, id);
+        states.push_back(set);
+
+        int rule = -1;
+        for (int position : set) {
+            size_t pattern;
+            if (position != 0 && !atomAt(position, pattern) && (rule < 0 || (int)pattern < rule)) rule = pattern;
+        }
+        matched.push_back(rule);
+        return id;
+    };
+
+    int start = stateFor(close({0}));
+    for (size_t state = 0; state < states.size(); ++state) {
+        for (int symbol = 0; symbol < SYMBOLS; ++symbol) {
+            std::vector<int> next;
+            for (int position : states[state]) {
+                size_t pattern;
+                if (position == 0) {
+                    next.push_back(0);
+                } else if (const Atom* atom = atomAt(position, pattern)) {
+                    if (matches(*atom, symbol)) next.push_back(atom->repeat ? position : position + 1);
+                }
+            }
+            int target = stateFor(close(next));
+            table.resize(states.size() * SYMBOLS, 0);
+            table[state * SYMBOLS + symbol] = target;
+        }
+    }
+    line_start = table[start * SYMBOLS + LINE_START];
+}
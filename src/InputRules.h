@@ -0,0 +1,90 @@
+/**
+ * @file InputRules.h
+ * @brief Header file for the InputRules class, the automatic expansions applied while typing.
+ *
+ * A rule replaces what was just typed when the text left of the cursor ends with
+ * its trigger, like "1. " at the start of a line becoming an indented list item.
+ * All rules are compiled once into a single automaton that recognizes every
+ * trigger as a suffix of the line, so the editor keeps the automaton's state for
+ * the cursor and advances it by one transition per typed byte; a line is only
+ * scanned again after the cursor moved or a rule fired. Pairs are keys that insert
+ * an opening and closing marker around the cursor, or step over the closing one.
+ * The rules and pairs in use are declared in Settings.h.
+ */
+
+#ifndef INPUT_RULES_H
+#define INPUT_RULES_H
+
+#include <string>
+#include <vector>
+
+class InputRules {
+public:
+    // Patterns are bytes matched literally, except ^ for the start of the line,
+    // \d for a digit, and + or * after a byte or \d to repeat it; \ escapes the rest.
+    // In replacements $& is the trigger as it was typed and $| places the cursor.
+    struct Rule {
+        const char* before;         ///< Pattern that must come right before the trigger, not replaced
+        const char* trigger;        ///< Pattern of the text replaced, ending with the byte just typed
+        const char* replacement;
+    };
+
+    struct Pair {
+        int key;
+        const char* open;
+        const char* close;
+    };
+
+    // Replaces [start, end) of the line with text and puts the cursor at `cursor`
+    struct Edit {
+        size_t start;
+        size_t end;
+        std::string text;
+        size_t cursor;
+    };
+
+    InputRules(const Rule* rules, size_t rule_count, const Pair* pairs, size_t pair_count);
+
+    // The rules and pairs from Settings.h, compiled on first use
+    static const InputRules& standard();
+
+    // State at the start of a line, and after the bytes of a line up to a column
+    int lineStart() const { return line_start; }
+    int stateAt(const std::string& line, size_t col) const;
+
+    int advance(int state, unsigned char byte) const { return table[state * SYMBOLS + byte]; }
+
+    // Finds the edit of the rule a state matched, with the cursor at col after the typed byte
+    bool expand(int state, const std::string& line, size_t col, Edit& edit) const;
+
+    // The pair a key inserts, nullptr if none
+    const Pair* pairFor(int key) const;
+
+private:
+    static constexpr int SYMBOLS = 257;     ///< The bytes and the start of a line
+    static constexpr int LINE_START = 256;
+
+    struct Atom {
+        int symbol;         ///< A byte, LINE_START, or DIGIT
+        bool repeat;        ///< Matches any number of times
+    };
+
+    static constexpr int DIGIT = -1;
+
+    struct Compiled {
+        std::vector<Atom> trigger;
+        std::string replacement;
+    };
+
+    std::vector<Compiled> rules;
+    std::vector<Pair> pairs;
+    std::vector<int> table;         ///< Transitions, SYMBOLS per state
+    std::vector<int> matched;       ///< Rule each state matched, -1 if none
+    int line_start = 0;
+
+    static std::vector<Atom> parse(const char* pattern);
+    static bool matches(const Atom& atom, int symbol);
+    void build(const std::vector<std::vector<Atom>>& patterns);
+};
+
+#endif // INPUT_RULES_H
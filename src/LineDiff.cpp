@@ -0,0 +1,70 @@
+#include "LineDiff.h"
+#include <functional>
+
+/**
+ * @brief Hashes one line of a note.
+ *
+ * @param line The line to hash.
+ * @return The hash of the line.
+ */
+std::uint64_t LineDiff::hashLine(const std::string& line) {
+    return std::hash<std::string>{}(line);
+}
+
+/**
+ * @brief Hashes every line of a note.
+ *
+ * @param lines The lines of the note.
+ * @return One hash per line.
+ */
+std::vector<std::uint64_t> LineDiff::hashLines(const std::vector<std::string>& lines) {
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(lines.size());
+    for (const std::string& line : lines) {
+        hashes.push_back(hashLine(line));
+    }
+    return hashes;
+}
+
+/**
+ * @brief Finds the window of lines that changed between two versions of a note.
+ *
+ * Skips the lines both versions start with, then the lines both end with. The
+ * lines in between are the ones that were inserted, removed or edited; lines
+ * after the window only moved by `newEnd - oldEnd`.
+ *
+ * @param oldHashes The line hashes of the previous version.
+ * @param newHashes The line hashes of the new version.
+ * @return The changed window.
+ */
+LineDiff LineDiff::between(const std::vector<std::uint64_t>& oldHashes,
+                           const std::vector<std::uint64_t>& newHashes) {
+    int oldSize = (int)oldHashes.size();
+    int newSize = (int)newHashes.size();
+
+    int start = 0;
+    while (start < oldSize && start < newSize && oldHashes[start] == newHashes[start]) {
+        start++;
+    }
+
+    int oldEnd = oldSize;
+    int newEnd = newSize;
+    while (oldEnd > start && newEnd > start && oldHashes[oldEnd - 1] == newHashes[newEnd - 1]) {
+        oldEnd--;
+        newEnd--;
+    }
+
+    return LineDiff{false, start, oldEnd, newEnd};
+}
+
+/**
+ * @brief Makes a diff that treats every line of a note as new.
+ *
+ * Used the first time a note is seen, when there is no previous version to compare with.
+ *
+ * @param lineCount The number of lines in the note.
+ * @return The diff.
+ */
+LineDiff LineDiff::everything(int lineCount) {
+    return LineDiff{true, 0, 0, lineCount};
+}
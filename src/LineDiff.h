@@ -0,0 +1,37 @@
+/**
+ * @file LineDiff.h
+ * @brief Header file for LineDiff, the range of lines that changed between two versions of a note.
+ *
+ * Notes are compared through one hash per line. The lines both versions start
+ * and end with are skipped, so an edit in one place only leaves a small window
+ * of lines to look at, however long the note is.
+ */
+
+#ifndef LINE_DIFF_H
+#define LINE_DIFF_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+struct LineDiff {
+    bool full = true;   ///< No previous version was known, every line is new
+    int start = 0;      ///< First changed line, the same in both versions
+    int oldEnd = 0;     ///< End of the changed lines in the previous version
+    int newEnd = 0;     ///< End of the changed lines in the new version
+
+    // Hashes one line of a note
+    static std::uint64_t hashLine(const std::string& line);
+
+    // Hashes every line of a note
+    static std::vector<std::uint64_t> hashLines(const std::vector<std::string>& lines);
+
+    // Finds the changed window between two versions of a note
+    static LineDiff between(const std::vector<std::uint64_t>& oldHashes,
+                            const std::vector<std::uint64_t>& newHashes);
+
+    // A diff where every line of the new version is new
+    static LineDiff everything(int lineCount);
+};
+
+#endif // LINE_DIFF_H
@@ -0,0 +1,287 @@
+#include "LinkGraph.h"
+#include <filesystem>
+#include <fstream>
+
+/**
+ * @brief Constructs an empty LinkGraph stored in a directory.
+ *
+ * @param linksDir The directory holding one file of outgoing links per note, with a trailing slash.
+ */
+LinkGraph::LinkGraph(const std::string& linksDir) : dir(linksDir) {}
+
+/**
+ * @brief Reads the stored outgoing links of every note and builds the backlinks.
+ *
+ * Each file holds one `count target` line per linked note. Per line positions are
+ * not stored, so the first save of a note in a session rescans the whole note.
+ */
+void LinkGraph::load() {
+    if (!std::filesystem::is_directory(dir)) return;
+
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (!entry.is_regular_file()) continue;
+
+        std::string note = entry.path().filename().string();
+        NoteLinks& links = forward[note];
+        std::ifstream file(entry.path());
+        int count;
+        std::string target;
+        while (file >> count && std::getline(file >> std::ws, target)) {
+            if (count <= 0 || target.empty()) continue;
+            links.targets[target] += count;
+            back[target][note] += count;
+        }
+    }
+}
+
+/**
+ * @brief Finds the first `[[target]]` or `[[target|label]]` link at or after a position.
+ *
+ * The target may not contain brackets or line breaks and may not be empty.
+ *
+ * @param line The line to search.
+ * @param from The position to start at.
+ * @param link Set to the link that was found.
+ * @return `true` if a link was found.
+ */
+bool LinkGraph::findLink(const std::string& line, size_t from, Link& link) {
+    size_t start = line.find("[[", from);
+    while (start != std::string::npos) {
+        size_t close = line.find("]]", start + 2);
+        if (close == std::string::npos) return false;
+
+        std::string inside = line.substr(start + 2, close - start - 2);
+        if (!inside.empty() && inside.find_first_of("[]") == std::string::npos) {
+            size_t bar = inside.find('|');
+            link.start = start;
+            link.end = close + 2;
+            link.target = inside.substr(0, bar);
+            link.labelStart = (bar == std::string::npos) ? start + 2 : start + 3 + bar;
+            link.labelEnd = close;
+            if (!link.target.empty() && link.labelStart < link.labelEnd) return true;
+        }
+        start = line.find("[[", start + 1);
+    }
+    return false;
+}
+
+/**
+ * @brief Rewrites the links to one note in a line so they point to another.
+ *
+ * Labels are kept, only the targets change.
+ *
+ * @param line The line to rewrite.
+ * @param oldName The note the links point to.
+ * @param newName The note the links should point to.
+ * @return The rewritten line.
+ */
+std::string LinkGraph::retarget(const std::string& line, const std::string& oldName, const std::string& newName) {
+    std::string result;
+    size_t copied = 0;
+    Link link;
+    for (size_t from = 0; findLink(line, from, link); from = link.end) {
+        if (link.target != oldName) continue;
+        result.append(line, copied, link.start + 2 - copied);
+        result += newName;
+        copied = link.start + 2 + oldName.length();
+    }
+    result.append(line, copied, std::string::npos);
+    return result;
+}
+
+/**
+ * @brief Updates a note's links from the lines that changed since its last save.
+ *
+ * Only the changed window is parsed. The links the window held before are taken
+ * out of the graph and the links it holds now are put in, then the note's file of
+ * outgoing links is rewritten if anything changed.
+ *
+ * @param note The name of the saved note.
+ * @param lines The lines that were saved.
+ * @param diff The lines that changed.
+ */
+void LinkGraph::update(const std::string& note, const std::vector<std::string>& lines, const LineDiff& diff) {
+    NoteLinks& links = forward[note];
+
+    int start = diff.start;
+    int oldEnd = diff.oldEnd;
+    int newEnd = diff.newEnd;
+    int oldSize = (int)links.lines.size();
+    bool rescan = !links.scanned || diff.full || oldSize - oldEnd != (int)lines.size() - newEnd;
+    if (rescan) {
+        // Nothing to compare with, drop every stored link of the note and parse it all
+        std::vector<std::string> stale;
+        for (const auto& [target, count] : links.targets) {
+            stale.insert(stale.end(), count, target);
+        }
+        removeLinks(note, stale);
+        links.lines.clear();
+        links.scanned = true;
+        start = 0;
+        oldEnd = 0;
+        newEnd = (int)lines.size();
+    }
+
+    std::vector<std::string> removed;
+    for (int i = start; i < oldEnd; ++i) {
+        removed.insert(removed.end(), links.lines[i].begin(), links.lines[i].end());
+    }
+
+    std::vector<std::vector<std::string>> window(newEnd - start);
+    std::vector<std::string> added;
+    for (int i = start; i < newEnd; ++i) {
+        Link link;
+        for (size_t from = 0; findLink(lines[i], from, link); from = link.end) {
+            window[i - start].push_back(link.target);
+            added.push_back(link.target);
+        }
+    }
+
+    links.lines.erase(links.lines.begin() + start, links.lines.begin() + oldEnd);
+    links.lines.insert(links.lines.begin() + start,
+                       std::make_move_iterator(window.begin()), std::make_move_iterator(window.end()));
+
+    if (removed == added && !rescan) return;
+    removeLinks(note, removed);
+    addLinks(note, added);
+    write(note);
+}
+
+/**
+ * @brief Forgets a deleted note's outgoing links.
+ *
+ * Links from other notes to it are kept, they point to a note that can be created again.
+ *
+ * @param note The name of the deleted note.
+ */
+void LinkGraph::remove(const std::string& note) {
+    auto links = forward.find(note);
+    if (links == forward.end()) return;
+
+    for (const auto& [target, count] : links->second.targets) {
+        auto sources = back.find(target);
+        if (sources == back.end()) continue;
+        sources->second.erase(note);
+        if (sources->second.empty()) back.erase(sources);
+    }
+    forward.erase(links);
+    std::filesystem::remove(dir + note);
+}
+
+/**
+ * @brief Moves a note and every link pointing to it to a new name.
+ *
+ * The notes linking to it must already have been rewritten on disk. Their stored
+ * targets are renamed in place, so they do not need to be parsed again.
+ *
+ * @param oldName The previous name of the note.
+ * @param newName The new name of the note.
+ */
+void LinkGraph::rename(const std::string& oldName, const std::string& newName) {
+    // The note's own outgoing links
+    auto own = forward.find(oldName);
+    if (own != forward.end()) {
+        NoteLinks moved = std::move(own->second);
+        forward.erase(own);
+        for (const auto& [target, count] : moved.targets) {
+            auto& sources = back[target];
+            sources.erase(oldName);
+            sources[newName] += count;
+        }
+        forward[newName] = std::move(moved);
+        std::filesystem::remove(dir + oldName);
+        write(newName);
+    }
+
+    // Links from other notes
+    auto incoming = back.find(oldName);
+    if (incoming == back.end()) return;
+    std::unordered_map<std::string, int> sources = std::move(incoming->second);
+    back.erase(incoming);
+
+    for (const auto& [source, count] : sources) {
+        std::string from = (source == oldName) ? newName : source;
+        NoteLinks& links = forward[from];
+        links.targets.erase(oldName);
+        links.targets[newName] += count;
+        for (auto& line : links.lines) {
+            for (std::string& target : line) {
+                if (target == oldName) target = newName;
+            }
+        }
+        back[newName][from] += count;
+        write(from);
+    }
+}
+
+/**
+ * @brief Gets the notes that link to a note.
+ *
+ * Reads the note's backlink set directly, so the cost is proportional to the
+ * number of linking notes, not to the number of notes.
+ *
+ * @param note The linked note.
+ * @return The names of the notes linking to it.
+ */
+std::vector<std::string> LinkGraph::backlinks(const std::string& note) const {
+    std::vector<std::string> sources;
+    auto found = back.find(note);
+    if (found != back.end()) {
+        sources.reserve(found->second.size());
+        for (const auto& [source, count] : found->second) {
+            sources.push_back(source);
+        }
+    }
+    return sources;
+}
+
+/**
+ * @brief Adds links from a note to the forward and backward maps.
+ *
+ * @param note The linking note.
+ * @param targets One entry per link.
+ */
+void LinkGraph::addLinks(const std::string& note, const std::vector<std::string>& targets) {
+    NoteLinks& links = forward[note];
+    for (const std::string& target : targets) {
+        links.targets[target]++;
+        back[target][note]++;
+    }
+}
+
+/**
+ * @brief Removes links from a note from the forward and backward maps.
+ *
+ * @param note The linking note.
+ * @param targets One entry per link.
+ */
+void LinkGraph::removeLinks(const std::string& note, const std::vector<std::string>& targets) {
+    NoteLinks& links = forward[note];
+    for (const std::string& target : targets) {
+        if (--links.targets[target] <= 0) links.targets.erase(target);
+
+        auto sources = back.find(target);
+        if (sources == back.end()) continue;
+        if (--sources->second[note] <= 0) sources->second.erase(note);
+        if (sources->second.empty()) back.erase(sources);
+    }
+}
+
+/**
+ * @brief Writes a note's outgoing links to its file, or removes the file if it has none.
+ *
+ * @param note The linking note.
+ */
+void LinkGraph::write(const std::string& note) const {
+    auto links = forward.find(note);
+    if (links == forward.end() || links->second.targets.empty()) {
+        std::filesystem::remove(dir + note);
+        return;
+    }
+
+    std::filesystem::create_directories(dir);
+    std::ofstream file(dir + note);
+    for (const auto& [target, count] : links->second.targets) {
+        file << count << " " << target << "\n";
+    }
+}
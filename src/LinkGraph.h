@@ -0,0 +1,69 @@
+/**
+ * @file LinkGraph.h
+ * @brief Header file for the LinkGraph class, the graph of `[[Note Name]]` links between notes.
+ *
+ * The graph keeps every note's outgoing links and, for every note, the notes linking
+ * to it, so backlinks are found without reading any file. Saving a note only rescans
+ * the lines that changed. Each note's outgoing links are stored in its own file in
+ * the links directory, so a save only rewrites that one file.
+ */
+
+#ifndef LINK_GRAPH_H
+#define LINK_GRAPH_H
+
+#include "LineDiff.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+class LinkGraph {
+public:
+    // A [[target]] or [[target|label]] link in a line
+    struct Link {
+        size_t start;           ///< Position of the opening brackets
+        size_t end;             ///< Position just past the closing brackets
+        size_t labelStart;      ///< Position of the text shown for the link
+        size_t labelEnd;        ///< Position just past the text shown for the link
+        std::string target;
+    };
+
+    LinkGraph(const std::string& linksDir);
+
+    // Reads the stored links of every note
+    void load();
+
+    // Updates a note's links from the lines that changed since its last save
+    void update(const std::string& note, const std::vector<std::string>& lines, const LineDiff& diff);
+
+    // Forgets a deleted note's outgoing links
+    void remove(const std::string& note);
+
+    // Moves a note and every link pointing to it to a new name
+    void rename(const std::string& oldName, const std::string& newName);
+
+    // Notes linking to a note, in time proportional to their number
+    std::vector<std::string> backlinks(const std::string& note) const;
+
+    // Finds the first link starting at or after a position, returns false if there is none
+    static bool findLink(const std::string& line, size_t from, Link& link);
+
+    // Rewrites the links to one note in a line to point to another
+    static std::string retarget(const std::string& line, const std::string& oldName, const std::string& newName);
+
+private:
+    struct NoteLinks {
+        bool scanned = false;                           ///< Per line links are known this session
+        std::vector<std::vector<std::string>> lines;    ///< Targets linked from each line
+        std::unordered_map<std::string, int> targets;   ///< Target -> number of links to it
+    };
+
+    std::string dir;
+    std::unordered_map<std::string, NoteLinks> forward;
+    std::unordered_map<std::string, std::unordered_map<std::string, int>> back;   ///< Target -> source -> links
+
+    void addLinks(const std::string& note, const std::vector<std::string>& targets);
+    void removeLinks(const std::string& note, const std::vector<std::string>& targets);
+    void write(const std::string& note) const;
+};
+
+#endif // LINK_GRAPH_H
@@ -125,5 +125,5 @@ void MainMenu::drawMenu() const {
         mvwprintw(win_, rowPrint + 1, (COLS - 4) / 2, "exit");
         wattroff(win_, COLOR_PAIR(1));
     }
-    wrefresh(win_);
+    wnoutrefresh(win_);
 }
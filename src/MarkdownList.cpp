@@ -0,0 +1,94 @@
+#include "MarkdownList.h"
+#include <algorithm>
+#include <cctype>
+
+/**
+ * @brief Finds the list item a line starts with.
+ *
+ * Accepts `- text`, `12. text`, `3) text` and either with a `[ ]`, `[x]` or `[X]`
+ * box, with any indentation. An item may have no text yet, like `- ` just typed.
+ *
+ * @param line The line to parse.
+ * @param item Set to the positions of the item's parts.
+ * @return `true` if the line is a list item.
+ */
+bool MarkdownList::parse(const std::string& line, Item& item) {
+    size_t i = line.find_first_not_of(" \t");
+    if (i == std::string::npos) return false;
+    item.indent = i;
+    item.numbered = false;
+    item.number = 0;
+    item.checkbox = std::string::npos;
+
+    if (line[i] == '-' || line[i] == '*' || line[i] == '+') {
+        item.number_end = i;
+        ++i;
+    } else {
+        size_t digits = i;
+        while (i < line.size() && i - digits < 9 && std::isdigit((unsigned char)line[i])) ++i;
+        if (i == digits || i >= line.size() || (line[i] != '.' && line[i] != ')')) return false;
+        item.numbered = true;
+        item.number = std::stol(line.substr(digits, i - digits));
+        item.number_end = i;
+        ++i;
+    }
+    if (i >= line.size() || line[i] != ' ') return false;
+    ++i;
+
+    if (line.size() >= i + 3 && line[i] == '[' && line[i + 2] == ']'
+        && (line[i + 1] == ' ' || line[i + 1] == 'x' || line[i + 1] == 'X')
+        && (line.size() == i + 3 || line[i + 3] == ' ')) {
+        item.checkbox = i;
+        i = std::min(line.size(), i + 4);
+    }
+    item.text_start = i;
+    return true;
+}
+
+/**
+ * @brief Builds the marker that starts the item after one.
+ *
+ * @param line The line of the item.
+ * @param item The item parsed from the line.
+ * @return The indentation, bullet or next number and an empty box if the item had one.
+ */
+std::string MarkdownList::nextMarker(const std::string& line, const Item& item) {
+    std::string marker = line.substr(0, item.text_start);
+    if (item.checkbox != std::string::npos) marker[item.checkbox + 1] = ' ';
+    if (item.numbered) {
+        marker.replace(item.indent, item.number_end - item.indent, std::to_string(item.number + 1));
+    }
+    if (item.checkbox != std::string::npos && marker.back() != ' ') marker += ' ';
+    return marker;
+}
+
+/**
+ * @brief Numbers the items following a numbered item.
+ *
+ * Lines indented deeper than the item belong to it and are skipped. The walk ends
+ * at a blank line, a line that is not an item at the same indentation, or an item
+ * whose number is already right, since everything after it is unchanged.
+ *
+ * @param lines The lines of the note.
+ * @param row The row of the numbered item to count from.
+ * @return One past the last row whose number was rewritten, row + 1 if none was.
+ */
+int MarkdownList::renumber(std::vector<std::string>& lines, int row) {
+    Item item;
+    if (!parse(lines[row], item) || !item.numbered) return row + 1;
+
+    int end = row + 1;
+    long next = item.number + 1;
+    for (size_t i = row + 1; i < lines.size(); ++i) {
+        size_t indent = lines[i].find_first_not_of(" \t");
+        if (indent == std::string::npos || indent < item.indent) break;
+        if (indent > item.indent) continue;
+
+        Item following;
+        if (!parse(lines[i], following) || !following.numbered || following.number == next) break;
+        lines[i].replace(following.indent, following.number_end - following.indent, std::to_string(next));
+        end = i + 1;
+        ++next;
+    }
+    return end;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file MarkdownList.h
+ * @brief Header file for the MarkdownList class, which continues and renumbers markdown lists.
+ *
+ * A list item is a line starting, after its indentation, with a bullet (`-`, `*`
+ * or `+`) or a number (`3.` or `3)`), optionally followed by a checkbox. Pressing
+ * Enter on an item starts the next one, and a numbered list is renumbered from
+ * the new item on. Renumbering walks only the list the item belongs to, the items
+ * at the same indentation up to a blank line or a shallower line, and stops at the
+ * first item that already has the right number, so only numbers that change are
+ * rewritten.
+ */
+
+#ifndef MARKDOWN_LIST_H
+#define MARKDOWN_LIST_H
+
+#include <string>
+#include <vector>
+
+class MarkdownList {
+public:
+    struct Item {
+        size_t indent;              ///< Position of the bullet or number
+        bool numbered;
+        long number;
+        size_t number_end;          ///< Position just past the digits
+        size_t checkbox;            ///< Position of the [ ] box, npos if there is none
+        size_t text_start;          ///< Position of the item's text
+    };
+
+    // Finds the list item a line starts with, returns false if it is none
+    static bool parse(const std::string& line, Item& item);
+
+    // The marker of the item after one, with its number one higher and its box empty
+    static std::string nextMarker(const std::string& line, const Item& item);
+
+    // Numbers the items after a numbered item on from it, returns one past the last line rewritten
+    static int renumber(std::vector<std::string>& lines, int row);
+};
+
+#endif // MARKDOWN_LIST_H
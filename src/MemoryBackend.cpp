@@ -0,0 +1,27 @@
+#include "MemoryBackend.h"
+
+/**
+ * @brief Copies the virtual screen as the new frame and counts the cells that changed.
+ *
+ * After a resize or invalidate() every cell counts as changed.
+ */
+void MemoryBackend::show() {
+    std::swap(frame, previous);
+    frame.capture(newscr);
+    getyx(newscr, cursor_y, cursor_x);
+    ++frames;
+
+    bool same_size = previous.rows() == frame.rows() && previous.cols() == frame.cols();
+    for (int y = 0; y < frame.rows(); ++y) {
+        for (int x = 0; x < frame.cols(); ++x) {
+            if (!same_size || frame.at(y, x) != previous.at(y, x)) ++changed_cells;
+        }
+    }
+}
+
+/**
+ * @brief Forgets the last frame, so the next one counts as changed everywhere.
+ */
+void MemoryBackend::invalidate() {
+    frame = CellGrid();
+}
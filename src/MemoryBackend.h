@@ -0,0 +1,41 @@
+/**
+ * @file MemoryBackend.h
+ * @brief Header file for the MemoryBackend class, which keeps frames in memory instead of showing them.
+ *
+ * Each frame is copied from the virtual screen into a CellGrid and compared with
+ * the one before, so tests can read what would be on screen and benchmarks can
+ * count how much of it changed, without a terminal.
+ */
+
+#ifndef MEMORY_BACKEND_H
+#define MEMORY_BACKEND_H
+
+#include "RenderBackend.h"
+#include "CellGrid.h"
+#include <cstdint>
+
+class MemoryBackend : public RenderBackend {
+public:
+    void show() override;
+    void invalidate() override;
+
+    // The last frame shown
+    const CellGrid& screen() const { return frame; }
+    int cursorRow() const { return cursor_y; }
+    int cursorCol() const { return cursor_x; }
+
+    std::uint64_t frameCount() const { return frames; }
+
+    // Cells that differed from the frame before, summed over all frames
+    std::uint64_t changedCellCount() const { return changed_cells; }
+
+private:
+    CellGrid frame;
+    CellGrid previous;
+    int cursor_y = 0;
+    int cursor_x = 0;
+    std::uint64_t frames = 0;
+    std::uint64_t changed_cells = 0;
+};
+
+#endif // MEMORY_BACKEND_H
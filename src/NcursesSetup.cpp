@@ -1,5 +1,10 @@
 #include "NcursesSetup.h"
 #include "Settings.h"
+#include <clocale>
+#include <cstdlib>
+#include <string>
+#include <sys/ioctl.h>
+#include <unistd.h>
 /**
  * @brief Constructs an NcursesSetup object.
  * 
@@ -28,14 +33,91 @@ NcursesSetup::~NcursesSetup() {
  * @return `true` if the Ncurses setup is successful, otherwise `false`.
  */
 bool NcursesSetup::initialize() {
-    // ncurses setup
+    // ncurses setup, with the user's locale so UTF-8 text is read and drawn as characters
+    setlocale(LC_ALL, "");
     initscr();
+    return configure();
+}
+
+/**
+ * @brief Initializes Ncurses on a virtual screen that is never shown.
+ *
+ * The screen is an xterm of the given size writing to /dev/null and reading from it,
+ * so windows are drawn and diffed exactly as on a real terminal but nothing is seen
+ * and getch returns ERR at once. Used by the benchmarks.
+ *
+ * @param lines Height of the virtual screen.
+ * @param cols Width of the virtual screen.
+ * @param output_in Where ncurses writes its output, /dev/null if nullptr. Not closed.
+ * @return `true` if the setup is successful, otherwise `false`.
+ */
+bool NcursesSetup::initializeHeadless(int lines, int cols, FILE *output_in) {
+    setlocale(LC_ALL, "");
+    owns_output = output_in == nullptr;
+    output = output_in ? output_in : fopen("/dev/null", "w");
+    input = fopen("/dev/null", "r");
+    if (!output || !input) return false;
+
+    // /dev/null has no size, so ncurses takes it from the environment
+    setenv("LINES", std::to_string(lines).c_str(), 1);
+    setenv("COLUMNS", std::to_string(cols).c_str(), 1);
+    screen = newterm("xterm-256color", output, input);
+    if (!screen) return false;
+    set_term(screen);
+    return configure();
+}
+
+/**
+ * @brief Initializes Ncurses to read keys from the terminal while a backend draws.
+ *
+ * ncurses writes to /dev/null, or to a file the backend sends on, and reads from
+ * standard input. It sets the terminal modes on the file it writes to, so raw mode
+ * is set on standard input here and restored by cleanup(). The virtual screen gets
+ * the size of the terminal.
+ *
+ * @param output_in Where ncurses writes its output, /dev/null if nullptr. Not closed.
+ * @return `false` if standard input or output is not a terminal.
+ */
+bool NcursesSetup::initializeDirect(FILE *output_in) {
+    setlocale(LC_ALL, "");
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) return false;
+
+    tcgetattr(STDIN_FILENO, &saved_tty);
+    tty_saved = true;
+    struct termios raw_tty = saved_tty;
+    cfmakeraw(&raw_tty);
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw_tty);
+
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+        setenv("LINES", std::to_string(size.ws_row).c_str(), 1);
+        setenv("COLUMNS", std::to_string(size.ws_col).c_str(), 1);
+    }
+    owns_output = output_in == nullptr;
+    output = output_in ? output_in : fopen("/dev/null", "w");
+    if (!output) return false;
+    screen = newterm(nullptr, output, stdin);
+    if (!screen) return false;
+    set_term(screen);
+    if (!configure()) return false;
+    meta(stdscr, TRUE);  // ncurses would only pass 8 bit input if /dev/null were an 8 bit terminal
+    return true;
+}
+
+/**
+ * @brief Sets the input modes and colors of the current screen.
+ *
+ * @return `false` if the terminal has no colors.
+ */
+bool NcursesSetup::configure() {
     cbreak();
     noecho();
     raw();
     use_default_colors();
     keypad(stdscr, TRUE);
     intrflush(stdscr, FALSE);
+    idlok(stdscr, TRUE);     // Lets doupdate scroll the terminal when the rows of a pane moved
+    typeahead(-1);           // Finish every frame, even if keys are waiting; InputDecoder reads them
 
     start_color();
 
@@ -55,6 +137,12 @@ bool NcursesSetup::initialize() {
     init_pair(6, COLOR_MAGENTA, -1);		///< Color 5
     init_pair(7, COLOR_CYAN, -1);		///< Color 6
     init_pair(9, COLOR_WHITE, COLOR_BLACK);	///< Codeblock
+    init_pair(10, COLOR_RED, COLOR_BLACK);	///< Code keyword
+    init_pair(11, COLOR_YELLOW, COLOR_BLACK);	///< Code literal
+    init_pair(12, COLOR_CYAN, COLOR_BLACK);	///< Code string
+    init_pair(13, COLOR_GREEN, COLOR_BLACK);	///< Code number
+    init_pair(14, COLOR_WHITE, COLOR_BLACK);	///< Code comment, drawn dim
+    init_pair(15, COLOR_BLUE, COLOR_BLACK);	///< Code directive, decorator or variable
     
     if (!has_colors()) {
         printw("Terminal does not support color");
@@ -73,4 +161,15 @@ bool NcursesSetup::initialize() {
  */
 void NcursesSetup::cleanup() {
     endwin();
+    if (screen) {
+        delscreen(screen);
+        screen = nullptr;
+    }
+    if (output && owns_output) fclose(output);
+    if (input) fclose(input);
+    output = input = nullptr;
+    if (tty_saved) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved_tty);
+        tty_saved = false;
+    }
 }
@@ -14,6 +14,8 @@
 #define NCURSES_SETUP_H
 
 #include <ncurses.h>
+#include <cstdio>
+#include <termios.h>
 
 class NcursesSetup {
 public:
@@ -21,7 +23,24 @@ public:
     ~NcursesSetup();
     
     bool initialize();
+
+    // Draws into a virtual screen of the given size that is never shown, for benchmarks
+    bool initializeHeadless(int lines, int cols, FILE *output_in = nullptr);
+
+    // Reads keys from the terminal but leaves writing to it to a render backend
+    bool initializeDirect(FILE *output_in = nullptr);
+
     void cleanup();
+
+private:
+    SCREEN *screen = nullptr;   ///< Set for a headless screen only
+    FILE *output = nullptr;     ///< Owned when it is /dev/null
+    FILE *input = nullptr;
+    bool owns_output = false;
+    bool tty_saved = false;
+    struct termios saved_tty;   ///< Terminal modes to restore after initializeDirect
+
+    bool configure();
 };
 
 #endif
@@ -0,0 +1,329 @@
+#include "NoteSync.h"
+#include <fstream>
+
+/**
+ * @brief Constructs a NoteSync for the notes in a directory.
+ *
+ * @param notesDir The directory holding the notes, with a trailing slash.
+ */
+NoteSync::NoteSync(const std::string& notesDir) : notesDir(notesDir) {}
+
+/**
+ * @brief Finds a markdown checkbox at the start of a line.
+ *
+ * Accepts `- [ ] text`, `* [x] text` and `+ [X] text`, with any indentation.
+ *
+ * @param line The line to parse.
+ * @param checked Set to whether the box is ticked.
+ * @param text Set to the text after the box.
+ * @param mark Set to the position of the character between the brackets.
+ * @return `true` if the line is a checkbox with some text.
+ */
+bool NoteSync::parseCheckbox(const std::string& line, bool& checked, std::string& text, size_t& mark) {
+    size_t i = line.find_first_not_of(" \t");
+    if (i == std::string::npos || line.size() < i + 6) return false;
+    if (line[i] != '-' && line[i] != '*' && line[i] != '+') return false;
+    if (line[i + 1] != ' ' || line[i + 2] != '[' || line[i + 4] != ']' || line[i + 5] != ' ') return false;
+
+    char box = line[i + 3];
+    if (box != ' ' && box != 'x' && box != 'X') return false;
+
+    size_t start = line.find_first_not_of(" \r", i + 6);
+    if (start == std::string::npos) return false;
+    size_t end = line.find_last_not_of(" \r");
+
+    checked = (box != ' ');
+    text = line.substr(start, end - start + 1);
+    mark = i + 3;
+    return true;
+}
+
+/**
+ * @brief Groups the board's linked tasks by note, once per session.
+ *
+ * A note that was not saved yet this session has no line state, so the first time
+ * it is scanned its checkboxes are matched with these tasks by text.
+ *
+ * @param board The board holding the linked tasks.
+ */
+void NoteSync::indexLinkedTasks(Board& board) {
+    if (indexed) return;
+    indexed = true;
+
+    for (int type = 0; type < board.columnCount(); ++type) {
+        for (int slot = board.getColumn(type).head; slot != -1; slot = board.getNode(slot).next) {
+            const Task& task = board.getNode(slot).task;
+            if (!task.getNote().empty()) {
+                unscanned[task.getNote()].push_back(task.getId());
+            }
+        }
+    }
+}
+
+/**
+ * @brief Creates, updates and removes the tasks of a note's checkboxes after it was saved.
+ *
+ * Only the changed window of lines is scanned, the lines around it keep their tasks.
+ *
+ * @param board The board holding the linked tasks.
+ * @param note The name of the saved note.
+ * @param lines The lines that were saved.
+ * @param diff The lines that changed since the last load or save.
+ * @return `true` if any task was added, removed, renamed or moved.
+ */
+bool NoteSync::noteSaved(Board& board, const std::string& note, const std::vector<std::string>& lines,
+                         const LineDiff& diff) {
+    indexLinkedTasks(board);
+    return scan(board, note, notes[note], lines, diff, true);
+}
+
+/**
+ * @brief Brings the tasks of a changed window of lines up to date.
+ *
+ * Checkboxes in the window are matched with the tasks the window held before:
+ * first by text, so lines that moved keep their task, then by position, so a line
+ * whose text was edited keeps its task and gets the new title. Leftover tasks are
+ * removed and leftover checkboxes get new tasks. Ticked boxes go to the last column
+ * and unticked boxes that were in the last column go back to the first one.
+ *
+ * @param board The board holding the linked tasks.
+ * @param note The name of the note.
+ * @param state The line state of the note, updated in place.
+ * @param lines The lines of the note.
+ * @param diff The changed window.
+ * @param applyChecks Whether existing tasks follow the state of their checkbox.
+ * @return `true` if any task changed.
+ */
+bool NoteSync::scan(Board& board, const std::string& note, NoteState& state,
+                    const std::vector<std::string>& lines, LineDiff diff, bool applyChecks) {
+    // The lines after the window must line up with the stored state, otherwise rescan everything
+    int oldSize = (int)state.taskIds.size();
+    if (!diff.full && oldSize - diff.oldEnd != (int)lines.size() - diff.newEnd) {
+        diff.full = true;
+    }
+    if (diff.full) {
+        diff = LineDiff{true, 0, oldSize, (int)lines.size()};
+    }
+
+    // Tasks the window held before, by position, followed by tasks of a note not seen yet
+    std::vector<int> candidates(state.taskIds.begin() + diff.start, state.taskIds.begin() + diff.oldEnd);
+    auto waiting = unscanned.find(note);
+    if (waiting != unscanned.end()) {
+        candidates.insert(candidates.end(), waiting->second.begin(), waiting->second.end());
+        unscanned.erase(waiting);
+    }
+
+    std::unordered_multimap<std::string, int> byTitle;
+    for (int i = 0; i < (int)candidates.size(); ++i) {
+        int slot = candidates[i] == -1 ? -1 : board.findSlot(candidates[i]);
+        if (slot == -1) {
+            candidates[i] = -1;
+        } else {
+            byTitle.emplace(board.getNode(slot).task.getTitle(), i);
+        }
+    }
+
+    struct Checkbox {
+        bool found = false;
+        bool checked = false;
+        std::string text;
+        int candidate = -1;
+    };
+    int windowSize = diff.newEnd - diff.start;
+    std::vector<Checkbox> boxes(windowSize);
+    for (int i = 0; i < windowSize; ++i) {
+        size_t mark;
+        Checkbox& box = boxes[i];
+        box.found = parseCheckbox(lines[diff.start + i], box.checked, box.text, mark);
+        if (!box.found) continue;
+
+        auto range = byTitle.equal_range(box.text);
+        for (auto match = range.first; match != range.second; ++match) {
+            if (candidates[match->second] != -1) {
+                box.candidate = match->second;
+                candidates[match->second] = -1 - candidates[match->second];   // Mark as used
+                byTitle.erase(match);
+                break;
+            }
+        }
+    }
+
+    // Edited lines keep the task of the line that was in the same place
+    int positional = diff.oldEnd - diff.start;
+    for (int i = 0; i < windowSize && i < positional; ++i) {
+        if (boxes[i].found && boxes[i].candidate == -1 && candidates[i] >= 0) {
+            boxes[i].candidate = i;
+            candidates[i] = -1 - candidates[i];
+        }
+    }
+
+    bool changed = false;
+    int done = board.columnCount() - 1;
+    std::vector<int> windowIds(windowSize, -1);
+    for (int i = 0; i < windowSize; ++i) {
+        const Checkbox& box = boxes[i];
+        if (!box.found) continue;
+
+        if (box.candidate == -1) {
+            int slot = board.addTask(box.text, box.checked ? done : 0, note);
+            windowIds[i] = board.getNode(slot).task.getId();
+            changed = true;
+            continue;
+        }
+
+        int taskId = -1 - candidates[box.candidate];
+        int slot = board.findSlot(taskId);
+        windowIds[i] = taskId;
+        if (board.getNode(slot).task.getTitle() != box.text) {
+            board.renameTask(slot, box.text);
+            changed = true;
+        }
+
+        int status = board.getNode(slot).task.getStatus();
+        if (applyChecks && box.checked && status != done) {
+            board.moveTask(slot, done);
+            changed = true;
+        } else if (applyChecks && !box.checked && status == done && done != 0) {
+            board.moveTask(slot, 0);
+            changed = true;
+        }
+    }
+
+    // Checkboxes that disappeared take their task with them
+    for (int candidate : candidates) {
+        if (candidate >= 0) {
+            board.removeTask(board.findSlot(candidate));
+            changed = true;
+        }
+    }
+
+    state.taskIds.erase(state.taskIds.begin() + diff.start, state.taskIds.begin() + diff.oldEnd);
+    state.taskIds.insert(state.taskIds.begin() + diff.start, windowIds.begin(), windowIds.end());
+    state.hashes.erase(state.hashes.begin() + std::min(diff.start, (int)state.hashes.size()),
+                       state.hashes.begin() + std::min(diff.oldEnd, (int)state.hashes.size()));
+    std::vector<std::uint64_t> windowHashes;
+    windowHashes.reserve(windowSize);
+    for (int i = diff.start; i < diff.newEnd; ++i) {
+        windowHashes.push_back(LineDiff::hashLine(lines[i]));
+    }
+    state.hashes.insert(state.hashes.begin() + diff.start, windowHashes.begin(), windowHashes.end());
+    return changed;
+}
+
+/**
+ * @brief Ticks or unticks the checkbox of a linked task so it matches the task's column.
+ *
+ * The box is ticked when the task is in the last column. Only the one character
+ * between the brackets is written, the rest of the note is left untouched. If the
+ * line no longer holds the task's checkbox, for example because the note was
+ * changed outside the editor, nothing is written.
+ *
+ * @param board The board holding the task.
+ * @param slot The pool slot of the task that moved.
+ */
+void NoteSync::taskMoved(Board& board, int slot) {
+    const Task& task = board.getNode(slot).task;
+    const std::string note = task.getNote();
+    const int taskId = task.getId();
+    const bool checked = (task.getStatus() == board.columnCount() - 1);
+    if (note.empty()) return;
+
+    std::string path = notesDir + note + ".md";
+    auto found = notes.find(note);
+    if (found == notes.end()) {
+        // First time this note is needed, read it without moving any task
+        std::ifstream in(path);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(in, line)) {
+            lines.push_back(line);
+        }
+        indexLinkedTasks(board);
+        found = notes.emplace(note, NoteState{}).first;
+        scan(board, note, found->second, lines, LineDiff::everything((int)lines.size()), false);
+    }
+    NoteState& state = found->second;
+
+    int target = -1;
+    for (int i = 0; i < (int)state.taskIds.size(); ++i) {
+        if (state.taskIds[i] == taskId) {
+            target = i;
+            break;
+        }
+    }
+    if (target == -1) return;
+
+    // Find where the line starts in the file
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file) return;
+    std::string line;
+    std::streamoff offset = 0;
+    for (int i = 0; i <= target; ++i) {
+        offset = file.tellg();
+        if (!std::getline(file, line)) return;
+    }
+
+    bool wasChecked;
+    std::string text;
+    size_t mark;
+    if (LineDiff::hashLine(line) != state.hashes[target] || !parseCheckbox(line, wasChecked, text, mark)) return;
+    if (wasChecked == checked) return;
+
+    line[mark] = checked ? 'x' : ' ';
+    file.clear();
+    file.seekp(offset + (std::streamoff)mark);
+    file.put(line[mark]);
+    file.close();
+
+    state.hashes[target] = LineDiff::hashLine(line);
+    patched.insert(note);
+}
+
+/**
+ * @brief Moves the links of a note's tasks to its new name.
+ *
+ * @param board The board holding the linked tasks.
+ * @param oldName The previous name of the note.
+ * @param newName The new name of the note.
+ */
+void NoteSync::noteRenamed(Board& board, const std::string& oldName, const std::string& newName) {
+    indexLinkedTasks(board);
+
+    std::vector<int> taskIds;
+    auto state = notes.find(oldName);
+    if (state != notes.end()) {
+        taskIds = state->second.taskIds;
+        NoteState moved = std::move(state->second);
+        notes.erase(state);
+        notes[newName] = std::move(moved);
+    }
+    auto waiting = unscanned.find(oldName);
+    if (waiting != unscanned.end()) {
+        taskIds.insert(taskIds.end(), waiting->second.begin(), waiting->second.end());
+        std::vector<int> moved = std::move(waiting->second);
+        unscanned.erase(waiting);
+        unscanned[newName] = std::move(moved);
+    }
+
+    for (int taskId : taskIds) {
+        int slot = taskId == -1 ? -1 : board.findSlot(taskId);
+        if (slot != -1) {
+            board.linkNote(slot, newName);
+        }
+    }
+    if (patched.erase(oldName)) {
+        patched.insert(newName);
+    }
+}
+
+/**
+ * @brief Checks whether a note's file was patched since the last call.
+ *
+ * Lets the editor reload a note whose checkbox was ticked from the board.
+ *
+ * @param note The name of the note.
+ * @return `true` if a checkbox in the note was written.
+ */
+bool NoteSync::takePatched(const std::string& note) {
+    return patched.erase(note) > 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file NoteSync.h
+ * @brief Header file for the NoteSync class, which keeps markdown checkboxes and kanban tasks in step.
+ *
+ * Every `- [ ] item` line in a note becomes a task on the first board, linked back
+ * to the note. Saving a note only rescans the lines that changed, and moving a
+ * linked task in or out of the last column ticks or unticks its checkbox in place.
+ */
+
+#ifndef NOTE_SYNC_H
+#define NOTE_SYNC_H
+
+#include "Board.h"
+#include "LineDiff.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+class NoteSync {
+public:
+    NoteSync(const std::string& notesDir);
+
+    // Creates, updates and removes the tasks of a note's checkboxes after the note was saved
+    bool noteSaved(Board& board, const std::string& note, const std::vector<std::string>& lines,
+                   const LineDiff& diff);
+
+    // Ticks or unticks the checkbox of a linked task so it matches the task's column
+    void taskMoved(Board& board, int slot);
+
+    // Moves the links of a note's tasks to its new name
+    void noteRenamed(Board& board, const std::string& oldName, const std::string& newName);
+
+    // Checks whether a note's file was patched since the last call
+    bool takePatched(const std::string& note);
+
+private:
+    struct NoteState {
+        std::vector<std::uint64_t> hashes;  ///< Hash of each line as last seen
+        std::vector<int> taskIds;           ///< Task of each line, -1 if the line has no checkbox
+    };
+
+    std::string notesDir;
+    std::unordered_map<std::string, NoteState> notes;
+    std::unordered_map<std::string, std::vector<int>> unscanned;   ///< Linked tasks of notes not seen yet
+    std::unordered_set<std::string> patched;
+    bool indexed = false;
+
+    void indexLinkedTasks(Board& board);
+    bool scan(Board& board, const std::string& note, NoteState& state,
+              const std::vector<std::string>& lines, LineDiff diff, bool applyChecks);
+    static bool parseCheckbox(const std::string& line, bool& checked, std::string& text, size_t& mark);
+};
+
+#endif // NOTE_SYNC_H
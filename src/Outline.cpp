@@ -0,0 +1,343 @@
+#include "Outline.h"
+#include <algorithm>
+
+namespace {
+
+// Screen rows taken by the lines before one, one per line when the wrap map is off
+int rowsBefore(const WrapMap& wrap, int line) {
+    return wrap.isActive() ? wrap.rowsBefore(line) : line;
+}
+
+bool byLine(const Outline::Heading& heading, int line) {
+    return heading.line < line;
+}
+
+}
+
+/**
+ * @brief Finds the headings and fences of a new buffer, with nothing folded.
+ *
+ * @param lines The buffer.
+ */
+void Outline::reset(const std::vector<std::string>& lines) {
+    marks.clear();
+    folded.clear();
+    hidden.clear();
+    rows_valid = false;
+    line_count = (int)lines.size();
+    for (int i = 0; i < line_count; ++i) {
+        int level = markLevel(lines[i]);
+        if (level >= 0) marks.push_back({i, level});
+    }
+    cached_valid = false;
+}
+
+/**
+ * @brief Updates the outline for the lines touched by an edit.
+ *
+ * Only the changed lines are scanned; the marks and folds after them move by the
+ * number of lines added or removed. A folded heading that was edited stays folded
+ * if it is still a heading.
+ *
+ * @param lines The buffer after the edit.
+ * @param start First line that changed.
+ * @param oldEnd End of the changed lines before the edit.
+ * @param newEnd End of the changed lines after the edit.
+ */
+void Outline::edited(const std::vector<std::string>& lines, int start, int oldEnd, int newEnd) {
+    if (line_count - oldEnd != (int)lines.size() - newEnd || start < 0 || start > oldEnd || oldEnd > line_count) {
+        reset(lines);
+        return;
+    }
+    int delta = newEnd - oldEnd;
+    line_count = (int)lines.size();
+
+    std::vector<Heading> found;
+    for (int i = start; i < newEnd; ++i) {
+        int level = markLevel(lines[i]);
+        if (level >= 0) found.push_back({i, level});
+    }
+    auto first = std::lower_bound(marks.begin(), marks.end(), start, byLine);
+    auto last = std::lower_bound(first, marks.end(), oldEnd, byLine);
+    bool changed = delta != 0 || !std::equal(first, last, found.begin(), found.end(),
+        [](const Heading& a, const Heading& b) { return a.line == b.line && a.level == b.level; });
+    if (!changed) return;
+
+    for (auto mark = last; mark != marks.end(); ++mark) mark->line += delta;
+    marks.insert(marks.erase(first, last), found.begin(), found.end());
+    cached_valid = false;
+
+    std::vector<int> kept;
+    for (int line : folded) {
+        if (line >= oldEnd) kept.push_back(line + delta);
+        else if (line < start || (line < newEnd && headingLevel(lines[line]) > 0)) kept.push_back(line);
+    }
+    folded = std::move(kept);
+    rebuildHidden();
+}
+
+/**
+ * @brief Lists the heading lines, leaving out `#` lines inside fenced code.
+ */
+const std::vector<Outline::Heading>& Outline::headings() const {
+    if (!cached_valid) {
+        cached.clear();
+        bool in_code = false;
+        for (const Heading& mark : marks) {
+            if (mark.level == 0) in_code = !in_code;
+            else if (!in_code) cached.push_back(mark);
+        }
+
+        // Walking back, a stack of the headings seen holds the next one of each level or higher
+        cached_ends.assign(cached.size(), -1);
+        std::vector<int> open;
+        for (int i = (int)cached.size() - 1; i >= 0; --i) {
+            while (!open.empty() && cached[open.back()].level > cached[i].level) open.pop_back();
+            if (!open.empty()) cached_ends[i] = open.back();
+            open.push_back(i);
+        }
+        cached_valid = true;
+    }
+    return cached;
+}
+
+/**
+ * @brief Finds the innermost section holding a line.
+ *
+ * @param line The line.
+ * @return The index of the section's heading in headings(), -1 before the first one.
+ */
+int Outline::sectionOf(int line) const {
+    const std::vector<Heading>& list = headings();
+    return (int)(std::upper_bound(list.begin(), list.end(), line,
+        [](int at, const Heading& heading) { return at < heading.line; }) - list.begin()) - 1;
+}
+
+/**
+ * @brief Folds or unfolds the section holding a line.
+ *
+ * A section with no lines under its heading is not folded.
+ *
+ * @param line A line of the section.
+ * @return The heading line, or -1 if nothing changed.
+ */
+int Outline::toggleFold(int line) {
+    int section = sectionOf(line);
+    if (section < 0) return -1;
+    int heading = headings()[section].line;
+
+    auto at = std::lower_bound(folded.begin(), folded.end(), heading);
+    if (at != folded.end() && *at == heading) {
+        folded.erase(at);
+    } else if (sectionEnd(section) > heading + 1) {
+        folded.insert(at, heading);
+    } else {
+        return -1;
+    }
+    rebuildHidden();
+    return heading;
+}
+
+/**
+ * @brief Unfolds the folds hiding a line, so it is shown.
+ *
+ * @param line The line.
+ */
+void Outline::reveal(int line) {
+    while (isHidden(line)) {
+        int heading = hidden[hiddenIndex(line)].first - 1;
+        folded.erase(std::remove(folded.begin(), folded.end(), heading), folded.end());
+        rebuildHidden();
+    }
+}
+
+/**
+ * @brief Checks whether a line is a folded heading.
+ */
+bool Outline::isFolded(int line) const {
+    return std::binary_search(folded.begin(), folded.end(), line) && !isHidden(line);
+}
+
+/**
+ * @brief Checks whether a line is inside a folded section.
+ */
+bool Outline::isHidden(int line) const {
+    int index = hiddenIndex(line);
+    return index >= 0 && line < hidden[index].second;
+}
+
+/**
+ * @brief Counts the lines a folded heading hides.
+ *
+ * @param line The heading line.
+ * @return The number of hidden lines, 0 if the heading is not folded.
+ */
+int Outline::foldedLines(int line) const {
+    int index = hiddenIndex(line + 1);
+    if (index < 0 || hidden[index].first != line + 1) return 0;
+    return hidden[index].second - hidden[index].first;
+}
+
+/**
+ * @brief Skips forward over the fold hiding a line.
+ */
+int Outline::nextVisible(int line) const {
+    int index = hiddenIndex(line);
+    return index >= 0 && line < hidden[index].second ? hidden[index].second : line;
+}
+
+/**
+ * @brief Skips back over the fold hiding a line, to its heading.
+ */
+int Outline::prevVisible(int line) const {
+    int index = hiddenIndex(line);
+    return index >= 0 && line < hidden[index].second ? hidden[index].first - 1 : line;
+}
+
+/**
+ * @brief Gets the first screen row of a line, not counting the folded lines above it.
+ *
+ * The folds wholly above the line are taken out with their summed rows, and a fold
+ * holding the line with the rows from its start to the line.
+ *
+ * @param wrap The wrap map of the view, inactive when lines do not wrap.
+ * @param line The line; a hidden line gets the row after its fold's heading.
+ * @return The row.
+ */
+int Outline::rowOf(const WrapMap& wrap, int line) const {
+    int rows = rowsBefore(wrap, line);
+    int index = hiddenIndex(line - 1);
+    if (index < 0) return rows;
+    sumRows(wrap);
+    const auto& range = hidden[index];
+    return rows - rows_hidden[index] - (rowsBefore(wrap, std::min(line, range.second)) - rowsBefore(wrap, range.first));
+}
+
+/**
+ * @brief Finds the line shown on a screen row.
+ *
+ * The folds before the row are those whose following line starts on or above it,
+ * found by binary search, and their rows are added back to look the row up in the
+ * whole buffer.
+ *
+ * @param wrap The wrap map of the view, inactive when lines do not wrap.
+ * @param row The screen row, counted from the top of the buffer without folded lines.
+ * @param segment Set to the row within the line.
+ * @return The line, or the last line shown if the row is past the end.
+ */
+int Outline::lineAt(const WrapMap& wrap, int row, int& segment) const {
+    int skipped = 0;
+    if (!hidden.empty()) {
+        sumRows(wrap);
+        size_t before = std::upper_bound(rows_shown.begin(), rows_shown.end(), row) - rows_shown.begin();
+        skipped = rows_hidden[before];
+    }
+    int line;
+    if (wrap.isActive()) {
+        line = wrap.lineAtRow(row + skipped, segment);
+    } else {
+        segment = 0;
+        line = std::max(0, std::min(row + skipped, line_count - 1));
+    }
+    return prevVisible(line);
+}
+
+/**
+ * @brief Gets the number of screen rows of the lines that are shown.
+ */
+int Outline::totalRows(const WrapMap& wrap) const {
+    return rowOf(wrap, line_count);
+}
+
+/**
+ * @brief Gets the level of a heading line the way the editor draws it.
+ *
+ * @param line The line.
+ * @return 1 to 6 for `#` to `######` followed by a space or the end of the line, else 0.
+ */
+int Outline::headingLevel(const std::string& line) {
+    int level = 0;
+    while (level < (int)line.length() && line[level] == '#' && level < 7) ++level;
+    if (level == 0 || level > 6) return 0;
+    return level == (int)line.length() || line[level] == ' ' ? level : 0;
+}
+
+/**
+ * @brief Classifies a line for the outline.
+ *
+ * @return The heading level, 0 for a fence, -1 for any other line.
+ */
+int Outline::markLevel(const std::string& line) {
+    if (line.rfind("```", 0) == 0) return 0;
+    int level = headingLevel(line);
+    return level > 0 ? level : -1;
+}
+
+/**
+ * @brief Gets the end of a section, the next heading of the same or a higher level.
+ *
+ * @param heading Index of the section's heading in headings().
+ * @return One past the section's last line.
+ */
+int Outline::sectionEnd(size_t heading) const {
+    const std::vector<Heading>& list = headings();
+    int next = cached_ends[heading];
+    return next < 0 ? line_count : list[next].line;
+}
+
+/**
+ * @brief Computes the hidden line ranges from the folded headings.
+ *
+ * A fold inside a folded section adds nothing, and folds on lines that stopped
+ * being headings, like a `#` line now inside a code block, are dropped.
+ */
+void Outline::rebuildHidden() {
+    hidden.clear();
+    rows_valid = false;
+    const std::vector<Heading>& list = headings();
+    std::vector<int> kept;
+    size_t next = 0;
+    for (int line : folded) {
+        while (next < list.size() && list[next].line < line) ++next;
+        if (next == list.size() || list[next].line != line) continue;
+        kept.push_back(line);
+        if (!hidden.empty() && line < hidden.back().second) continue;
+        int end = sectionEnd(next);
+        if (end > line + 1) hidden.push_back({line + 1, end});
+    }
+    folded = std::move(kept);
+}
+
+/**
+ * @brief Finds the last hidden range starting at or before a line.
+ *
+ * @return Its index, -1 if there is none.
+ */
+int Outline::hiddenIndex(int line) const {
+    auto after = std::upper_bound(hidden.begin(), hidden.end(), line,
+        [](int at, const std::pair<int, int>& range) { return at < range.first; });
+    return (int)(after - hidden.begin()) - 1;
+}
+
+/**
+ * @brief Sums the rows hidden by the ranges, unless they are summed for these rows already.
+ *
+ * Takes one lookup in the wrap map per range, and is only done again after the folds
+ * change or the wrap map's stamp does.
+ *
+ * @param wrap The wrap map of the view, inactive when lines do not wrap.
+ */
+void Outline::sumRows(const WrapMap& wrap) const {
+    std::uint64_t stamp = wrap.isActive() ? wrap.rowsStamp() : 0;
+    if (rows_valid && rows_stamp == stamp) return;
+
+    rows_hidden.assign(1, 0);
+    rows_shown.clear();
+    for (const auto& range : hidden) {
+        int start = rowsBefore(wrap, range.first);
+        rows_shown.push_back(start - rows_hidden.back());
+        rows_hidden.push_back(rows_hidden.back() + rowsBefore(wrap, range.second) - start);
+    }
+    rows_stamp = stamp;
+    rows_valid = true;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file Outline.h
+ * @brief Header file for the Outline class, the headings of a note and the sections folded away.
+ *
+ * The outline keeps the positions of the `#` heading lines and the ``` fence lines
+ * of a buffer, updated from the lines each edit touched like the wrap map, so the
+ * headings are known without scanning the note. A `#` line between fences is code,
+ * not a heading. A folded heading hides its section, the lines up to the next
+ * heading of the same or a higher level, found once each time the headings change.
+ * The hidden sections form a sorted list of disjoint line ranges, so the line after
+ * a fold is found by binary search. Screen rows count only the lines that are not
+ * folded away: next to the ranges the outline keeps the rows hidden before each one,
+ * summed for the wrap map last asked, so a line and its screen row are converted
+ * with binary searches however many folds there are. The sums are built again only
+ * when the folds change or the wrap map's rows do, like after an edit adds a row.
+ */
+
+#ifndef OUTLINE_H
+#define OUTLINE_H
+
+#include "WrapMap.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+class Outline {
+public:
+    struct Heading {
+        int line;
+        int level;      ///< 1 for #, up to 6; 0 for a ``` fence while stored
+    };
+
+    // Forgets the previous buffer and finds the headings of a new one
+    void reset(const std::vector<std::string>& lines);
+
+    // Lines [start, oldEnd) were replaced by lines [start, newEnd)
+    void edited(const std::vector<std::string>& lines, int start, int oldEnd, int newEnd);
+
+    // The headings outside code blocks, in order
+    const std::vector<Heading>& headings() const;
+
+    // Index in headings() of the section holding a line, -1 before the first heading
+    int sectionOf(int line) const;
+
+    // Folds the section holding a line, or unfolds it if it is folded; returns its heading line or -1
+    int toggleFold(int line);
+
+    // Unfolds every fold hiding a line
+    void reveal(int line);
+
+    bool hasFolds() const { return !hidden.empty(); }
+    bool isFolded(int line) const;
+    bool isHidden(int line) const;
+
+    // Number of lines a folded heading hides
+    int foldedLines(int line) const;
+
+    // The line itself if it is shown, else the first line after the fold hiding it, or the fold's heading
+    int nextVisible(int line) const;
+    int prevVisible(int line) const;
+
+    // Screen rows without the folded lines; each line is one row unless wrap is active
+    int rowOf(const WrapMap& wrap, int line) const;
+    int lineAt(const WrapMap& wrap, int row, int& segment) const;
+    int totalRows(const WrapMap& wrap) const;
+
+    // The level of a heading line, 0 if it is no heading
+    static int headingLevel(const std::string& line);
+
+private:
+    std::vector<Heading> marks;                 ///< Heading and fence lines, in order
+    std::vector<int> folded;                    ///< Folded heading lines, in order
+    std::vector<std::pair<int, int>> hidden;    ///< Hidden line ranges [first, end), in order
+    int line_count = 0;
+
+    mutable std::vector<Heading> cached;        ///< headings(), built again after marks change
+    mutable std::vector<int> cached_ends;       ///< Index in cached of the heading ending each section, -1 for none
+    mutable bool cached_valid = false;
+
+    mutable std::vector<int> rows_hidden;       ///< Rows hidden by the ranges before each one, and by all of them
+    mutable std::vector<int> rows_shown;        ///< Screen row of the line after each range
+    mutable std::uint64_t rows_stamp = 0;       ///< Stamp of the wrap map the sums are for, 0 when it is off
+    mutable bool rows_valid = false;
+
+    static int markLevel(const std::string& line);
+    void rebuildHidden();
+    int sectionEnd(size_t heading) const;
+    int hiddenIndex(int line) const;
+    void sumRows(const WrapMap& wrap) const;
+};
+
+#endif // OUTLINE_H
@@ -0,0 +1,271 @@
+#include "PaneTree.h"
+#include "Settings.h"
+#include <algorithm>
+
+/**
+ * @brief Constructs a tree with a single pane and no windows yet.
+ */
+PaneTree::PaneTree() : root(std::make_unique<Node>()), current(root.get()) {}
+
+/**
+ * @brief Deletes the pane windows.
+ */
+PaneTree::~PaneTree() {
+    releaseWindows();
+}
+
+/**
+ * @brief Places the panes over a rectangle of a parent window.
+ *
+ * The pane windows are created again for their new sizes, and every pane is
+ * damaged so it gets drawn in full.
+ *
+ * @param parent_in The window the panes are subwindows of.
+ * @param y Top row of the rectangle in the parent.
+ * @param x Left column of the rectangle in the parent.
+ * @param rows Height of the rectangle.
+ * @param cols Width of the rectangle.
+ */
+void PaneTree::layout(WINDOW* parent_in, int y, int x, int rows, int cols) {
+    releaseWindows();
+    parent = parent_in;
+    top = y;
+    left = x;
+    height = rows;
+    width = cols;
+    place(root.get(), top, left, height, width);
+    damageAll();
+}
+
+/**
+ * @brief Goes back to a single pane filling the whole rectangle.
+ */
+void PaneTree::reset() {
+    releaseWindows();
+    root = std::make_unique<Node>();
+    current = root.get();
+    place(root.get(), top, left, height, width);
+    damageAll();
+}
+
+/**
+ * @brief Deletes every pane window.
+ *
+ * The panes keep their state and get new windows from the next layout.
+ */
+void PaneTree::releaseWindows() {
+    dropWindows(root.get());
+}
+
+/**
+ * @brief Gets the focused pane.
+ *
+ * @return The pane that receives input.
+ */
+PaneTree::Pane& PaneTree::focused() {
+    return current->pane;
+}
+
+/**
+ * @brief Splits the focused pane in two halves showing the same thing.
+ *
+ * The focused pane keeps the left or top half and stays focused; the new pane
+ * gets a copy of its view, so both show the same place of the same note.
+ *
+ * @param side_by_side Split into left and right halves, otherwise top and bottom.
+ * @return `false` if the halves would be smaller than MIN_PANE_WIDTH by MIN_PANE_HEIGHT.
+ */
+bool PaneTree::split(bool side_by_side) {
+    int rows = 0, cols = 0;
+    if (current->pane.win) getmaxyx(current->pane.win, rows, cols);
+    if (side_by_side ? cols / 2 < MIN_PANE_WIDTH : rows / 2 < MIN_PANE_HEIGHT) return false;
+
+    releaseWindows();
+    current->first = std::make_unique<Node>();
+    current->second = std::make_unique<Node>();
+    current->first->parent = current->second->parent = current;
+    current->first->pane = std::move(current->pane);
+    current->second->pane = current->first->pane;
+    current->side_by_side = side_by_side;
+    current->pane = Pane();
+    current = current->first.get();
+
+    place(root.get(), top, left, height, width);
+    damageAll();
+    return true;
+}
+
+/**
+ * @brief Closes the focused pane.
+ *
+ * Its neighbour takes the space of both, and the first pane of the neighbour is focused.
+ *
+ * @return `false` if the focused pane is the only one.
+ */
+bool PaneTree::close() {
+    Node* split = current->parent;
+    if (!split) return false;
+
+    releaseWindows();
+    std::unique_ptr<Node> sibling = std::move(split->first.get() == current ? split->second : split->first);
+    split->pane = std::move(sibling->pane);
+    split->side_by_side = sibling->side_by_side;
+    split->first = std::move(sibling->first);
+    split->second = std::move(sibling->second);
+    if (split->first) {
+        split->first->parent = split->second->parent = split;
+    }
+    current = firstLeaf(split);
+
+    place(root.get(), top, left, height, width);
+    damageAll();
+    return true;
+}
+
+/**
+ * @brief Focuses the next pane, going back to the first after the last.
+ */
+void PaneTree::focusNext() {
+    std::vector<Node*> leaves;
+    collect(root.get(), leaves);
+    auto found = std::find(leaves.begin(), leaves.end(), current);
+    current = (found + 1 == leaves.end()) ? leaves.front() : *(found + 1);
+}
+
+/**
+ * @brief Gets every pane, left to right and top to bottom.
+ *
+ * @return Pointers to the panes, valid until the tree is split or a pane is closed.
+ */
+std::vector<PaneTree::Pane*> PaneTree::panes() {
+    std::vector<Node*> leaves;
+    collect(root.get(), leaves);
+    std::vector<Pane*> result;
+    for (Node* leaf : leaves) {
+        result.push_back(&leaf->pane);
+    }
+    return result;
+}
+
+/**
+ * @brief Adds rows of a pane to its damage region.
+ *
+ * The region stays a single span of rows, so two separate edits damage the rows between them too.
+ *
+ * @param pane The pane that changed.
+ * @param first First window row that changed, clamped to the window.
+ * @param last One past the last window row that changed, clamped to the window.
+ */
+void PaneTree::damage(Pane& pane, int first, int last) {
+    first = std::max(first, 0);
+    last = std::min(last, pane.win ? getmaxy(pane.win) : 0);
+    if (first >= last) return;
+
+    if (pane.damage_top == pane.damage_bottom) {
+        pane.damage_top = first;
+        pane.damage_bottom = last;
+    } else {
+        pane.damage_top = std::min(pane.damage_top, first);
+        pane.damage_bottom = std::max(pane.damage_bottom, last);
+    }
+}
+
+/**
+ * @brief Damages every row of every pane.
+ *
+ * Needed after the panes are laid out again or something was drawn over them.
+ */
+void PaneTree::damageAll() {
+    for (Pane* pane : panes()) {
+        damage(*pane, 0, pane->win ? getmaxy(pane->win) : 0);
+    }
+}
+
+/**
+ * @brief Copies the damaged rows of a freshly drawn pane to the virtual screen.
+ *
+ * The whole window is drawn again, but rows outside the damage region are
+ * unchanged, so they are not copied. The terminal is only updated by the next
+ * doupdate, once for all panes.
+ *
+ * @param pane The pane that was drawn.
+ */
+void PaneTree::present(Pane& pane) {
+    if (!pane.win) return;
+    if (pane.damage_top > 0 || pane.damage_bottom < getmaxy(pane.win)) {
+        untouchwin(pane.win);
+        touchline(pane.win, pane.damage_top, pane.damage_bottom - pane.damage_top);
+    }
+    wnoutrefresh(pane.win);
+    pane.damage_top = pane.damage_bottom = 0;
+}
+
+/**
+ * @brief Gives the panes of a subtree their share of a rectangle.
+ *
+ * @param node The root of the subtree.
+ * @param y Top row of the rectangle in the parent window.
+ * @param x Left column of the rectangle.
+ * @param rows Height of the rectangle.
+ * @param cols Width of the rectangle.
+ */
+void PaneTree::place(Node* node, int y, int x, int rows, int cols) {
+    if (node->first) {
+        if (node->side_by_side) {
+            place(node->first.get(), y, x, rows, cols / 2);
+            place(node->second.get(), y, x + cols / 2, rows, cols - cols / 2);
+        } else {
+            place(node->first.get(), y, x, rows / 2, cols);
+            place(node->second.get(), y + rows / 2, x, rows - rows / 2, cols);
+        }
+        return;
+    }
+
+    // derwin reads a size of 0 as "up to the edge of the parent"
+    if (parent && rows > 0 && cols > 0) {
+        node->pane.win = derwin(parent, rows, cols, y, x);
+    }
+}
+
+/**
+ * @brief Deletes the windows of the panes of a subtree.
+ *
+ * @param node The root of the subtree.
+ */
+void PaneTree::dropWindows(Node* node) {
+    if (node->first) {
+        dropWindows(node->first.get());
+        dropWindows(node->second.get());
+    } else if (node->pane.win) {
+        delwin(node->pane.win);
+        node->pane.win = nullptr;
+    }
+}
+
+/**
+ * @brief Lists the leaves of a subtree in order.
+ *
+ * @param node The root of the subtree.
+ * @param leaves The leaves are appended here.
+ */
+void PaneTree::collect(Node* node, std::vector<Node*>& leaves) {
+    if (node->first) {
+        collect(node->first.get(), leaves);
+        collect(node->second.get(), leaves);
+    } else {
+        leaves.push_back(node);
+    }
+}
+
+/**
+ * @brief Finds the first leaf of a subtree.
+ *
+ * @param node The root of the subtree.
+ * @return The leftmost or topmost leaf.
+ */
+PaneTree::Node* PaneTree::firstLeaf(Node* node) {
+    while (node->first) {
+        node = node->first.get();
+    }
+    return node;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file PaneTree.h
+ * @brief Header file for the PaneTree class, which splits the content area into panes.
+ *
+ * The content area is a binary tree: a split divides its rectangle in half, side by
+ * side or one above the other, and every leaf is a pane with its own window. A pane
+ * shows a note, the kanban board or the calendar. Panes on notes only keep their own
+ * cursor, scroll position and wrap map; the lines belong to the editor, so two panes
+ * on the same note draw from the same buffer. Each pane has a damage region, the rows
+ * that changed since it was last drawn, and only those rows are copied to the screen.
+ */
+
+#ifndef PANE_TREE_H
+#define PANE_TREE_H
+
+#include <ncurses.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "WrapMap.h"
+
+class PaneTree {
+public:
+    enum class View {
+        Note,
+        Kanban,
+        Calendar
+    };
+
+    struct Pane {
+        View view = View::Note;
+        std::string note;           ///< Note shown when the view is Note
+        int row = 0;                ///< Cursor and scroll position, kept while another pane is focused
+        int col = 0;
+        int scroll_row = 0;
+        int scroll_col = 0;
+        WrapMap wrap;               ///< Wrapped rows at this pane's width, the focused pane's is in EditorUI
+        WINDOW* win = nullptr;
+        int damage_top = 0;         ///< First window row to repaint
+        int damage_bottom = 0;      ///< One past the last row to repaint, equal to damage_top when clean
+    };
+
+    PaneTree();
+    ~PaneTree();
+    PaneTree(const PaneTree&) = delete;
+    PaneTree& operator=(const PaneTree&) = delete;
+
+    // Places the panes over a rectangle of a parent window, creating their windows again
+    void layout(WINDOW* parent, int y, int x, int height, int width);
+
+    // Goes back to a single pane
+    void reset();
+
+    // Deletes every pane window, needed before the parent window is deleted
+    void releaseWindows();
+
+    Pane& focused();
+
+    // Splits the focused pane in two showing the same thing, returns false if it is too small
+    bool split(bool side_by_side);
+
+    // Closes the focused pane and focuses its neighbour, returns false for the last pane
+    bool close();
+
+    void focusNext();
+
+    // Every pane, left to right and top to bottom
+    std::vector<Pane*> panes();
+
+    // Adds window rows [top, bottom) of a pane to its damage region
+    void damage(Pane& pane, int top, int bottom);
+    void damageAll();
+
+    // Copies the damaged rows of a drawn pane to the virtual screen without updating the terminal
+    void present(Pane& pane);
+
+private:
+    struct Node {
+        Node* parent = nullptr;
+        std::unique_ptr<Node> first;    ///< Left or top half, set for splits only
+        std::unique_ptr<Node> second;   ///< Right or bottom half
+        bool side_by_side = false;
+        Pane pane;                      ///< Used by leaves only
+    };
+
+    std::unique_ptr<Node> root;
+    Node* current;                      ///< The focused leaf
+    WINDOW* parent = nullptr;
+    int top = 0;
+    int left = 0;
+    int height = 0;
+    int width = 0;
+
+    void place(Node* node, int y, int x, int rows, int cols);
+    void dropWindows(Node* node);
+    void collect(Node* node, std::vector<Node*>& leaves);
+    Node* firstLeaf(Node* node);
+};
+
+#endif // PANE_TREE_H
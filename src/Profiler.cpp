@@ -0,0 +1,216 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+Profiler::Histogram Profiler::histograms[Profiler::STAGE_COUNT];
+
+/**
+ * @brief Turns measuring and the overlay on or off.
+ *
+ * The histograms are kept, so turning the profiler on again adds to them.
+ */
+void Profiler::toggle() {
+    enabled.store(!enabled.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Checks whether the profiler is measuring.
+ *
+ * @return `true` while stages are recorded and the overlay is shown.
+ */
+bool Profiler::isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adds a duration to the histogram of a stage.
+ *
+ * Safe to call from any thread; only relaxed atomic operations are used.
+ *
+ * @param stage The stage that was timed.
+ * @param nanos How long it took in nanoseconds.
+ */
+void Profiler::record(Stage stage, std::uint64_t nanos) {
+    Histogram& histogram = histograms[stage];
+    histogram.counts[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+    histogram.total.fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t seen = histogram.max.load(std::memory_order_relaxed);
+    while (nanos > seen && !histogram.max.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {}
+}
+
+/**
+ * @brief Computes the count, median, 99th percentile and maximum of a stage.
+ *
+ * The percentiles are the middle of their bucket, never more than the maximum.
+ *
+ * @param stage The stage to summarize.
+ * @return The summary, all zero if the stage was never timed.
+ */
+Profiler::Summary Profiler::summarize(Stage stage) {
+    Histogram& histogram = histograms[stage];
+    std::uint32_t counts[BUCKETS];
+    std::uint64_t total = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        counts[i] = histogram.counts[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    Summary summary;
+    summary.count = total;
+    summary.max = histogram.max.load(std::memory_order_relaxed);
+    if (total == 0) return summary;
+
+    std::uint64_t median_rank = (total + 1) / 2;
+    std::uint64_t tail_rank = total - total / 100;
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        std::uint64_t before = seen;
+        seen += counts[i];
+        if (before < median_rank && seen >= median_rank) summary.p50 = bucketValue(i);
+        if (before < tail_rank && seen >= tail_rank) {
+            summary.p99 = bucketValue(i);
+            break;
+        }
+    }
+    summary.p50 = std::min(summary.p50, summary.max);
+    summary.p99 = std::min(summary.p99, summary.max);
+    return summary;
+}
+
+/**
+ * @brief Draws the histograms in the top right corner of a window.
+ *
+ * Nothing is drawn if the window is too small. The cursor of the window is
+ * left where it was, and the window is not refreshed.
+ *
+ * @param win The window to draw over.
+ */
+void Profiler::drawOverlay(WINDOW* win) {
+    const int width = 46;
+    const int height = STAGE_COUNT + 3;
+    int rows, cols;
+    getmaxyx(win, rows, cols);
+    if (cols < width + 2 || rows < height + 2) return;
+
+    int cursor_y, cursor_x;
+    getyx(win, cursor_y, cursor_x);
+    int top = 1;
+    int left = cols - width - 1;
+    for (int y = 0; y < height; ++y) {
+        mvwprintw(win, top + y, left, "%*s", width, "");
+    }
+
+    wattron(win, A_REVERSE);
+    mvwprintw(win, top, left, " %-*s", width - 1, "Profiler");
+    wattroff(win, A_REVERSE);
+    wattron(win, A_BOLD);
+    mvwprintw(win, top + 1, left, " %-9s %7s %8s %8s %8s", "stage", "count", "p50", "p99", "max");
+    wattroff(win, A_BOLD);
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        Summary summary = summarize(static_cast<Stage>(stage));
+        mvwprintw(win, top + 2 + stage, left, " %-9s %7llu %8s %8s %8s",
+                  stageName(static_cast<Stage>(stage)), (unsigned long long)summary.count,
+                  formatTime(summary.p50).c_str(), formatTime(summary.p99).c_str(),
+                  formatTime(summary.max).c_str());
+    }
+    wmove(win, cursor_y, cursor_x);
+}
+
+/**
+ * @brief Writes the histograms to a file if anything was measured.
+ *
+ * Each stage gets a line with its count, median, 99th percentile and maximum in
+ * microseconds, followed by its non-empty buckets.
+ *
+ * @param path The file to write, replaced if it exists.
+ */
+void Profiler::dump(const std::string& path) {
+    bool measured = false;
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        if (histograms[stage].total.load(std::memory_order_relaxed) > 0) measured = true;
+    }
+    if (!measured) return;
+
+    std::ofstream file(path);
+    file << "stage count p50_us p99_us max_us\n";
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        Summary summary = summarize(static_cast<Stage>(stage));
+        file << stageName(static_cast<Stage>(stage)) << ' ' << summary.count << ' '
+             << summary.p50 / 1000.0 << ' ' << summary.p99 / 1000.0 << ' ' << summary.max / 1000.0 << '\n';
+    }
+
+    file << "\nstage bucket_us count\n";
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        for (int i = 0; i < BUCKETS; ++i) {
+            std::uint32_t count = histograms[stage].counts[i].load(std::memory_order_relaxed);
+            if (count > 0) {
+                file << stageName(static_cast<Stage>(stage)) << ' ' << bucketValue(i) / 1000.0 << ' ' << count << '\n';
+            }
+        }
+    }
+}
+
+/**
+ * @brief Finds the bucket of a duration.
+ *
+ * Durations below SUB_BUCKETS nanoseconds get a bucket each; above that every
+ * power of two is split into SUB_BUCKETS equal buckets.
+ *
+ * @param nanos The duration in nanoseconds.
+ * @return The bucket index, the last bucket for anything too long.
+ */
+int Profiler::bucketOf(std::uint64_t nanos) {
+    if (nanos < SUB_BUCKETS) return static_cast<int>(nanos);
+    int exponent = 63 - __builtin_clzll(nanos);
+    int bucket = (exponent - 2) * SUB_BUCKETS + static_cast<int>((nanos >> (exponent - 3)) & (SUB_BUCKETS - 1));
+    return std::min(bucket, BUCKETS - 1);
+}
+
+/**
+ * @brief Gets the duration a bucket stands for.
+ *
+ * @param bucket The bucket index.
+ * @return The middle of the bucket's range in nanoseconds.
+ */
+std::uint64_t Profiler::bucketValue(int bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    int exponent = bucket / SUB_BUCKETS + 2;
+    std::uint64_t step = 1ULL << (exponent - 3);
+    return (SUB_BUCKETS + bucket % SUB_BUCKETS) * step + step / 2;
+}
+
+/**
+ * @brief Gets the name of a stage as shown in the overlay and the dump.
+ *
+ * @param stage The stage.
+ * @return A short lowercase name.
+ */
+const char* Profiler::stageName(Stage stage) {
+    switch (stage) {
+        case Keystroke: return "keystroke";
+        case Dispatch: return "dispatch";
+        case Edit: return "edit";
+        case Render: return "render";
+        case Refresh: return "refresh";
+        case Save: return "save";
+        default: return "?";
+    }
+}
+
+/**
+ * @brief Formats a duration with a unit that keeps it short.
+ *
+ * @param nanos The duration in nanoseconds.
+ * @return The duration in microseconds, milliseconds or seconds, or "-" for zero.
+ */
+std::string Profiler::formatTime(std::uint64_t nanos) {
+    char text[16];
+    if (nanos == 0) return "-";
+    if (nanos < 10000) snprintf(text, sizeof(text), "%.1fus", nanos / 1e3);
+    else if (nanos < 1000000) snprintf(text, sizeof(text), "%.0fus", nanos / 1e3);
+    else if (nanos < 1000000000) snprintf(text, sizeof(text), "%.1fms", nanos / 1e6);
+    else snprintf(text, sizeof(text), "%.1fs", nanos / 1e9);
+    return text;
+}
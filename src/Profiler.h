@@ -0,0 +1,94 @@
+/**
+ * @file Profiler.h
+ * @brief Header file for the Profiler class, which measures how long each stage of a keystroke takes.
+ *
+ * A keystroke goes through stages: getch returns, TerminalEditor::handleInput dispatches
+ * it, the buffer is edited, EditorUI::renderContent draws the pane, and doupdate sends the
+ * frame to the terminal. A Scope placed around a stage adds its duration to the histogram
+ * of that stage. The histograms only use atomic counters, so the save thread records into
+ * them without locks. While the profiler is off, a Scope costs one load and one branch.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <ncurses.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+class Profiler {
+public:
+    enum Stage {
+        Keystroke,      ///< From getch returning to the frame being on the terminal
+        Dispatch,       ///< TerminalEditor::handleInput
+        Edit,           ///< Changing the buffer of the focused note
+        Render,         ///< EditorUI::renderContent
+        Refresh,        ///< doupdate
+        Save,           ///< Writing a note on the save thread
+        STAGE_COUNT
+    };
+
+    struct Summary {
+        std::uint64_t count = 0;
+        std::uint64_t p50 = 0;      ///< Nanoseconds
+        std::uint64_t p99 = 0;
+        std::uint64_t max = 0;
+    };
+
+    // Times a stage from construction to destruction if the profiler is on
+    class Scope {
+    public:
+        explicit Scope(Stage stage_in) : stage(stage_in) {
+            if (enabled.load(std::memory_order_relaxed)) start = now();
+        }
+        ~Scope() {
+            if (start) record(stage, now() - start);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Stage stage;
+        std::uint64_t start = 0;
+    };
+
+    // Turns measuring and the overlay on or off
+    static void toggle();
+    static bool isEnabled();
+
+    static void record(Stage stage, std::uint64_t nanos);
+    static Summary summarize(Stage stage);
+
+    // Draws the histograms in the top right corner of a window
+    static void drawOverlay(WINDOW* win);
+
+    // Writes the histograms to a file if anything was measured
+    static void dump(const std::string& path);
+
+private:
+    static constexpr int SUB_BUCKETS = 8;                   ///< Buckets per power of two, so within 12.5%
+    static constexpr int BUCKETS = 40 * SUB_BUCKETS;        ///< Up to 2^40 ns, about 18 minutes
+
+    struct Histogram {
+        std::atomic<std::uint32_t> counts[BUCKETS];
+        std::atomic<std::uint64_t> total;
+        std::atomic<std::uint64_t> max;
+    };
+
+    static inline std::atomic<bool> enabled{false};
+    static Histogram histograms[STAGE_COUNT];   ///< Zeroed as static storage
+
+    static std::uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static int bucketOf(std::uint64_t nanos);
+    static std::uint64_t bucketValue(int bucket);
+    static const char* stageName(Stage stage);
+    static std::string formatTime(std::uint64_t nanos);
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,55 @@
+#include "RenderBackend.h"
+#include "CursesBackend.h"
+#include "InputDecoder.h"
+
+namespace {
+CursesBackend cursesBackend;    ///< Active unless another backend is used
+}
+
+RenderBackend* RenderBackend::current = &cursesBackend;
+
+/**
+ * @brief Makes a backend show the frames from now on.
+ *
+ * The backend is not owned and must outlive its use.
+ *
+ * @param backend The backend, or nullptr for the ncurses backend.
+ */
+void RenderBackend::use(RenderBackend* backend) {
+    current = backend ? backend : &cursesBackend;
+}
+
+/**
+ * @brief Gets the backend that shows the frames.
+ *
+ * @return The active backend.
+ */
+RenderBackend& RenderBackend::active() {
+    return *current;
+}
+
+/**
+ * @brief Shows the frame on the virtual screen with the active backend.
+ *
+ * Called once the windows of a frame were copied with wnoutrefresh.
+ */
+void RenderBackend::present() {
+    current->show();
+}
+
+/**
+ * @brief Shows the current frame and reads a key.
+ *
+ * wgetch refreshes a changed window before it waits, which only the ncurses
+ * backend would see, so the window is copied to the virtual screen here and the
+ * frame is shown by the active backend first. The key comes from InputDecoder.
+ *
+ * @param win The window to show, and to read from if ncurses decodes the keys.
+ * @param timeout_ms How long to wait for a key, -1 to wait until one arrives.
+ * @return The key, or ERR if reading was interrupted or timed out.
+ */
+int RenderBackend::readKey(WINDOW* win, int timeout_ms) {
+    if (is_wintouched(win)) wnoutrefresh(win);
+    current->show();
+    return InputDecoder::get(win, timeout_ms);
+}
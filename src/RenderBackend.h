@@ -0,0 +1,52 @@
+/**
+ * @file RenderBackend.h
+ * @brief Header file for the RenderBackend class, which puts finished frames on a screen.
+ *
+ * Everything is drawn into ncurses windows and copied to the ncurses virtual screen
+ * with wnoutrefresh. What happens to that frame next is up to the active backend:
+ * CursesBackend lets ncurses update the terminal, MemoryBackend keeps the frame as
+ * a CellGrid for tests and benchmarks, and EscapeBackend diffs it against the last
+ * frame and writes the escape sequences itself. Code that finishes a frame calls
+ * present(), and code that waits for a key calls readKey() so the frame it waits
+ * on is shown first, whichever backend is active. Nothing else updates the
+ * terminal, so each frame reaches it in one piece.
+ */
+
+#ifndef RENDER_BACKEND_H
+#define RENDER_BACKEND_H
+
+#include <ncurses.h>
+
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    // Shows the frame on the virtual screen
+    virtual void show() = 0;
+
+    // Forgets what is on screen, so the next frame is drawn in full
+    virtual void invalidate() {}
+
+    // Screen rows [top, bottom) of the next frame are the last frame's moved up by `distance`, down if negative
+    virtual void scrolled(int /*top*/, int /*bottom*/, int /*distance*/) {}
+
+    // Makes a backend active, nullptr goes back to the ncurses one
+    static void use(RenderBackend* backend);
+    static RenderBackend& active();
+
+    // Shows the frame with the active backend
+    static void present();
+
+    // Shows the frame with a window's pending changes, then reads a key from the window, waiting at most timeout_ms if not -1
+    static int readKey(WINDOW* win = stdscr, int timeout_ms = -1);
+
+protected:
+    // Terminals that know DEC private mode 2026 hold the screen between these, others ignore them
+    static constexpr const char* BEGIN_SYNC = "\033[?2026h";
+    static constexpr const char* END_SYNC = "\033[?2026l";
+
+private:
+    static RenderBackend* current;
+};
+
+#endif // RENDER_BACKEND_H
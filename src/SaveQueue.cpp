@@ -0,0 +1,111 @@
+#include "SaveQueue.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include <fstream>
+#include <filesystem>
+#include <csignal>
+
+/**
+ * @brief Starts the worker thread.
+ *
+ * The worker blocks every signal, so a terminal resize always interrupts the
+ * main thread waiting for a key instead of the worker.
+ */
+SaveQueue::SaveQueue() {
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    worker = std::thread(&SaveQueue::run, this);
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+/**
+ * @brief Writes every queued file, then stops the worker thread.
+ */
+SaveQueue::~SaveQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+/**
+ * @brief Queues the text of a file to be written.
+ *
+ * If the file is already waiting, its text is replaced, so only the newest version is written.
+ *
+ * @param path The path of the file.
+ * @param text The whole text of the file.
+ */
+void SaveQueue::write(const std::string& path, std::string text) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending[path] = std::move(text);
+    }
+    wake.notify_one();
+}
+
+/**
+ * @brief Waits until every queued file is on disk.
+ *
+ * Called before anything reads, renames or deletes notes on disk.
+ */
+void SaveQueue::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending.empty() && !writing; });
+}
+
+/**
+ * @brief Gets the files that could not be written.
+ *
+ * @return Their paths, each reported once.
+ */
+std::vector<std::string> SaveQueue::takeFailures() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> taken;
+    taken.swap(failed);
+    return taken;
+}
+
+/**
+ * @brief Writes queued files until the queue is stopped.
+ *
+ * The queue is taken as a whole, so the lock is not held while writing. A file is
+ * only renamed into place once all of its text was written and closed; otherwise
+ * the temporary file is removed and the path is kept for takeFailures().
+ */
+void SaveQueue::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty()) break;     // Stopping with nothing left to write
+
+        std::unordered_map<std::string, std::string> batch;
+        batch.swap(pending);
+        writing = true;
+        lock.unlock();
+
+        std::vector<std::string> batch_failed;
+        for (const auto& [path, text] : batch) {
+            Profiler::Scope timer(Profiler::Save);
+            AllocationTracker::Scope tag(AllocationTracker::FileIO);
+            std::string temporary = path + ".tmp";
+            std::ofstream file(temporary, std::ios::binary);
+            file.write(text.data(), text.size());
+            file.close();
+            std::error_code error;
+            if (file) std::filesystem::rename(temporary, path, error);
+            if (!file || error) {
+                std::filesystem::remove(temporary, error);  /**< The old version stays in place. */
+                batch_failed.push_back(path);
+            }
+        }
+
+        lock.lock();
+        failed.insert(failed.end(), batch_failed.begin(), batch_failed.end());
+        writing = false;
+        if (pending.empty()) idle.notify_all();
+    }
+}
@@ -0,0 +1,52 @@
+/**
+ * @file SaveQueue.h
+ * @brief Header file for the SaveQueue class, which writes notes to disk on a background thread.
+ *
+ * Saving hands the text of a note to the queue and returns at once. A worker thread
+ * writes it next to the note and renames it into place, so a note on disk is always
+ * either the old or the new version. Saving a note again before it was written only
+ * keeps the newest text. A write that fails, like on a full disk, leaves the old
+ * version in place and is reported by takeFailures().
+ */
+
+#ifndef SAVE_QUEUE_H
+#define SAVE_QUEUE_H
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+class SaveQueue {
+public:
+    SaveQueue();
+    ~SaveQueue();
+
+    SaveQueue(const SaveQueue&) = delete;
+    SaveQueue& operator=(const SaveQueue&) = delete;
+
+    // Queues the text of a file to be written
+    void write(const std::string& path, std::string text);
+
+    // Waits until every queued file is on disk
+    void flush();
+
+    // The paths that could not be written since the last call
+    std::vector<std::string> takeFailures();
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;       ///< Signals the worker that there is work or it should stop
+    std::condition_variable idle;       ///< Signals flush that the queue is empty
+    std::unordered_map<std::string, std::string> pending;   ///< Path -> newest text
+    std::vector<std::string> failed;    ///< Paths whose write failed, not reported yet
+    bool writing = false;
+    bool stopping = false;
+    std::thread worker;
+
+    void run();
+};
+
+#endif // SAVE_QUEUE_H
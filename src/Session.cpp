@@ -0,0 +1,72 @@
+#include "Session.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+// First line of a snapshot, changed when the format changes so old snapshots are ignored
+const char* const HEADER = "neonote-session 1";
+}
+
+/**
+ * @brief Reads the snapshot written when the editor last ran.
+ *
+ * Each line starts with a keyword; names come last on their line, so they may hold
+ * spaces. Lines with unknown keywords are skipped.
+ *
+ * @return `false` if there is no snapshot, it has another format, or it lists no notes.
+ */
+bool Session::load() {
+    std::ifstream file(path());
+    std::string line;
+    if (!std::getline(file, line) || line != HEADER) return false;
+
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string key, name;
+        in >> key;
+        if (key == "focus") {
+            in >> focus >> view >> sidebar_index;
+        } else if (key == "board") {
+            in >> board;
+        } else if (key == "open") {
+            Cursor cursor;
+            in >> cursor.row >> cursor.col >> cursor.scroll_row >> cursor.scroll_col;
+            if (std::getline(in >> std::ws, cursor.note)) open.push_back(cursor);
+        } else if (key == "note" && std::getline(in >> std::ws, name)) {
+            catalog.notes.push_back(name);
+        } else if (key == "kanban" && std::getline(in >> std::ws, name)) {
+            catalog.boards.push_back(name);
+        }
+    }
+    return !catalog.notes.empty();
+}
+
+/**
+ * @brief Writes the snapshot out in the format load() reads.
+ *
+ * @return The text of the snapshot file.
+ */
+std::string Session::text() const {
+    std::ostringstream out;
+    out << HEADER << '\n';
+    out << "focus " << focus << ' ' << view << ' ' << sidebar_index << '\n';
+    out << "board " << board << '\n';
+    for (const Cursor& cursor : open) {
+        out << "open " << cursor.row << ' ' << cursor.col << ' ' << cursor.scroll_row << ' '
+            << cursor.scroll_col << ' ' << cursor.note << '\n';
+    }
+    for (const std::string& note : catalog.notes) out << "note " << note << '\n';
+    for (const std::string& board_name : catalog.boards) out << "kanban " << board_name << '\n';
+    return out.str();
+}
+
+/**
+ * @brief Gets the path of the snapshot file.
+ *
+ * @return `~/.local/share/neonote/session`, or an empty string without a home directory.
+ */
+std::string Session::path() {
+    const char* home = getenv("HOME");
+    return home ? std::string(home) + "/.local/share/neonote/session" : "";
+}
@@ -0,0 +1,51 @@
+/**
+ * @file Session.h
+ * @brief Header file for the Session class, a snapshot of the editor to start up into.
+ *
+ * The snapshot holds the open notes with their cursor and scroll positions, the
+ * panel that had the focus and the view of the focused pane, and the catalog: the
+ * names of the notes and of the kanban boards. It is written when the editor
+ * closes and every SESSION_SAVE_SECONDS while it runs. Starting from it skips the
+ * main menu and the directory scans, and the editor opens where it was left. The
+ * catalog is checked against the disk on a background thread once the editor is
+ * drawn.
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <string>
+#include <vector>
+
+class Session {
+public:
+    struct Cursor {
+        std::string note;
+        int row = 0;
+        int col = 0;
+        int scroll_row = 0;
+        int scroll_col = 0;
+    };
+
+    struct Catalog {
+        std::vector<std::string> notes;     ///< In sidebar order
+        std::vector<std::string> boards;    ///< Without "My Tasks", which always exists
+    };
+
+    int focus = 0;              ///< The focused panel, as TerminalEditor's focused_div
+    int view = 0;               ///< What the focused pane shows, as PaneTree::View
+    int sidebar_index = 0;
+    int board = 0;              ///< The open kanban board
+    std::vector<Cursor> open;   ///< The note of the focused pane first, then the notes opened before it
+    Catalog catalog;
+
+    // Reads the snapshot, returns false if there is none or it cannot be used
+    bool load();
+
+    // The snapshot as written to path()
+    std::string text() const;
+
+    static std::string path();
+};
+
+#endif // SESSION_H
@@ -3,9 +3,29 @@
 #define SETTINGS_H
 
 #include <ncurses.h>
+#include "InputDecoder.h"
+#include "InputRules.h"
 
 // Sizing
 static constexpr double SIDEBAR_WIDTH_RATIO = 0.25;
+constexpr int MIN_COLUMN_WIDTH = 18;     // Narrowest kanban column before columns scroll
+constexpr int MIN_PANE_WIDTH = 20;       // Narrowest pane a split may leave
+constexpr int MIN_PANE_HEIGHT = 6;       // Shortest pane a split may leave
+constexpr int RESIZE_SETTLE_MS = 40;     // Quiet time after the last resize before the layout is redone
+
+// Memory
+constexpr size_t BUFFER_CACHE_BYTES = 32 * 1024 * 1024;  // Notes kept in memory after switching away from them
+
+// Session
+constexpr int SESSION_SAVE_SECONDS = 30;  // How often the session snapshot is written while editing
+constexpr int CATALOG_POLL_MS = 50;       // Wait for a key this long while the notes are checked against the disk
+
+// Statistics
+constexpr int READING_WPM = 200;        // Words read per minute, for the reading time on the status line
+
+// Input
+constexpr int ESCAPE_TIMEOUT_MS = 25;    // How long an Escape waits for the rest of a key sequence before it is a key
+constexpr bool KITTY_KEYBOARD = true;    // Ask the terminal to send Escape and Ctrl combinations unambiguously
 
 // Keybinds
 static constexpr int MENU_SHORTCUT = 17;
@@ -25,29 +45,59 @@ constexpr int GOTO_FILE_END = KEY_NPAGE;    // Ctrl+T
 // Editing
 constexpr int DELETE_LEFT = KEY_BACKSPACE;     // Backspace
 constexpr int DELETE_RIGHT = KEY_DC; // Delete
-constexpr int DELETE_WORD = 8;       // Ctrl+Backspace
+constexpr int DELETE_WORD = InputDecoder::withModifiers(KEY_BACKSPACE, InputDecoder::Ctrl);    // Ctrl+Backspace
 constexpr int NEW_LINE = '\n';       // Enter
 constexpr int INDENT = KEY_BTAB;    // Tab
-constexpr int INDENT_ALT = KEY_CTAB; // Ctrl+Tab
+constexpr int INDENT_ALT = InputDecoder::withModifiers('\t', InputDecoder::Ctrl);  // Ctrl+Tab
 
 // Formatting
 constexpr int ITALIC = 9;            // Ctrl+I
 constexpr int BOLD = 2;              // Ctrl+B
+
+// Input rules: typing text that ends with `before` and `trigger` replaces the trigger (see InputRules.h)
+constexpr InputRules::Rule INPUT_RULES[] = {
+    {"^ *", "\\d+. ", "    $&"},     // "1. " at the start of a line indents a numbered item
+    {"^ *", "- ", "    - "},         // "- " at the start of a line indents a bullet
+};
+
+// Keys that insert markers around the cursor, or step over the closing marker
+constexpr InputRules::Pair INPUT_PAIRS[] = {
+    {BOLD, "**", "**"},
+    {ITALIC, "*", "*"},
+};
     
 // File Operations
 constexpr int NEW_FILE = 14;         // Ctrl+N
 constexpr int SAVE_FILE = 19;        // Ctrl+S
 constexpr int RENAME_FILE = 18;      // Ctrl+R
 constexpr int DELETE_FILE = KEY_DC;  // Delete (in sidebar)
+constexpr int FOLLOW_LINK = 7;       // Ctrl+G
+constexpr int SHOW_BACKLINKS = 11;   // Ctrl+K
+constexpr int SHOW_OUTLINE = 16;     // Ctrl+P
+constexpr int TOGGLE_FOLD = KEY_F(9);
+constexpr int FORMAT_TABLE = 20;     // Ctrl+T
 
 // UI Navigation
 constexpr int SWITCH_PANEL = 15;     // Ctrl+O
 constexpr int SWITCH_PANEL_ALT = 4;  // Ctrl+D
 constexpr int TOGGLE_SIDEBAR = KEY_F(1);
+constexpr int TOGGLE_WRAP = KEY_F(2);
+constexpr int SPLIT_SIDE_BY_SIDE = KEY_F(3);
+constexpr int SPLIT_STACKED = KEY_F(4);
+constexpr int NEXT_PANE = KEY_F(5);
+constexpr int CLOSE_PANE = KEY_F(6);
+constexpr int TOGGLE_PROFILER = KEY_F(7);
+constexpr int TOGGLE_ALLOCATIONS = KEY_F(8);
+constexpr int TOGGLE_TABLES = KEY_F(10);
     
 // Kanban Specific
 constexpr int MOVE_TASK_LEFT = KEY_LEFT;
 constexpr int MOVE_TASK_RIGHT = KEY_RIGHT;
+constexpr int SWITCH_BOARD = 23;     // Ctrl+W
+constexpr int ADD_COLUMN = 12;       // Ctrl+L
+constexpr int EDIT_TASK = 5;         // Ctrl+E
+constexpr int SORT_TASKS = 25;       // Ctrl+Y
+constexpr int FILTER_TAG = 6;        // Ctrl+F
 
 // Basic
 constexpr int CONFIRM_OPTION = '\n';
@@ -0,0 +1,121 @@
+#include "SyntaxCache.h"
+
+/**
+ * @brief Forgets the lexed lines of the previous buffer.
+ *
+ * @param lines The new buffer, lexed as its lines are drawn.
+ */
+void SyntaxCache::reset(const std::vector<std::string>& lines) {
+    entries.assign(lines.size(), Entry());
+    valid = 0;
+}
+
+/**
+ * @brief Lexes the lines touched by an edit again.
+ *
+ * The lines after the edit keep their runs. They are still right if the edited
+ * lines end in the state they ended in before; if not, they are checked again as
+ * they are drawn. An edit below the watermark only marks its lines to be lexed.
+ *
+ * @param lines The buffer after the edit.
+ * @param start First line that changed.
+ * @param oldEnd End of the changed lines before the edit.
+ * @param newEnd End of the changed lines after the edit.
+ * @return Whether the lines after the edit may be drawn differently now.
+ */
+bool SyntaxCache::edited(const std::vector<std::string>& lines, int start, int oldEnd, int newEnd) {
+    int size = entries.size();
+    if (size - oldEnd != (int)lines.size() - newEnd || start < 0 || start > oldEnd || oldEnd > size) {
+        reset(lines);
+        return true;
+    }
+
+    bool known = valid >= start;
+    bool end_known = valid >= oldEnd;
+    int before = end_known && oldEnd > 0 ? entries[oldEnd - 1].out : 0;
+    entries.erase(entries.begin() + start, entries.begin() + oldEnd);
+    entries.insert(entries.begin() + start, newEnd - start, Entry());
+    if (!known) return false;
+
+    for (int i = start; i < newEnd; ++i) {
+        lexLine(lines[i], i > 0 ? entries[i - 1].out : 0, entries[i]);
+    }
+    int after = newEnd > 0 ? entries[newEnd - 1].out : 0;
+    if (end_known && after == before) {
+        valid += newEnd - oldEnd;
+        return false;
+    }
+    valid = newEnd;
+    return true;
+}
+
+/**
+ * @brief Gets the state a line starts in, lexing the lines before it that are not yet.
+ *
+ * @param lines The buffer.
+ * @param line The line.
+ * @return The state, 0 outside code blocks and past the last line.
+ */
+int SyntaxCache::stateAt(const std::vector<std::string>& lines, int line) const {
+    if (line < 0 || line >= (int)lines.size()) return 0;
+    advance(lines, line);
+    return entries[line].in;
+}
+
+/**
+ * @brief Gets the token runs of a line.
+ *
+ * @param lines The buffer.
+ * @param line The line.
+ * @return The runs, empty outside code blocks.
+ */
+const std::vector<CodeLexer::Run>& SyntaxCache::runs(const std::vector<std::string>& lines, int line) const {
+    static const std::vector<CodeLexer::Run> none;
+    if (line < 0 || line >= (int)lines.size()) return none;
+    advance(lines, line);
+    return entries[line].runs;
+}
+
+/**
+ * @brief Moves the watermark past a line.
+ *
+ * A line whose start state is the one it was lexed from and that did not change
+ * keeps its runs.
+ *
+ * @param lines The buffer.
+ * @param line The line that must be lexed from the right state.
+ */
+void SyntaxCache::advance(const std::vector<std::string>& lines, int line) const {
+    if (entries.size() != lines.size()) {
+        entries.assign(lines.size(), Entry());
+        valid = 0;
+    }
+    for (; valid <= line; ++valid) {
+        Entry& entry = entries[valid];
+        int in = valid > 0 ? entries[valid - 1].out : 0;
+        if (entry.stale || entry.in != in) lexLine(lines[valid], in, entry);
+    }
+}
+
+/**
+ * @brief Lexes one line from a start state.
+ *
+ * A fence opens a block or closes the open one; lines outside blocks have no runs.
+ *
+ * @param text The line.
+ * @param in The state the line starts in.
+ * @param entry Set to the line's end state and runs.
+ */
+void SyntaxCache::lexLine(const std::string& text, int in, Entry& entry) {
+    entry.in = in;
+    entry.stale = false;
+    if (text.rfind("```", 0) == 0) {
+        entry.runs.clear();
+        entry.out = in ? 0 : CodeLexer::blockState(text);
+    } else if (in == 0) {
+        entry.runs.clear();
+        entry.out = 0;
+    } else {
+        entry.out = CodeLexer::lex(text, in, entry.runs);
+    }
+}
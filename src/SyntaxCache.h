@@ -0,0 +1,53 @@
+/**
+ * @file SyntaxCache.h
+ * @brief Header file for the SyntaxCache class, the token runs of the fenced code in a note.
+ *
+ * Every line keeps the state it was lexed from, the state it ends in and its token
+ * runs. The state outside code blocks is 0, so the same states tell which lines are
+ * code without scanning the note for fences. Lines are lexed when they are first
+ * drawn; all lines before a watermark are known to be lexed from the right state.
+ * An edit lexes the lines it touched again, and if the last of them still ends in
+ * the state it did, the lines after it are kept as they are. Otherwise the
+ * watermark drops to the edit and the following lines are checked as they are
+ * drawn: a line whose start state did not change is kept without lexing it again,
+ * so typing in a long code block lexes the edited line only.
+ */
+
+#ifndef SYNTAX_CACHE_H
+#define SYNTAX_CACHE_H
+
+#include "CodeLexer.h"
+#include <string>
+#include <vector>
+
+class SyntaxCache {
+public:
+    // Forgets the previous buffer, its lines are lexed as they are drawn
+    void reset(const std::vector<std::string>& lines);
+
+    // Lines [start, oldEnd) were replaced by lines [start, newEnd); returns whether lines after them change
+    bool edited(const std::vector<std::string>& lines, int start, int oldEnd, int newEnd);
+
+    // The state a line starts in, 0 outside code blocks
+    int stateAt(const std::vector<std::string>& lines, int line) const;
+    bool inCode(const std::vector<std::string>& lines, int line) const { return stateAt(lines, line) != 0; }
+
+    // The token runs of a line, empty outside code blocks and on fences
+    const std::vector<CodeLexer::Run>& runs(const std::vector<std::string>& lines, int line) const;
+
+private:
+    struct Entry {
+        int in = 0;             ///< State the runs were lexed from
+        int out = 0;            ///< State the line ends in
+        bool stale = true;      ///< The line changed since it was lexed
+        std::vector<CodeLexer::Run> runs;
+    };
+
+    mutable std::vector<Entry> entries;     ///< One per line
+    mutable int valid = 0;                  ///< Lines before this one are lexed from the right state
+
+    void advance(const std::vector<std::string>& lines, int line) const;
+    static void lexLine(const std::string& text, int in, Entry& entry);
+};
+
+#endif // SYNTAX_CACHE_H
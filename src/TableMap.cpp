@@ -0,0 +1,400 @@
+#include "TableMap.h"
+#include "Utf8.h"
+#include <algorithm>
+
+namespace {
+
+// Columns of padding before a cell's text in a column of some width
+int padBefore(TableMap::Align align, int column, int width) {
+    int pad = std::max(0, column - width);
+    if (align == TableMap::Align::Right) return pad;
+    if (align == TableMap::Align::Center) return pad / 2;
+    return 0;
+}
+
+}
+
+/**
+ * @brief Finds the tables of a new buffer.
+ *
+ * @param lines The buffer.
+ */
+void TableMap::reset(const std::vector<std::string>& lines) {
+    rows.clear();
+    for (const std::string& line : lines) rows.push_back(parseRow(line));
+    tables.clear();
+    scan(0, (int)rows.size(), tables);
+}
+
+/**
+ * @brief Updates the tables for the lines touched by an edit.
+ *
+ * An edit that leaves every touched line a row of the same table only moves the
+ * touched rows' cells in the width counts. An edit that makes or breaks a row may
+ * split or join tables, so the tables touching it are scanned again.
+ *
+ * @param lines The buffer after the edit.
+ * @param start First line that changed.
+ * @param oldEnd End of the changed lines before the edit.
+ * @param newEnd End of the changed lines after the edit.
+ * @return Whether rows other than the edited ones are laid out differently now.
+ */
+bool TableMap::edited(const std::vector<std::string>& lines, int start, int oldEnd, int newEnd) {
+    int size = rows.size();
+    if (size - oldEnd != (int)lines.size() - newEnd || start < 0 || start > oldEnd || oldEnd > size) {
+        reset(lines);
+        return true;
+    }
+    int delta = newEnd - oldEnd;
+    std::vector<Row> fresh;
+    for (int i = start; i < newEnd; ++i) fresh.push_back(parseRow(lines[i]));
+
+    auto shiftAfter = [&](size_t from) {
+        for (size_t i = from; i < tables.size(); ++i) {
+            tables[i].first += delta;
+            tables[i].end += delta;
+            if (tables[i].delimiter >= 0) tables[i].delimiter += delta;
+        }
+    };
+
+    int t = tableIndex(start);
+    bool in_place = t >= 0 && oldEnd <= tables[t].end;
+    for (int i = start; i < oldEnd && in_place; ++i) {
+        Kind now = i < newEnd ? fresh[i - start].kind : NONE;
+        in_place = rows[i].kind == ROW || (delta == 0 && rows[i].kind == now);
+    }
+    for (int i = start; i < newEnd && in_place; ++i) {
+        Kind was = i < oldEnd ? rows[i].kind : NONE;
+        in_place = fresh[i - start].kind == ROW || (delta == 0 && fresh[i - start].kind == was);
+    }
+
+    if (in_place) {
+        Table& table = tables[t];
+        std::vector<int> before = widths(start);
+        for (int i = start; i < oldEnd; ++i) count(table, rows[i], -1);
+        rows.erase(rows.begin() + start, rows.begin() + oldEnd);
+        rows.insert(rows.begin() + start, fresh.begin(), fresh.end());
+        for (int i = start; i < newEnd; ++i) count(table, rows[i], 1);
+        table.end += delta;
+        if (table.delimiter >= oldEnd) table.delimiter += delta;
+        shiftAfter(t + 1);
+
+        bool aligns_changed = table.delimiter >= start && table.delimiter < newEnd;
+        return aligns_changed || widths(start) != before;
+    }
+
+    // Scan the tables touching the edit again, they may split or join
+    int first = start;
+    int last = oldEnd;
+    size_t begin = 0;
+    while (begin < tables.size() && tables[begin].end < start) ++begin;
+    size_t end = begin;
+    while (end < tables.size() && tables[end].first <= oldEnd) {
+        first = std::min(first, tables[end].first);
+        last = std::max(last, tables[end].end);
+        ++end;
+    }
+    tables.erase(tables.begin() + begin, tables.begin() + end);
+    rows.erase(rows.begin() + start, rows.begin() + oldEnd);
+    rows.insert(rows.begin() + start, fresh.begin(), fresh.end());
+    shiftAfter(begin);
+
+    std::vector<Table> found;
+    scan(first, last + delta, found);
+    tables.insert(tables.begin() + begin, found.begin(), found.end());
+    return true;
+}
+
+/**
+ * @brief Checks whether a line is a table row, the delimiter row included.
+ */
+bool TableMap::isRow(int line) const {
+    return line >= 0 && line < (int)rows.size() && rows[line].kind != NONE;
+}
+
+/**
+ * @brief Checks whether a line is a delimiter row like `|---|:-:|`.
+ */
+bool TableMap::isDelimiter(int line) const {
+    return line >= 0 && line < (int)rows.size() && rows[line].kind == DELIMITER;
+}
+
+/**
+ * @brief Checks whether a line is the header row, the row above the delimiter row.
+ */
+bool TableMap::isHeader(int line) const {
+    int t = tableIndex(line);
+    return t >= 0 && tables[t].delimiter == line + 1;
+}
+
+/**
+ * @brief Gets the lines of the table holding a row.
+ *
+ * @param line The row.
+ * @return The first line and one past the last, or {line, line} if the line is no row.
+ */
+std::pair<int, int> TableMap::span(int line) const {
+    int t = tableIndex(line);
+    if (t < 0) return {line, line};
+    return {tables[t].first, tables[t].end};
+}
+
+/**
+ * @brief Gets the cells of a row, empty if the line is no row.
+ */
+const std::vector<TableMap::Cell>& TableMap::cells(int line) const {
+    static const std::vector<Cell> none;
+    return line >= 0 && line < (int)rows.size() ? rows[line].cells : none;
+}
+
+/**
+ * @brief Gets the column widths of the table holding a row.
+ *
+ * A column is as wide as its widest cell, and at least three columns for the
+ * dashes of the delimiter row.
+ *
+ * @param line The row.
+ * @return One width per column, empty if the line is no row.
+ */
+const std::vector<int>& TableMap::widths(int line) const {
+    static const std::vector<int> none;
+    int t = tableIndex(line);
+    if (t < 0) return none;
+    const Table& table = tables[t];
+    if (!table.widths_valid) {
+        table.widths.clear();
+        for (const auto& column : table.columns) {
+            table.widths.push_back(std::max(3, column.empty() ? 0 : column.rbegin()->first));
+        }
+        table.widths_valid = true;
+    }
+    return table.widths;
+}
+
+/**
+ * @brief Gets the alignment the delimiter row gives a column.
+ *
+ * @param line A row of the table.
+ * @param column The column.
+ * @return Center for colons at both ends of the column's dashes, Right for one on the right, else Left.
+ */
+TableMap::Align TableMap::align(int line, size_t column) const {
+    int t = tableIndex(line);
+    if (t < 0 || tables[t].delimiter < 0) return Align::Left;
+    const std::vector<Align>& colons = rows[tables[t].delimiter].aligns;
+    return column < colons.size() ? colons[column] : Align::Left;
+}
+
+/**
+ * @brief Computes a key for how an aligned row is drawn besides its own text.
+ *
+ * @param line The row.
+ * @return A hash of the table's widths and alignments and of the row's kind, 0 for a line that is no row.
+ */
+std::uint64_t TableMap::layoutKey(int line) const {
+    if (!isRow(line)) return 0;
+    std::uint64_t key = 0xCBF29CE484222325ULL ^ rows[line].kind ^ (isHeader(line) ? 4 : 0);
+    const std::vector<int>& list = widths(line);
+    for (size_t c = 0; c < list.size(); ++c) {
+        key = (key ^ (std::uint64_t)(list[c] * 3 + (int)align(line, c))) * 0x100000001B3ULL;
+    }
+    return key;
+}
+
+/**
+ * @brief Finds where a byte of a row is drawn when its columns are aligned.
+ *
+ * A byte in the spaces around a cell's text goes to the nearest end of the text.
+ *
+ * @param text The row.
+ * @param line The row's line.
+ * @param col The byte.
+ * @return The column, counted from the row's first `|`.
+ */
+int TableMap::displayColumn(const std::string& text, int line, size_t col) const {
+    const std::vector<Cell>& list = cells(line);
+    const std::vector<int>& columns = widths(line);
+    if (list.empty() || col < list[0].from) return 0;
+
+    int x = 0;
+    for (size_t c = 0; c < list.size() && c < columns.size(); ++c) {
+        const Cell& cell = list[c];
+        if (col <= cell.to) {
+            int text_x = x + 2 + padBefore(align(line, c), columns[c], cell.width);
+            if (col <= cell.start) return text_x;
+            if (col <= cell.end) return text_x + Utf8::width(text, cell.start, col);
+            if (col == cell.to && cell.to < text.size()) return x + columns[c] + 3;
+            return std::min(text_x + cell.width + (int)(col - cell.end), x + columns[c] + 2);
+        }
+        x += columns[c] + 3;
+    }
+    return x;
+}
+
+/**
+ * @brief Finds the cell holding a byte of a row.
+ *
+ * @return The cell's index, the last cell for a byte past it, -1 before the first `|`.
+ */
+int TableMap::cellAt(int line, size_t col) const {
+    const std::vector<Cell>& list = cells(line);
+    if (list.empty() || col < list[0].from) return -1;
+    for (size_t c = 0; c < list.size(); ++c) {
+        if (col <= list[c].to) return c;
+    }
+    return (int)list.size() - 1;
+}
+
+/**
+ * @brief Writes a row with its cells padded to the widths of its table's columns.
+ *
+ * Missing cells are added empty, and the delimiter row gets dashes as wide as the
+ * columns with the colons of their alignment.
+ *
+ * @param text The row.
+ * @param line The row's line.
+ * @return The formatted row, with the row's indentation.
+ */
+std::string TableMap::format(const std::string& text, int line) const {
+    const std::vector<Cell>& list = cells(line);
+    const std::vector<int>& columns = widths(line);
+    std::string out = text.substr(0, text.find_first_not_of(" \t")) + "|";
+    for (size_t c = 0; c < columns.size(); ++c) {
+        Align column_align = align(line, c);
+        if (isDelimiter(line)) {
+            std::string dashes(columns[c], '-');
+            if (column_align == Align::Center) dashes.front() = ':';
+            if (column_align != Align::Left) dashes.back() = ':';
+            out += " " + dashes + " |";
+        } else {
+            int width = c < list.size() ? list[c].width : 0;
+            int before = padBefore(column_align, columns[c], width);
+            out += " " + std::string(before, ' ');
+            if (c < list.size()) out += text.substr(list[c].start, list[c].end - list[c].start);
+            out += std::string(columns[c] - width - before, ' ') + " |";
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Splits a line into table cells.
+ *
+ * A row starts with `|` after its indentation; `\|` is a pipe inside a cell. Text
+ * after the last `|` is a cell of its own, so a row being typed has all its cells.
+ *
+ * @param text The line.
+ * @param cells Set to the cells of the row.
+ * @param delimiter Set to whether every cell is dashes with optional colons at the ends.
+ * @return `true` if the line is a table row.
+ */
+bool TableMap::parse(const std::string& text, std::vector<Cell>& cells, bool& delimiter) {
+    cells.clear();
+    delimiter = false;
+    size_t indent = text.find_first_not_of(" \t");
+    if (indent == std::string::npos || text[indent] != '|') return false;
+
+    size_t from = indent + 1;
+    for (size_t i = from;; ++i) {
+        if (i < text.size() && text[i] == '\\') {
+            ++i;
+            continue;
+        }
+        if (i < text.size() && text[i] != '|') continue;
+
+        size_t to = std::min(i, text.size());
+        size_t start = text.find_first_not_of(" \t", from);
+        if (to == text.size() && start == std::string::npos) break;  /**< Nothing after the last `|`. */
+        Cell cell{from, to, from, from, 0};
+        if (start != std::string::npos && start < to) {
+            cell.start = start;
+            cell.end = text.find_last_not_of(" \t", to - 1) + 1;
+            cell.width = Utf8::width(text, cell.start, cell.end);
+        }
+        cells.push_back(cell);
+        if (to == text.size()) break;
+        from = i + 1;
+    }
+
+    delimiter = !cells.empty();
+    for (const Cell& cell : cells) {
+        std::string dashes = text.substr(cell.start, cell.end - cell.start);
+        if (!dashes.empty() && dashes.front() == ':') dashes.erase(0, 1);
+        if (!dashes.empty() && dashes.back() == ':') dashes.pop_back();
+        if (dashes.empty() || dashes.find_first_not_of('-') != std::string::npos) delimiter = false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a line into a row.
+ */
+TableMap::Row TableMap::parseRow(const std::string& text) {
+    Row row;
+    bool delimiter;
+    if (parse(text, row.cells, delimiter)) row.kind = delimiter ? DELIMITER : ROW;
+    if (row.kind != DELIMITER) return row;
+    for (const Cell& cell : row.cells) {
+        bool left = text[cell.start] == ':';
+        bool right = text[cell.end - 1] == ':';
+        row.aligns.push_back(left && right ? Align::Center : right ? Align::Right : Align::Left);
+    }
+    return row;
+}
+
+/**
+ * @brief Collects the tables in a range of lines.
+ *
+ * @param first First line of the range.
+ * @param end One past the last line.
+ * @param found The tables are added to it, in order.
+ */
+void TableMap::scan(int first, int end, std::vector<Table>& found) {
+    for (int i = first; i < end;) {
+        if (rows[i].kind == NONE) {
+            ++i;
+            continue;
+        }
+        Table table;
+        table.first = i;
+        table.delimiter = -1;
+        for (; i < end && rows[i].kind != NONE; ++i) {
+            if (rows[i].kind == DELIMITER && table.delimiter < 0) table.delimiter = i;
+            count(table, rows[i], 1);
+        }
+        table.end = i;
+        found.push_back(std::move(table));
+    }
+}
+
+/**
+ * @brief Adds a row's cells to the width counts of its table, or takes them out.
+ *
+ * The cells of the delimiter row count as empty, its dashes follow the widths.
+ *
+ * @param table The table.
+ * @param row The row.
+ * @param delta 1 to add the cells, -1 to take them out.
+ */
+void TableMap::count(Table& table, const Row& row, int delta) {
+    for (size_t c = 0; c < row.cells.size(); ++c) {
+        if (c >= table.columns.size()) table.columns.resize(c + 1);
+        int width = row.kind == DELIMITER ? 0 : row.cells[c].width;
+        if ((table.columns[c][width] += delta) <= 0) table.columns[c].erase(width);
+    }
+    while (!table.columns.empty() && table.columns.back().empty()) table.columns.pop_back();
+    table.widths_valid = false;
+}
+
+/**
+ * @brief Finds the table holding a line.
+ *
+ * @return Its index, -1 if the line is no row.
+ */
+int TableMap::tableIndex(int line) const {
+    auto after = std::upper_bound(tables.begin(), tables.end(), line,
+        [](int at, const Table& table) { return at < table.first; });
+    if (after == tables.begin()) return -1;
+    int t = (int)(after - tables.begin()) - 1;
+    return line < tables[t].end ? t : -1;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file TableMap.h
+ * @brief Header file for the TableMap class, the markdown tables of a note and their column widths.
+ *
+ * A table is a run of lines starting with `|`, its rows. A row of dashes like
+ * `|---|:-:|` is the delimiter row, whose colons set the alignment of each column.
+ * Every row keeps the byte range and width of its cells, and every table keeps, for
+ * each column, how many of its cells have each width, so the column's width is the
+ * largest one counted. Editing a cell takes the edited rows out of the counts and
+ * puts them back, which costs the rows touched, not the rows of the table. Only an
+ * edit that makes or breaks a row scans the tables around it again.
+ *
+ * In table mode the rows are drawn with their columns aligned. An aligned row is
+ * laid out as `| cell | cell |`, each cell padded to its column's width.
+ */
+
+#ifndef TABLE_MAP_H
+#define TABLE_MAP_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TableMap {
+public:
+    enum class Align { Left, Center, Right };
+
+    struct Cell {
+        size_t from;        ///< Just past the cell's opening `|`
+        size_t to;          ///< The closing `|`, or the end of the line
+        size_t start;       ///< The cell's text without the spaces around it
+        size_t end;
+        int width;          ///< Columns the text takes
+    };
+
+    // Forgets the previous buffer and finds the tables of a new one
+    void reset(const std::vector<std::string>& lines);
+
+    // Lines [start, oldEnd) were replaced by lines [start, newEnd); returns whether other rows are laid out differently
+    bool edited(const std::vector<std::string>& lines, int start, int oldEnd, int newEnd);
+
+    bool isRow(int line) const;
+    bool isDelimiter(int line) const;
+    bool isHeader(int line) const;
+
+    // The lines [first, end) of the table holding a row
+    std::pair<int, int> span(int line) const;
+
+    const std::vector<Cell>& cells(int line) const;
+
+    // The width and alignment of each column of the table holding a row
+    const std::vector<int>& widths(int line) const;
+    Align align(int line, size_t column) const;
+
+    // Changes whenever the aligned layout of a row would be drawn differently
+    std::uint64_t layoutKey(int line) const;
+
+    // The column of the aligned row a byte of the row is drawn at, counted from the row's first `|`
+    int displayColumn(const std::string& text, int line, size_t col) const;
+
+    // The cell holding a byte of a row, -1 if the byte is before the first `|`
+    int cellAt(int line, size_t col) const;
+
+    // The row written with its cells padded to the column widths
+    std::string format(const std::string& text, int line) const;
+
+    // Splits a line into cells, returns false if it is no table row
+    static bool parse(const std::string& text, std::vector<Cell>& cells, bool& delimiter);
+
+private:
+    enum Kind : unsigned char { NONE, ROW, DELIMITER };
+
+    struct Row {
+        Kind kind = NONE;
+        std::vector<Cell> cells;
+        std::vector<Align> aligns;  ///< The colons of a delimiter row
+    };
+
+    struct Table {
+        int first;
+        int end;
+        int delimiter;                              ///< The first delimiter row, -1 if there is none
+        std::vector<std::map<int, int>> columns;    ///< Per column, the number of cells of each width
+        mutable std::vector<int> widths;            ///< widths(), worked out again after the counts change
+        mutable bool widths_valid = false;
+    };
+
+    std::vector<Row> rows;          ///< One per line
+    std::vector<Table> tables;      ///< In order
+
+    static Row parseRow(const std::string& text);
+    void scan(int first, int end, std::vector<Table>& found);
+    void count(Table& table, const Row& row, int delta);
+    int tableIndex(int line) const;
+};
+
+#endif // TABLE_MAP_H
@@ -1,5 +1,7 @@
 #include "Task.h"
 #include <sstream>
+#include <cstdio>
+#include <algorithm>
 
 /**
  * @brief Constructs a Task object.
@@ -40,6 +42,37 @@ std::string Task::getDescription() const { return description; }
  */
 int Task::getStatus() const { return status; }
 
+/**
+ * @brief Gets the priority of the task.
+ * @return The priority, from 0 (none) to MAX_PRIORITY.
+ */
+int Task::getPriority() const { return priority; }
+
+/**
+ * @brief Gets the packed due date of the task.
+ * @return The due date as packed by parseDate(), or 0 if there is none.
+ */
+std::uint32_t Task::getDueDate() const { return dueDate; }
+
+/**
+ * @brief Gets the tags of the task.
+ * @return A bitset with one bit per tag of the task's board.
+ */
+std::uint64_t Task::getTags() const { return tags; }
+
+/**
+ * @brief Checks whether the task has a tag.
+ * @param bit The tag's bit on the task's board.
+ * @return `true` if the tag is set.
+ */
+bool Task::hasTag(int bit) const { return bit >= 0 && bit < MAX_TAGS && (tags >> bit) & 1; }
+
+/**
+ * @brief Gets the note the task was created from.
+ * @return The note name, or an empty string if the task is not linked to a checkbox.
+ */
+std::string Task::getNote() const { return note; }
+
 /**
  * @brief Updates the title of the task.
  * @param newTitle The new title for the task.
@@ -56,4 +89,59 @@ void Task::setDescription(const std::string& newDescription) { description = new
  * @brief Updates the status of the task.
  * @param newStatus The new status for the task.
  */
-void Task::setStatus(int newStatus) { status = newStatus; }
\ No newline at end of file
+void Task::setStatus(int newStatus) { status = newStatus; }
+
+/**
+ * @brief Updates the priority of the task.
+ * @param newPriority The new priority, clamped to 0..MAX_PRIORITY.
+ */
+void Task::setPriority(int newPriority) {
+    priority = (std::uint8_t)std::max(0, std::min(newPriority, MAX_PRIORITY));
+}
+
+/**
+ * @brief Updates the due date of the task.
+ * @param newDueDate The new packed due date, 0 for none.
+ */
+void Task::setDueDate(std::uint32_t newDueDate) { dueDate = newDueDate; }
+
+/**
+ * @brief Updates the tags of the task.
+ * @param newTags A bitset with one bit per tag of the task's board.
+ */
+void Task::setTags(std::uint64_t newTags) { tags = newTags; }
+
+/**
+ * @brief Links the task to a checkbox in a note.
+ * @param newNote The note name, or an empty string to unlink the task.
+ */
+void Task::setNote(const std::string& newNote) { note = newNote; }
+
+/**
+ * @brief Packs a date written as YYYY-MM-DD.
+ * @param text The date to parse.
+ * @return The packed date, or 0 if the text is not a valid date.
+ */
+std::uint32_t Task::parseDate(const std::string& text) {
+    static const int monthDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int year, month, day;
+    if (std::sscanf(text.c_str(), "%d-%d-%d", &year, &month, &day) != 3 ||
+        year < 1 || year > 9999 || month < 1 || month > 12 || day < 1) {
+        return 0;
+    }
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (day > monthDays[month - 1] + (month == 2 && leap ? 1 : 0)) return 0;
+    return ((std::uint32_t)year << 9) | ((std::uint32_t)month << 5) | (std::uint32_t)day;
+}
+
+/**
+ * @brief Formats a packed date as YYYY-MM-DD.
+ * @param packed The packed date.
+ * @return The formatted date, or an empty string if there is no date.
+ */
+std::string Task::formatDate(std::uint32_t packed) {
+    if (packed == 0) return "";
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04u-%02u-%02u", packed >> 9, (packed >> 5) & 0xF, packed & 0x1F);
+    return buffer;
+}
@@ -15,6 +15,7 @@
 #define TASK_H
 
 #include <string>
+#include <cstdint>
 
 // The Task class represents an individual task in a Kanban board.
 class Task {
@@ -28,17 +29,38 @@ public:
     std::string getTitle() const;
     std::string getDescription() const;
     int getStatus() const;
+    int getPriority() const;
+    std::uint32_t getDueDate() const;
+    std::uint64_t getTags() const;
+    bool hasTag(int bit) const;
+    std::string getNote() const;
 
     // Setter methods:
     void setTitle(const std::string& newTitle);
     void setDescription(const std::string& newDescription);
     void setStatus(const int newStatus);
+    void setPriority(int newPriority);
+    void setDueDate(std::uint32_t newDueDate);
+    void setTags(std::uint64_t newTags);
+    void setNote(const std::string& newNote);
+
+    // Due dates are packed as (year << 9) | (month << 5) | day, 0 meaning no date,
+    // so comparing packed values compares dates.
+    static std::uint32_t parseDate(const std::string& text);
+    static std::string formatDate(std::uint32_t packed);
+
+    static constexpr int MAX_PRIORITY = 3;
+    static constexpr int MAX_TAGS = 64;
     
 private:
     int id;
     std::string title;
     std::string description;
     int status;
+    std::uint8_t priority = 0;      ///< 0 (none) to MAX_PRIORITY
+    std::uint32_t dueDate = 0;      ///< Packed date, see parseDate()
+    std::uint64_t tags = 0;         ///< One bit per tag of the board
+    std::string note;               ///< Note holding the task's checkbox, empty if none
 };
 
 #endif // TASK_H
\ No newline at end of file
@@ -1,278 +1,684 @@
 #include "TaskManager.h"
+#include "AllocationTracker.h"
+#include "Settings.h"
+#include "RenderBackend.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
-#include <ncurses.h> 
+#include <ncurses.h>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <cstdlib>
+#include <cstdio>
+#include <cctype>
 
 /**
  * @brief Constructor for TaskManager.
- * 
+ *
  * Initializes a TaskManager with the given ncurses window where tasks will be displayed.
- * 
+ * Only the list of boards is read here, each board loads its tasks the first time it is opened.
+ * The board stored directly in the kanban directory is always first, the others live in
+ * `kanban/boards/<name>/`. With the board names of a session snapshot, the boards
+ * directory is not read.
+ *
  * @param content Pointer to the ncurses window where tasks will be displayed.
+ * @param boardNames The boards of a session snapshot, nullptr to read the boards directory.
  */
-TaskManager::TaskManager(WINDOW* content) : content(content), currentSelected(-1), currentType(-1) {
+TaskManager::TaskManager(WINDOW* content, const std::vector<std::string>* boardNames)
+    : activeBoard(0), content(content),
+      noteSync(getenv("HOME") ? std::string(getenv("HOME")) + "/.local/share/neonote/" : ""),
+      currentSelected(-1), currentType(-1), selectedRow(0) {
+    AllocationTracker::Scope tag(AllocationTracker::Tasks);
     this->content = content;
 
     const char* homeDir = getenv("HOME");
-    if (!homeDir) return;
+    if (homeDir) {
+        kanbanDir = std::string(homeDir) + "/.local/share/neonote/kanban/";
+    }
 
-    std::string dirPath = std::string(homeDir) + "/.local/share/neonote/kanban/";
+    boards.emplace_back("My Tasks", kanbanDir);
 
-    if (!std::filesystem::exists(dirPath) || !std::filesystem::is_directory(dirPath)) {
-        std::filesystem::create_directories(dirPath);  // Create the directory if it doesn't exist
-        return;
+    if (!homeDir) return;
+    std::vector<std::string> names = boardNames ? *boardNames : scanBoards(kanbanDir);
+    for (const std::string& name : names) {
+        boards.emplace_back(name, kanbanDir + "boards/" + name + "/");
     }
+}
 
-    for (const auto& entry : std::filesystem::directory_iterator(dirPath)) {
-        if (entry.is_regular_file()) {
-            std::ifstream inFile(entry.path());
-            
-            std::string title;
-            int type = -1;
-            
-            if (std::getline(inFile, title) && inFile >> type) {
-                std::string filename = entry.path().filename().string();
-                int taskId = std::stoi(filename);
+/**
+ * @brief Lists the boards in the boards directory.
+ *
+ * Only reads the directory, so it can run on another thread.
+ *
+ * @param kanbanDir The kanban directory.
+ * @return The board names, sorted.
+ */
+std::vector<std::string> TaskManager::scanBoards(const std::string& kanbanDir) {
+    std::vector<std::string> names;
+    std::string boardsDir = kanbanDir + "boards/";
+    if (!std::filesystem::is_directory(boardsDir)) return names;
+    for (const auto& entry : std::filesystem::directory_iterator(boardsDir)) {
+        if (entry.is_directory()) {
+            names.push_back(entry.path().filename().string());
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
 
-                if (type >= 0 && type < tasks.size()) {
-                    tasks[type].emplace_back(taskId, title, type);
-                }
-            }
-            inFile.close();
+/**
+ * @brief Replaces the boards taken from a session snapshot with the ones on disk.
+ *
+ * Works like FileManager::setFiles: a board the scan and the list disagree on is
+ * kept only if its directory exists now, and the open board is always kept. Boards
+ * keep their loaded tasks.
+ *
+ * @param scanned The boards found by scanBoards.
+ * @return `true` if the list changed.
+ */
+bool TaskManager::setBoards(const std::vector<std::string>& scanned) {
+    std::vector<std::string> names = boardNames();
+    auto exists = [this](const std::string& name) {
+        return std::filesystem::is_directory(kanbanDir + "boards/" + name);
+    };
+
+    std::vector<Board> merged;
+    merged.push_back(std::move(boards[0]));
+    int open = 0;
+    for (size_t i = 1; i < boards.size(); ++i) {
+        const std::string& name = boards[i].getName();
+        bool active = (int)i == activeBoard;
+        if (!active && std::find(scanned.begin(), scanned.end(), name) == scanned.end() && !exists(name)) continue;
+        if (active) open = merged.size();
+        merged.push_back(std::move(boards[i]));
+    }
+    for (const std::string& name : scanned) {
+        if (std::find(names.begin(), names.end(), name) == names.end() && exists(name)) {
+            merged.emplace_back(name, kanbanDir + "boards/" + name + "/");
         }
     }
+
+    boards = std::move(merged);
+    activeBoard = open;
+    return boardNames() != names;
+}
+
+/**
+ * @brief Gets the names of the boards after "My Tasks".
+ *
+ * @return The names, in the order of the board popup.
+ */
+std::vector<std::string> TaskManager::boardNames() const {
+    std::vector<std::string> names;
+    for (size_t i = 1; i < boards.size(); ++i) {
+        names.push_back(boards[i].getName());
+    }
+    return names;
+}
+
+/**
+ * @brief Gets the names of all boards.
+ *
+ * @return The names, "My Tasks" first, in the order of the sidebar.
+ */
+std::vector<std::string> TaskManager::allBoardNames() const {
+    std::vector<std::string> names;
+    for (const Board& each : boards) {
+        names.push_back(each.getName());
+    }
+    return names;
+}
+
+/**
+ * @brief Gets the open board, reading it from disk if this is the first access.
+ * @return The open board.
+ */
+Board& TaskManager::board() {
+    Board& open = boards[activeBoard];
+    if (!open.isLoaded()) {
+        AllocationTracker::Scope tag(AllocationTracker::Tasks);
+        open.load();
+    }
+    return open;
 }
 
 /**
  * @brief Adds a task to the task list with the given title.
- * 
- * This function creates a new task with a unique ID, default status ("To Do"), 
+ *
+ * This function creates a new task with a unique ID, default status ("To Do"),
  * and the given title. The task is then added to the task list.
- * 
+ *
  * @param title The title of the task to be added.
  */
 void TaskManager::addTask(const std::string& title, int type) {
-    int newTaskId = nextFree();
-    tasks[type].emplace_back(newTaskId, title, type);
-
-    const char* homeDir = getenv("HOME");  // Get the home directory
-    if (homeDir == nullptr) return;        // Failsafe if HOME is not set
+    if (type < 0 || type >= board().columnCount()) return;
 
-    std::string kanbanDir = std::string(homeDir) + "/.local/share/neonote/kanban/";
-
-    // Create the directory if it doesn't exist
-    std::filesystem::create_directories(kanbanDir);
-
-    // Write the task to a file with ID as filename
-    std::string filePath = kanbanDir + std::to_string(newTaskId);
-
-    std::ofstream outFile(filePath);
-    if (outFile.is_open()) {
-        outFile << title << "\n";
-        outFile << type << "\n";
-        outFile.close();
+    int slot = board().addTask(title, type);
+    if (type < (int)tops.size() && tops[type] == -1 && board().inView(slot, view)) {
+        tops[type] = slot;
+    }
+    if (currentSelected == -1 && currentType == type && tops[type] == slot) {
+        selectRow(type, 0);
     }
+    damage.full = true;
 }
 
 /**
  * @brief Removes a task from the task list by its ID.
- * 
- * This function searches for a task by its ID and removes it from the task list.
- * 
+ *
+ * The task is found through the ID index and unlinked from its column in constant time.
+ *
  * @param taskId The ID of the task to be removed.
  */
 void TaskManager::removeTask(int taskId) {
-    if (taskId == -1) return;
+    int slot = board().findSlot(taskId);
+    if (slot == -1) return;
 
-    for (auto& taskList : tasks) {
-        for (auto it = taskList.begin(); it != taskList.end(); ++it) {
-            if (it->getId() == taskId) {
-                taskList.erase(it);
-
-                const char* homeDir = getenv("HOME");
-                if (homeDir != nullptr) {
-                    std::string filePath = std::string(homeDir) + "/.local/share/neonote/kanban/" + std::to_string(taskId);
-
-                    if (std::filesystem::exists(filePath)) {
-                        std::filesystem::remove(filePath);
-                    }
-                }
-                return;
-            }
-        }
-    }
+    releaseSelection(slot);
+    board().removeTask(slot);
+    recountSelectedRow();
+    damage.full = true;
 }
 
 /**
  * @brief Moves a task to a new status.
- * 
- * This function searches for a task by its ID and updates its status to the
- * provided new status.
- * 
+ *
+ * The task is unlinked from its current column and appended to the new one
+ * without being copied, then its file is rewritten with the new status. On the
+ * first board this also ticks or unticks the task's checkbox in its note file,
+ * so the caller must have saved the note and flushed the save queue first.
+ *
  * @param taskId The ID of the task to be moved.
  * @param type The new status to assign to the task.
  */
 void TaskManager::moveTask(int taskId, int type) {
-    if (type < 0 || type >= tasks.size()) {
+    if (type < 0 || type >= board().columnCount()) {
         return;
     }
 
-    for (auto& taskList : tasks) {
-        for (auto it = taskList.begin(); it != taskList.end();) {  
-            if (it->getId() == taskId) {
-                if (&taskList != &tasks[type]) {
-                    tasks[type].push_back(*it);
-                    it = taskList.erase(it);
-
-                    const char* homeDir = getenv("HOME");
-                    if (homeDir != nullptr) {
-                        std::string filePath = std::string(homeDir) + "/.local/share/neonote/kanban/" + std::to_string(taskId);
-
-                        if (std::filesystem::exists(filePath)) {
-                            std::ifstream inFile(filePath);
-                            std::string title;
-
-                            if (std::getline(inFile, title)) {
-                                inFile.close();
-
-                                std::ofstream outFile(filePath);
-                                outFile << title << "\n" << type << "\n";
-                                outFile.close();
-                            }
-                        }
-                    }
-                } else {
-                    ++it;
-                }
-                return;
-            } else {
-                ++it;
-            }
+    int slot = board().findSlot(taskId);
+    if (slot == -1 || board().getNode(slot).task.getStatus() == type) return;
+
+    releaseSelection(slot);
+    board().moveTask(slot, type);
+    if (activeBoard == 0) {
+        noteSync.taskMoved(board(), slot);
+    }
+    if (tops[type] == -1 && board().inView(slot, view)) {
+        tops[type] = slot;
+    }
+    recountSelectedRow();
+    damage.full = true;
+}
+
+/**
+ * @brief Looks up a task on the open board by its ID.
+ *
+ * @param taskId The ID of the task.
+ * @return A pointer to the task, or `nullptr` if no task has this ID.
+ */
+const Task* TaskManager::findTask(int taskId) {
+    int slot = board().findSlot(taskId);
+    return slot == -1 ? nullptr : &board().getNode(slot).task;
+}
+
+/**
+ * @brief Sets the description, priority, due date and tags of a task from user input.
+ *
+ * Empty fields keep their current value and "-" clears them. Tags are given as a
+ * comma separated list of names and are added to the board the first time they are
+ * used. The task can change position or leave the current view, so the columns
+ * scroll back to their first card when needed.
+ *
+ * @param taskId The ID of the task to edit.
+ * @param description The new description.
+ * @param priority The new priority, from 0 to Task::MAX_PRIORITY.
+ * @param dueDate The new due date as YYYY-MM-DD.
+ * @param tags The new comma separated tags.
+ */
+void TaskManager::editTask(int taskId, const std::string& description, const std::string& priority,
+                           const std::string& dueDate, const std::string& tags) {
+    int slot = board().findSlot(taskId);
+    if (slot == -1) return;
+
+    const Task& task = board().getNode(slot).task;
+    std::string newDescription = task.getDescription();
+    int newPriority = task.getPriority();
+    std::uint32_t newDue = task.getDueDate();
+    std::uint64_t newTags = task.getTags();
+
+    if (description == "-") newDescription.clear();
+    else if (!description.empty()) newDescription = description;
+
+    if (priority == "-") newPriority = 0;
+    else if (!priority.empty() && std::isdigit((unsigned char)priority[0])) newPriority = std::atoi(priority.c_str());
+
+    if (dueDate == "-") newDue = 0;
+    else if (!dueDate.empty() && Task::parseDate(dueDate)) newDue = Task::parseDate(dueDate);
+
+    if (tags == "-") {
+        newTags = 0;
+    } else if (!tags.empty()) {
+        newTags = 0;
+        std::stringstream stream(tags);
+        std::string tag;
+        while (std::getline(stream, tag, ',')) {
+            size_t start = tag.find_first_not_of(' ');
+            size_t end = tag.find_last_not_of(' ');
+            if (start == std::string::npos) continue;
+            int bit = board().findTag(tag.substr(start, end - start + 1), true);
+            if (bit != -1) newTags |= std::uint64_t(1) << bit;
         }
     }
+
+    int type = task.getStatus();
+    board().updateTask(slot, newDescription, newPriority, newDue, newTags);
+
+    tops[type] = board().first(type, view);
+    if (currentType == type) {
+        if (currentSelected != -1 && board().inView(currentSelected, view)) {
+            recountSelectedRow();
+        } else {
+            selectRow(type, 0);
+        }
+    }
+    damage.full = true;
+}
+
+/**
+ * @brief Switches the columns between manual, due date and priority order.
+ *
+ * The index for each order is built the first time it is used, so switching
+ * back and forth afterwards does not sort the board again.
+ */
+void TaskManager::cycleSortOrder() {
+    switch (view.order) {
+        case Board::SortOrder::Manual: view.order = Board::SortOrder::Due; break;
+        case Board::SortOrder::Due: view.order = Board::SortOrder::Priority; break;
+        case Board::SortOrder::Priority: view.order = Board::SortOrder::Manual; break;
+    }
+    resetTops();
+    if (currentType >= 0) selectRow(currentType, 0);
+    damage.full = true;
+}
+
+/**
+ * @brief Lets the user pick a tag from a popup and shows only the tasks that have it.
+ */
+void TaskManager::filterPopup() {
+    std::vector<std::string> options = {"All tasks"};
+    for (const std::string& tag : board().getTagNames()) {
+        options.push_back("+" + tag);
+    }
+
+    int choice = choicePopup("Filter By Tag:", options);
+    if (choice == -1) return;
+
+    view.tag = choice - 1;
+    resetTops();
+    if (currentType >= 0) selectRow(currentType, 0);
+    damage.full = true;
+}
+
+/**
+ * @brief Scrolls every column back to its first card in the current view.
+ */
+void TaskManager::resetTops() {
+    tops.resize(board().columnCount());
+    for (int type = 0; type < (int)tops.size(); ++type) {
+        tops[type] = board().first(type, view);
+    }
+}
+
+/**
+ * @brief Gets the number of tasks in a status category.
+ *
+ * @param type The status category.
+ * @return The number of tasks, or 0 for an unknown category.
+ */
+int TaskManager::columnSize(int type) {
+    if (type < 0 || type >= board().columnCount()) return 0;
+    return board().getColumn(type).size;
+}
+
+/**
+ * @brief Moves the selection and the first visible card off a task that is about to leave its column.
+ *
+ * The card below takes its place, or the card above if it was the last one.
+ *
+ * @param slot The pool slot of the task leaving its column.
+ */
+void TaskManager::releaseSelection(int slot) {
+    if (tops.size() != (size_t)board().columnCount()) resetTops();
+
+    int type = board().getNode(slot).task.getStatus();
+    if (slot != tops[type] && slot != currentSelected) return;
+
+    int replacement = board().next(slot, view);
+    if (replacement == -1) replacement = board().prev(slot, view);
+
+    if (slot == tops[type]) tops[type] = replacement;
+    if (slot == currentSelected) currentSelected = replacement;
 }
 
 /**
- * @brief Gets a reference to the list of all tasks.
- * @return A reference to the vector containing all tasks.
+ * @brief Recounts the selected card's visible row after its column changed.
+ *
+ * Walks at most one screen of cards. If the selection is no longer on screen,
+ * the column is scrolled to start at it.
  */
-const std::vector<std::vector<Task>>& TaskManager::getTasks() const {
-    return tasks;
+void TaskManager::recountSelectedRow() {
+    if (currentType < 0) return;
+
+    if (currentSelected == -1) {
+        selectedRow = 0;
+        return;
+    }
+
+    int row = 0;
+    int cursor = tops[currentType];
+    while (cursor != -1 && cursor != currentSelected && row < visibleCards()) {
+        cursor = board().next(cursor, view);
+        row++;
+    }
+    if (cursor != currentSelected) {
+        tops[currentType] = currentSelected;
+        row = 0;
+    }
+    selectedRow = row;
 }
 
 /**
  * @brief Renders the tasks in the ncurses window.
- * 
- * This function clears the window and displays the list of tasks divided by their
- * status into three columns: "To Do", "In Progress", and "Done".
+ *
+ * Each column of the open board gets a pane at least MIN_COLUMN_WIDTH wide; when
+ * they do not all fit, only the panes around the selected column are drawn and
+ * arrows on the border show that more columns are hidden. Panes are laid out once
+ * per window size, only the cards that fit in a column are drawn, and when nothing
+ * but the selection changed since the last call only the affected headers and
+ * cards are repainted. The terminal is updated by the next doupdate.
  */
 void TaskManager::renderTasks() {
-    werase(content);
-    box(content, 0, 0);
-
+    AllocationTracker::Scope tag(AllocationTracker::Render);
     int maxY, maxX;
     getmaxyx(content, maxY, maxX);  // Get the height and width of the window
 
-    // Calculate dimensions for the columns
-    int colWidth = (maxX - 2) / 3;        // Divide window into 3 equal parts
-    int colHeight = maxY - 2;             // Leave space for borders
-
-    // Create derwin windows for each column
-    WINDOW* todoWin = derwin(content, colHeight, colWidth, 1, 1);
-    WINDOW* inProgressWin = derwin(content, colHeight, colWidth, 1, colWidth + 1);
-    WINDOW* doneWin = derwin(content, colHeight, colWidth, 1, 2 * colWidth + 1);
-
-    // Render headers
-    if(currentType == 0) wattron(todoWin, COLOR_PAIR(6));
-    mvwprintw(todoWin, 0, (colWidth - 6) / 2, "To Do");
-    mvwhline(todoWin, 1, 0, ACS_HLINE, colWidth);
-    wattroff(todoWin, COLOR_PAIR(6));
-
-    if(currentType == 1) wattron(inProgressWin, COLOR_PAIR(6));
-    mvwprintw(inProgressWin, 0, (colWidth - 11) / 2, "In Progress");
-    mvwhline(inProgressWin, 1, 0, ACS_HLINE, colWidth);
-    wattroff(inProgressWin, COLOR_PAIR(6));
-
-    if(currentType == 2) wattron(doneWin, COLOR_PAIR(6));
-    mvwprintw(doneWin, 0, (colWidth - 4) / 2, "Done");
-    mvwhline(doneWin, 1, 0, ACS_HLINE, colWidth);
-    wattroff(doneWin, COLOR_PAIR(6));
-
-    // Display tasks in each column
-    for (int col = 0; col < 3; ++col) {
-        WINDOW* drawWin = (col == 0) ? todoWin : (col == 1) ? inProgressWin : doneWin;
-
-        int maxVisibleEvents = (colHeight / 3) - 1;
-
-        if (currentSelected < colOffset[col]) {
-            colOffset[col] = std::max(currentSelected, 0);
-        } else if (currentSelected >= colOffset[col] + maxVisibleEvents) {
-            colOffset[col] = currentSelected - maxVisibleEvents + 1;
+    if (tops.size() != (size_t)board().columnCount()) {
+        resetTops();
+    }
+    if (maxY != paneMaxY || maxX != paneMaxX || paneColumns != board().columnCount()) {
+        layoutPanes(maxY, maxX);
+        damage.full = true;
+    }
+
+    if (damage.full) {
+        if (followColumn()) {
+            layoutPanes(maxY, maxX);
         }
-        
-        int y = 3;
-        for (int i = colOffset[col]; i < std::min(colOffset[col] + maxVisibleEvents, (int)tasks[col].size()); ++i) {
-            bool isSelected = (currentType == col && currentSelected == i);
+        followSelection();
+        werase(content);
+        box(content, 0, 0);
 
-            if (isSelected) {
-                wattron(drawWin, A_REVERSE);
-            }
+        std::string title = board().getName();
+        if (view.order == Board::SortOrder::Due) title += " | by due date";
+        if (view.order == Board::SortOrder::Priority) title += " | by priority";
+        if (view.tag >= 0) title += " | +" + board().getTagNames()[view.tag];
+        mvwprintw(content, 0, 2, " %.*s ", std::max(0, maxX - 6), title.c_str());
+        if (firstColumn > 0) {
+            mvwaddch(content, 1, 0, ACS_LARROW);
+        }
+        if (paneColumns > 0 && panes.back().x == -1) {
+            mvwaddch(content, 1, maxX - 1, ACS_RARROW);
+        }
 
-            std::string title = " " + tasks[col][i].getTitle() + " ";
-            std::string id = " #" + std::to_string(tasks[col][i].getId()) + " ";
+        for (int type = 0; type < (int)panes.size(); ++type) {
+            drawColumn(type);
+        }
+    } else {
+        for (int type : damage.columns) {
+            drawColumn(type);
+        }
+        for (int type : damage.headers) {
+            drawHeader(type);
+        }
+        for (const auto& [slot, row] : damage.cards) {
+            drawCard(slot, row);
+        }
+    }
 
-            // Elipsis overflow
-            if (title.length() > colWidth - 2) {
-                title = title.substr(0, colWidth - 5) + "...";
-            }
+    damage = Damage{false, {}, {}, {}};
+    wnoutrefresh(content);
+}
 
-            // Pad both lines to fit the column width
-            while (title.length() < colWidth - 2) {
-                title += " ";
-            }
-            while (id.length() < colWidth - 2) {
-                id += " ";
-            }
+/**
+ * @brief Forces the next renderTasks() call to repaint the whole board.
+ *
+ * Needed whenever something else (a note, a prompt, the calendar) has drawn
+ * over the content window since the board was last rendered.
+ */
+void TaskManager::invalidate() {
+    damage.full = true;
+}
+
+/**
+ * @brief Sets the window the board is drawn into.
+ *
+ * The board is shown in a pane, and the focused pane's window changes when
+ * panes are split, closed or focused.
+ *
+ * @param win The window of the pane showing the board.
+ */
+void TaskManager::setWindow(WINDOW* win) {
+    if (win != content) {
+        content = win;
+        damage.full = true;
+    }
+}
+
+/**
+ * @brief Computes the column panes for the given content window size.
+ *
+ * Fits as many columns as possible at MIN_COLUMN_WIDTH, shares the width
+ * equally among them and marks the rest as scrolled out of view.
+ *
+ * @param maxY Height of the content window.
+ * @param maxX Width of the content window.
+ */
+void TaskManager::layoutPanes(int maxY, int maxX) {
+    paneMaxY = maxY;
+    paneMaxX = maxX;
+    paneColumns = board().columnCount();
 
-            // Draw the task with padding and inverted color if selected
-            mvwprintw(drawWin, y++, 1, "%s", title.c_str());
-            mvwprintw(drawWin, y++, 1, "%s", id.c_str());
-            y++;  // Add spacing between tasks
+    int visible = std::max(1, std::min(paneColumns, (maxX - 2) / MIN_COLUMN_WIDTH));
+    int colWidth = (maxX - 2) / visible;
+    firstColumn = std::max(0, std::min(firstColumn, paneColumns - visible));
 
-            if (isSelected) {
-                wattroff(drawWin, A_REVERSE);  // Turn off inversion
-            }
+    panes.assign(paneColumns, ColumnPane{-1, colWidth});
+    for (int i = 0; i < visible && firstColumn + i < paneColumns; ++i) {
+        panes[firstColumn + i].x = 1 + i * colWidth;
+    }
+}
+
+/**
+ * @brief Scrolls the board horizontally so the selected column is visible.
+ *
+ * @return `true` if the leftmost visible column changed and the panes must be laid out again.
+ */
+bool TaskManager::followColumn() {
+    if (currentType < 0 || currentType >= (int)panes.size() || panes[currentType].x != -1) return false;
+
+    int visible = 0;
+    for (const ColumnPane& pane : panes) {
+        if (pane.x != -1) visible++;
+    }
+
+    if (currentType < firstColumn) {
+        firstColumn = currentType;
+    } else {
+        firstColumn = currentType - visible + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Number of cards that fit in a column at the current window height.
+ */
+int TaskManager::visibleCards() const {
+    int colHeight = paneMaxY - 2;             // Leave space for borders
+    return std::max(1, (colHeight / 3) - 1);
+}
+
+/**
+ * @brief Scrolls the selected column so the selected card stays visible.
+ *
+ * Only needed when the number of visible cards shrinks, so it walks at most
+ * one screen of cards.
+ *
+ * @return `true` if the column scrolled and must be repainted.
+ */
+bool TaskManager::followSelection() {
+    if (currentType < 0 || currentType >= board().columnCount() || currentSelected == -1) return false;
+
+    int& top = tops[currentType];
+    bool scrolled = false;
+    while (selectedRow >= visibleCards() && top != currentSelected) {
+        top = board().next(top, view);
+        selectedRow--;
+        scrolled = true;
+    }
+    return scrolled;
+}
+
+/**
+ * @brief Draws the title and separator of a column.
+ *
+ * @param type The column to draw.
+ */
+void TaskManager::drawHeader(int type) {
+    const ColumnPane& pane = panes[type];
+    if (pane.x == -1) return;
+
+    const std::string& title = board().getColumn(type).name;
+    int titleLen = std::min((int)title.length(), std::max(0, pane.width - 2));
+
+    mvwhline(content, 1, pane.x, ' ', pane.width);
+    if (currentType == type) wattron(content, COLOR_PAIR(6));
+    mvwprintw(content, 1, pane.x + std::max(0, (pane.width - titleLen - 1) / 2), "%.*s", titleLen, title.c_str());
+    mvwhline(content, 2, pane.x, ACS_HLINE, pane.width);
+    wattroff(content, COLOR_PAIR(6));
+}
+
+/**
+ * @brief Clears a column and draws its header and every visible card.
+ *
+ * Walks the column from its first visible card, so the cost only depends on
+ * the window height, not on the number of tasks.
+ *
+ * @param type The column to draw.
+ */
+void TaskManager::drawColumn(int type) {
+    const ColumnPane& pane = panes[type];
+    if (pane.x == -1) return;
+
+    for (int y = 3; y < paneMaxY - 1; ++y) {
+        mvwhline(content, y, pane.x, ' ', pane.width);
+    }
+
+    drawHeader(type);
+
+    int slot = tops[type];
+    for (int row = 0; slot != -1 && row < visibleCards(); ++row) {
+        drawCard(slot, row);
+        slot = board().next(slot, view);
+    }
+}
+
+/**
+ * @brief Draws a single card, inverted if it is the current selection.
+ *
+ * @param slot The pool slot of the task to draw.
+ * @param row The visible row of the card within its column.
+ */
+void TaskManager::drawCard(int slot, int row) {
+    if (slot < 0 || row < 0 || row >= visibleCards()) return;
+
+    const Task& task = board().getNode(slot).task;
+    const ColumnPane& pane = panes[task.getStatus()];
+    if (pane.x == -1) return;
+
+    int y = 4 + row * 3;
+    int x = pane.x + 1;
+    int inner = std::max(0, pane.width - 2);
+    bool isSelected = (currentSelected == slot);
+
+    if (isSelected) {
+        wattron(content, A_REVERSE);
+    }
+
+    // Pad both lines to the column width, with ellipsis overflow on the title
+    const std::string& title = task.getTitle();
+    if ((int)title.length() + 2 > inner) {
+        mvwprintw(content, y, x, " %.*s...", std::max(0, inner - 4), title.c_str());
+    } else {
+        mvwprintw(content, y, x, " %-*s", std::max(0, inner - 1), title.c_str());
+    }
+    // Second line: ID, priority marks, due date and tags, cut at the column width
+    char details[256];
+    int length = std::snprintf(details, sizeof(details), "#%d", task.getId());
+    if (task.getPriority()) {
+        length += std::snprintf(details + length, sizeof(details) - length, " %.*s",
+                                (int)task.getPriority(), "!!!");
+    }
+    if (task.getDueDate()) {
+        length += std::snprintf(details + length, sizeof(details) - length, " %s",
+                                Task::formatDate(task.getDueDate()).c_str());
+    }
+    for (int bit = 0; bit < (int)board().getTagNames().size() && length < (int)sizeof(details) - 1; ++bit) {
+        if (task.hasTag(bit)) {
+            length += std::snprintf(details + length, sizeof(details) - length, " +%s",
+                                    board().getTagNames()[bit].c_str());
         }
     }
+    mvwprintw(content, y + 1, x, " %-*.*s", std::max(0, inner - 1), std::max(0, inner - 1), details);
 
-    // Refresh all windows
-    wrefresh(todoWin);
-    wrefresh(inProgressWin);
-    wrefresh(doneWin);
-    wrefresh(content);
+    if (isSelected) {
+        wattroff(content, A_REVERSE);  // Turn off inversion
+    }
+}
 
-    // Clean up windows
-    delwin(todoWin);
-    delwin(inProgressWin);
-    delwin(doneWin);
+/**
+ * @brief Selects the card at a visible row of a column.
+ *
+ * If the column has fewer cards below its first visible one, the last of them is selected.
+ *
+ * @param type The column to select in.
+ * @param row The preferred visible row.
+ */
+void TaskManager::selectRow(int type, int row) {
+    currentType = type;
+    currentSelected = tops[type];
+    selectedRow = 0;
+    while (currentSelected != -1 && selectedRow < row && board().next(currentSelected, view) != -1) {
+        currentSelected = board().next(currentSelected, view);
+        selectedRow++;
+    }
 }
 
 /**
  * @brief Moves the task selection in the specified direction.
- * 
- * This function handles circular navigation for both rows (tasks) and columns (task types). 
+ *
+ * This function handles circular navigation for both rows (tasks) and columns (task types).
  * - **Direction 0:** Moves the selection up within the current task type.
  * - **Direction 1:** Moves the selection down within the current task type.
  * - **Direction 2:** Moves the selection left to the previous task type.
  * - **Direction 3:** Moves the selection right to the next task type.
- * 
+ *
  * Circular navigation ensures that moving past the first or last element wraps around.
- * 
+ * Moving between columns keeps the selection on the same visible row. Only the
+ * previously and newly selected cards are marked for repainting, unless the
+ * selected column had to scroll.
+ *
  * @param direction The direction to move the selection:
  *                  - 0: Up
  *                  - 1: Down
@@ -280,147 +686,351 @@ void TaskManager::renderTasks() {
  *                  - 3: Right
  */
 void TaskManager::moveSelection(int direction){
+    if (currentType < 0) return;
+
+    int oldType = currentType;
+    int oldSelected = currentSelected;
+    int oldRow = selectedRow;
+    Board& open = board();
+    int& top = tops[currentType];
+    int previousTop = top;
+    int numTypes = open.columnCount();
+
     switch (direction) {
         case 0:  // Up
-            if (!tasks[currentType].empty()) {
-                currentSelected = (currentSelected - 1 + tasks[currentType].size()) % tasks[currentType].size();
+            if (currentSelected == -1) break;
+            if (open.prev(currentSelected, view) != -1) {
+                currentSelected = open.prev(currentSelected, view);
+                if (selectedRow > 0) selectedRow--;
+                else top = currentSelected;
+            } else {
+                // Wrap to the last card and show a full screen above it
+                currentSelected = open.last(currentType, view);
+                top = currentSelected;
+                selectedRow = 0;
+                while (selectedRow < visibleCards() - 1 && open.prev(top, view) != -1) {
+                    top = open.prev(top, view);
+                    selectedRow++;
+                }
             }
             break;
 
         case 1:  // Down
-            if (!tasks[currentType].empty()) {
-                currentSelected = (currentSelected + 1) % tasks[currentType].size();
+            if (currentSelected == -1) break;
+            if (open.next(currentSelected, view) != -1) {
+                currentSelected = open.next(currentSelected, view);
+                if (selectedRow < visibleCards() - 1) selectedRow++;
+                else top = open.next(top, view);
+            } else {
+                currentSelected = open.first(currentType, view);
+                top = currentSelected;
+                selectedRow = 0;
             }
             break;
 
         case 2:  // Left
-            currentType = (currentType - 1 + 3) % 3;
-            currentSelected = std::min(currentSelected, tasks[currentType].size() == 0 ? 0 : (int)tasks[currentType].size() - 1);
+            selectRow((currentType - 1 + numTypes) % numTypes, selectedRow);
             break;
 
         case 3:  // Right
-            currentType = (currentType + 1) % 3;
-            currentSelected = std::min(currentSelected, tasks[currentType].size() == 0 ? 0 : (int)tasks[currentType].size() - 1);
+            selectRow((currentType + 1) % numTypes, selectedRow);
             break;
     }
+
+    if (damage.full || panes.empty()) return;
+
+    if (followColumn()) {
+        damage.full = true;
+        return;
+    }
+
+    bool scrolled = (tops[oldType] != previousTop);
+    if (scrolled) {
+        damage.columns.push_back(oldType);
+    } else {
+        damage.cards.emplace_back(oldSelected, oldRow);
+    }
+    if (oldType != currentType) {
+        damage.headers.push_back(oldType);
+        damage.headers.push_back(currentType);
+    }
+    if (!(scrolled && oldType == currentType)) {
+        damage.cards.emplace_back(currentSelected, selectedRow);
+    }
 }
 
 
 /**
  * @brief Retrieves the ID of the currently selected task.
- * 
- * This function returns the ID of the task at the current selection. 
- * If the current type or selection is out of bounds, it returns `-1` to indicate an invalid selection.
- * 
- * @return The ID of the selected task, or `-1` if the selection is invalid.
+ *
+ * @return The ID of the selected task, or `-1` if nothing is selected.
  */
 int TaskManager::getSelectedTaskId() {
-    if (currentType >= tasks.size() || currentSelected >= tasks[currentType].size()) {
+    if (currentSelected == -1) {
         return -1;
     }
-    return tasks[currentType][currentSelected].getId();
+    return board().getNode(currentSelected).task.getId();
 }
 
-
 /**
- * @brief Prompts the user to move a task to a different status via a popup.
- * @param taskId The ID of the task to move.
+ * @brief Shows a list of options in a centered popup and lets the user pick one.
+ *
+ * Long lists scroll inside the popup. Enter picks the highlighted option and Escape cancels.
+ *
+ * @param title The title shown above the options.
+ * @param options The options to pick from.
+ * @return The index of the picked option, or -1 if cancelled.
  */
-void TaskManager::moveTaskPopup(int taskId) {
-    if(taskId == - 1)return;
-    const std::vector<std::string> categories = {"To Do", "In Progress", "Done"};
-    const std::vector<int> categoriesType = {0, 1, 2};
+int TaskManager::choicePopup(const std::string& title, const std::vector<std::string>& options) {
+    if (options.empty()) return -1;
 
     int highlight = 0;
     int choice = -1;
+    int offset = 0;
 
     int maxY, maxX;
     getmaxyx(stdscr, maxY, maxX);
-    
+
     // Popup dimensions
-    int popupHeight = categories.size() + 4;
-    int popupWidth = 20;
+    int longest = (int)title.length();
+    for (const std::string& option : options) {
+        longest = std::max(longest, (int)option.length());
+    }
+    int popupHeight = std::min((int)options.size() + 4, std::max(5, maxY - 2));
+    int popupWidth = std::min(std::max(20, longest + 6), std::max(20, maxX - 2));
+    int visible = popupHeight - 4;
     int startY = (maxY - popupHeight) / 2;
     int startX = (maxX - popupWidth) / 2;
-    
+
     // Create popup window
     WINDOW* popup = newwin(popupHeight, popupWidth, startY, startX);
     box(popup, 0, 0);
     keypad(popup, TRUE);
 
-    mvwprintw(popup, 1, 3, "Move Task To:");
-    wrefresh(popup);
+    mvwprintw(popup, 1, 3, "%.*s", popupWidth - 6, title.c_str());
 
     while (choice == -1) {
+        if (highlight < offset) offset = highlight;
+        if (highlight >= offset + visible) offset = highlight - visible + 1;
+
         // Display options
-        for (size_t i = 0; i < categories.size(); i++) {
-            if (i == highlight) wattron(popup, A_REVERSE);
-            mvwprintw(popup, i + 2, 3, "%s", categories[i].c_str());
+        for (int i = 0; i < visible; i++) {
+            int index = offset + i;
+            mvwhline(popup, i + 2, 1, ' ', popupWidth - 2);
+            if (index >= (int)options.size()) continue;
+            if (index == highlight) wattron(popup, A_REVERSE);
+            mvwprintw(popup, i + 2, 3, "%.*s", popupWidth - 6, options[index].c_str());
             wattroff(popup, A_REVERSE);
         }
-        wrefresh(popup);
+        wnoutrefresh(popup);
 
         // Handle input
-        int input = wgetch(popup);
+        int input = RenderBackend::readKey(popup);
+        int count = (int)options.size();
         switch (input) {
             case KEY_UP:
-                highlight = (highlight == 0) ? categories.size() - 1 : highlight - 1;
+                highlight = (highlight == 0) ? count - 1 : highlight - 1;
                 break;
             case KEY_DOWN:
-                highlight = (highlight == categories.size() - 1) ? 0 : highlight + 1;
+                highlight = (highlight == count - 1) ? 0 : highlight + 1;
                 break;
             case 10: // Enter key
                 choice = highlight;
                 break;
+            case 27: // Escape
+                choice = -2;
+                break;
         }
     }
 
     delwin(popup);
     clear();
-    refresh();
+    wnoutrefresh(stdscr);
+    damage.full = true;
+
+    return choice < 0 ? -1 : choice;
+}
+
+/**
+ * @brief Prompts the user to move a task to a different status via a popup.
+ * @param taskId The ID of the task to move.
+ */
+void TaskManager::moveTaskPopup(int taskId) {
+    if(taskId == - 1)return;
+
+    std::vector<std::string> categories;
+    for (int type = 0; type < board().columnCount(); ++type) {
+        categories.push_back(board().getColumn(type).name);
+    }
 
+    int choice = choicePopup("Move Task To:", categories);
     if (choice != -1) {
-        moveTask(taskId, categoriesType[choice]);
+        moveTask(taskId, choice);
     }
 }
 
 /**
- * @brief Finds the next available task ID.
- * 
- * This function iterates through all tasks across all types and 
- * returns the next free ID, which is one greater than the current maximum ID.
- * 
- * @return The next free task ID.
+ * @brief Lets the user pick a board from a popup.
+ *
+ * The last option creates a new board.
+ *
+ * @return The index of the picked board, boardCount() for a new board, or -1 if cancelled.
  */
-int TaskManager::nextFree() {
-    int maxId = 0;
+int TaskManager::boardPopup() {
+    std::vector<std::string> options = allBoardNames();
+    options.push_back("+ New board");
+
+    return choicePopup("Open Board:", options);
+}
+
+/**
+ * @brief Opens a board, reading its tasks from disk if it was never opened before.
+ *
+ * The selection moves to the first card of the new board's first column.
+ *
+ * @param index The index of the board to open.
+ */
+void TaskManager::openBoard(int index) {
+    if (index < 0 || index >= (int)boards.size()) return;
+
+    activeBoard = index;
+    view = Board::View();
+    resetTops();
+    firstColumn = 0;
+    paneColumns = -1;
+    if (currentType >= 0) {
+        swapIn();
+    }
+    damage.full = true;
+}
+
+/**
+ * @brief Creates a new board and opens it.
+ *
+ * @param name The name of the board, also used as its directory name.
+ * @param columnList Comma separated column names, empty for the default columns.
+ * @return `false` if the name is invalid or already used.
+ */
+bool TaskManager::createBoard(const std::string& name, const std::string& columnList) {
+    if (name.empty() || name[0] == '.' || name.find('/') != std::string::npos) return false;
+    for (const Board& each : boards) {
+        if (each.getName() == name) return false;
+    }
 
-    // Iterate through all task vectors
-    for (const auto& taskList : tasks) {
-        for (const auto& task : taskList) {
-            maxId = std::max(maxId, task.getId());
+    std::vector<std::string> columnNames;
+    std::stringstream stream(columnList);
+    std::string columnName;
+    while (std::getline(stream, columnName, ',')) {
+        size_t start = columnName.find_first_not_of(' ');
+        size_t end = columnName.find_last_not_of(' ');
+        if (start != std::string::npos) {
+            columnNames.push_back(columnName.substr(start, end - start + 1));
         }
     }
 
-    return maxId + 1;
+    boards.emplace_back(name, kanbanDir + "boards/" + name + "/");
+    boards.back().create(columnNames);
+    openBoard((int)boards.size() - 1);
+    return true;
+}
+
+/**
+ * @brief Appends a column to the open board.
+ *
+ * @param name The name of the new column.
+ */
+void TaskManager::addColumn(const std::string& name) {
+    board().addColumn(name);
+    tops.push_back(-1);
+    damage.full = true;
+}
+
+/**
+ * @brief Updates the tasks of a note's checkboxes after the note was saved.
+ *
+ * Checkbox tasks live on the first board. Only the lines that changed since the
+ * note was last loaded or saved are scanned.
+ *
+ * @param note The name of the saved note.
+ * @param lines The lines that were saved.
+ * @param diff The lines that changed.
+ */
+void TaskManager::syncNote(const std::string& note, const std::vector<std::string>& lines, const LineDiff& diff) {
+    Board& tasks = boards[0];
+    if (!tasks.isLoaded()) {
+        tasks.load();
+    }
+    if (!noteSync.noteSaved(tasks, note, lines, diff) || activeBoard != 0) return;
+
+    // Tasks may have been removed, start the columns and the selection over
+    resetTops();
+    if (currentType >= 0) {
+        selectRow(currentType, 0);
+    }
+    damage.full = true;
+}
+
+/**
+ * @brief Keeps the tasks of a note's checkboxes linked after the note was renamed.
+ *
+ * @param oldName The previous name of the note.
+ * @param newName The new name of the note.
+ */
+void TaskManager::renameNote(const std::string& oldName, const std::string& newName) {
+    Board& tasks = boards[0];
+    if (!tasks.isLoaded()) {
+        tasks.load();
+    }
+    noteSync.noteRenamed(tasks, oldName, newName);
+}
+
+/**
+ * @brief Checks whether a checkbox in a note was ticked or unticked from the board.
+ *
+ * @param note The name of the note.
+ * @return `true` if the note's file changed since the last call and must be reloaded.
+ */
+bool TaskManager::takePatchedNote(const std::string& note) {
+    return noteSync.takePatched(note);
+}
+
+/**
+ * @brief Gets the number of boards.
+ *
+ * @return The board count.
+ */
+int TaskManager::boardCount() const {
+    return (int)boards.size();
+}
+
+/**
+ * @brief Finds the next available task ID on the open board.
+ *
+ * @return The next free task ID.
+ */
+int TaskManager::nextFree() {
+    return board().nextFree();
 }
 
 /**
  * @brief Swaps into the task manager, resetting the selection.
- * 
+ *
  * Sets the selection to the first task type and the first task within it.
  */
 void TaskManager::swapIn(){
-    currentSelected = 0;
-    currentType = 0;
+    resetTops();
+    selectRow(0, 0);
+    damage.full = true;
 }
 
 /**
  * @brief Swaps out of the task manager, clearing the selection.
- * 
+ *
  * Sets the selection to invalid indices, indicating no selection.
  */
 void TaskManager::swapOut(){
     currentSelected = -1;
     currentType = -1;
+    selectedRow = 0;
+    damage.full = true;
 }
@@ -1,10 +1,11 @@
 /**
  * @file TaskManager.h
  * @brief Header file for the TaskManager class, which manages a collection of Task objects.
- * 
- * This file defines the TaskManager class, responsible for handling multiple 
- * Task objects, including adding, removing, moving, and rendering them using ncurses.
- * 
+ *
+ * This file defines the TaskManager class, responsible for handling the kanban
+ * boards and their Task objects, including adding, removing, moving, and rendering
+ * them using ncurses.
+ *
  * @author Gordon Xu
  * @author Emily Atyeo
  */
@@ -13,15 +14,18 @@
 #define TASKMANAGER_H
 
 #include "Task.h"
+#include "Board.h"
+#include "NoteSync.h"
+#include "LineDiff.h"
 #include <vector>
 #include <string>
-#include <ncurses.h> 
+#include <ncurses.h>
 
-// TaskManager class manages a collection of Task objects
+// TaskManager class manages the kanban boards and renders the open one
 class TaskManager {
 public:
-    // Constructor that takes an ncurses window for rendering
-    TaskManager(WINDOW* content);
+    // Constructor that takes an ncurses window for rendering, and the boards of a session snapshot if there is one
+    TaskManager(WINDOW* content, const std::vector<std::string>* boardNames = nullptr);
 
     // Adds a new task to the task list
     void addTask(const std::string& title, int type);
@@ -32,33 +36,126 @@ public:
     // Moves a task to a new status category
     void moveTask(int taskId, int type);
 
-    // Returns all tasks
-    const std::vector<std::vector<Task>>& getTasks() const;
+    // Looks up a task by its ID, returns nullptr if there is none
+    const Task* findTask(int taskId);
 
-    // Renders all tasks
+    // Sets the details of a task from user input, empty fields keep their value and "-" clears them
+    void editTask(int taskId, const std::string& description, const std::string& priority,
+                  const std::string& dueDate, const std::string& tags);
+
+    // Switches between manual, due date and priority order
+    void cycleSortOrder();
+
+    // Lets the user show only the tasks with one tag
+    void filterPopup();
+
+    // Number of tasks in a status category
+    int columnSize(int type);
+
+    // Renders the board, repainting only what changed since the last call
     void renderTasks();
 
+    // Forces the next renderTasks() call to repaint the whole board
+    void invalidate();
+
+    // Draws into another window from now on, repainting the whole board
+    void setWindow(WINDOW* win);
 
     int nextFree();
 
     void moveTaskPopup(int taskId);
 
     void moveSelection(int direction);
-    
+
     int getSelectedTaskId();
 
     void swapIn();
 
     void swapOut();
 
+    // Lets the user pick a board, returns its index, boardCount() for "new board" or -1
+    int boardPopup();
+
+    // Opens a board by index, loading it from disk the first time
+    void openBoard(int index);
+
+    // Creates and opens a board from a name and a comma separated list of columns
+    bool createBoard(const std::string& name, const std::string& columnList);
+
+    // Appends a column to the open board
+    void addColumn(const std::string& name);
+
+    int boardCount() const;
+    int openBoardIndex() const { return activeBoard; }
+
+    // The names of the boards other than "My Tasks", as kept in a session snapshot
+    std::vector<std::string> boardNames() const;
+
+    // The names of all boards, "My Tasks" first, as listed in the sidebar
+    std::vector<std::string> allBoardNames() const;
+
+    // Lists the boards on disk; setBoards takes the result when the boards came from a session snapshot
+    static std::vector<std::string> scanBoards(const std::string& kanbanDir);
+    bool setBoards(const std::vector<std::string>& scanned);
+
+    // Updates the tasks of a note's checkboxes after the note was saved
+    void syncNote(const std::string& note, const std::vector<std::string>& lines, const LineDiff& diff);
+
+    // Keeps the tasks of a note's checkboxes linked after the note was renamed
+    void renameNote(const std::string& oldName, const std::string& newName);
+
+    // Checks whether a checkbox in a note was ticked or unticked from the board since the last call
+    bool takePatchedNote(const std::string& note);
+
 private:
-    std::vector<std::vector<Task>> tasks = {{}, {}, {}};
+    // Screen area of one column, cached until the layout changes
+    struct ColumnPane {
+        int x;          ///< -1 if the column is scrolled out of view
+        int width;
+    };
+
+    // Parts of the board that must be repainted by the next renderTasks()
+    struct Damage {
+        bool full = true;
+        std::vector<int> headers;
+        std::vector<int> columns;
+        std::vector<std::pair<int, int>> cards;   ///< (slot, row) pairs
+    };
+
+    std::vector<Board> boards;
+    int activeBoard;
+    std::string kanbanDir;
     WINDOW* content;
+    NoteSync noteSync;      ///< Checkbox tasks, always on the first board
 
-    int currentSelected;
+    int currentSelected;    ///< Slot of the selected task, -1 if none
     int currentType;
-
-    std::vector<int> colOffset = {0, 0, 0};
+    int selectedRow;        ///< Visible row of the selected card in its column
+
+    Board::View view;       ///< Order and filter of the columns
+    std::vector<int> tops;  ///< First visible slot of each column
+
+    std::vector<ColumnPane> panes;
+    int firstColumn = 0;    ///< Leftmost visible column
+    int paneMaxY = -1;
+    int paneMaxX = -1;
+    int paneColumns = -1;
+    Damage damage;
+
+    Board& board();
+    void selectRow(int type, int row);
+    void releaseSelection(int slot);
+    void resetTops();
+    void recountSelectedRow();
+    int choicePopup(const std::string& title, const std::vector<std::string>& options);
+
+    void layoutPanes(int maxY, int maxX);
+    bool followColumn();
+    int visibleCards() const;
+    bool followSelection();
+    void drawHeader(int type);
+    void drawColumn(int type);
+    void drawCard(int slot, int row);
 };
 
-#endif // TASKMANAGER_H
\ No newline at end of file
+#endif // TASKMANAGER_H
@@ -1,7 +1,15 @@
 #include "TerminalEditor.h"
 #include "Settings.h"
+#include "LinkGraph.h"
+#include "MarkdownList.h"
+#include "Utf8.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include "RenderBackend.h"
+#include "TextPrompt.h"
 #include <string>
 #include <algorithm>
+#include <filesystem>
 
 using std::string;
 
@@ -13,52 +21,258 @@ using std::string;
  * 
  * @param win_in Pointer to the main window.
  * @param sidebar_in Pointer to the sidebar window.
- * @param content_in Pointer to the content window.
+ * @param panes_in The panes of the content area, reset to a single pane.
  * @param files_in List of files to be loaded into the editor (not used directly here).
+ * @param session The snapshot of the last session to open where it was left, nullptr to open the first note.
  */
 TerminalEditor::TerminalEditor(WINDOW *win_in, WINDOW *sidebar_in, 
-                               WINDOW *content_in, const std::vector<std::string> &files_in)
-    : fileManager(), ui(win_in, sidebar_in, content_in), calendar(content_in), taskManager(content_in),
-      row(0), col(0), scroll_row(0), scroll_col(0), focused_div(0), sidebar_index(0), sidebar_width(COLS * 0.25){
+                               PaneTree *panes_in, const std::vector<std::string> &files_in,
+                               const Session *session)
+    : fileManager(session ? &session->catalog.notes : nullptr), ui(win_in, sidebar_in, nullptr), calendar(nullptr),
+      taskManager(nullptr, session ? &session->catalog.boards : nullptr),
+      buffers(BUFFER_CACHE_BYTES), panes(panes_in), row(0), col(0), scroll_row(0), scroll_col(0), focused_div(0), last_focused_div(0), sidebar_index(0), sidebar_width(COLS * 0.25),
+      dirty(false), current_bytes(0), rule_state(-1), edited_start(0), edited_end(0),
+      session_saved(std::chrono::steady_clock::now()){
+
+    panes->reset();
+    attachFocusedPane();  /**< Everything draws into the focused pane's window. */
 
     // Load initial file from file manager
     std::vector<std::string> initialFiles = fileManager.getFiles();
-    if (!initialFiles.empty()) {
+    if (session) {
+        restoreSession(*session);  /**< Open the note and panel that were open when the editor closed. */
+    } else if (!initialFiles.empty()) {
         current_file = initialFiles[0];
-        fileManager.loadFile(initialFiles[0], lines, current_file);  /**< Load the first file into lines. */
+        loadNote(initialFiles[0]);  /**< Load the first file into lines. */
     } else {
         lines.push_back("");  /**< If no files exist, start with an empty line. */
     }
+    panes->focused().note = current_file;
 
-    curs_set(1);  /**< Show the cursor in the terminal editor. */
+    curs_set(focused_div == 0 ? 1 : 0);  /**< Show the cursor in the terminal editor. */
 
     // Render the initial UI and display the loaded content
+    ui.setBoards(taskManager.allBoardNames());
     ui.renderUI(sidebar_width, initialFiles);  /**< Render the user interface with the list of files. */
-    ui.displayContent(lines, row, col, scroll_row, scroll_col, fileManager.getFiles()[sidebar_index]);  /**< Display the loaded content in the editor. */
+    ui.renderSidebar(sidebar_width, initialFiles, sidebar_index);
+    drawFocusedPane();  /**< Display the loaded content in the editor. */
+    renderPanes();
+}
+
+/**
+ * @brief Opens the note and panel of a session snapshot.
+ *
+ * Only the note of the focused pane is read, with its cursor and scroll position;
+ * the other notes of the snapshot get theirs back when they are opened. The notes
+ * and boards of the snapshot are listed on a background thread meanwhile, see
+ * checkCatalog.
+ *
+ * @param session The snapshot.
+ */
+void TerminalEditor::restoreSession(const Session &session) {
+    for (const Session::Cursor &cursor : session.open) positions[cursor.note] = cursor;
+
+    std::vector<std::string> files = fileManager.getFiles();
+    std::string note = session.open.empty() ? files[0] : session.open[0].note;
+    if (std::find(files.begin(), files.end(), note) == files.end()) note = files[0];
+    switchNote(note);
+    taskManager.openBoard(session.board);
+
+    PaneTree::Pane &pane = panes->focused();
+    if (session.view == static_cast<int>(PaneTree::View::Kanban)) {
+        pane.view = PaneTree::View::Kanban;
+        focused_div = 2;
+        sidebar_index = files.size() + taskManager.openBoardIndex();
+    } else if (session.view == static_cast<int>(PaneTree::View::Calendar)) {
+        pane.view = PaneTree::View::Calendar;
+        focused_div = 3;
+        sidebar_index = calendarIndex();
+    } else {
+        sidebar_index = std::find(files.begin(), files.end(), current_file) - files.begin();
+    }
+    if (session.focus == 1) {
+        focused_div = 1;
+        sidebar_index = std::clamp(session.sidebar_index, 0, calendarIndex());
+    } else if (focused_div == 2) {
+        taskManager.swapIn();
+    } else if (focused_div == 3) {
+        calendar.setSelectedEvent(0);
+    }
+    last_focused_div = focused_div;
+
+    std::string dir = fileManager.getDataPath();
+    catalog_scan = std::async(std::launch::async, [dir] {
+        return Session::Catalog{FileManager::scanNotes(dir), TaskManager::scanBoards(dir + "/kanban/")};
+    });
+}
+
+/**
+ * @brief Takes the notes and boards found on disk once the background scan is done.
+ *
+ * Notes and boards added or removed while the editor was closed show up in the
+ * sidebar and the board picker. The sidebar keeps its selection, a board that is
+ * gone passes it to the open board. A restored note that was deleted is closed,
+ * so that saving it does not bring it back, and the first note is opened instead.
+ * If it was edited since it was restored it is saved and kept.
+ *
+ * @return `true` while the scan is still running.
+ */
+bool TerminalEditor::checkCatalog() {
+    if (!catalog_scan.valid()) return false;
+    if (catalog_scan.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return true;
+
+    Session::Catalog catalog = catalog_scan.get();
+    if (dirty && !std::filesystem::exists(fileManager.getDataPath() + "/" + current_file + ".md")) {
+        saveCurrentFile();
+        fileManager.flushSaves();  /**< setFiles keeps only the notes that exist. */
+    }
+    std::vector<std::string> old_files = fileManager.getFiles();
+    std::vector<std::string> old_boards = taskManager.allBoardNames();
+    bool boards_changed = taskManager.setBoards(catalog.boards);
+    if (!fileManager.setFiles(catalog.notes) && !boards_changed) return false;
+
+    std::vector<std::string> files = fileManager.getFiles();
+    std::vector<std::string> boards = taskManager.allBoardNames();
+    std::string missing;
+    if (std::find(files.begin(), files.end(), current_file) == files.end()) {
+        missing = current_file;
+        buffers.remove(missing);
+        positions.erase(missing);
+        current_file.clear();  /**< Nothing left to save or park. */
+        dirty = false;
+        switchNote(files[0]);
+        for (PaneTree::Pane *pane : panes->panes()) {
+            if (pane->note != missing) continue;
+            pane->note = current_file;
+            pane->row = pane->col = pane->scroll_row = pane->scroll_col = 0;
+            pane->wrap.reset(lines);
+        }
+        adjustCursorPosition();
+    }
+    int board = sidebar_index - old_files.size();
+    if (board >= (int)old_boards.size()) {
+        sidebar_index = calendarIndex();
+    } else if (board >= 0) {
+        auto found = std::find(boards.begin(), boards.end(), old_boards[board]);
+        sidebar_index = files.size() + (found != boards.end() ? found - boards.begin() : taskManager.openBoardIndex());
+    } else {
+        auto found = std::find(files.begin(), files.end(), old_files[sidebar_index]);
+        if (found == files.end() && old_files[sidebar_index] == missing) {
+            found = std::find(files.begin(), files.end(), current_file);  /**< Follow the note opened instead. */
+        }
+        sidebar_index = found != files.end() ? found - files.begin() : std::min<int>(sidebar_index, files.size() - 1);
+    }
+    updateCorpusCounts();
+    ui.setBoards(boards);
+    ui.renderSidebar(sidebar_width, files, sidebar_index);
+    drawFocusedPane();
+    renderPanes();
+    return false;
+}
+
+/**
+ * @brief Writes a session snapshot to start up into next time.
+ *
+ * Holds the open note and the notes opened before it with their positions, the
+ * focused panel and view, the open board, and the names of the notes and boards.
+ */
+void TerminalEditor::saveSession() {
+    Session session;
+    session.focus = focused_div;
+    session.view = static_cast<int>(panes->focused().view);
+    session.sidebar_index = sidebar_index;
+    session.board = taskManager.openBoardIndex();
+    session.catalog = Session::Catalog{fileManager.getFiles(), taskManager.boardNames()};
+    session.open.push_back(Session::Cursor{current_file, row, col, scroll_row, scroll_col});
+    for (const auto &[note, cursor] : positions) {
+        if (note == current_file) continue;
+        if (std::find(session.catalog.notes.begin(), session.catalog.notes.end(), note) == session.catalog.notes.end()) continue;
+        session.open.push_back(cursor);
+    }
+    fileManager.saveSession(session);
+    session_saved = std::chrono::steady_clock::now();
 }
 
 /**
  * @brief Handles input from the user for both content and sidebar sections.
  * 
  * Based on which section of the screen is focused (content or sidebar), it processes the user's input 
- * accordingly and updates the display.
+ * accordingly and updates the display. Keys that split, focus or close panes work everywhere.
+ * The panes that changed are drawn at the end, and the terminal is updated once.
  * 
  * @param ch The character code representing the user's input.
  */
 void TerminalEditor::handleInput(int ch) {
+    Profiler::Scope timer(Profiler::Dispatch);
+    reportSaveFailures();
+    if (std::chrono::steady_clock::now() - session_saved >= std::chrono::seconds(SESSION_SAVE_SECONDS)) {
+        saveSession();  /**< So a crash or a closed terminal still starts up where it was. */
+    }
+    if (ch == TOGGLE_PROFILER || ch == TOGGLE_ALLOCATIONS) {
+        if (ch == TOGGLE_PROFILER) Profiler::toggle();
+        else AllocationTracker::toggle();
+        drawFocusedPane();  /**< Draws over the overlay when it is turned off. */
+        renderPanes();
+        return;
+    }
+    if (handlePaneKey(ch)) {
+        renderPanes();
+        return;
+    }
+
     if (focused_div == 0) { //**< 0 = content */
-        handleInputContent(ch);  /**< Handle input in the content area of the editor. */
+        int old_row = row;
+        int old_size = lines.size();
+        std::string old_file = current_file;
+        std::string old_line = lines.empty() ? "" : lines[row];
+        edited_start = row;
+        edited_end = 0;
+        {
+            Profiler::Scope edit_timer(Profiler::Edit);
+            AllocationTracker::Scope tag(AllocationTracker::Buffer);
+            handleInputContent(ch);  /**< Handle input in the content area of the editor. */
+        }
+
+        // Only the lines between the old and new cursor rows can have changed
+        int new_size = lines.size();
+        if (current_file == old_file && (new_size != old_size || lines[old_row] != old_line || edited_end > 0)) {
+            dirty = true;
+            int start = std::min({old_row, row, edited_start});
+            int new_end = std::min(std::max({old_row + 1, row + 1, edited_end}), new_size);
+            int old_end = new_end - (new_size - old_size);
+            ui.getWrapMap().edited(lines, start, old_end, new_end);
+            ui.getOutline().edited(lines, start, old_end, new_end);
+            bool code_changed = ui.getSyntax().edited(lines, start, old_end, new_end);
+            bool columns_changed = ui.getTables().edited(lines, start, old_end, new_end);
+            ui.getStats().edited(lines, start, old_end, new_end);
+
+            // Other panes on this note share the lines; rows below move if lines were added, code states or table columns changed
+            bool to_bottom = new_size != old_size || code_changed || columns_changed;
+            for (PaneTree::Pane *view : otherViews()) {
+                view->wrap.edited(lines, start, old_end, new_end);
+                damageView(*view, start, new_end, to_bottom);
+            }
+        }
         adjustCursorPosition();  /**< Adjust cursor position based on current content. */
         ui.displayContent(lines, row, col, scroll_row, scroll_col, fileManager.getFiles()[sidebar_index]);  /**< Redraw the content after input. */
+        if (ch == SHOW_BACKLINKS || ch == SHOW_OUTLINE) panes->damageAll();  /**< The popup was drawn over the other panes. */
     } else if (focused_div == 1) { //**< 1 = sidebar */
         handleInputSidebar(ch);  /**< Handle input in the sidebar area. */
     }
     else if (focused_div == 2) { //**< 2 = handleinputkanban */
+        AllocationTracker::Scope tag(AllocationTracker::Tasks);
         handleInputKanban(ch);
     }
     else if (focused_div == 3) { //**< 3 = handleinputcalendar */
+        AllocationTracker::Scope tag(AllocationTracker::Events);
         handleInputCalendar(ch);
     } 
+
+    if (focused_div != 0) {
+        panes->damageAll();  /**< Prompts may have been drawn over the other panes. */
+        ui.invalidate();  /**< The board or the calendar may have been drawn in the note's window. */
+    }
+    renderPanes();
 }
 
 /**
@@ -73,49 +287,57 @@ void TerminalEditor::handleInputContent(int ch) {
     if (lines.empty()) {
         lines.push_back("");  /**< Ensure at least one line exists. */
     }
+    int typed_state = rule_state;
+    rule_state = -1;  /**< Any key but text may change the line before the cursor. */
+    Outline &outline = ui.getOutline();
 
     switch (ch) {
         case CURSOR_UP: 
-            if (row > 0) row--;  /**< Move the cursor up one line. */
+            if (ui.getWrapMap().isActive()) moveScreenRow(-1);  /**< Move up one wrapped row. */
+            else if (row > 0) moveToLine(outline.prevVisible(row - 1));  /**< Move the cursor up one line, over folds. */
             break;
         case CURSOR_DOWN: 
-            if (row < lines.size() - 1) row++;  /**< Move the cursor down one line. */
+            if (ui.getWrapMap().isActive()) moveScreenRow(1);  /**< Move down one wrapped row. */
+            else if (outline.nextVisible(row + 1) < (int)lines.size()) moveToLine(outline.nextVisible(row + 1));  /**< Move the cursor down one line, over folds. */
             break;
         case CURSOR_LEFT: 
             if (col > 0) {
-                col--;  /**< Move the cursor left. */
+                col = Utf8::prevChar(lines[row], col);  /**< Move the cursor left one character. */
             } else if (row > 0) {
                 // At beginning of line, move to end of previous line
-                row--;
+                row = outline.prevVisible(row - 1);
                 col = lines[row].length();
             }
             break;
         case CURSOR_RIGHT: 
             if (col < lines[row].length()) {
-                col++;  /**< Move the cursor right. */
-            } else if (row < lines.size() - 1) {
+                col = Utf8::nextChar(lines[row], col);  /**< Move the cursor right one character. */
+            } else if (outline.nextVisible(row + 1) < (int)lines.size()) {
                 // At end of line, move to beginning of next line
-                row++;
+                row = outline.nextVisible(row + 1);
                 col = 0;
             }
             break;
         case DELETE_RIGHT:
 	    if (col < lines[row].length()) {  /**< Delete the character at the cursor position. */
-                lines[row].erase(col, 1);
+                lines[row].erase(col, Utf8::nextChar(lines[row], col) - col);
             } else if (row < lines.size() - 1) {  /**< Merge with next line if at end of current line. */
                 lines[row] += lines[row + 1];
                 lines.erase(lines.begin() + row + 1);
+                edited_end = MarkdownList::renumber(lines, row);  /**< A numbered item may have gone. */
             }
             break;
         case DELETE_LEFT:
             if (col > 0) {  /**< Delete the character to the left of the cursor. */
-                lines[row].erase(col - 1, 1);
-                col--;
+                int start = Utf8::prevChar(lines[row], col);
+                lines[row].erase(start, col - start);
+                col = start;
             } else if (row > 0) {  /**< Merge current line with previous line if cursor is at the beginning. */
                 col = lines[row - 1].length();
                 lines[row - 1] += lines[row];
                 lines.erase(lines.begin() + row);
                 row--;
+                edited_end = MarkdownList::renumber(lines, row);
             }
             break;
         case SKIP_LEFT:
@@ -144,60 +366,27 @@ void TerminalEditor::handleInputContent(int ch) {
             }
             break;
 
-        case ' ': {
-            bool shouldExpand = false;
-            int numStart = col - 1;
-            
-            while (numStart > 0 && isdigit(lines[row][numStart - 1])) {
-                numStart--;
-            }
-            
-            if (numStart < col - 1 && lines[row][col - 1] == '.') {
-                shouldExpand = true;
-                for (int i = 0; i < numStart; ++i) {
-                    if (lines[row][i] != ' ') {
-                        shouldExpand = false;
-                        break;
-                    }
-                }
-                
-                if (shouldExpand) {
-                    string numberPart = lines[row].substr(numStart, col - numStart);
-                    lines[row].replace(numStart, col - numStart, INDENTATION + numberPart + " ");
-                    col = numStart + 5 + numberPart.length();
-                }
-            }
-            else if (col >= 1 && lines[row][col - 1] == '-') {
-                shouldExpand = true;
-                for (int i = 0; i < col - 1; ++i) {
-                    if (lines[row][i] != ' ') {
-                        shouldExpand = false;
-                        break;
-                    }
-                }
-                if (shouldExpand) {
-                    lines[row].replace(col - 1, 1, "    - ");
-                    col += 5;
-                }
-            }
-
-            if (!shouldExpand) {
-                lines[row].insert(col, " ");
-                col++;
-            }
-            break;
-        }
 	case INDENT:
         case INDENT_ALT:
             lines[row].insert(col, INDENTATION);
             col += 4;
             break;
-        case NEW_LINE: 
-            lines.insert(lines.begin() + row + 1, lines[row].substr(col));  /**< Insert a new line at the current cursor position. */
+        case NEW_LINE: {
+            MarkdownList::Item item;
+            bool in_item = MarkdownList::parse(lines[row], item) && col >= (int)item.text_start;
+            if (in_item && item.text_start == lines[row].length()) {
+                lines[row].clear();  /**< Enter on an empty item ends the list. */
+                col = 0;
+                break;
+            }
+            string marker = in_item ? MarkdownList::nextMarker(lines[row], item) : "";
+            lines.insert(lines.begin() + row + 1, marker + lines[row].substr(col));  /**< Insert a new line at the current cursor position. */
             lines[row].resize(col);  /**< Resize the current line to the cursor position. */
             row++;  /**< Move cursor to the next line. */
-            col = 0;  /**< Reset the column to the beginning of the new line. */
+            col = marker.length();  /**< Continue the list the cursor was in, or start at the beginning. */
+            edited_end = MarkdownList::renumber(lines, row);  /**< Later items move up one number. */
             break;
+        }
         case GOTO_FILE_START: // Ctrl+F - Go to front of file
             row = 0;
             col = 0;
@@ -206,28 +395,12 @@ void TerminalEditor::handleInputContent(int ch) {
             row = lines.size() - 1;
             col = lines[row].length();
             break;
-        case SAVE_FILE: // Ctrl+S
-            fileManager.saveFile(current_file, lines);  /**< Save the current file. */
+        case TOGGLE_WRAP: // F2 - Wrap long lines
+            ui.setSoftWrap(!ui.getWrapMap().isActive(), lines);
+            scroll_row = scroll_col = 0;  /**< Scrolling now counts screen rows, adjustCursorPosition finds the cursor again. */
             break;
-        case BOLD: // Ctrl+B - Handle bold markdown
-            if (col + 2 <= lines[row].length() && lines[row].substr(col, 2) == "**") {
-                // If we're at existing **, just move cursor right past them
-                col += 2;
-            } else {
-                // First press: insert **** and move left 2 positions
-                lines[row].insert(col, "****");
-                col += 2; // Position cursor in the middle
-            }
-            break;
-        case ITALIC: // Ctrl+I - Handle italic markdown
-            if (col < lines[row].length() && lines[row][col] == '*') {
-                // If we're at existing *, just move cursor right past it
-                col++;
-            } else {
-                // Insert * and stay at position (user types between the asterisks)
-                lines[row].insert(col, "**");
-		col += 1;
-            }
+        case SAVE_FILE: // Ctrl+S
+            saveCurrentFile();  /**< Save the current file. */
             break;
         case DELETE_WORD:  // Ctrl+Backspace - delete work
             if (col > 0) {
@@ -248,6 +421,43 @@ void TerminalEditor::handleInputContent(int ch) {
             fileManager.newFile(); /**< Push new file to files vector. */
             ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
             break;
+        case FOLLOW_LINK: { // Ctrl+G - Open the note linked under the cursor
+            LinkGraph::Link link;
+            for (size_t from = 0; LinkGraph::findLink(lines[row], from, link); from = link.end) {
+                if (col >= (int)link.start && col <= (int)link.end) {
+                    openNote(link.target);
+                    break;
+                }
+            }
+            break;
+        }
+        case SHOW_OUTLINE: // Ctrl+P - Jump to a heading
+            showOutline();
+            break;
+        case TOGGLE_FOLD: // F9 - Fold or unfold the section under the cursor
+            toggleFold();
+            break;
+        case TOGGLE_TABLES: // F10 - Align the columns of tables
+            ui.setTableMode(!ui.tableMode());
+            scroll_col = 0;  /**< Aligned rows scroll by screen columns, adjustCursorPosition finds the cursor again. */
+            ui.invalidate();
+            for (PaneTree::Pane *view : otherViews()) {
+                panes->damage(*view, 0, getmaxy(view->win));
+            }
+            break;
+        case FORMAT_TABLE: // Ctrl+T - Pad the cells of the table under the cursor
+            formatTable();
+            break;
+        case SHOW_BACKLINKS: { // Ctrl+K - Pick a note linking to this one
+            std::vector<string> sources = fileManager.getBacklinks(current_file);
+            std::sort(sources.begin(), sources.end());
+            int choice = ui.displayChoice("Linked from:", sources);
+            if (choice != -1) {
+                openNote(sources[choice]);
+            }
+            ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
+            break;
+        }
         case SWITCH_PANEL:
         case SWITCH_PANEL_ALT:
         // Ctrl+O or Ctrl+D - Swap to sidebar control:
@@ -256,14 +466,59 @@ void TerminalEditor::handleInputContent(int ch) {
             curs_set(0);
             break;
         default:
-            if (ch >= 32 && ch <= 126) {  /**< Insert printable characters. */
-                lines[row].insert(col, string(1, ch));
-                col++;
+            if (const InputRules::Pair *pair = InputRules::standard().pairFor(ch)) {  /**< Ctrl+B, Ctrl+I and other pairs. */
+                insertPair(*pair);
+            } else if (ch >= 32 && ch <= 126) {  /**< Insert printable characters. */
+                typeText(string(1, ch), typed_state);
+            } else if (ch > 127 && ch < 256 && Utf8::sequenceLength(ch) > 1) {  /**< Insert a UTF-8 character. */
+                typeText(TextPrompt::readUtf8(ch), typed_state);
             }
             break;
     }
 }
 
+/**
+ * @brief Inserts typed text at the cursor and applies the input rule it completes.
+ *
+ * The rule automaton's state for the text before the cursor carries over from the
+ * last typed key, so typing costs one transition per byte. After any other key
+ * the state is found again from the start of the line.
+ *
+ * @param text The bytes of the typed character.
+ * @param state The state left by the last typed key, -1 if another key came since.
+ */
+void TerminalEditor::typeText(const std::string &text, int state) {
+    const InputRules &rules = InputRules::standard();
+    if (state < 0) state = rules.stateAt(lines[row], col);
+
+    lines[row].insert(col, text);
+    for (char byte : text) state = rules.advance(state, byte);
+    col += text.length();
+
+    InputRules::Edit edit;
+    if (rules.expand(state, lines[row], col, edit)) {
+        lines[row].replace(edit.start, edit.end - edit.start, edit.text);
+        col = edit.cursor;
+        state = rules.stateAt(lines[row], col);
+    }
+    rule_state = state;
+}
+
+/**
+ * @brief Inserts a pair of markers around the cursor, or steps over the closing one.
+ *
+ * @param pair The markers, like ** for bold.
+ */
+void TerminalEditor::insertPair(const InputRules::Pair &pair) {
+    string close = pair.close;
+    if (lines[row].compare(col, close.length(), close) == 0) {
+        col += close.length();  /**< Already before the closing marker, move past it. */
+    } else {
+        lines[row].insert(col, string(pair.open) + close);
+        col += string(pair.open).length();  /**< The cursor goes between the markers. */
+    }
+}
+
 /**
  * @brief Handles input in the sidebar section (currently not implemented).
  * 
@@ -274,7 +529,7 @@ void TerminalEditor::handleInputContent(int ch) {
  */
 void TerminalEditor::handleInputSidebar(int ch) {
     // Sidebar navigation logic would go here in the future.
-    int len_files = fileManager.getFiles().size() + 2;
+    int len_files = calendarIndex() + 1;
     std::string input; 
     switch (ch) {
         case SWITCH_PANEL:
@@ -283,13 +538,17 @@ void TerminalEditor::handleInputSidebar(int ch) {
                 last_focused_div = focused_div;
                 focused_div = 0; /**< Flip focused_div to content.  */
                 curs_set(1);
-                fileManager.saveFile(current_file, lines);
-                fileManager.loadFile(fileManager.getFiles()[sidebar_index], lines, current_file);
+                panes->focused().view = PaneTree::View::Note;
+                switchNote(fileManager.getFiles()[sidebar_index]);
                 adjustCursorPosition();
                 ui.displayContent(lines, row, col, scroll_row, scroll_col, fileManager.getFiles()[sidebar_index]);
             }
-            else if (sidebar_index == fileManager.getFiles().size()){
+            else if (sidebar_index < calendarIndex()){
                 //kanban swap
+                panes->focused().view = PaneTree::View::Kanban;
+                if (dirty) saveCurrentFile();  /**< Checkbox tasks must match the note before they are moved. */
+                fileManager.flushSaves();  /**< Moving a task may patch a note on disk. */
+                openSidebarBoard();
                 taskManager.swapIn();
                 taskManager.renderTasks();
                 last_focused_div = focused_div;
@@ -297,6 +556,7 @@ void TerminalEditor::handleInputSidebar(int ch) {
             }
             else{
                 //calendar swap
+                panes->focused().view = PaneTree::View::Calendar;
                 calendar.setSelectedEvent(0);
                 calendar.renderCalendar();
                 last_focused_div = focused_div;
@@ -317,13 +577,23 @@ void TerminalEditor::handleInputSidebar(int ch) {
             break;
         case RENAME_FILE:
             if(sidebar_index < fileManager.getFiles().size()){
-                fileManager.saveFile(current_file, lines);
-                fileManager.loadFile(fileManager.getFiles()[sidebar_index], lines, current_file);
+                switchNote(fileManager.getFiles()[sidebar_index]);
                 input = ui.displayPrompt("Rename note");
                 while (input.empty()) {
                     input = ui.displayPrompt("Rename note (Field cannot be empty)");
                 }
-                fileManager.renameFile(fileManager.getFiles()[sidebar_index], input, current_file);
+                string oldName = fileManager.getFiles()[sidebar_index];
+                if (dirty) saveCurrentFile();  /**< The note is read again from its new path below. */
+                fileManager.renameFile(oldName, input, current_file);
+                if (fileManager.getFiles()[sidebar_index] == input) {
+                    taskManager.renameNote(oldName, input);
+                    for (PaneTree::Pane *pane : panes->panes()) {
+                        if (pane->note == oldName) pane->note = input;
+                    }
+                    buffers.clear();  /**< Notes linking to it were rewritten on disk. */
+                    positions.erase(oldName);
+                    loadNote(current_file);  /**< Its own links may have been rewritten. */
+                }
                 ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
                 ui.displayContent(lines, row, col, scroll_row, scroll_col, fileManager.getFiles()[sidebar_index]);
             }
@@ -332,29 +602,45 @@ void TerminalEditor::handleInputSidebar(int ch) {
             if(fileManager.getFiles().size() > 1){
                 input = ui.displayPrompt("Delete permanently? (Y/N)");
                 if(input == "Y" || input == "y"){
-                    fileManager.deleteFile(fileManager.getFiles()[sidebar_index]);
+                    string deleted = fileManager.getFiles()[sidebar_index];
+                    fileManager.deleteFile(deleted);
+                    buffers.remove(deleted);
+                    positions.erase(deleted);
+                    if (deleted == current_file) {
+                        current_file.clear();  /**< Nothing left to save or park. */
+                        dirty = false;
+                    }
                     sidebar_index = std::max(sidebar_index - 1, 0);
-                    fileManager.loadFile(fileManager.getFiles()[sidebar_index], lines, current_file);
+                    switchNote(fileManager.getFiles()[sidebar_index]);
+                    for (PaneTree::Pane *pane : panes->panes()) {
+                        if (pane->note != deleted) continue;
+                        pane->note = current_file;  /**< Panes on the deleted note show the same note as the focused one. */
+                        pane->row = pane->col = pane->scroll_row = pane->scroll_col = 0;
+                        pane->wrap.reset(lines);
+                    }
                     adjustCursorPosition();  /**< Adjust cursor position based on current content. */
                 }
             }
             ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
             ui.displayContent(lines, row, col, scroll_row, scroll_col, fileManager.getFiles()[sidebar_index]);
-            refresh();
             break;
         case CONFIRM_OPTION:
             if (sidebar_index < fileManager.getFiles().size()){
-                fileManager.saveFile(current_file, lines);
-                fileManager.loadFile(fileManager.getFiles()[sidebar_index], lines, current_file);
+                panes->focused().view = PaneTree::View::Note;
+                switchNote(fileManager.getFiles()[sidebar_index]);
                 adjustCursorPosition();  /**< Adjust cursor position based on current content. */
                 ui.displayContent(lines, row, col, scroll_row, scroll_col, fileManager.getFiles()[sidebar_index]);  /**< Redraw the content after input. */
             }
-            else if (sidebar_index == fileManager.getFiles().size()){
+            else if (sidebar_index < calendarIndex()){
                 //render kanban here
+                panes->focused().view = PaneTree::View::Kanban;
+                openSidebarBoard();
+                taskManager.invalidate();
                 taskManager.renderTasks();
             }
             else {
                 //render calendar here
+                panes->focused().view = PaneTree::View::Calendar;
                 calendar.setSelectedEvent(-1);
                 calendar.renderCalendar();
             }
@@ -409,10 +695,67 @@ void TerminalEditor::handleInputKanban(int ch){
             taskManager.renderTasks();  /**< Refresh task display. */
             break;
         case CONFIRM_OPTION: // Enter to move task
+            if (dirty) saveCurrentFile();  /**< The checkbox is patched in the file, which must hold every edit. */
+            fileManager.flushSaves();  /**< A queued save would overwrite the patch. */
+            reportSaveFailures();
+            if (dirty) break;  /**< The note could not be saved, so its checkboxes cannot be patched. */
             taskManager.moveTaskPopup(taskManager.getSelectedTaskId());
+            if (taskManager.takePatchedNote(current_file)) {
+                loadNote(current_file);  /**< Pick up the ticked checkbox. */
+            }
             taskManager.renderTasks();  /**< Refresh task display. */
             ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
             break;
+        case SWITCH_BOARD: {
+            int choice = taskManager.boardPopup();
+            if (choice == taskManager.boardCount()) {
+                input = ui.displayPrompt("New board name:");
+                string columns = ui.displayPrompt("Columns (comma separated, empty for To Do, In Progress, Done):");
+                while (!taskManager.createBoard(input, columns)) {
+                    input = ui.displayPrompt("New board name: (Must be new and not empty)");
+                }
+            } else if (choice != -1) {
+                taskManager.openBoard(choice);
+            }
+            taskManager.renderTasks();
+            ui.setBoards(taskManager.allBoardNames());
+            sidebar_index = fileManager.getFiles().size() + taskManager.openBoardIndex();
+            ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
+            break;
+        }
+        case ADD_COLUMN:
+            input = ui.displayPrompt("New column name:");
+            if (!input.empty()) {
+                taskManager.addColumn(input);
+            }
+            taskManager.invalidate();  /**< The prompt was drawn over the board. */
+            taskManager.renderTasks();
+            break;
+        case EDIT_TASK: {
+            int taskId = taskManager.getSelectedTaskId();
+            if (taskId == -1) break;
+            string description = ui.displayPrompt("Description (empty keeps it, - clears it):");
+            string priority = ui.displayPrompt("Priority 0-3 (empty keeps it, - clears it):");
+            string due = ui.displayPrompt("Due date YYYY-MM-DD (empty keeps it, - clears it):");
+            while (!due.empty() && due != "-" && !Task::parseDate(due)) {
+                due = ui.displayPrompt("No such date, YYYY-MM-DD (empty keeps it, - clears it):");
+            }
+            string tags = ui.displayPrompt("Tags, comma separated (empty keeps them, - clears them):");
+            taskManager.editTask(taskId, description, priority, due, tags);
+            ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
+            taskManager.invalidate();  /**< The prompts were drawn over the board. */
+            taskManager.renderTasks();
+            break;
+        }
+        case SORT_TASKS:
+            taskManager.cycleSortOrder();
+            taskManager.renderTasks();
+            break;
+        case FILTER_TAG:
+            taskManager.filterPopup();
+            taskManager.renderTasks();
+            ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
+            break;
         case DELETE_FILE:
             if(taskManager.getSelectedTaskId() == -1){break;}
             input = ui.displayPrompt("Delete permanently? (Y/N)");
@@ -420,8 +763,8 @@ void TerminalEditor::handleInputKanban(int ch){
                 taskManager.removeTask(taskManager.getSelectedTaskId());
             }
             ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
+            taskManager.invalidate();  /**< The prompt was drawn over the board. */
             taskManager.renderTasks();  /**< Refresh task display. */
-            refresh();
             break;
     }
 }
@@ -482,7 +825,6 @@ void TerminalEditor::handleInputCalendar(int ch){
             }
             ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
             calendar.renderCalendar();
-            refresh();
             break;
     }
 }
@@ -496,54 +838,68 @@ void TerminalEditor::handleInputCalendar(int ch){
 void TerminalEditor::adjustCursorPosition() {
     if (row >= lines.size()) row = lines.size() - 1;  /**< Ensure row does not exceed the number of lines. */
     if (col > lines[row].length()) col = lines[row].length();  /**< Ensure column does not exceed the line length. */
+    while (col > 0 && Utf8::isContinuation(lines[row][col])) col--;  /**< Keep the cursor on a character boundary. */
+    Outline &outline = ui.getOutline();
+    if (outline.isHidden(row)) outline.reveal(row);  /**< An edit reached into a folded section, show it. */
     
     // Adjust scroll positions to keep the cursor visible.
-    int max_lines = LINES - 4;
-    int max_cols = COLS - sidebar_width - 4;
+    int max_lines = std::max(1, getmaxy(ui.getContent()) - 4);
+    int max_cols = std::max(1, getmaxx(ui.getContent()) - 4);
+
+    WrapMap& wrap = ui.getWrapMap();
+    if (wrap.isActive()) {
+        // Scroll by screen rows, wrapped lines never need horizontal scrolling
+        wrap.setWidth(ui.wrapWidth(), lines);
+        wrap.wrapLines(lines, row - max_lines, row + max_lines + 1);  /**< Every line that can share the screen with the cursor. */
+        int screen_row = outline.rowOf(wrap, row) + wrap.segmentOf(row, col);
+        if (screen_row < scroll_row) scroll_row = screen_row;
+        else if (screen_row >= scroll_row + max_lines) scroll_row = screen_row - max_lines + 1;
+        scroll_col = 0;
+        return;
+    }
     
-    if (row < scroll_row) scroll_row = row;  /**< Adjust scroll_row if the cursor is above the visible area. */
-    else if (row >= scroll_row + max_lines) scroll_row = row - max_lines + 1;  /**< Scroll down if the cursor goes beyond visible lines. */
+    int screen_row = outline.rowOf(wrap, row);  /**< The row itself unless lines above are folded. */
+    if (screen_row < scroll_row) scroll_row = screen_row;  /**< Adjust scroll_row if the cursor is above the visible area. */
+    else if (screen_row >= scroll_row + max_lines) scroll_row = screen_row - max_lines + 1;  /**< Scroll down if the cursor goes beyond visible lines. */
+
+    TableMap &tables = ui.getTables();
+    if (ui.tableMode() && tables.isRow(row) && !ui.getSyntax().inCode(lines, row)) {
+        // An aligned row scrolls by the screen columns of its padded cells
+        int x = tables.displayColumn(lines[row], row, col);
+        if (x < scroll_col) scroll_col = x;
+        else if (x - scroll_col >= max_cols) scroll_col = x - max_cols + 1;
+        return;
+    }
     
     if (col < scroll_col) scroll_col = col;  /**< Adjust scroll_col if the cursor is too far left. */
-    else if (col >= scroll_col + max_cols) scroll_col = col - max_cols + 1;  /**< Scroll right if the cursor goes beyond visible columns. */
+    while (Utf8::width(lines[row], scroll_col, col) >= max_cols) {
+        scroll_col = Utf8::nextChar(lines[row], scroll_col);  /**< Scroll right if the cursor goes beyond visible columns. */
+    }
 }
 
 /**
  * @brief Redraws the terminal editor interface.
  * 
- * This function adjusts the window sizes based on the current terminal dimensions,
- * repositions the sidebar and content windows, and renders the appropriate section
- * based on the current focus:
+ * This function is called after the terminal was resized and the panes were laid
+ * out again. Nothing is reloaded: notes, the board layout and the link index are
+ * kept, and wrapped lines are wrapped again only as they come on screen. It draws
+ * the sidebar and the focused pane for what it shows:
  * - **Content editor**: Displays the current file with cursor visibility.
  * - **Task manager**: Renders the task list.
  * - **Calendar**: Displays the calendar view.
  * 
- * It also ensures the sidebar and main content are properly refreshed.
+ * The other panes are drawn after it, and the terminal is updated once.
  */
 void TerminalEditor::redraw(int sidebar_width) {
-
+    this->sidebar_width = sidebar_width;
+    attachFocusedPane();  /**< The pane windows were created again for the new size. */
     ui.renderUI(sidebar_width, fileManager.getFiles());
-
-    if (focused_div == 0 || last_focused_div == 0){
-        ui.displayContent(lines, row, col, scroll_row, scroll_col, current_file);
-    }else if (focused_div == 2 || last_focused_div == 2){
-        taskManager.renderTasks();
-    }
-    else if (focused_div == 3 || last_focused_div == 3){
-        calendar.renderCalendar();
-    } 
-
+    drawFocusedPane();
     ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
 
     curs_set(focused_div == 0 ? 1 : 0); // Show cursor only in content editor
-    if (focused_div == 0) {
-        wmove(ui.getContent(), row - scroll_row, col - scroll_col);
-    }
-
-    wrefresh(ui.getMainWindow());
-    wrefresh(ui.getSidebar());
-    wrefresh(ui.getContent());
-    refresh();
+    panes->damageAll();
+    renderPanes();
 }
 
 /**
@@ -553,6 +909,564 @@ void TerminalEditor::redraw(int sidebar_width) {
  * exiting the application.
  */
 void TerminalEditor::cleanup() {
-    fileManager.saveFile(current_file, lines);  /**< Save the current file. */
-    ui.cleanup();  /**< Clean up the UI (e.g., end ncurses session). */
+    if (dirty) saveCurrentFile();  /**< Save the current file. */
+    saveSession();  /**< Start up here next time. */
+    fileManager.flushSaves();  /**< Wait for background saves before exiting. */
+    reportSaveFailures();
+    Profiler::dump(fileManager.getDataPath() + "/profile.txt");  /**< Keep the timings if the profiler was used. */
+    AllocationTracker::dump(fileManager.getDataPath() + "/allocations.txt");  /**< Keep the memory use if it was tracked. */
+    ui.cleanup();  /**< Clear the screen for the main menu. */
+}
+
+/**
+ * @brief Saves the current file and updates the kanban tasks of its checkboxes.
+ *
+ * Only the lines that changed since the file was loaded or last saved are rescanned.
+ */
+void TerminalEditor::saveCurrentFile() {
+    TextStats::Counts counts = ui.getStats().total();
+    LineDiff diff = fileManager.saveFile(current_file, lines, &counts);
+    taskManager.syncNote(current_file, lines, diff);
+    dirty = false;
+    current_bytes = BufferCache::footprint(lines);
+    updateCorpusCounts();
+}
+
+/**
+ * @brief Tells the user about background saves that failed.
+ *
+ * The files on disk kept their previous version. If the open note is one of them,
+ * it is marked as changed again, so it is saved again with the next save.
+ */
+void TerminalEditor::reportSaveFailures() {
+    std::vector<std::string> failed = fileManager.takeSaveFailures();
+    if (failed.empty()) return;
+    if (std::find(failed.begin(), failed.end(), current_file) != failed.end()) dirty = true;
+
+    ui.displayChoice("Could not save, the files on disk were kept:", failed);
+    ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
+    drawFocusedPane();  /**< The popup was drawn over it. */
+    panes->damageAll();
+}
+
+/**
+ * @brief Passes the word counts of the notes other than the open one to the status line.
+ *
+ * The open note's own counts are live, so they are taken out of the saved total.
+ */
+void TerminalEditor::updateCorpusCounts() {
+    TextStats::Counts others = fileManager.getCorpusCounts();
+    others -= fileManager.getCounts(current_file);
+    ui.setCorpusCounts(others);
+}
+
+/**
+ * @brief Gets the sidebar index of the calendar, which comes after the notes and the boards.
+ *
+ * @return The index.
+ */
+int TerminalEditor::calendarIndex() {
+    return fileManager.getFiles().size() + taskManager.boardCount();
+}
+
+/**
+ * @brief Opens the board selected in the sidebar, unless it is already open.
+ *
+ * A board is read from disk the first time it is opened.
+ */
+void TerminalEditor::openSidebarBoard() {
+    int board = sidebar_index - fileManager.getFiles().size();
+    if (board != taskManager.openBoardIndex()) taskManager.openBoard(board);
+}
+
+/**
+ * @brief Saves the current file and opens another note, creating it if it does not exist.
+ *
+ * Used to follow `[[links]]` and backlinks. The sidebar selection moves to the opened note.
+ *
+ * @param name The name of the note to open.
+ */
+void TerminalEditor::openNote(const std::string &name) {
+    fileManager.createFile(name);
+    switchNote(name);
+
+    std::vector<std::string> files = fileManager.getFiles();
+    sidebar_index = std::find(files.begin(), files.end(), name) - files.begin();
+    ui.renderSidebar(sidebar_width, files, sidebar_index);
+}
+
+/**
+ * @brief Loads a note into the editor and wraps its lines if soft wrap is on.
+ *
+ * Other panes showing the note are wrapped again and redrawn.
+ *
+ * @param name The name of the note to load.
+ */
+void TerminalEditor::loadNote(const std::string &name) {
+    fileManager.loadFile(name, lines, current_file);
+    rule_state = -1;
+    ui.getWrapMap().reset(lines);
+    ui.getOutline().reset(lines);
+    ui.getSyntax().reset(lines);
+    ui.getTables().reset(lines);
+    ui.getStats().reset(lines);
+    dirty = false;
+    current_bytes = BufferCache::footprint(lines);
+    updateCorpusCounts();
+
+    for (PaneTree::Pane *view : otherViews()) {
+        view->wrap.reset(lines);
+        panes->damage(*view, 0, getmaxy(view->win));
+    }
+}
+
+/**
+ * @brief Switches the editor to another note without losing the open one.
+ *
+ * The open note is saved if it changed, then parked in the buffer cache with its
+ * cursor, scroll position and wrap map. A parked note is taken back in constant
+ * time, other notes are read from disk. A parked note whose checkbox was ticked
+ * from the kanban board is read again, since its file changed.
+ *
+ * @param name The name of the note to open.
+ */
+void TerminalEditor::switchNote(const std::string &name) {
+    if (name == current_file) return;
+    bool wrap_on = ui.getWrapMap().isActive();
+
+    if (!current_file.empty()) {
+        if (dirty) saveCurrentFile();
+        BufferCache::Buffer parked;
+        parked.lines = std::move(lines);
+        parked.row = row;
+        parked.col = col;
+        parked.scroll_row = scroll_row;
+        parked.scroll_col = scroll_col;
+        parked.wrap = std::move(ui.getWrapMap());
+        parked.outline = std::move(ui.getOutline());
+        parked.syntax = std::move(ui.getSyntax());
+        parked.tables = std::move(ui.getTables());
+        parked.stats = std::move(ui.getStats());
+        parked.bytes = current_bytes;
+        positions[current_file] = Session::Cursor{current_file, row, col, scroll_row, scroll_col};
+        buffers.store(current_file, std::move(parked));
+    }
+    ui.getWrapMap() = WrapMap();
+    rule_state = -1;
+
+    BufferCache::Buffer buffer;
+    if (!taskManager.takePatchedNote(name) && buffers.take(name, buffer)) {
+        lines = std::move(buffer.lines);
+        row = buffer.row;
+        col = buffer.col;
+        scroll_row = buffer.scroll_row;
+        scroll_col = buffer.scroll_col;
+        ui.getWrapMap() = std::move(buffer.wrap);
+        ui.getOutline() = std::move(buffer.outline);
+        ui.getSyntax() = std::move(buffer.syntax);
+        ui.getTables() = std::move(buffer.tables);
+        ui.getStats() = std::move(buffer.stats);
+        current_bytes = buffer.bytes;
+        current_file = name;
+        dirty = false;
+        updateCorpusCounts();
+    } else {
+        buffers.remove(name);
+        loadNote(name);
+        auto known = positions.find(name);  /**< Opened before, maybe in an earlier session. */
+        Session::Cursor cursor = known != positions.end() ? known->second : Session::Cursor();
+        row = cursor.row;
+        col = cursor.col;
+        scroll_row = cursor.scroll_row;
+        scroll_col = cursor.scroll_col;
+    }
+    if (lines.empty()) lines.push_back("");
+    row = std::clamp(row, 0, (int)lines.size() - 1);  /**< The file may have changed since. */
+    col = std::clamp(col, 0, (int)lines[row].size());
+    if (ui.getWrapMap().isActive() != wrap_on) ui.setSoftWrap(wrap_on, lines);
+}
+
+/**
+ * @brief Moves the cursor up or down one screen row while soft wrap is on.
+ *
+ * The cursor keeps its screen column within the row where possible.
+ *
+ * @param delta -1 to move up, 1 to move down.
+ */
+void TerminalEditor::moveScreenRow(int delta) {
+    WrapMap& wrap = ui.getWrapMap();
+    const Outline &outline = ui.getOutline();
+    int segment = wrap.segmentOf(row, col);
+    int columns = Utf8::width(lines[row], wrap.segmentStart(row, segment), col);
+    int target = outline.rowOf(wrap, row) + segment + delta;
+    if (target < 0 || target >= outline.totalRows(wrap)) return;
+
+    row = outline.lineAt(wrap, target, segment);
+    int start = wrap.segmentStart(row, segment);
+    int end = wrap.segmentEnd(row, segment, lines[row].length());
+    if (segment < wrap.rowCount(row) - 1) end = Utf8::prevChar(lines[row], end);  /**< Stay on this row, the break belongs to the next one. */
+    col = std::min((int)Utf8::offsetAtWidth(lines[row], start, columns), end);
+}
+
+/**
+ * @brief Moves the cursor to another line, keeping its screen column.
+ *
+ * The column is a byte offset, so it is converted through the display width
+ * to land on a character boundary of the new line.
+ *
+ * @param target The line to move to.
+ */
+void TerminalEditor::moveToLine(int target) {
+    int columns = Utf8::width(lines[row], 0, col);
+    row = target;
+    col = Utf8::offsetAtWidth(lines[row], 0, columns);
+}
+
+/**
+ * @brief Lets the user pick a heading of the note and moves the cursor to it.
+ *
+ * The headings come from the outline, so the note is not scanned. They are
+ * indented by level, the section holding the cursor is highlighted first, and
+ * folds hiding the picked heading are opened.
+ */
+void TerminalEditor::showOutline() {
+    Outline &outline = ui.getOutline();
+    const std::vector<Outline::Heading> &headings = outline.headings();
+    std::vector<string> labels;
+    for (const Outline::Heading &heading : headings) {
+        size_t text = lines[heading.line].find_first_not_of("# ");
+        labels.push_back(string(2 * (heading.level - 1), ' ') +
+                         (text == string::npos ? "" : lines[heading.line].substr(text)));
+    }
+    int choice = ui.displayChoice("Outline:", labels, outline.sectionOf(row));
+    if (choice != -1) {
+        row = headings[choice].line;
+        col = 0;
+        outline.reveal(row);
+        ui.invalidate();
+    }
+    ui.renderSidebar(sidebar_width, fileManager.getFiles(), sidebar_index);
+}
+
+/**
+ * @brief Folds the section under the cursor, or unfolds it if it is folded.
+ *
+ * The cursor moves to the section's heading, and every pane on the note is drawn
+ * again since the rows below the heading moved.
+ */
+void TerminalEditor::toggleFold() {
+    Outline &outline = ui.getOutline();
+    int heading = outline.toggleFold(row);
+    if (heading < 0) return;
+    if (row != heading) {
+        row = heading;
+        col = std::min(col, (int)lines[row].length());
+    }
+    ui.invalidate();
+    for (PaneTree::Pane *view : otherViews()) {
+        panes->damage(*view, 0, getmaxy(view->win));
+    }
+}
+
+/**
+ * @brief Pads the cells of the table under the cursor to the widths of its columns.
+ *
+ * The widths are the ones the table map keeps, so the table is not measured again.
+ * Only rows that change are written, and the cursor stays at its place in its cell.
+ */
+void TerminalEditor::formatTable() {
+    TableMap &tables = ui.getTables();
+    if (!tables.isRow(row)) return;
+    std::pair<int, int> span = tables.span(row);
+
+    int cell = tables.cellAt(row, col);
+    size_t offset = 0;
+    if (cell >= 0) {
+        const TableMap::Cell &at = tables.cells(row)[cell];
+        offset = std::min<size_t>(std::max(col, (int)at.start), at.end) - at.start;
+    }
+
+    std::vector<std::string> formatted;
+    for (int i = span.first; i < span.second; ++i) formatted.push_back(tables.format(lines[i], i));
+    for (int i = span.first; i < span.second; ++i) {
+        if (lines[i] == formatted[i - span.first]) continue;
+        lines[i] = std::move(formatted[i - span.first]);
+        edited_start = std::min(edited_start, i);
+        edited_end = std::max(edited_end, i + 1);
+    }
+
+    // The cell's text is unchanged, only the padding around it moved
+    std::vector<TableMap::Cell> cells;
+    bool delimiter;
+    if (cell >= 0 && TableMap::parse(lines[row], cells, delimiter) && cell < (int)cells.size()) {
+        col = std::min(cells[cell].start + offset, cells[cell].end);
+    }
+}
+
+/**
+ * @brief Handles the keys that split, focus and close panes.
+ *
+ * @param ch The key pressed.
+ * @return `true` if the key was a pane key.
+ */
+bool TerminalEditor::handlePaneKey(int ch) {
+    switch (ch) {
+        case SPLIT_SIDE_BY_SIDE:
+        case SPLIT_STACKED:
+            parkPane();  /**< The new pane starts as a copy of the focused one. */
+            if (panes->split(ch == SPLIT_SIDE_BY_SIDE)) {
+                attachFocusedPane();
+                drawFocusedPane();
+            }
+            return true;
+        case NEXT_PANE:
+            leavePane();
+            panes->focusNext();
+            panes->damageAll();  /**< The titles show which pane is focused. */
+            enterPane();
+            return true;
+        case CLOSE_PANE:
+            leavePane();
+            panes->close();
+            enterPane();
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Keeps the cursor, scroll position and wrap map of the focused pane in the pane.
+ *
+ * They are restored when the pane is focused again, and copied when it is split.
+ */
+void TerminalEditor::parkPane() {
+    PaneTree::Pane &pane = panes->focused();
+    if (pane.view != PaneTree::View::Note) return;
+
+    pane.note = current_file;
+    pane.row = row;
+    pane.col = col;
+    pane.scroll_row = scroll_row;
+    pane.scroll_col = scroll_col;
+    pane.wrap = ui.getWrapMap();
+}
+
+/**
+ * @brief Parks the focused pane before another pane is focused.
+ *
+ * The kanban and calendar selections are cleared, as when switching to the sidebar.
+ */
+void TerminalEditor::leavePane() {
+    parkPane();
+    if (focused_div == 2) taskManager.swapOut();
+    if (focused_div == 3) calendar.setSelectedEvent(-1);
+}
+
+/**
+ * @brief Moves input and drawing to the focused pane.
+ *
+ * A note pane switches the editor to its note and takes back its cursor, scroll
+ * position and wrap map. Focusing a board saves the open note first, as the
+ * sidebar does. The sidebar selection follows what the pane shows.
+ */
+void TerminalEditor::enterPane() {
+    attachFocusedPane();
+    PaneTree::Pane &pane = panes->focused();
+    std::vector<std::string> files = fileManager.getFiles();
+    last_focused_div = focused_div;
+
+    if (pane.view == PaneTree::View::Note) {
+        switchNote(pane.note);
+        row = pane.row;
+        col = pane.col;
+        scroll_row = pane.scroll_row;
+        scroll_col = pane.scroll_col;
+        ui.getWrapMap() = std::move(pane.wrap);
+        sidebar_index = std::find(files.begin(), files.end(), current_file) - files.begin();
+        focused_div = 0;
+    } else if (pane.view == PaneTree::View::Kanban) {
+        if (dirty) saveCurrentFile();  /**< Checkbox tasks must match the note before they are moved. */
+        fileManager.flushSaves();  /**< Moving a task may patch a note on disk. */
+        taskManager.swapIn();
+        sidebar_index = files.size() + taskManager.openBoardIndex();
+        focused_div = 2;
+    } else {
+        calendar.setSelectedEvent(0);
+        sidebar_index = calendarIndex();
+        focused_div = 3;
+    }
+
+    curs_set(focused_div == 0 ? 1 : 0);
+    ui.renderSidebar(sidebar_width, files, sidebar_index);
+    drawFocusedPane();
+}
+
+/**
+ * @brief Points the editor, the board and the calendar at the focused pane's window.
+ */
+void TerminalEditor::attachFocusedPane() {
+    WINDOW *win = panes->focused().win;
+    ui.setContent(win);
+    taskManager.setWindow(win);
+    calendar.setWindow(win);
+}
+
+/**
+ * @brief Draws the focused pane in full.
+ */
+void TerminalEditor::drawFocusedPane() {
+    switch (panes->focused().view) {
+        case PaneTree::View::Note:
+            adjustCursorPosition();
+            ui.invalidate();
+            ui.displayContent(lines, row, col, scroll_row, scroll_col, current_file);
+            break;
+        case PaneTree::View::Kanban:
+            taskManager.invalidate();
+            taskManager.renderTasks();
+            break;
+        case PaneTree::View::Calendar:
+            calendar.renderCalendar();
+            break;
+    }
+}
+
+/**
+ * @brief Draws the damaged panes that are not focused and updates the terminal once.
+ *
+ * The focused pane was already drawn by the input handlers. Each other pane copies
+ * only its damaged rows to the virtual screen, then a single doupdate sends all
+ * the changes to the terminal, with the cursor left in the focused pane.
+ */
+void TerminalEditor::renderPanes() {
+    AllocationTracker::Scope tag(AllocationTracker::Render);
+    PaneTree::Pane &current = panes->focused();
+    for (PaneTree::Pane *pane : panes->panes()) {
+        if (pane == &current || !pane->win || pane->damage_top == pane->damage_bottom) continue;
+
+        if (pane->view == PaneTree::View::Note) {
+            bool reloaded = false;
+            const std::vector<std::string> &shown = viewLines(pane->note, reloaded);
+            if (reloaded) pane->wrap.reset(shown);
+
+            // Lines may have been removed from another pane on the same note
+            pane->row = std::min(pane->row, (int)shown.size() - 1);
+            pane->col = std::min(pane->col, (int)shown[pane->row].length());
+            while (pane->col > 0 && Utf8::isContinuation(shown[pane->row][pane->col])) pane->col--;
+            const BufferCache::Buffer *parked = pane->note == current_file ? nullptr : buffers.peek(pane->note);
+            ui.displayView(pane->win, pane->wrap, shown, pane->row, pane->col,
+                           pane->scroll_row, pane->scroll_col, pane->note, false,
+                           nullptr, parked ? &parked->outline : &ui.getOutline(),
+                           parked ? &parked->syntax : &ui.getSyntax(),
+                           parked ? &parked->tables : &ui.getTables());
+        } else if (pane->view == PaneTree::View::Kanban) {
+            taskManager.setWindow(pane->win);
+            taskManager.renderTasks();
+        } else {
+            calendar.setWindow(pane->win);
+            calendar.renderCalendar();
+        }
+        panes->present(*pane);
+    }
+
+    attachFocusedPane();
+    current.damage_top = current.damage_bottom = 0;
+    if (current.win) {
+        wnoutrefresh(current.win);  /**< The last window copied places the terminal cursor. */
+        if (Profiler::isEnabled() || AllocationTracker::isEnabled()) drawOverlays(current.win);
+    }
+    Profiler::Scope timer(Profiler::Refresh);
+    RenderBackend::present();
+}
+
+/**
+ * @brief Draws the profiler overlays over a copy of a pane window and copies it to the screen.
+ *
+ * The pane window itself is left as it was drawn, so the rows it keeps when it
+ * scrolls never carry a piece of an overlay.
+ *
+ * @param under The window of the focused pane, already copied to the screen.
+ */
+void TerminalEditor::drawOverlays(WINDOW *under) {
+    int height, width, top, left;
+    getmaxyx(under, height, width);
+    getbegyx(under, top, left);
+    WINDOW *copy = overlay.get();
+    if (!copy || getmaxy(copy) != height || getmaxx(copy) != width || getbegy(copy) != top || getbegx(copy) != left) {
+        overlay.reset(newwin(height, width, top, left));
+        copy = overlay.get();
+        if (!copy) return;
+    }
+
+    copywin(under, copy, 0, 0, 0, 0, height - 1, width - 1, FALSE);
+    wmove(copy, getcury(under), getcurx(under));
+    if (Profiler::isEnabled()) Profiler::drawOverlay(copy);
+    if (AllocationTracker::isEnabled()) AllocationTracker::drawOverlay(copy);
+    touchwin(copy);
+    wnoutrefresh(copy);  /**< Copied last, so it places the terminal cursor. */
+}
+
+/**
+ * @brief Lists the panes other than the focused one that show the open note.
+ *
+ * @return The panes drawing from the editor's lines.
+ */
+std::vector<PaneTree::Pane*> TerminalEditor::otherViews() {
+    std::vector<PaneTree::Pane*> views;
+    for (PaneTree::Pane *pane : panes->panes()) {
+        if (pane != &panes->focused() && pane->view == PaneTree::View::Note && pane->note == current_file) {
+            views.push_back(pane);
+        }
+    }
+    return views;
+}
+
+/**
+ * @brief Damages the rows of a pane that show edited lines.
+ *
+ * @param view A pane on the open note.
+ * @param start First edited line.
+ * @param end One past the last edited line.
+ * @param to_bottom Whether the rows below the edit changed too.
+ */
+void TerminalEditor::damageView(PaneTree::Pane &view, int start, int end, bool to_bottom) {
+    bool wrapped = view.wrap.isActive();
+    const Outline &outline = ui.getOutline();
+    int first = outline.rowOf(view.wrap, start);
+    int last = (to_bottom || wrapped) ? getmaxy(view.win) : outline.rowOf(view.wrap, end) - view.scroll_row + 2;
+    panes->damage(view, first - view.scroll_row + 2, last);  /**< Text starts on the third row of a pane. */
+}
+
+/**
+ * @brief Gets the lines of a note shown in a pane that is not focused.
+ *
+ * The open note is drawn from the editor's own lines and other notes from the
+ * buffer cache, so panes on the same note never copy it. A note that is not
+ * parked, or whose checkbox was ticked from the kanban board, is read from disk
+ * and parked.
+ *
+ * @param name The name of the note.
+ * @param reloaded Set to `true` if the note was read from disk.
+ * @return The lines of the note, at least one.
+ */
+const std::vector<std::string>& TerminalEditor::viewLines(const std::string &name, bool &reloaded) {
+    if (name == current_file) return lines;
+    if (taskManager.takePatchedNote(name)) buffers.remove(name);
+
+    const BufferCache::Buffer *parked = buffers.peek(name);
+    if (!parked) {
+        BufferCache::Buffer loaded;
+        std::string loaded_name;
+        fileManager.loadFile(name, loaded.lines, loaded_name);
+        if (loaded.lines.empty()) loaded.lines.push_back("");
+        loaded.bytes = BufferCache::footprint(loaded.lines);
+        loaded.outline.reset(loaded.lines);
+        loaded.syntax.reset(loaded.lines);
+        loaded.tables.reset(loaded.lines);
+        loaded.stats.reset(loaded.lines);
+        buffers.store(name, std::move(loaded));
+        parked = buffers.peek(name);
+        reloaded = true;
+    }
+    return parked->lines;
 }
@@ -14,27 +14,45 @@
 #define TERMINAL_EDITOR_H
 
 #include <ncurses.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include "FileManager.h"
 #include "EditorUI.h"
 #include "Calendar.h"
 #include "TaskManager.h"
+#include "BufferCache.h"
+#include "PaneTree.h"
+#include "InputRules.h"
+#include "Session.h"
 
 class TerminalEditor {
 public:
-    TerminalEditor(WINDOW *win, WINDOW *sidebar, WINDOW *content,
-                 const std::vector<std::string> &files);
+    TerminalEditor(WINDOW *win, WINDOW *sidebar, PaneTree *panes,
+                 const std::vector<std::string> &files, const Session *session = nullptr);
     
     void handleInput(int ch);
     void redraw(int sidebar_width);
     void cleanup();
+
+    // Applies the background check of a restored session's notes and boards once it is done, true while it runs
+    bool checkCatalog();
     
 private:
+    struct WindowDeleter {
+        void operator()(WINDOW *win) const { delwin(win); }
+    };
+
     FileManager fileManager;
     EditorUI ui;
     Calendar calendar;
     TaskManager taskManager; 
+    BufferCache buffers;
+    PaneTree *panes;            ///< Owned by the application, which lays it out
+    std::unique_ptr<WINDOW, WindowDeleter> overlay;     ///< A copy of the focused pane with the profiler overlays on it
     
     int row;
     int col;
@@ -46,12 +64,50 @@ private:
     int sidebar_width;
     std::vector<std::string> lines;
     std::string current_file;
+    bool dirty;                 ///< The open note has changes that are not saved
+    size_t current_bytes;       ///< Estimated memory of the open note's lines
+    int rule_state;             ///< Input rule state after the text typed last, -1 after any other key
+    int edited_start;           ///< First row the key rewrote above the cursor, like the rows of a formatted table
+    int edited_end;             ///< One past the last row the key rewrote below the cursor, like renumbered items
+    std::unordered_map<std::string, Session::Cursor> positions;    ///< Cursor of each note opened before, restored when it is read again
+    std::future<Session::Catalog> catalog_scan;                    ///< Notes and boards on disk, valid until checkCatalog takes them
+    std::chrono::steady_clock::time_point session_saved;           ///< When the session snapshot was last written
 
     void handleInputContent(int ch);
+    void typeText(const std::string &text, int state);
+    void insertPair(const InputRules::Pair &pair);
     void handleInputSidebar(int ch);
     void handleInputKanban(int ch);
     void handleInputCalendar(int ch);
     void adjustCursorPosition();
+    void saveCurrentFile();
+    void openNote(const std::string &name);
+    void loadNote(const std::string &name);
+    void switchNote(const std::string &name);
+    void updateCorpusCounts();
+    void reportSaveFailures();
+    int calendarIndex();
+    void openSidebarBoard();
+    void restoreSession(const Session &session);
+    void saveSession();
+    void moveScreenRow(int delta);
+    void moveToLine(int target);
+    void showOutline();
+    void toggleFold();
+    void formatTable();
+
+    // Split panes, the focused pane's cursor and scroll position live in this class
+    bool handlePaneKey(int ch);
+    void parkPane();
+    void leavePane();
+    void enterPane();
+    void attachFocusedPane();
+    void drawFocusedPane();
+    void renderPanes();
+    void drawOverlays(WINDOW *under);
+    std::vector<PaneTree::Pane*> otherViews();
+    void damageView(PaneTree::Pane &view, int start, int end, bool to_bottom);
+    const std::vector<std::string>& viewLines(const std::string &name, bool &reloaded);
 };
 
 #endif
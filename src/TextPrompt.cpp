@@ -1,4 +1,7 @@
 #include "TextPrompt.h"
+#include "Utf8.h"
+#include "RenderBackend.h"
+#include "InputDecoder.h"
 #include <string>
 #include <ncurses.h>
 #include <algorithm>
@@ -22,6 +25,7 @@ TextPrompt::TextPrompt(WINDOW *win_in, std::string title_in){
  * 
  * This function creates a temporary window for displaying a text prompt to the user, who can input text. 
  * The function supports cursor movement, backspace functionality, and scrolling when the input exceeds the visible space. 
+ * Input may hold any UTF-8 text, and the cursor moves and deletes whole characters.
  * The user can finalize their input by pressing the Enter key, which will return the input as a string.
  * 
  * @return A string containing the user input.
@@ -41,100 +45,112 @@ std::string TextPrompt::prompt() {
     // Draw the border and title
     box(prompt_win, 0, 0);
     mvwprintw(prompt_win, 1, 2, "%s", title.substr(0, std::max(0, width - 4)).c_str());
-    wrefresh(win);
-    wrefresh(prompt_win);
+    wnoutrefresh(win);
+    wnoutrefresh(prompt_win);
 
     // Cursor settings
     curs_set(1);  ///< Make the cursor visible.
-    char input[256] = {0};  ///< Input buffer for storing user input.
-    int input_len = 0;  ///< Length of the input text.
-    int cursor_pos = 0;  ///< Position of the cursor.
-    int view_start = 0;  ///< Scrolling position (text view start).
-    const int max_visible = width - 4;  ///< Maximum number of characters visible in the prompt window.
+    const size_t max_input = 255;  ///< Maximum number of bytes of input.
+    std::string input;  ///< The user input, as UTF-8 bytes.
+    size_t cursor_pos = 0;  ///< Byte position of the cursor, always on a character boundary.
+    size_t view_start = 0;  ///< Scrolling position (text view start).
+    const int max_visible = width - 4;  ///< Maximum number of columns visible in the prompt window.
 
     while (1) {
         werase(prompt_win);  ///< Clear the window for redrawing.
         box(prompt_win, 0, 0);  ///< Redraw the border.
         mvwprintw(prompt_win, 0, 2, "%s", title.substr(0, std::max(0, width - 4)).c_str());
 
-        // Display the visible part of the input text
-        // If the cursor is near the right edge of the visible area, scroll to the right.
-        if (cursor_pos - view_start >= max_visible) {
-            view_start = cursor_pos - max_visible + 1;  // Adjust view_start so the cursor is visible.
-        }
-
-        // If the cursor is near the left edge of the visible area, scroll to the left.
-        if (cursor_pos - view_start < 0) {
+        // If the cursor is left of the visible area, scroll to the left.
+        if (cursor_pos < view_start) {
             view_start = cursor_pos;  // Adjust view_start so the cursor is at the start of the visible area.
         }
 
-        // Now, print the visible portion of the input text based on the adjusted view_start.
-        if (input_len - view_start > max_visible) {
-            mvwprintw(prompt_win, 1, 2, "%.*s", max_visible, &input[view_start]);
-        } else {
-            mvwprintw(prompt_win, 1, 2, "%s", &input[view_start]);
+        // If the cursor is at the right edge of the visible area, scroll to the right one character at a time.
+        while (Utf8::width(input, view_start, cursor_pos) >= max_visible) {
+            view_start = Utf8::nextChar(input, view_start);
         }
 
-        // Calculate the cursor's x position
-        int cursor_x = 2 + cursor_pos - view_start;
+        // Now, print the characters that fit starting at view_start.
+        size_t view_end = Utf8::offsetAtWidth(input, view_start, max_visible);
+        mvwaddnstr(prompt_win, 1, 2, input.c_str() + view_start, view_end - view_start);
+
+        // Calculate the cursor's x position from the width of the text before it
+        int cursor_x = 2 + Utf8::width(input, view_start, cursor_pos);
         if (cursor_x >= max_visible) cursor_x = max_visible + 1;
         wmove(prompt_win, 1, cursor_x);  ///< Move the cursor.
-        wrefresh(prompt_win);  ///< Refresh the window to show updates.
+        wnoutrefresh(prompt_win);  ///< Copy the window to the frame the key is read on.
 
-        int ch = getch();  ///< Capture the user input.
+        int ch = RenderBackend::readKey();  ///< Capture the user input.
 
         switch (ch) {
             case '\n':  ///< Enter key pressed, return the input text.
                 delwin(prompt_win);
                 curs_set(0);  ///< Hide the cursor.
-                return std::string(input);
+                return input;
             
             case KEY_BACKSPACE:
             case 127:  ///< Handle backspace.
                 if (cursor_pos > 0) {
-                    // Shift characters left if there's text to delete.
-                    for (int i = cursor_pos - 1; i < input_len - 1; i++) {
-                        input[i] = input[i + 1];
-                    }
-                    input[--input_len] = '\0';  ///< Null-terminate the string.
-                    cursor_pos--;  ///< Move the cursor left.
+                    // Remove the whole character left of the cursor.
+                    size_t start = Utf8::prevChar(input, cursor_pos);
+                    input.erase(start, cursor_pos - start);
+                    cursor_pos = start;  ///< Move the cursor left.
                 }
                 break;
 
             case KEY_RIGHT:  ///< Right arrow key.
-                if (cursor_pos < input_len) {
-                    cursor_pos++;  ///< Move cursor right.
+                if (cursor_pos < input.length()) {
+                    cursor_pos = Utf8::nextChar(input, cursor_pos);  ///< Move cursor right.
                 }
                 break;
 
             case KEY_LEFT:  ///< Left arrow key.
                 if (cursor_pos > 0) {
-                    cursor_pos--;  ///< Move cursor left.
-                } else if (view_start > 0) {
-                    view_start--;  ///< Scroll input text to the left.
+                    cursor_pos = Utf8::prevChar(input, cursor_pos);  ///< Move cursor left.
                 }
                 break;
 
-            default:  ///< Handle regular characters.
-                if (ch >= 32 && ch <= 126 && input_len < sizeof(input) - 1) {
+            default: {  ///< Handle regular characters, including the bytes of UTF-8 characters.
+                std::string typed;
+                if (ch >= 32 && ch <= 126) {
+                    typed = std::string(1, (char)ch);
+                } else if (ch > 127 && ch < 256 && Utf8::sequenceLength(ch) > 1) {
+                    typed = readUtf8(ch);
+                }
+                if (!typed.empty() && input.length() + typed.length() <= max_input) {
                     // Insert the character at the cursor position.
-                    for (int i = input_len; i > cursor_pos; i--) {
-                        input[i] = input[i - 1];
-                    }
-                    input[cursor_pos++] = (char)ch;
-                    input_len++;
-                    input[input_len] = '\0';  ///< Null-terminate the string.
-
-                    // Scroll input text if necessary when the cursor goes out of view.
-                    if (cursor_pos - view_start >= max_visible && view_start < input_len - max_visible) {
-                        view_start++;  ///< Scroll text to the right.
-                    }
+                    input.insert(cursor_pos, typed);
+                    cursor_pos += typed.length();
                 }
                 break;
+            }
         }
     }
 
     delwin(prompt_win);  ///< Delete the prompt window after use.
     curs_set(0);  ///< Hide the cursor.
-    return std::string(input);  ///< Return the input string.
+    return input;  ///< Return the input string.
+}
+
+/**
+ * @brief Reads the rest of a UTF-8 character whose first byte was typed.
+ *
+ * The terminal sends all bytes of a character at once, so they are already waiting.
+ * A byte that does not continue the character is put back for the next read.
+ *
+ * @param lead The first byte, as returned by RenderBackend::readKey.
+ * @return The bytes of the character, shorter if the sequence was cut off.
+ */
+std::string TextPrompt::readUtf8(int lead) {
+    std::string bytes(1, (char)lead);
+    for (int i = 1; i < Utf8::sequenceLength(lead); ++i) {
+        int next = InputDecoder::get();
+        if (next == ERR || next > 255 || !Utf8::isContinuation(next)) {
+            if (next != ERR) InputDecoder::unget(next);
+            break;
+        }
+        bytes += (char)next;
+    }
+    return bytes;
 }
\ No newline at end of file
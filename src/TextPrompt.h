@@ -18,6 +18,9 @@ class TextPrompt {
 public:
     TextPrompt(WINDOW *win, std::string title_in);
     std::string prompt();
+
+    // Reads the remaining bytes of a typed UTF-8 character
+    static std::string readUtf8(int lead);
     
 private:
     std::string title;
@@ -0,0 +1,166 @@
+#include "TextStats.h"
+#include "Settings.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <cctype>
+
+/**
+ * @brief Adds another count to this one.
+ */
+TextStats::Counts& TextStats::Counts::operator+=(const Counts& other) {
+    words += other.words;
+    chars += other.chars;
+    return *this;
+}
+
+/**
+ * @brief Takes another count from this one.
+ */
+TextStats::Counts& TextStats::Counts::operator-=(const Counts& other) {
+    words -= other.words;
+    chars -= other.chars;
+    return *this;
+}
+
+/**
+ * @brief Counts every line of a new buffer.
+ *
+ * @param lines The buffer.
+ */
+void TextStats::reset(const std::vector<std::string>& lines) {
+    counts.clear();
+    sum = Counts();
+    for (const std::string& line : lines) {
+        counts.push_back(count(line));
+        sum += counts.back();
+    }
+    tree_valid = false;
+}
+
+/**
+ * @brief Counts the lines touched by an edit again.
+ *
+ * When no lines were added or removed, each touched line's difference goes into
+ * the tree in O(log n). Otherwise the line counts after the edit move, and the
+ * tree is built again when it is next needed.
+ *
+ * @param lines The buffer after the edit.
+ * @param start First line that changed.
+ * @param oldEnd End of the changed lines before the edit.
+ * @param newEnd End of the changed lines after the edit.
+ */
+void TextStats::edited(const std::vector<std::string>& lines, int start, int oldEnd, int newEnd) {
+    int size = counts.size();
+    if (size - oldEnd != (int)lines.size() - newEnd || start < 0 || start > oldEnd || oldEnd > size) {
+        reset(lines);
+        return;
+    }
+
+    if (oldEnd == newEnd) {
+        for (int i = start; i < newEnd; ++i) {
+            Counts now = count(lines[i]);
+            Counts delta = now;
+            delta -= counts[i];
+            counts[i] = now;
+            sum += delta;
+            if (tree_valid) add(i, delta);
+        }
+        return;
+    }
+
+    for (int i = start; i < oldEnd; ++i) sum -= counts[i];
+    std::vector<Counts> fresh;
+    for (int i = start; i < newEnd; ++i) {
+        fresh.push_back(count(lines[i]));
+        sum += fresh.back();
+    }
+    counts.erase(counts.begin() + start, counts.begin() + oldEnd);
+    counts.insert(counts.begin() + start, fresh.begin(), fresh.end());
+    tree_valid = false;
+}
+
+/**
+ * @brief Gets the counts of the lines before a line.
+ *
+ * @param line The line, the counts of every line if it is past the end.
+ * @return The counts of the lines [0, line).
+ */
+TextStats::Counts TextStats::before(int line) const {
+    if (!tree_valid) {
+        // Each node adds itself to its parent, which builds the tree in one pass
+        tree.assign(counts.size() + 1, Counts());
+        for (size_t i = 1; i < tree.size(); ++i) {
+            tree[i] += counts[i - 1];
+            size_t parent = i + (i & -i);
+            if (parent < tree.size()) tree[parent] += tree[i];
+        }
+        tree_valid = true;
+    }
+    Counts result;
+    for (size_t i = std::min<size_t>(std::max(line, 0), counts.size()); i > 0; i -= i & -i) {
+        result += tree[i];
+    }
+    return result;
+}
+
+/**
+ * @brief Gets the counts of a range of lines.
+ *
+ * @param first First line of the range.
+ * @param end One past the last line.
+ * @return The counts of the lines [first, end).
+ */
+TextStats::Counts TextStats::range(int first, int end) const {
+    Counts result = before(end);
+    result -= before(first);
+    return result;
+}
+
+/**
+ * @brief Counts the words and characters of part of a line.
+ *
+ * Markdown markers on their own, like `-`, `#` or `|`, are not words.
+ *
+ * @param text The line.
+ * @param from First byte to count.
+ * @param to One past the last byte, the end of the line if npos.
+ * @return The counts.
+ */
+TextStats::Counts TextStats::count(const std::string& text, size_t from, size_t to) {
+    Counts result;
+    to = std::min(to, text.size());
+    bool in_word = false;
+    bool word_has_letter = false;
+    for (size_t i = from; i < to; ++i) {
+        unsigned char byte = text[i];
+        if (!Utf8::isContinuation(byte)) ++result.chars;
+        if (byte == ' ' || byte == '\t') {
+            if (in_word && word_has_letter) ++result.words;
+            in_word = word_has_letter = false;
+        } else {
+            in_word = true;
+            if (std::isalnum(byte) || byte >= 0x80) word_has_letter = true;
+        }
+    }
+    if (in_word && word_has_letter) ++result.words;
+    return result;
+}
+
+/**
+ * @brief Gets the reading time of some words at READING_WPM.
+ *
+ * @param words The number of words.
+ * @return The minutes, at least one if there are any words.
+ */
+int TextStats::readingMinutes(long words) {
+    return (int)((words + READING_WPM - 1) / READING_WPM);
+}
+
+/**
+ * @brief Adds a difference to the counts of a line in the tree.
+ */
+void TextStats::add(int line, const Counts& delta) {
+    for (size_t i = line + 1; i < tree.size(); i += i & -i) {
+        tree[i] += delta;
+    }
+}
@@ -0,0 +1,56 @@
+/**
+ * @file TextStats.h
+ * @brief Header file for the TextStats class, the word and character counts of a note.
+ *
+ * Every line keeps its own counts, and a Fenwick tree over them gives the counts
+ * of the lines before any line in O(log n), so the words up to the cursor or in a
+ * range of lines are known without reading the lines. An edit counts the lines it
+ * touched again and adds the difference to the tree. An edit that adds or removes
+ * lines shifts the lines after it, so the tree is built again from the kept line
+ * counts, in one linear pass that reads no text, the next time a range is asked for.
+ */
+
+#ifndef TEXT_STATS_H
+#define TEXT_STATS_H
+
+#include <string>
+#include <vector>
+
+class TextStats {
+public:
+    struct Counts {
+        long words = 0;
+        long chars = 0;     ///< Characters without line breaks
+
+        Counts& operator+=(const Counts& other);
+        Counts& operator-=(const Counts& other);
+    };
+
+    // Forgets the previous buffer and counts a new one
+    void reset(const std::vector<std::string>& lines);
+
+    // Lines [start, oldEnd) were replaced by lines [start, newEnd)
+    void edited(const std::vector<std::string>& lines, int start, int oldEnd, int newEnd);
+
+    Counts total() const { return sum; }
+
+    // Counts of the lines [0, line) and of the lines [first, end)
+    Counts before(int line) const;
+    Counts range(int first, int end) const;
+
+    // Counts of the bytes [from, to) of a line; a word is a run of non-space characters with a letter or digit
+    static Counts count(const std::string& text, size_t from = 0, size_t to = std::string::npos);
+
+    // Minutes it takes to read some words, rounded up
+    static int readingMinutes(long words);
+
+private:
+    std::vector<Counts> counts;         ///< One per line
+    mutable std::vector<Counts> tree;   ///< Fenwick tree over counts, index i + 1 for line i
+    mutable bool tree_valid = false;
+    Counts sum;
+
+    void add(int line, const Counts& delta);
+};
+
+#endif // TEXT_STATS_H
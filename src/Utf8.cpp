@@ -0,0 +1,344 @@
+#include "Utf8.h"
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+namespace {
+
+struct Range {
+    char32_t first;
+    char32_t last;
+};
+
+// Combining marks, format characters and other code points drawn in the cell before them
+const Range ZERO_WIDTH[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2},
+    {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A}, {0x061C, 0x061C}, {0x064B, 0x065F},
+    {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED},
+    {0x0711, 0x0711}, {0x0730, 0x074A}, {0x07A6, 0x07B0}, {0x07EB, 0x07F3}, {0x0816, 0x082D},
+    {0x0859, 0x085B}, {0x08D3, 0x0902}, {0x093A, 0x093A}, {0x093C, 0x093C}, {0x0941, 0x0948},
+    {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0962, 0x0963}, {0x0981, 0x0981}, {0x09BC, 0x09BC},
+    {0x09C1, 0x09C4}, {0x09CD, 0x09CD}, {0x09E2, 0x09E3}, {0x0A01, 0x0A02}, {0x0A3C, 0x0A3C},
+    {0x0A41, 0x0A51}, {0x0A70, 0x0A71}, {0x0A75, 0x0A75}, {0x0A81, 0x0A82}, {0x0ABC, 0x0ABC},
+    {0x0AC1, 0x0AC8}, {0x0ACD, 0x0ACD}, {0x0AE2, 0x0AE3}, {0x0B01, 0x0B01}, {0x0B3C, 0x0B3C},
+    {0x0B3F, 0x0B3F}, {0x0B41, 0x0B44}, {0x0B4D, 0x0B4D}, {0x0B56, 0x0B56}, {0x0B62, 0x0B63},
+    {0x0B82, 0x0B82}, {0x0BC0, 0x0BC0}, {0x0BCD, 0x0BCD}, {0x0C00, 0x0C00}, {0x0C3E, 0x0C40},
+    {0x0C46, 0x0C56}, {0x0C62, 0x0C63}, {0x0CBC, 0x0CBC}, {0x0CCC, 0x0CCD}, {0x0CE2, 0x0CE3},
+    {0x0D00, 0x0D01}, {0x0D41, 0x0D44}, {0x0D4D, 0x0D4D}, {0x0D62, 0x0D63}, {0x0DCA, 0x0DCA},
+    {0x0DD2, 0x0DD6}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x0EB1, 0x0EB1},
+    {0x0EB4, 0x0EBC}, {0x0EC8, 0x0ECD}, {0x0F18, 0x0F19}, {0x0F35, 0x0F35}, {0x0F37, 0x0F37},
+    {0x0F39, 0x0F39}, {0x0F71, 0x0F7E}, {0x0F80, 0x0F84}, {0x0F86, 0x0F87}, {0x0F8D, 0x0FBC},
+    {0x0FC6, 0x0FC6}, {0x102D, 0x1030}, {0x1032, 0x1037}, {0x1039, 0x103A}, {0x103D, 0x103E},
+    {0x1058, 0x1059}, {0x105E, 0x1060}, {0x1071, 0x1074}, {0x1082, 0x1082}, {0x1085, 0x1086},
+    {0x108D, 0x108D}, {0x109D, 0x109D}, {0x1160, 0x11FF}, {0x135D, 0x135F}, {0x1712, 0x1714},
+    {0x1732, 0x1734}, {0x1752, 0x1753}, {0x1772, 0x1773}, {0x17B4, 0x17B5}, {0x17B7, 0x17BD},
+    {0x17C6, 0x17C6}, {0x17C9, 0x17D3}, {0x17DD, 0x17DD}, {0x180B, 0x180F}, {0x18A9, 0x18A9},
+    {0x1920, 0x1922}, {0x1927, 0x1928}, {0x1932, 0x1932}, {0x1939, 0x193B}, {0x1A17, 0x1A18},
+    {0x1A1B, 0x1A1B}, {0x1A56, 0x1A56}, {0x1A58, 0x1A60}, {0x1A62, 0x1A62}, {0x1A65, 0x1A6C},
+    {0x1A73, 0x1A7F}, {0x1AB0, 0x1AFF}, {0x1B00, 0x1B03}, {0x1B34, 0x1B34}, {0x1B36, 0x1B3A},
+    {0x1B6B, 0x1B73}, {0x1B80, 0x1B81}, {0x1BA2, 0x1BA5}, {0x1BA8, 0x1BA9}, {0x1C2C, 0x1C33},
+    {0x1C36, 0x1C37}, {0x1CD0, 0x1CD2}, {0x1CD4, 0x1CE0}, {0x1CE2, 0x1CE8}, {0x1DC0, 0x1DFF},
+    {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20F0}, {0x2CEF, 0x2CF1},
+    {0x2D7F, 0x2D7F}, {0x2DE0, 0x2DFF}, {0x302A, 0x302D}, {0x3099, 0x309A}, {0xA66F, 0xA672},
+    {0xA674, 0xA67D}, {0xA69E, 0xA69F}, {0xA6F0, 0xA6F1}, {0xA802, 0xA802}, {0xA806, 0xA806},
+    {0xA80B, 0xA80B}, {0xA825, 0xA826}, {0xA8C4, 0xA8C5}, {0xA8E0, 0xA8F1}, {0xA926, 0xA92D},
+    {0xA947, 0xA951}, {0xA980, 0xA982}, {0xA9B3, 0xA9B3}, {0xA9B6, 0xA9B9}, {0xA9BC, 0xA9BD},
+    {0xAA29, 0xAA2E}, {0xAA31, 0xAA32}, {0xAA35, 0xAA36}, {0xAAEC, 0xAAED}, {0xABE5, 0xABE5},
+    {0xABE8, 0xABE8}, {0xABED, 0xABED}, {0xD7B0, 0xD7FF}, {0xFB1E, 0xFB1E}, {0xFE00, 0xFE0F},
+    {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF}, {0x101FD, 0x101FD}, {0x10A01, 0x10A0F}, {0x10A38, 0x10A3F},
+    {0x11001, 0x11001}, {0x11038, 0x11046}, {0x1107F, 0x11081}, {0x110B3, 0x110B6}, {0x110B9, 0x110BA},
+    {0x11100, 0x11102}, {0x11127, 0x1112B}, {0x1112D, 0x11134}, {0x1D167, 0x1D169}, {0x1D17B, 0x1D182},
+    {0x1D185, 0x1D18B}, {0x1D1AA, 0x1D1AD}, {0x1E8D0, 0x1E8D6}, {0x1E944, 0x1E94A}, {0x1F3FB, 0x1F3FF},
+    {0xE0000, 0xE0FFF},
+};
+
+// East Asian Wide and Fullwidth code points, including emoji presented as pictures
+const Range WIDE[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0},
+    {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F},
+    {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5},
+    {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728},
+    {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+    {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+    {0x2E80, 0x3029}, {0x302E, 0x303E}, {0x3041, 0x3098}, {0x309B, 0x33FF}, {0x3400, 0x4DBF},
+    {0x4E00, 0x9FFF}, {0xA000, 0xA4CF}, {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF},
+    {0xFE10, 0xFE19}, {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4},
+    {0x17000, 0x18CFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E},
+    {0x1F191, 0x1F19A}, {0x1F200, 0x1F251}, {0x1F300, 0x1F320}, {0x1F32D, 0x1F335}, {0x1F337, 0x1F37C},
+    {0x1F37E, 0x1F393}, {0x1F3A0, 0x1F3CA}, {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0}, {0x1F3F4, 0x1F3F4},
+    {0x1F3F8, 0x1F3FA}, {0x1F400, 0x1F43E}, {0x1F440, 0x1F440}, {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D},
+    {0x1F54B, 0x1F54E}, {0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596}, {0x1F5A4, 0x1F5A4},
+    {0x1F5FB, 0x1F64F}, {0x1F680, 0x1F6C5}, {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2}, {0x1F6D5, 0x1F6D7},
+    {0x1F6DC, 0x1F6DF}, {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC}, {0x1F7E0, 0x1F7EB}, {0x1F7F0, 0x1F7F0},
+    {0x1F90C, 0x1F93A}, {0x1F93C, 0x1F945}, {0x1F947, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD},
+    {0x30000, 0x3FFFD},
+};
+
+constexpr char32_t CODEPOINT_LIMIT = 0x110000;
+constexpr int BLOCK_BITS = 8;
+constexpr int BLOCK_BYTES = (1 << BLOCK_BITS) / 4;     ///< Four 2-bit widths per byte
+constexpr char32_t ZERO_WIDTH_JOINER = 0x200D;
+constexpr char32_t REPLACEMENT = 0xFFFD;
+
+/**
+ * @brief The two stage width table, built the first time a width is needed.
+ *
+ * `blocks[index[cp >> 8]]` holds the 2-bit widths of the 256 code points of the block.
+ */
+struct WidthTable {
+    std::vector<std::uint16_t> index;
+    std::vector<std::uint8_t> blocks;
+
+    WidthTable() {
+        std::vector<std::uint8_t> widths(CODEPOINT_LIMIT, 1);
+        for (const Range& range : ZERO_WIDTH) {
+            for (char32_t cp = range.first; cp <= range.last; ++cp) widths[cp] = 0;
+        }
+        for (const Range& range : WIDE) {
+            for (char32_t cp = range.first; cp <= range.last; ++cp) widths[cp] = 2;
+        }
+
+        // Pack every block and share the ones that are identical
+        std::unordered_map<std::string, std::uint16_t> seen;
+        index.resize(CODEPOINT_LIMIT >> BLOCK_BITS);
+        for (size_t block = 0; block < index.size(); ++block) {
+            std::string packed(BLOCK_BYTES, '\0');
+            for (int i = 0; i < (1 << BLOCK_BITS); ++i) {
+                packed[i >> 2] |= (char)(widths[(block << BLOCK_BITS) + i] << ((i & 3) * 2));
+            }
+            auto found = seen.emplace(packed, (std::uint16_t)seen.size());
+            if (found.second) blocks.insert(blocks.end(), packed.begin(), packed.end());
+            index[block] = found.first->second;
+        }
+    }
+};
+
+const WidthTable& widthTable() {
+    static const WidthTable table;
+    return table;
+}
+
+/**
+ * @brief Checks whether a code point is a regional indicator, two of which make a flag.
+ */
+bool isRegionalIndicator(char32_t cp) {
+    return cp >= 0x1F1E6 && cp <= 0x1F1FF;
+}
+
+/**
+ * @brief Backs up from a byte to the start of the code point holding it.
+ */
+size_t codepointStart(const std::string& text, size_t pos) {
+    for (int i = 0; i < 3 && pos > 0 && Utf8::isContinuation(text[pos]); ++i) --pos;
+    return pos;
+}
+
+} // namespace
+
+/**
+ * @brief Gets the length of the UTF-8 sequence a byte starts.
+ *
+ * @param lead The first byte.
+ * @return 2 to 4 for a multibyte lead byte, 1 for ASCII and for bytes that cannot start a sequence.
+ */
+int Utf8::sequenceLength(unsigned char lead) {
+    if (lead < 0xC2) return 1;
+    if (lead < 0xE0) return 2;
+    if (lead < 0xF0) return 3;
+    if (lead < 0xF5) return 4;
+    return 1;
+}
+
+/**
+ * @brief Checks whether a byte continues a multibyte sequence.
+ *
+ * @param byte The byte.
+ * @return `true` for bytes of the form 10xxxxxx.
+ */
+bool Utf8::isContinuation(unsigned char byte) {
+    return (byte & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Decodes the code point at a position.
+ *
+ * Malformed bytes decode to U+FFFD one byte at a time, so any byte string can be stepped through.
+ *
+ * @param text The text.
+ * @param pos The position of the first byte.
+ * @param next Set to the position after the code point.
+ * @return The code point.
+ */
+char32_t Utf8::decode(const std::string& text, size_t pos, size_t& next) {
+    unsigned char lead = text[pos];
+    int length = sequenceLength(lead);
+    next = pos + 1;
+    if (length == 1) return lead < 0x80 ? lead : REPLACEMENT;
+    if (pos + length > text.size()) return REPLACEMENT;
+
+    char32_t cp = lead & (0x7F >> length);
+    for (int i = 1; i < length; ++i) {
+        unsigned char byte = text[pos + i];
+        if (!isContinuation(byte)) return REPLACEMENT;
+        cp = (cp << 6) | (byte & 0x3F);
+    }
+    next = pos + length;
+    return cp;
+}
+
+/**
+ * @brief Gets the number of columns a code point takes.
+ *
+ * @param codepoint The code point.
+ * @return 0, 1 or 2.
+ */
+int Utf8::codepointWidth(char32_t codepoint) {
+    if (codepoint < 0x300) return 1;
+    if (codepoint >= CODEPOINT_LIMIT) return 1;
+    const WidthTable& table = widthTable();
+    std::uint8_t packed = table.blocks[table.index[codepoint >> BLOCK_BITS] * BLOCK_BYTES + ((codepoint & 0xFF) >> 2)];
+    return (packed >> ((codepoint & 3) * 2)) & 3;
+}
+
+/**
+ * @brief Finds the start of the character after a position.
+ *
+ * Zero width code points stay with the character before them, a zero width joiner
+ * pulls in the code point after it, and regional indicators pair up into flags.
+ *
+ * @param text The text.
+ * @param pos A character boundary.
+ * @return The next character boundary, or the text length.
+ */
+size_t Utf8::nextChar(const std::string& text, size_t pos) {
+    if (pos >= text.size()) return text.size();
+
+    size_t next;
+    char32_t base = decode(text, pos, next);
+    char32_t previous = base;
+    bool flagOpen = isRegionalIndicator(base);
+    while (next < text.size()) {
+        if ((unsigned char)text[next] < 0x80) break;   // ASCII never extends a character
+
+        size_t after;
+        char32_t cp = decode(text, next, after);
+        bool joined = previous == ZERO_WIDTH_JOINER;
+        if (flagOpen && isRegionalIndicator(cp)) {
+            flagOpen = false;
+        } else if (!joined && codepointWidth(cp) != 0) {
+            break;
+        }
+        previous = cp;
+        next = after;
+    }
+    return next;
+}
+
+/**
+ * @brief Finds the start of the character before a position.
+ *
+ * Backs up to a code point that begins a character, one that takes columns and
+ * does not follow a zero width joiner or pair with a regional indicator before it,
+ * then steps forward so the boundaries match the ones nextChar finds.
+ *
+ * @param text The text.
+ * @param pos A character boundary.
+ * @return The previous character boundary, or 0.
+ */
+size_t Utf8::prevChar(const std::string& text, size_t pos) {
+    pos = std::min(pos, text.size());
+    size_t start = pos;
+    while (start > 0) {
+        start = codepointStart(text, start - 1);
+        if ((unsigned char)text[start] < 0x80) break;
+
+        size_t next;
+        char32_t cp = decode(text, start, next);
+        if (codepointWidth(cp) == 0 || start == 0) continue;
+        char32_t before = decode(text, codepointStart(text, start - 1), next);
+        if (before == ZERO_WIDTH_JOINER || (isRegionalIndicator(cp) && isRegionalIndicator(before))) continue;
+        break;
+    }
+
+    size_t boundary = start;
+    for (size_t next = nextChar(text, start); next < pos; next = nextChar(text, next)) {
+        boundary = next;
+    }
+    return boundary;
+}
+
+/**
+ * @brief Gets the number of columns a range of text takes.
+ *
+ * ASCII bytes are counted without decoding.
+ *
+ * @param text The text.
+ * @param from The first byte.
+ * @param to The byte just past the range.
+ * @return The width in columns.
+ */
+int Utf8::width(const std::string& text, size_t from, size_t to) {
+    to = std::min(to, text.size());
+    int columns = 0;
+    size_t pos = from;
+    while (pos < to) {
+        if ((unsigned char)text[pos] < 0x80) {
+            ++columns;
+            ++pos;
+            continue;
+        }
+        size_t next;
+        columns += codepointWidth(decode(text, pos, next));
+        pos = next;
+    }
+    return columns;
+}
+
+/**
+ * @brief Finds how much text starting at a position fits in a number of columns.
+ *
+ * @param text The text.
+ * @param from A character boundary to start at.
+ * @param columns The number of columns available.
+ * @return The last character boundary whose text from `from` fits.
+ */
+size_t Utf8::offsetAtWidth(const std::string& text, size_t from, int columns) {
+    size_t pos = from;
+    while (pos < text.size()) {
+        size_t next = nextChar(text, pos);
+        int used = width(text, pos, next);
+        if (used > columns) break;
+        columns -= used;
+        pos = next;
+    }
+    return pos;
+}
+
+/**
+ * @brief Appends the UTF-8 bytes of a code point to a string.
+ *
+ * Code points past U+10FFFF are written as U+FFFD.
+ *
+ * @param codepoint The code point to encode.
+ * @param out The string to append to.
+ */
+void Utf8::encode(char32_t codepoint, std::string& out) {
+    if (codepoint > 0x10FFFF) codepoint = REPLACEMENT;
+    if (codepoint < 0x80) {
+        out += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
@@ -0,0 +1,46 @@
+/**
+ * @file Utf8.h
+ * @brief Header file for the Utf8 class, which steps through and measures UTF-8 text.
+ *
+ * Lines are kept as UTF-8 bytes and the cursor is a byte offset that always sits
+ * on a character boundary. A character here is a base code point followed by the
+ * combining marks, variation selectors and zero width joined code points that are
+ * drawn in the same cell, so moving and deleting never split one. Display widths
+ * come from a two stage table built once at startup: the high bits of a code point
+ * pick a 256 entry block, and identical blocks are shared, so a lookup is two
+ * array reads and the whole table stays small.
+ */
+
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <string>
+#include <cstddef>
+
+class Utf8 {
+public:
+    // Number of bytes of the sequence a lead byte starts, 1 for ASCII and invalid bytes
+    static int sequenceLength(unsigned char lead);
+    static bool isContinuation(unsigned char byte);
+
+    // Decodes the code point at a position and sets next to the position after it
+    static char32_t decode(const std::string& text, size_t pos, size_t& next);
+
+    // Appends the UTF-8 bytes of a code point
+    static void encode(char32_t codepoint, std::string& out);
+
+    // Columns taken by a code point: 0 for combining marks, 2 for wide characters
+    static int codepointWidth(char32_t codepoint);
+
+    // Start of the next and previous character, never splitting combining sequences
+    static size_t nextChar(const std::string& text, size_t pos);
+    static size_t prevChar(const std::string& text, size_t pos);
+
+    // Columns taken by the bytes [from, to)
+    static int width(const std::string& text, size_t from, size_t to);
+
+    // The last character boundary at or after from whose text fits in some columns
+    static size_t offsetAtWidth(const std::string& text, size_t from, int columns);
+};
+
+#endif // UTF8_H
@@ -0,0 +1,324 @@
+#include "WrapMap.h"
+#include "LineDiff.h"
+#include "Utf8.h"
+#include <algorithm>
+
+std::uint64_t WrapMap::next_stamp = 0;
+
+/**
+ * @brief Starts or stops tracking a buffer.
+ *
+ * While inactive no line is wrapped, so the editor pays nothing for soft wrap when it is off.
+ *
+ * @param isOn Whether soft wrap is on.
+ * @param lines The buffer to wrap.
+ */
+void WrapMap::setActive(bool isOn, const std::vector<std::string>& lines) {
+    active = isOn;
+    if (active) {
+        reset(lines);
+    } else {
+        entries.clear();
+        tree.clear();
+    }
+}
+
+/**
+ * @brief Checks whether soft wrap is on.
+ * @return `true` if the buffer is being wrapped.
+ */
+bool WrapMap::isActive() const { return active; }
+
+/**
+ * @brief Sets the number of columns a row may hold.
+ *
+ * Resizing the terminal changes the width many times in a row, so lines are not
+ * wrapped again here. Each keeps the rows of the width it was last wrapped at
+ * until wrapLines or wrapRows reaches it, and the tree stays consistent with
+ * those rows in the meantime. Only a buffer that does not match is wrapped in full.
+ *
+ * @param newWidth The row width.
+ * @param lines The buffer.
+ */
+void WrapMap::setWidth(int newWidth, const std::vector<std::string>& lines) {
+    width = std::max(1, newWidth);
+    if (entries.size() != lines.size()) reset(lines);
+}
+
+/**
+ * @brief Wraps lines that were wrapped at another width.
+ *
+ * @param lines The buffer.
+ * @param first First line to check, clamped to the buffer.
+ * @param last One past the last line to check, clamped to the buffer.
+ */
+void WrapMap::wrapLines(const std::vector<std::string>& lines, int first, int last) {
+    if (!active) return;
+
+    last = std::min(last, (int)entries.size());
+    for (int i = std::max(first, 0); i < last; ++i) {
+        if (entries[i].width == width) continue;
+        int before = rowCount(i);
+        wrapLine(lines[i], entries[i]);
+        addRows(i, rowCount(i) - before);
+    }
+}
+
+/**
+ * @brief Wraps the lines shown on a range of screen rows.
+ *
+ * Lines are wrapped one at a time from the first row down until the rows are
+ * filled, so only what is on screen is wrapped after a resize.
+ *
+ * @param lines The buffer.
+ * @param firstRow The first screen row.
+ * @param rows The number of rows.
+ */
+void WrapMap::wrapRows(const std::vector<std::string>& lines, int firstRow, int rows) {
+    if (!active) return;
+
+    int segment = 0;
+    for (int line = lineAtRow(firstRow, segment); line < (int)entries.size() && rowsBefore(line) < firstRow + rows; ++line) {
+        wrapLines(lines, line, line + 1);
+    }
+}
+
+/**
+ * @brief Wraps a new buffer.
+ *
+ * Lines whose hash and width match the entry at the same index keep their rows,
+ * so reloading the same note only wraps the lines that changed.
+ *
+ * @param lines The buffer.
+ */
+void WrapMap::reset(const std::vector<std::string>& lines) {
+    if (!active) return;
+
+    entries.resize(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        wrapLine(lines[i], entries[i]);
+    }
+    rebuildTree();
+}
+
+/**
+ * @brief Updates the rows of the lines touched by an edit.
+ *
+ * Editing inside a line only wraps that line again and updates the tree in
+ * logarithmic time. Inserting or removing lines shifts the entries, like the
+ * buffer itself, and rebuilds the tree in linear time.
+ *
+ * @param lines The buffer after the edit.
+ * @param start First line that changed.
+ * @param oldEnd End of the changed lines before the edit.
+ * @param newEnd End of the changed lines after the edit.
+ */
+void WrapMap::edited(const std::vector<std::string>& lines, int start, int oldEnd, int newEnd) {
+    if (!active) return;
+
+    // A window that does not fit the cached lines, e.g. after another note was loaded
+    if (start < 0 || start > oldEnd || start > newEnd || oldEnd > (int)entries.size() ||
+        newEnd > (int)lines.size() || (int)entries.size() - oldEnd != (int)lines.size() - newEnd) {
+        reset(lines);
+        return;
+    }
+
+    if (oldEnd == newEnd) {
+        for (int i = start; i < newEnd; ++i) {
+            int before = rowCount(i);
+            wrapLine(lines[i], entries[i]);
+            addRows(i, rowCount(i) - before);
+        }
+        return;
+    }
+
+    if (oldEnd > newEnd) {
+        entries.erase(entries.begin() + newEnd, entries.begin() + oldEnd);
+    } else {
+        entries.insert(entries.begin() + oldEnd, newEnd - oldEnd, Entry{});
+    }
+    for (int i = start; i < newEnd; ++i) {
+        wrapLine(lines[i], entries[i]);
+    }
+    rebuildTree();
+}
+
+/**
+ * @brief Computes where the rows of a line start, unless they are already known.
+ *
+ * Rows break after the last space that fits, or before the character that does not
+ * fit if a word is longer than a row. Widths are display columns, so wide characters
+ * count twice and combining marks not at all.
+ *
+ * @param line The text of the line.
+ * @param entry The cache entry of the line, updated in place.
+ */
+void WrapMap::wrapLine(const std::string& line, Entry& entry) const {
+    std::uint64_t hash = LineDiff::hashLine(line);
+    if (entry.width == width && entry.hash == hash) return;
+
+    entry.hash = hash;
+    entry.width = width;
+    entry.breaks.clear();
+
+    // Walk whole characters so a break never splits one, and count their display width
+    size_t start = 0;
+    size_t lastSpace = 0;       ///< Position just after the last space of the current row
+    int used = 0;
+    for (size_t pos = 0; pos < line.length();) {
+        size_t next = Utf8::nextChar(line, pos);
+        int columns = Utf8::width(line, pos, next);
+        if (used + columns > width && pos > start) {
+            size_t rowEnd = (lastSpace > start) ? lastSpace : pos;
+            entry.breaks.push_back((int)rowEnd);
+            used = Utf8::width(line, rowEnd, pos);
+            start = rowEnd;
+            if (used + columns > width && pos > start) {
+                entry.breaks.push_back((int)pos);     // A wide character still does not fit after the word moved down
+                used = 0;
+                start = pos;
+            }
+        }
+        if (line[pos] == ' ') lastSpace = next;
+        used += columns;
+        pos = next;
+    }
+}
+
+/**
+ * @brief Builds the Fenwick tree of rows per line in linear time.
+ */
+void WrapMap::rebuildTree() {
+    int size = (int)entries.size();
+    stamp = ++next_stamp;
+    tree.assign(size + 1, 0);
+    for (int i = 1; i <= size; ++i) {
+        tree[i] += 1 + (int)entries[i - 1].breaks.size();
+        int parent = i + (i & -i);
+        if (parent <= size) tree[parent] += tree[i];
+    }
+}
+
+/**
+ * @brief Adds to the number of rows of one line in the tree.
+ *
+ * @param line The line.
+ * @param delta The change in its number of rows.
+ */
+void WrapMap::addRows(int line, int delta) {
+    if (delta == 0) return;
+    stamp = ++next_stamp;
+    for (int i = line + 1; i < (int)tree.size(); i += i & -i) {
+        tree[i] += delta;
+    }
+}
+
+/**
+ * @brief Gets the number of screen rows of the whole buffer.
+ * @return The row count.
+ */
+int WrapMap::totalRows() const {
+    return rowsBefore((int)entries.size());
+}
+
+/**
+ * @brief Gets the screen row a line starts on.
+ *
+ * @param line The line.
+ * @return The number of rows taken by the lines before it.
+ */
+int WrapMap::rowsBefore(int line) const {
+    int rows = 0;
+    for (int i = std::min(line, (int)tree.size() - 1); i > 0; i -= i & -i) {
+        rows += tree[i];
+    }
+    return rows;
+}
+
+/**
+ * @brief Gets the number of screen rows a line takes.
+ *
+ * @param line The line.
+ * @return The row count, at least 1.
+ */
+int WrapMap::rowCount(int line) const {
+    if (line < 0 || line >= (int)entries.size()) return 1;
+    return 1 + (int)entries[line].breaks.size();
+}
+
+/**
+ * @brief Finds the line shown on a screen row by descending the tree.
+ *
+ * @param row The screen row, counted from the top of the buffer.
+ * @param segment Set to the row within the line.
+ * @return The line, or the last line if the row is past the end.
+ */
+int WrapMap::lineAtRow(int row, int& segment) const {
+    int size = (int)entries.size();
+    if (size == 0) {
+        segment = 0;
+        return 0;
+    }
+
+    int line = 0;
+    int remaining = std::max(0, row);
+    int step = 1;
+    while (step * 2 <= size) step *= 2;
+    for (; step > 0; step /= 2) {
+        if (line + step <= size && tree[line + step] <= remaining) {
+            line += step;
+            remaining -= tree[line];
+        }
+    }
+
+    if (line >= size) {
+        segment = rowCount(size - 1) - 1;
+        return size - 1;
+    }
+    segment = std::min(remaining, rowCount(line) - 1);
+    return line;
+}
+
+/**
+ * @brief Gets the stamp of the current rows.
+ * @return A number that changes whenever the rows of any line change.
+ */
+std::uint64_t WrapMap::rowsStamp() const { return stamp; }
+
+/**
+ * @brief Finds the row of a line that holds a column.
+ *
+ * @param line The line.
+ * @param col The column.
+ * @return The row within the line.
+ */
+int WrapMap::segmentOf(int line, int col) const {
+    if (line < 0 || line >= (int)entries.size()) return 0;
+    const std::vector<int>& breaks = entries[line].breaks;
+    return (int)(std::upper_bound(breaks.begin(), breaks.end(), col) - breaks.begin());
+}
+
+/**
+ * @brief Gets the first column of a row of a line.
+ *
+ * @param line The line.
+ * @param segment The row within the line.
+ * @return The column the row starts at.
+ */
+int WrapMap::segmentStart(int line, int segment) const {
+    if (segment <= 0 || line < 0 || line >= (int)entries.size()) return 0;
+    return entries[line].breaks[segment - 1];
+}
+
+/**
+ * @brief Gets the column just past the last one of a row of a line.
+ *
+ * @param line The line.
+ * @param segment The row within the line.
+ * @param lineLength The length of the line.
+ * @return The column the next row starts at, or the line length for the last row.
+ */
+int WrapMap::segmentEnd(int line, int segment, int lineLength) const {
+    if (line < 0 || line >= (int)entries.size() || segment >= (int)entries[line].breaks.size()) return lineLength;
+    return entries[line].breaks[segment];
+}
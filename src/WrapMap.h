@@ -0,0 +1,73 @@
+/**
+ * @file WrapMap.h
+ * @brief Header file for the WrapMap class, which maps buffer lines to wrapped screen rows.
+ *
+ * Each line keeps the positions where its wrapped rows start, tagged with the hash
+ * of the line and the width they were computed for, so a line is only wrapped again
+ * when its text or the window width changes. A Fenwick tree over the number of rows
+ * of each line turns a line into its first screen row, and a screen row back into
+ * its line, in logarithmic time. When the width changes, lines are only wrapped
+ * again as they come on screen; until then they keep their rows for the old width.
+ * Every change to the rows takes a new stamp, so what others cache about the rows
+ * can be checked against it.
+ */
+
+#ifndef WRAP_MAP_H
+#define WRAP_MAP_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class WrapMap {
+public:
+    // Starts tracking a buffer, or stops if active is false
+    void setActive(bool active, const std::vector<std::string>& lines);
+    bool isActive() const;
+
+    // Changes the width, lines keep their old rows until wrapLines or wrapRows reaches them
+    void setWidth(int width, const std::vector<std::string>& lines);
+
+    // Wraps the lines [first, last), or the lines on screen rows [firstRow, firstRow + rows), at the current width
+    void wrapLines(const std::vector<std::string>& lines, int first, int last);
+    void wrapRows(const std::vector<std::string>& lines, int firstRow, int rows);
+
+    // Forgets the previous buffer and wraps a new one, reusing rows of unchanged lines
+    void reset(const std::vector<std::string>& lines);
+
+    // Lines [start, oldEnd) were replaced by lines [start, newEnd)
+    void edited(const std::vector<std::string>& lines, int start, int oldEnd, int newEnd);
+
+    int totalRows() const;
+    int rowsBefore(int line) const;
+    int rowCount(int line) const;
+    int lineAtRow(int row, int& segment) const;
+
+    // Taken anew whenever a line gains or loses rows; copies share it until one of them changes
+    std::uint64_t rowsStamp() const;
+
+    int segmentOf(int line, int col) const;
+    int segmentStart(int line, int segment) const;
+    int segmentEnd(int line, int segment, int lineLength) const;
+
+private:
+    struct Entry {
+        std::uint64_t hash = 0;
+        int width = 0;
+        std::vector<int> breaks;    ///< Start of every row after the first
+    };
+
+    bool active = false;
+    int width = 1;
+    std::vector<Entry> entries;
+    std::vector<int> tree;          ///< Fenwick tree of rows per line, 1-based
+    std::uint64_t stamp = 0;        ///< Set from next_stamp when the tree changes
+
+    static std::uint64_t next_stamp;
+
+    void wrapLine(const std::string& line, Entry& entry) const;
+    void rebuildTree();
+    void addRows(int line, int delta);
+};
+
+#endif // WRAP_MAP_H
@@ -0,0 +1,406 @@
+/**
+ * @file EditorTest.cpp
+ * @brief Headless regression tests that drive scripted keystrokes through TerminalEditor.
+ *
+ * Like the benchmarks, each test gets its own home directory and the editor runs on
+ * a virtual ncurses screen. Keys a prompt waits for are pushed back with ungetch
+ * before the key that opens it. A failed check prints what was
+ * expected and the run exits with status 1.
+ *
+ * Usage: neonote-test
+ */
+
+#include "../src/InputDecoder.h"
+#include "../src/NcursesSetup.h"
+#include "../src/Outline.h"
+#include "../src/PaneTree.h"
+#include "../src/Session.h"
+#include "../src/Settings.h"
+#include "../src/Task.h"
+#include "../src/TerminalEditor.h"
+#include "../src/WrapMap.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+int failures = 0;
+
+/**
+ * @brief Records a failed check.
+ */
+void check(bool passed, const std::string& what) {
+    if (passed) return;
+    std::cerr << "FAILED: " << what << std::endl;
+    ++failures;
+}
+
+/**
+ * @brief Reads a whole file, empty if it does not exist.
+ */
+std::string readFile(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+/**
+ * @brief Queues keys for the next prompt, in the order they are typed.
+ *
+ * ncurses returns keys pushed back last first, so they are pushed in reverse.
+ */
+void queueKeys(const std::string& text) {
+    for (auto key = text.rbegin(); key != text.rend(); ++key) {
+        ungetch(static_cast<unsigned char>(*key));
+    }
+}
+
+/**
+ * @brief Gives a test a fresh home directory with the given notes.
+ *
+ * @return The notes directory.
+ */
+std::string makeHome(const std::string& root, const std::string& name,
+                     const std::vector<std::pair<std::string, std::string>>& notes) {
+    std::string home = root + "/" + name;
+    std::string dir = home + "/.local/share/neonote";
+    std::filesystem::create_directories(dir);
+    for (const auto& [note, text] : notes) {
+        std::ofstream(dir + "/" + note + ".md") << text;
+    }
+    setenv("HOME", home.c_str(), 1);
+    return dir;
+}
+
+/**
+ * @brief Reads the text of a window, one line per row.
+ */
+std::string windowText(WINDOW* win) {
+    std::string text;
+    for (int y = 0; y < getmaxy(win); ++y) {
+        std::vector<char> row(getmaxx(win) + 1, '\0');
+        mvwinnstr(win, y, 0, row.data(), getmaxx(win));
+        text += row.data();
+        text += '\n';
+    }
+    return text;
+}
+
+/**
+ * @brief Owns the windows an editor draws into, laid out like the application does.
+ */
+class Screen {
+public:
+    Screen() {
+        int sidebar_width = static_cast<int>(COLS * SIDEBAR_WIDTH_RATIO);
+        main = newwin(LINES, COLS, 0, 0);
+        sidebar = derwin(main, LINES, sidebar_width, 0, 0);
+        panes.layout(main, 0, sidebar_width, LINES, COLS - sidebar_width);
+    }
+    ~Screen() {
+        panes.releaseWindows();
+        delwin(sidebar);
+        delwin(main);
+    }
+
+    WINDOW* main;
+    WINDOW* sidebar;
+    PaneTree panes;
+};
+
+/**
+ * @brief Renaming the open note keeps the edits that were not saved yet.
+ */
+void testRenameDirtyNote(const std::string& root) {
+    std::string dir = makeHome(root, "rename-dirty", {{"Draft", "old text\n"}});
+    Screen screen;
+    {
+        TerminalEditor editor(screen.main, screen.sidebar, &screen.panes, {});
+        for (char c : std::string("new ")) editor.handleInput(c);  /**< Not saved. */
+        editor.handleInput(SWITCH_PANEL);
+        queueKeys("Final\n");
+        editor.handleInput(RENAME_FILE);
+        editor.cleanup();
+    }
+    check(!std::filesystem::exists(dir + "/Draft.md"), "rename: the old file is gone");
+    check(readFile(dir + "/Final.md") == "new old text\n",
+          "rename: the renamed note keeps its unsaved edits, got \"" + readFile(dir + "/Final.md") + "\"");
+}
+
+/**
+ * @brief A save that cannot be written keeps the note on disk and is reported.
+ */
+void testFailedSaveKeepsNote(const std::string& root) {
+    std::string dir = makeHome(root, "save-failure", {{"Locked", "kept\n"}});
+    std::filesystem::create_directory(dir + "/Locked.md.tmp");  /**< The temporary file cannot be created. */
+    std::ofstream(dir + "/Locked.md.tmp/inside") << "x";       /**< Nor removed. */
+    Screen screen;
+    {
+        TerminalEditor editor(screen.main, screen.sidebar, &screen.panes, {});
+        editor.handleInput('x');
+        editor.handleInput(SAVE_FILE);
+        queueKeys("\x1b");  /**< Closes the popup listing the failed save. */
+        editor.cleanup();   /**< Waits for the save, then reports it. */
+    }
+    wtimeout(stdscr, 0);
+    check(wgetch(stdscr) == ERR, "save failure: a popup reported it");
+    check(readFile(dir + "/Locked.md") == "kept\n", "save failure: the note on disk is unchanged");
+    check(std::filesystem::is_directory(dir + "/Locked.md.tmp"), "save failure: nothing was moved over the note");
+}
+
+/**
+ * @brief The sidebar lists every board and opens the selected one.
+ */
+void testSidebarBoards(const std::string& root) {
+    std::string dir = makeHome(root, "sidebar-boards", {{"Only", "text\n"}});
+    std::filesystem::create_directories(dir + "/kanban/boards/Work");
+    std::ofstream(dir + "/kanban/boards/Work/columns") << "Backlog\nShipped\n";
+    Screen screen;
+    {
+        TerminalEditor editor(screen.main, screen.sidebar, &screen.panes, {});
+        std::string sidebar = windowText(screen.sidebar);
+        check(sidebar.find("My Tasks") < sidebar.find("Work") && sidebar.find("Work") < sidebar.find("Calendar"),
+              "sidebar boards: the boards are listed before the calendar");
+
+        // The sidebar lists the note, then My Tasks, then Work
+        editor.handleInput(SWITCH_PANEL);
+        editor.handleInput(CURSOR_DOWN);
+        editor.handleInput(CURSOR_DOWN);
+        editor.handleInput(SWITCH_PANEL);
+        check(windowText(screen.panes.focused().win).find("Backlog") != std::string::npos,
+              "sidebar boards: the selected board is open");
+
+        editor.handleInput(SWITCH_PANEL);
+        editor.handleInput(CURSOR_DOWN);
+        editor.handleInput(SWITCH_PANEL);
+        check(screen.panes.focused().view == PaneTree::View::Calendar, "sidebar boards: the calendar comes after them");
+        editor.cleanup();
+    }
+}
+
+/**
+ * @brief Ticking a checkbox from the board keeps the edits of the note that were not saved yet.
+ */
+void testBoardMoveKeepsEdits(const std::string& root) {
+    std::string dir = makeHome(root, "board-move", {{"Plan", "intro\n- [ ] ship it\n"}});
+    Screen screen;
+    {
+        TerminalEditor editor(screen.main, screen.sidebar, &screen.panes, {});
+        editor.handleInput(SAVE_FILE);  /**< Links the checkbox to a task on My Tasks. */
+        editor.handleInput(SPLIT_SIDE_BY_SIDE);
+
+        // The sidebar lists the note, then My Tasks; the new pane shows the board
+        editor.handleInput(SWITCH_PANEL);
+        editor.handleInput(CURSOR_DOWN);
+        editor.handleInput(SWITCH_PANEL);
+        editor.handleInput(NEXT_PANE);
+        editor.handleInput('Z');  /**< Not saved. */
+        editor.handleInput(NEXT_PANE);
+
+        ungetch('\n');  /**< Moves the task to Done. */
+        ungetch(KEY_DOWN);
+        ungetch(KEY_DOWN);
+        editor.handleInput(CONFIRM_OPTION);
+        check(readFile(dir + "/Plan.md") == "Zintro\n- [x] ship it\n",
+              "board move: the box is ticked next to the unsaved edit, got \"" + readFile(dir + "/Plan.md") + "\"");
+        editor.cleanup();
+    }
+    check(readFile(dir + "/Plan.md") == "Zintro\n- [x] ship it\n",
+          "board move: the note keeps both after closing, got \"" + readFile(dir + "/Plan.md") + "\"");
+}
+
+/**
+ * @brief A task is not moved while its note cannot be saved, so the checkbox is not patched under the edits.
+ */
+void testBoardMoveUnsavedNote(const std::string& root) {
+    std::string dir = makeHome(root, "board-move-unsaved", {{"Plan", "intro\n- [ ] ship it\n"}});
+    Screen screen;
+    {
+        TerminalEditor editor(screen.main, screen.sidebar, &screen.panes, {});
+        editor.handleInput(SAVE_FILE);  /**< Links the checkbox to a task on My Tasks. */
+        std::filesystem::create_directory(dir + "/Plan.md.tmp");  /**< Later saves fail. */
+        std::ofstream(dir + "/Plan.md.tmp/inside") << "x";
+        editor.handleInput('Z');
+        editor.handleInput(SWITCH_PANEL);
+        editor.handleInput(CURSOR_DOWN);
+        editor.handleInput(SWITCH_PANEL);  /**< Opens My Tasks, the save fails. */
+
+        // The first popup reports that failure; the keys after it would move the task to Done
+        ungetch('\n');
+        ungetch(KEY_DOWN);
+        ungetch(KEY_DOWN);
+        ungetch(27);
+        editor.handleInput(CONFIRM_OPTION);
+        wtimeout(stdscr, 0);
+        while (wgetch(stdscr) != ERR) {}
+        check(readFile(dir + "/Plan.md") == "intro\n- [ ] ship it\n",
+              "board move unsaved: the note file was not patched, got \"" + readFile(dir + "/Plan.md") + "\"");
+
+        std::filesystem::remove_all(dir + "/Plan.md.tmp");
+        editor.cleanup();
+    }
+    check(readFile(dir + "/Plan.md") == "Zintro\n- [ ] ship it\n",
+          "board move unsaved: the edit is saved once it can be, got \"" + readFile(dir + "/Plan.md") + "\"");
+}
+
+/**
+ * @brief A restored note that was deleted while the editor was closed is not written back.
+ */
+void testRestoredNoteDeleted(const std::string& root) {
+    std::string dir = makeHome(root, "restore-deleted", {{"Kept", "kept\n"}});
+    Session session;
+    session.open.push_back(Session::Cursor{"Gone"});
+    session.catalog.notes = {"Gone", "Kept"};
+    Screen screen;
+    {
+        TerminalEditor editor(screen.main, screen.sidebar, &screen.panes, {}, &session);
+        while (editor.checkCatalog()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        check(screen.panes.focused().note == "Kept", "restore deleted: the first note is opened instead");
+        editor.handleInput('x');
+        editor.cleanup();
+    }
+    check(!std::filesystem::exists(dir + "/Gone.md"), "restore deleted: the deleted note stays deleted");
+    check(readFile(dir + "/Kept.md") == "xkept\n",
+          "restore deleted: the edit goes to the opened note, got \"" + readFile(dir + "/Kept.md") + "\"");
+}
+
+/**
+ * @brief Due dates are checked against the length of their month.
+ */
+void testDueDates() {
+    check(Task::parseDate("2024-02-29") != 0, "due dates: 29 February of a leap year is accepted");
+    check(Task::parseDate("2000-02-29") != 0, "due dates: 29 February 2000 is accepted");
+    check(Task::parseDate("2023-02-29") == 0, "due dates: 29 February of a common year is rejected");
+    check(Task::parseDate("1900-02-29") == 0, "due dates: 29 February 1900 is rejected");
+    check(Task::parseDate("2024-04-31") == 0, "due dates: 31 April is rejected");
+    check(Task::parseDate("2024-12-31") != 0, "due dates: 31 December is accepted");
+    check(Task::formatDate(Task::parseDate("2024-02-29")) == "2024-02-29", "due dates: a date formats back unchanged");
+}
+
+/**
+ * @brief A character beyond ASCII held with Ctrl or Alt is skipped, not typed.
+ */
+void testDecodeModifiedUnicode() {
+    int in[2], out[2];
+    if (pipe(in) != 0 || pipe(out) != 0) {
+        check(false, "decode unicode: could not create pipes");
+        return;
+    }
+    const char typed[] = "\033[233;5u\033[233;3u\033[233;2ux";  // Ctrl+é, Alt+é, Shift+é, x
+    check(write(in[1], typed, sizeof(typed) - 1) == (ssize_t)(sizeof(typed) - 1), "decode unicode: write the keys");
+    {
+        InputDecoder decoder(in[0], out[1]);
+        int first = decoder.read(0);
+        int second = decoder.read(0);
+        check(first == 0xC3 && second == 0xA9, "decode unicode: Shift+é is typed as é");
+        int third = decoder.read(0);
+        check(third == 'x', "decode unicode: Ctrl+é and Alt+é are skipped, got " + std::to_string(third));
+        decoder.finish();
+    }
+    for (int fd : {in[0], in[1], out[0], out[1]}) close(fd);
+}
+
+/**
+ * @brief Checks every shown line's rows against counting the rows of the shown lines above it.
+ */
+void checkFoldRows(const Outline& outline, const WrapMap& wrap, int lineCount, const std::string& what) {
+    int row = 0;
+    bool matched = true;
+    for (int line = 0; line < lineCount && matched; ++line) {
+        if (outline.isHidden(line)) continue;
+        int rows = wrap.isActive() ? wrap.rowCount(line) : 1;
+        matched = outline.rowOf(wrap, line) == row;
+        for (int segment = 0; segment < rows && matched; ++segment) {
+            int found = -1;
+            matched = outline.lineAt(wrap, row + segment, found) == line && found == segment;
+        }
+        if (!matched) check(false, what + ": rows of line " + std::to_string(line));
+        row += rows;
+    }
+    check(!matched || outline.totalRows(wrap) == row, what + ": total rows");
+}
+
+/**
+ * @brief Folding and unfolding sections keeps lines and screen rows in step, with and without wrap.
+ */
+void testFoldRows() {
+    std::vector<std::string> lines;
+    for (int section = 0; section < 8; ++section) {
+        lines.push_back("# Part " + std::to_string(section));
+        for (int sub = 0; sub < 3; ++sub) {
+            lines.push_back("## Chapter " + std::to_string(sub));
+            for (int i = 0; i < 4; ++i) lines.push_back(std::string((section + sub + i) % 5 * 9, 'w') + " end");
+        }
+    }
+    int count = (int)lines.size();
+
+    for (bool wrapped : {false, true}) {
+        std::string what = wrapped ? "fold rows, wrap on" : "fold rows, wrap off";
+        Outline outline;
+        outline.reset(lines);
+        WrapMap wrap;
+        wrap.setWidth(12, lines);
+        wrap.setActive(wrapped, lines);
+        checkFoldRows(outline, wrap, count, what + ", nothing folded");
+
+        check(outline.toggleFold(2) == 1, what + ": a chapter folds at its heading");
+        check(outline.toggleFold(16) == 16, what + ": a part folds at its heading");
+        check(outline.toggleFold(50) == 49, what + ": a later chapter folds at its heading");
+        check(outline.foldedLines(16) == 15, what + ": a part hides its chapters");
+        checkFoldRows(outline, wrap, count, what + ", three folds");
+
+        check(outline.toggleFold(1) == 1, what + ": a folded chapter unfolds");
+        checkFoldRows(outline, wrap, count, what + ", two folds");
+
+        lines[20] += std::string(40, 'x');
+        outline.edited(lines, 20, 21, 21);
+        wrap.edited(lines, 20, 21, 21);
+        checkFoldRows(outline, wrap, count, what + ", a folded line grew");
+
+        outline.reveal(20);
+        check(!outline.isHidden(20) && outline.isFolded(49), what + ": revealing a line leaves other folds");
+        checkFoldRows(outline, wrap, count, what + ", revealed");
+        lines[20].resize(lines[20].size() - 40);
+    }
+}
+
+}  // namespace
+
+int main() {
+    char root_template[] = "/tmp/neonote-test-XXXXXX";
+    if (!mkdtemp(root_template)) {
+        std::perror("neonote-test");
+        return 1;
+    }
+    std::string root = root_template;
+
+    NcursesSetup ncurses;
+    if (!ncurses.initializeHeadless(40, 120)) {
+        std::cerr << "neonote-test: could not create a virtual screen" << std::endl;
+        return 1;
+    }
+
+    testRenameDirtyNote(root);
+    testFailedSaveKeepsNote(root);
+    testSidebarBoards(root);
+    testBoardMoveKeepsEdits(root);
+    testBoardMoveUnsavedNote(root);
+    testRestoredNoteDeleted(root);
+    testFoldRows();
+    testDueDates();
+    testDecodeModifiedUnicode();
+
+    ncurses.cleanup();
+    std::filesystem::remove_all(root);
+    std::cout << (failures ? "neonote-test: " + std::to_string(failures) + " failed" : "neonote-test: all passed") << std::endl;
+    return failures ? 1 : 0;
+}